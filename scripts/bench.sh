@@ -0,0 +1,72 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Builds and runs native benchmarks; results are appended to bench_output.txt.
+#   ./scripts/bench.sh            # all benchmarks
+#   ./scripts/bench.sh resampler  # one benchmark
+#   ./scripts/bench.sh daemon     # SEARCH/RESOLVE latency against tools/standin
+#   ./scripts/bench.sh params     # get_param/set_param key dispatch
+#   ./scripts/bench.sh meter      # fused output gain + level metering
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+REPO_ROOT="$(dirname "$SCRIPT_DIR")"
+CC="${CC:-cc}"
+BENCH_DIR="$REPO_ROOT/build/bench"
+OUTPUT="${BENCH_OUTPUT:-$REPO_ROOT/bench_output.txt}"
+which_bench="${1:-all}"
+
+mkdir -p "$BENCH_DIR"
+
+run_resampler() {
+  "$CC" -O3 -Wall -Wextra \
+    -I"$REPO_ROOT/src/dsp" \
+    "$REPO_ROOT/tools/bench/resampler_bench.c" \
+    -o "$BENCH_DIR/resampler_bench" -lm -lpthread
+  "$BENCH_DIR/resampler_bench"
+}
+
+run_params() {
+  "$CC" -O2 -Wall -Wextra -Wno-format-truncation -Wno-unused-function \
+    -I"$REPO_ROOT/src/dsp" \
+    "$REPO_ROOT/tools/bench/param_bench.c" \
+    -o "$BENCH_DIR/param_bench" -lpthread -lm
+  "$BENCH_DIR/param_bench"
+}
+
+run_meter() {
+  "$CC" -O3 -Wall -Wextra \
+    -I"$REPO_ROOT/src/dsp" \
+    "$REPO_ROOT/tools/bench/meter_bench.c" \
+    -o "$BENCH_DIR/meter_bench"
+  "$BENCH_DIR/meter_bench"
+}
+
+run_daemon() {
+  python3 "$REPO_ROOT/tools/bench/daemon_bench.py" ${DAEMON_BENCH_ARGS:-}
+}
+
+run_one() {
+  local name="$1"
+  echo "=== $name ($(date -u +%Y-%m-%dT%H:%M:%SZ)) ==="
+  case "$name" in
+    resampler) run_resampler ;;
+    daemon) run_daemon ;;
+    params) run_params ;;
+    meter) run_meter ;;
+    *)
+      echo "Unknown benchmark: $name"
+      exit 1
+      ;;
+  esac
+}
+
+{
+  if [ "$which_bench" = "all" ]; then
+    run_one resampler
+    run_one params
+    run_one meter
+    run_one daemon
+  else
+    run_one "$which_bench"
+  fi
+} | tee -a "$OUTPUT"
@@ -60,6 +60,13 @@ echo "Compiling v2 DSP plugin..."
   -Isrc/dsp \
   -lpthread -lm
 
+echo "Compiling host simulator (not packaged)..."
+"${CROSS_PREFIX}gcc" -O2 -g \
+  tools/host_sim/host_sim.c \
+  -o build/module/host_sim \
+  -Isrc/dsp \
+  -ldl
+
 cat src/module.json > dist/webstream/module.json
 cat src/ui.js > dist/webstream/ui.js
 cat src/ui_chain.js > dist/webstream/ui_chain.js
@@ -70,7 +77,9 @@ printf '%s\n' "$BUNDLE_RUNTIME" > dist/webstream/runtime_profile.txt
 
 mkdir -p dist/webstream/bin
 cp src/bin/yt_dlp_daemon.py dist/webstream/bin/yt_dlp_daemon.py
-chmod +x dist/webstream/bin/yt_dlp_daemon.py
+cp src/bin/range_prefetch.py dist/webstream/bin/range_prefetch.py
+cp src/bin/library_fetch.py dist/webstream/bin/library_fetch.py
+chmod +x dist/webstream/bin/yt_dlp_daemon.py dist/webstream/bin/range_prefetch.py dist/webstream/bin/library_fetch.py
 
 if [ "$bundle_deps" -eq 1 ]; then
   echo "Bundling runtime dependencies..."
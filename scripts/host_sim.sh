@@ -0,0 +1,105 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Builds dsp.so + host_sim natively and replays a scenario fully offline:
+# local WAV media behind tools/standin, the stub daemon, and a stub ffmpeg.
+#   ./scripts/host_sim.sh                       # scenarios/basic.sim
+#   ./scripts/host_sim.sh my.sim -- --json      # extra args go to host_sim
+# Knobs: SIM_LATENCY_MS, SIM_RATE_KBPS, SIM_PORT (stand-in server), SIM_RESOLVE_MS and
+# SIM_SEARCH_MS (stub daemon), SIM_DAEMON_LOG=file (stub daemon request log),
+# SIM_DECODER_BURN=N (busy helpers per stub decoder), SIM_DECODER_LOG=file
+# (stub decoder scheduling as applied), SIM_FFMPEG_PROBE=1 (stub decoder probes
+# like ffmpeg does a compressed stream), SIM_FFMPEG=/path/to/ffmpeg to decode
+# with a real ffmpeg instead. Each run starts with an empty search/resolve
+# cache, no startup-profile history and an empty offline library unless
+# SIM_CACHE_FILE / SIM_STARTUP_FILE / SIM_LIBRARY_DIR name ones to keep
+# between runs.
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+REPO_ROOT="$(dirname "$SCRIPT_DIR")"
+CC="${CC:-cc}"
+SIM_DIR="$REPO_ROOT/build/host_sim"
+TOOLS_DIR="$REPO_ROOT/tools/host_sim"
+
+scenario="${1:-basic.sim}"
+shift || true
+if [ "${1:-}" = "--" ]; then shift; fi
+if [ ! -f "$scenario" ]; then scenario="$TOOLS_DIR/scenarios/$scenario"; fi
+if [ ! -f "$scenario" ]; then
+  echo "Unknown scenario: $scenario"
+  exit 1
+fi
+
+mkdir -p "$SIM_DIR/media" "$SIM_DIR/module/bin"
+
+"$CC" -O2 -g -shared -fPIC \
+  "$REPO_ROOT/src/dsp/yt_stream_plugin.c" \
+  -o "$SIM_DIR/dsp.so" \
+  -I"$REPO_ROOT/src/dsp" \
+  -lpthread -lm
+"$CC" -O2 -g -Wall -Wextra \
+  -I"$REPO_ROOT/src/dsp" \
+  "$TOOLS_DIR/host_sim.c" \
+  -o "$SIM_DIR/host_sim" \
+  -ldl
+
+[ -f "$SIM_DIR/media/tone48k.wav" ] || python3 "$TOOLS_DIR/make_media.py" "$SIM_DIR/media/tone48k.wav" --rate 48000 --seconds 90
+[ -f "$SIM_DIR/media/tone44k.wav" ] || python3 "$TOOLS_DIR/make_media.py" "$SIM_DIR/media/tone44k.wav" --rate 44100 --seconds 30
+# Every other frame of tone44k: the stub daemon offers it as tone44k's fast-start rung.
+[ -f "$SIM_DIR/media/tone44k_lo.wav" ] || python3 "$TOOLS_DIR/make_media.py" "$SIM_DIR/media/tone44k_lo.wav" --rate 22050 --decimate "$SIM_DIR/media/tone44k.wav"
+
+cp "$TOOLS_DIR/stub_daemon.py" "$SIM_DIR/module/bin/yt_dlp_daemon.py"
+cp "$REPO_ROOT/src/bin/range_prefetch.py" "$SIM_DIR/module/bin/range_prefetch.py"
+cp "$REPO_ROOT/src/bin/library_fetch.py" "$SIM_DIR/module/bin/library_fetch.py"
+if [ -n "${SIM_FFMPEG:-}" ]; then
+  ln -sf "$SIM_FFMPEG" "$SIM_DIR/module/bin/ffmpeg"
+else
+  cp "$TOOLS_DIR/stub_ffmpeg.py" "$SIM_DIR/module/bin/ffmpeg"
+fi
+chmod +x "$SIM_DIR/module/bin/"*
+
+cache_file="${SIM_CACHE_FILE:-$SIM_DIR/cache.shm}"
+[ -n "${SIM_CACHE_FILE:-}" ] || rm -f "$cache_file"
+startup_file="${SIM_STARTUP_FILE:-$SIM_DIR/startup.tsv}"
+[ -n "${SIM_STARTUP_FILE:-}" ] || rm -f "$startup_file"
+library_dir="${SIM_LIBRARY_DIR:-$SIM_DIR/library}"
+[ -n "${SIM_LIBRARY_DIR:-}" ] || rm -rf "$library_dir"
+
+port_file="$SIM_DIR/standin.port"
+rm -f "$port_file"
+python3 "$REPO_ROOT/tools/standin/standin_server.py" \
+  --root "$SIM_DIR/media" \
+  --port "${SIM_PORT:-0}" \
+  --latency-ms "${SIM_LATENCY_MS:-40}" \
+  --rate-kbps "${SIM_RATE_KBPS:-0}" > "$port_file" &
+server_pid=$!
+trap 'kill "$server_pid" 2>/dev/null || true' EXIT
+for _ in $(seq 1 50); do
+  [ -s "$port_file" ] && break
+  sleep 0.1
+done
+port="$(awk '/^PORT/ {print $2}' "$port_file")"
+if [ -z "$port" ]; then
+  echo "Stand-in server failed to start"
+  exit 1
+fi
+
+WEBSTREAM_SIM_MEDIA_DIR="$SIM_DIR/media" \
+WEBSTREAM_SIM_MEDIA_BASE="http://127.0.0.1:${port}" \
+WEBSTREAM_SIM_RESOLVE_MS="${SIM_RESOLVE_MS:-0}" \
+WEBSTREAM_SIM_SEARCH_MS="${SIM_SEARCH_MS:-0}" \
+WEBSTREAM_SIM_DAEMON_LOG="${SIM_DAEMON_LOG:-}" \
+WEBSTREAM_SIM_DECODER_BURN="${SIM_DECODER_BURN:-0}" \
+WEBSTREAM_SIM_DECODER_LOG="${SIM_DECODER_LOG:-}" \
+WEBSTREAM_SIM_FFMPEG_PROBE="${SIM_FFMPEG_PROBE:-0}" \
+WEBSTREAM_CACHE_PATH="$cache_file" \
+WEBSTREAM_STARTUP_PATH="$startup_file" \
+WEBSTREAM_LIBRARY_DIR="$library_dir" \
+  "$SIM_DIR/host_sim" "$SIM_DIR/dsp.so" \
+    --module-dir "$SIM_DIR/module" \
+    --script "$scenario" \
+    --report-param underrun_count \
+    --report-param resume_count \
+    --report-param stats_json \
+    --report-param ttfa_trace \
+    "$@"
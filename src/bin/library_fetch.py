@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""Rate-limited media download for the offline library.
+
+Fetches a resolved media URL into OUT.part and renames it to OUT once the
+whole body has arrived, so the library never lists a partial file. HLS
+playlists are followed to their first variant and the segments (plus any
+init segment) are concatenated; encrypted playlists are refused.
+
+Progress goes to stdout, one line each:
+    PROGRESS <bytes> <total or 0>
+    DONE <bytes>
+    ERROR <message>
+
+usage: library_fetch.py --url URL --out PATH [--rate-kbps N] [--user-agent UA] [--referer URL]
+"""
+import argparse
+import os
+import sys
+import time
+import urllib.error
+import urllib.parse
+import urllib.request
+
+USER_AGENT = "move-anything-webstream/1.0"
+CHUNK = 16384
+PROGRESS_EVERY = 0.5
+
+
+def emit(*fields) -> None:
+    sys.stdout.write(" ".join(str(f) for f in fields) + "\n")
+    sys.stdout.flush()
+
+
+class Bucket:
+    """Token bucket in bytes per second; rate 0 means unlimited."""
+
+    def __init__(self, kbps: int):
+        self.rate = kbps * 1000 // 8
+        self.tokens = float(CHUNK)
+        self.last = time.monotonic()
+
+    def take(self, n: int) -> None:
+        if self.rate <= 0:
+            return
+        while True:
+            now = time.monotonic()
+            self.tokens = min(float(max(CHUNK, self.rate // 4)), self.tokens + (now - self.last) * self.rate)
+            self.last = now
+            if self.tokens >= n:
+                self.tokens -= n
+                return
+            time.sleep((n - self.tokens) / self.rate)
+
+
+class Fetcher:
+    def __init__(self, args, out):
+        self.headers = {"User-Agent": args.user_agent or USER_AGENT}
+        if args.referer:
+            self.headers["Referer"] = args.referer
+        self.timeout = args.timeout
+        self.bucket = Bucket(args.rate_kbps)
+        self.out = out
+        self.done = 0
+        self.total = 0
+        self.reported = 0.0
+
+    def open(self, url: str):
+        return urllib.request.urlopen(urllib.request.Request(url, headers=self.headers), timeout=self.timeout)
+
+    def progress(self, force: bool = False) -> None:
+        now = time.monotonic()
+        if force or now - self.reported >= PROGRESS_EVERY:
+            self.reported = now
+            emit("PROGRESS", self.done, self.total)
+
+    def copy(self, resp, head: bytes = b"") -> None:
+        if head:
+            self.out.write(head)
+            self.done += len(head)
+        while True:
+            self.bucket.take(CHUNK)
+            data = resp.read(CHUNK)
+            if not data:
+                break
+            self.out.write(data)
+            self.done += len(data)
+            self.progress()
+
+    def playlist(self, url: str, text: str) -> None:
+        lines = [line.strip() for line in text.splitlines() if line.strip()]
+        variant = None
+        for i, line in enumerate(lines):
+            if line.startswith("#EXT-X-STREAM-INF") and i + 1 < len(lines) and not lines[i + 1].startswith("#"):
+                variant = urllib.parse.urljoin(url, lines[i + 1])
+                break
+        if variant:
+            with self.open(variant) as resp:
+                self.playlist(variant, resp.read().decode("utf-8", "replace"))
+            return
+
+        segments = []
+        for line in lines:
+            if line.startswith("#EXT-X-KEY") and "METHOD=NONE" not in line:
+                raise ValueError("encrypted HLS is not supported")
+            if line.startswith("#EXT-X-MAP"):
+                uri = line.split('URI="', 1)[1].split('"', 1)[0] if 'URI="' in line else ""
+                if uri:
+                    segments.append(urllib.parse.urljoin(url, uri))
+            elif not line.startswith("#"):
+                segments.append(urllib.parse.urljoin(url, line))
+        if not segments:
+            raise ValueError("empty playlist")
+        for seg in segments:
+            with self.open(seg) as resp:
+                self.copy(resp)
+
+    def fetch(self, url: str) -> None:
+        with self.open(url) as resp:
+            head = resp.read(CHUNK)
+            if head.lstrip().startswith(b"#EXTM3U"):
+                self.playlist(url, (head + resp.read()).decode("utf-8", "replace"))
+                return
+            self.total = int(resp.headers.get("Content-Length") or 0)
+            self.copy(resp, head)
+            if self.total and self.done != self.total:
+                raise ValueError(f"short body {self.done}/{self.total}")
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description="Offline library download")
+    ap.add_argument("--url", required=True)
+    ap.add_argument("--out", required=True)
+    ap.add_argument("--rate-kbps", type=int, default=0)
+    ap.add_argument("--user-agent", default="")
+    ap.add_argument("--referer", default="")
+    ap.add_argument("--timeout", type=float, default=20.0)
+    args = ap.parse_args()
+
+    # The plugin kills the whole process group on destroy and removes the .part itself.
+    part = args.out + ".part"
+    try:
+        with open(part, "wb") as out:
+            fetcher = Fetcher(args, out)
+            fetcher.fetch(args.url)
+        if fetcher.done == 0:
+            raise ValueError("empty body")
+        os.replace(part, args.out)
+    except (urllib.error.URLError, OSError, ValueError) as exc:
+        try:
+            os.unlink(part)
+        except OSError:
+            pass
+        emit("ERROR", str(exc).replace("\n", " ")[:200])
+        return 1
+    fetcher.progress(force=True)
+    emit("DONE", fetcher.done)
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,391 @@
+#!/usr/bin/env python3
+"""Parallel HTTP range prefetcher for large media files.
+
+Downloads a URL with several concurrent Range requests into a sparse cache
+file and serves that file to the decoder over a loopback HTTP server. Chunks
+nearest the decoder's current read offset are fetched first, so initial
+buffering and far seeks do not wait on one sequential connection.
+
+usage: range_prefetch.py --url URL [options] -- DECODER ARGS...
+       Every "{input}" in the decoder args is replaced with the loopback URL.
+"""
+import argparse
+import hashlib
+import os
+import re
+import signal
+import subprocess
+import sys
+import threading
+import time
+import urllib.error
+import urllib.request
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+DEFAULT_CACHE_DIR = "/data/UserData/move-anything/cache/prefetch"
+USER_AGENT = "move-anything-webstream/1.0"
+CONTENT_RANGE_RE = re.compile(r"bytes\s+(\d+)-(\d+)/(\d+)")
+RANGE_RE = re.compile(r"bytes=(\d*)-(\d*)$")
+
+MISSING = 0
+INFLIGHT = 1
+DONE = 2
+
+FAIL_BACKOFF_MAX_S = 30.0
+
+
+def log(msg: str) -> None:
+    sys.stderr.write(f"range_prefetch: {msg}\n")
+    sys.stderr.flush()
+
+
+def http_range(url: str, start: int, end: int, user_agent: str, timeout: float):
+    req = urllib.request.Request(url, headers={"User-Agent": user_agent, "Range": f"bytes={start}-{end}"})
+    return urllib.request.urlopen(req, timeout=timeout)
+
+
+def probe_size(url: str, user_agent: str, timeout: float):
+    """Returns the total size when the origin honours Range requests, else None."""
+    try:
+        with http_range(url, 0, 0, user_agent, timeout) as resp:
+            if resp.status != 206:
+                return None
+            m = CONTENT_RANGE_RE.match(resp.headers.get("Content-Range", ""))
+            resp.read()
+            if not m:
+                return None
+            return int(m.group(3))
+    except (urllib.error.URLError, OSError, ValueError):
+        return None
+
+
+def prune_cache(cache_dir: str, budget_bytes: int, keep: tuple) -> None:
+    entries = []
+    total = 0
+    try:
+        names = os.listdir(cache_dir)
+    except OSError:
+        return
+    for name in names:
+        path = os.path.join(cache_dir, name)
+        if path in keep or not name.endswith((".data", ".map")):
+            continue
+        try:
+            st = os.stat(path)
+        except OSError:
+            continue
+        # Sparse files only cost the blocks actually fetched.
+        used = getattr(st, "st_blocks", 0) * 512 or st.st_size
+        entries.append((st.st_mtime, used, path))
+        total += used
+    entries.sort()
+    for _, used, path in entries:
+        if total <= budget_bytes:
+            break
+        try:
+            os.unlink(path)
+            total -= used
+        except OSError:
+            pass
+
+
+class ChunkStore:
+    """Sparse cache file plus a per-chunk state map shared by fetchers and readers."""
+
+    def __init__(self, base_path: str, size: int, chunk_size: int, window_bytes: int):
+        self.size = size
+        self.chunk_size = chunk_size
+        self.count = (size + chunk_size - 1) // chunk_size
+        self.window_chunks = max(1, window_bytes // chunk_size)
+        self.data_path = base_path + ".data"
+        self.map_path = base_path + ".map"
+        self.cond = threading.Condition()
+        self.cursor = 0
+        self.closed = False
+        self.failed = False
+        self.failures = 0
+        self.completed_since_save = 0
+        self.state = self._load_map()
+
+        fd = os.open(self.data_path, os.O_RDWR | os.O_CREAT, 0o644)
+        try:
+            if os.fstat(fd).st_size != size:
+                os.ftruncate(fd, size)
+        finally:
+            os.close(fd)
+        self.fd = os.open(self.data_path, os.O_RDWR)
+
+    def _load_map(self) -> bytearray:
+        header = f"{self.size}:{self.chunk_size}\n".encode()
+        try:
+            with open(self.map_path, "rb") as fp:
+                raw = fp.read()
+            if raw.startswith(header) and len(raw) == len(header) + self.count:
+                state = bytearray(raw[len(header):])
+                for i, v in enumerate(state):
+                    if v != DONE:
+                        state[i] = MISSING
+                return state
+        except OSError:
+            pass
+        return bytearray(self.count)
+
+    def save_map(self) -> None:
+        header = f"{self.size}:{self.chunk_size}\n".encode()
+        tmp = self.map_path + ".tmp"
+        with self.cond:
+            snapshot = bytes(b if b == DONE else MISSING for b in self.state)
+        try:
+            with open(tmp, "wb") as fp:
+                fp.write(header + snapshot)
+            os.replace(tmp, self.map_path)
+        except OSError:
+            pass
+
+    def set_cursor(self, offset: int) -> None:
+        with self.cond:
+            idx = min(offset // self.chunk_size, self.count - 1)
+            if idx != self.cursor:
+                self.cursor = idx
+                self.cond.notify_all()
+
+    def _pick(self):
+        # Nearest missing chunk at or ahead of the reader, within the lookahead window.
+        end = min(self.count, self.cursor + self.window_chunks)
+        for idx in range(self.cursor, end):
+            if self.state[idx] == MISSING:
+                return idx
+        return None
+
+    def claim(self):
+        with self.cond:
+            while not self.closed:
+                idx = self._pick()
+                if idx is not None:
+                    self.state[idx] = INFLIGHT
+                    return idx
+                self.cond.wait(0.5)
+            return None
+
+    def finish(self, idx: int, data: bytes) -> None:
+        os.pwrite(self.fd, data, idx * self.chunk_size)
+        with self.cond:
+            self.state[idx] = DONE
+            recovered = self.failed
+            self.failed = False
+            self.completed_since_save += 1
+            save = self.completed_since_save >= 16
+            if save:
+                self.completed_since_save = 0
+            self.cond.notify_all()
+        if recovered:
+            log(f"chunk {idx} fetched, origin reachable again")
+        if save:
+            # The process group is usually killed rather than exiting cleanly.
+            self.save_map()
+
+    def release(self, idx: int) -> None:
+        with self.cond:
+            self.state[idx] = MISSING
+            self.cond.notify_all()
+
+    def fail(self) -> None:
+        with self.cond:
+            self.failed = True
+            self.failures += 1
+            self.cond.notify_all()
+
+    def backoff(self, seconds: float) -> None:
+        with self.cond:
+            if not self.closed:
+                self.cond.wait(seconds)
+
+    def wait_chunk(self, idx: int) -> bool:
+        # Only a failure while this reader waits drops it; a reconnect waits for the retry.
+        with self.cond:
+            seen = self.failures
+            while self.state[idx] != DONE:
+                if self.closed or self.failures != seen:
+                    return False
+                self.cond.wait(0.5)
+            return True
+
+    def read(self, offset: int, length: int) -> bytes:
+        return os.pread(self.fd, length, offset)
+
+    def close(self) -> None:
+        with self.cond:
+            self.closed = True
+            self.cond.notify_all()
+
+
+def fetch_worker(store: ChunkStore, url: str, user_agent: str, timeout: float, retries: int) -> None:
+    delay = 0.0
+    while True:
+        idx = store.claim()
+        if idx is None:
+            return
+        start = idx * store.chunk_size
+        end = min(store.size, start + store.chunk_size) - 1
+        data = None
+        for attempt in range(retries):
+            try:
+                with http_range(url, start, end, user_agent, timeout) as resp:
+                    body = resp.read()
+                if resp.status == 206 and len(body) == end - start + 1:
+                    data = body
+                    break
+            except (urllib.error.URLError, OSError, ValueError):
+                pass
+            if store.closed:
+                break
+            time.sleep(0.25 * (attempt + 1))
+        if data is None:
+            store.release(idx)
+            if store.closed:
+                return
+            # Back off and keep the worker; the origin may come back.
+            delay = min(FAIL_BACKOFF_MAX_S, max(1.0, delay * 2))
+            log(f"chunk {idx} failed after {retries} attempts, retrying in {delay:.0f}s")
+            store.fail()
+            store.backoff(delay)
+            continue
+        delay = 0.0
+        store.finish(idx, data)
+
+
+class LoopbackHandler(BaseHTTPRequestHandler):
+    server_version = "webstream-prefetch/1.0"
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, fmt, *args):
+        return
+
+    def serve(self, head_only: bool) -> None:
+        store = self.server.store
+        start, end = 0, store.size - 1
+        partial = False
+        rng = self.headers.get("Range")
+        if rng:
+            m = RANGE_RE.match(rng.strip())
+            if m and m.group(1) != "":
+                start = int(m.group(1))
+                if m.group(2) != "":
+                    end = min(end, int(m.group(2)))
+                partial = True
+            if start >= store.size or start > end:
+                self.send_response(416)
+                self.send_header("Content-Range", f"bytes */{store.size}")
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+
+        self.send_response(206 if partial else 200)
+        self.send_header("Content-Type", self.server.content_type)
+        self.send_header("Accept-Ranges", "bytes")
+        self.send_header("Content-Length", str(end - start + 1))
+        if partial:
+            self.send_header("Content-Range", f"bytes {start}-{end}/{store.size}")
+        self.end_headers()
+        if head_only:
+            return
+
+        pos = start
+        try:
+            while pos <= end:
+                idx = pos // store.chunk_size
+                store.set_cursor(pos)
+                if not store.wait_chunk(idx):
+                    # Drop the connection; the plugin resumes the decoder at its position.
+                    self.close_connection = True
+                    return
+                stop = min(end + 1, (idx + 1) * store.chunk_size)
+                self.wfile.write(store.read(pos, stop - pos))
+                pos = stop
+        except (BrokenPipeError, ConnectionResetError):
+            self.close_connection = True
+
+    def do_GET(self):
+        self.serve(False)
+
+    def do_HEAD(self):
+        self.serve(True)
+
+
+def substitute_input(argv: list, value: str) -> list:
+    return [a.replace("{input}", value) for a in argv]
+
+
+def main() -> int:
+    if "--" not in sys.argv:
+        log("missing -- before decoder command")
+        return 2
+    split = sys.argv.index("--")
+    decoder = sys.argv[split + 1:]
+
+    ap = argparse.ArgumentParser(description="Parallel HTTP range prefetcher")
+    ap.add_argument("--url", required=True)
+    ap.add_argument("--cache-dir", default=DEFAULT_CACHE_DIR)
+    ap.add_argument("--connections", type=int, default=4)
+    ap.add_argument("--chunk-kib", type=int, default=512)
+    ap.add_argument("--window-mib", type=int, default=64, help="lookahead fetched past the read offset")
+    ap.add_argument("--min-size-mib", type=int, default=8, help="smaller files stream directly")
+    ap.add_argument("--cache-budget-mib", type=int, default=256)
+    ap.add_argument("--user-agent", default=USER_AGENT)
+    ap.add_argument("--timeout", type=float, default=15.0)
+    ap.add_argument("--retries", type=int, default=3)
+    args = ap.parse_args(sys.argv[1:split])
+
+    if not decoder:
+        log("empty decoder command")
+        return 2
+
+    size = probe_size(args.url, args.user_agent, args.timeout)
+    if size is None or size < args.min_size_mib * 1024 * 1024:
+        # No range support or not worth it: hand the origin URL straight to the decoder.
+        argv = substitute_input(decoder, args.url)
+        os.execvp(argv[0], argv)
+
+    os.makedirs(args.cache_dir, exist_ok=True)
+    base = os.path.join(args.cache_dir, hashlib.sha1(args.url.encode()).hexdigest())
+    prune_cache(args.cache_dir, args.cache_budget_mib * 1024 * 1024, (base + ".data", base + ".map"))
+    store = ChunkStore(base, size, max(16, args.chunk_kib) * 1024, args.window_mib * 1024 * 1024)
+
+    server = ThreadingHTTPServer(("127.0.0.1", 0), LoopbackHandler)
+    server.daemon_threads = True
+    server.store = store
+    server.content_type = "application/octet-stream"
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+
+    workers = []
+    for _ in range(max(1, args.connections)):
+        t = threading.Thread(
+            target=fetch_worker,
+            args=(store, args.url, args.user_agent, args.timeout, max(1, args.retries)),
+            daemon=True,
+        )
+        t.start()
+        workers.append(t)
+
+    local_url = f"http://127.0.0.1:{server.server_address[1]}/media"
+    child = subprocess.Popen(substitute_input(decoder, local_url))
+
+    def on_term(signum, frame):
+        store.close()
+        if child.poll() is None:
+            child.terminate()
+
+    signal.signal(signal.SIGTERM, on_term)
+    signal.signal(signal.SIGINT, on_term)
+
+    rc = child.wait()
+    store.close()
+    server.shutdown()
+    for t in workers:
+        t.join(timeout=1.0)
+    store.save_map()
+    return rc
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -16,8 +16,16 @@ def clean_field(value: object) -> str:
     return s
 
 
+# Requests may start with an "@<tag>" field (plugin instance + sequence);
+# every reply line to that request carries the same tag so a client shared
+# by several instances can route replies and drop ones nobody waits for.
+reply_tag = ""
+
+
 def write_fields(*fields: object) -> None:
     line = "\t".join(clean_field(f) for f in fields)
+    if reply_tag:
+        line = f"{reply_tag}\t{line}"
     sys.stdout.write(f"{line}\n")
     sys.stdout.flush()
 
@@ -156,6 +164,52 @@ def create_ytdlp_resolve_opts(provider: str) -> dict:
     return opts
 
 
+# RESOLVE_OK carries the full-quality url, user agent and referer, then its
+# bitrate and up to LADDER_RUNGS smaller "kbps url" pairs, lowest first. The
+# plugin can start on a small rung and switch to the full-quality url once a
+# background decoder has caught up.
+LADDER_RUNGS = 2
+LADDER_MAX_RATIO = 0.75     # a rung must be clearly smaller than the target
+
+
+def format_kbps(value: object) -> int:
+    try:
+        return int(round(float(value)))
+    except (TypeError, ValueError):
+        return 0
+
+
+def pick_fast_start_rungs(formats: object, target_kbps: int, target_url: str) -> list:
+    """Direct-download audio-only formats below the target bitrate, lowest first."""
+    if not isinstance(formats, list) or target_kbps <= 0:
+        return []
+    by_kbps = {}
+    for f in formats:
+        if not isinstance(f, dict):
+            continue
+        url = f.get("url") or ""
+        if not url or url == target_url:
+            continue
+        if f.get("vcodec") not in (None, "none") or f.get("acodec") in (None, "none"):
+            continue
+        if f.get("protocol") not in ("http", "https"):
+            continue
+        kbps = format_kbps(f.get("abr") or f.get("tbr"))
+        if kbps <= 0 or kbps > target_kbps * LADDER_MAX_RATIO:
+            continue
+        by_kbps.setdefault(kbps, url)
+    return [(k, by_kbps[k]) for k in sorted(by_kbps)][:LADDER_RUNGS]
+
+
+def write_resolve_ok(media_url: str, user_agent: str, referer: str, kbps: int = 0, rungs: list = ()) -> None:
+    fields = ["RESOLVE_OK", media_url, user_agent, referer]
+    if kbps > 0:
+        fields.append(str(kbps))
+        for rung_kbps, rung_url in rungs:
+            fields += [str(rung_kbps), rung_url]
+    write_fields(*fields)
+
+
 def ensure_ytdlp(yt_dlp_mod):
     if yt_dlp_mod is None:
         raise RuntimeError("yt-dlp is unavailable")
@@ -251,7 +305,8 @@ def resolve_request_ytdlp(yt_dlp_mod, provider: str, source_url: str) -> None:
     if isinstance(headers, dict):
         user_agent = headers.get("User-Agent") or ""
         referer = headers.get("Referer") or ""
-    write_fields("RESOLVE_OK", media_url, user_agent, referer)
+    kbps = format_kbps(data.get("abr") or data.get("tbr"))
+    write_resolve_ok(media_url, user_agent, referer, kbps, pick_fast_start_rungs(data.get("formats"), kbps, media_url))
 
 
 def load_provider_config() -> dict:
@@ -291,6 +346,25 @@ def provider_is_enabled(provider: str, config: dict) -> bool:
     return True
 
 
+DEFAULT_BASE_URLS = {
+    "freesound": "https://freesound.org/apiv2",
+    "archive": "https://archive.org",
+}
+
+
+def provider_base_url(config: dict, provider: str) -> str:
+    """API base for a provider; overridable (e.g. to a local stand-in) via
+    WEBSTREAM_<PROVIDER>_BASE_URL or a "base_url" key in the provider config."""
+    env_value = os.environ.get(f"WEBSTREAM_{provider.upper()}_BASE_URL")
+    if env_value and env_value.strip():
+        return env_value.strip().rstrip("/")
+    block = config_provider_block(config, provider)
+    value = block.get("base_url")
+    if isinstance(value, str) and value.strip():
+        return value.strip().rstrip("/")
+    return DEFAULT_BASE_URLS[provider]
+
+
 def freesound_api_key(config: dict) -> str:
     env_key = os.environ.get("FREESOUND_API_KEY") or os.environ.get("FREESOUND_TOKEN")
     if env_key:
@@ -368,7 +442,7 @@ def search_request_freesound(limit_text: str, query: str, config: dict) -> None:
         "page_size": str(limit),
         "token": key,
     }
-    url = "https://freesound.org/apiv2/search/text/?" + urllib.parse.urlencode(params)
+    url = provider_base_url(config, "freesound") + "/search/text/?" + urllib.parse.urlencode(params)
     data = http_json(url, timeout=20)
     results = []
     if isinstance(data, dict):
@@ -402,7 +476,7 @@ def resolve_request_freesound(source_url: str, config: dict) -> None:
         raise RuntimeError("could not parse freesound id")
 
     params = {"fields": "id,name,previews", "token": key}
-    url = f"https://freesound.org/apiv2/sounds/{urllib.parse.quote(sid)}/?" + urllib.parse.urlencode(params)
+    url = provider_base_url(config, "freesound") + f"/sounds/{urllib.parse.quote(sid)}/?" + urllib.parse.urlencode(params)
     data = http_json(url, timeout=20)
     if not isinstance(data, dict):
         raise RuntimeError("freesound resolve returned invalid payload")
@@ -421,6 +495,11 @@ def resolve_request_freesound(source_url: str, config: dict) -> None:
     if not media_url:
         raise RuntimeError("freesound preview url missing")
 
+    # The low-quality mp3 preview (~64 kbps) makes a fast-start rung for the ~128 kbps one.
+    lq = previews.get("preview-lq-mp3")
+    if media_url == previews.get("preview-hq-mp3") and isinstance(lq, str) and lq:
+        write_resolve_ok(media_url, "", "", 128, [(64, lq)])
+        return
     write_fields("RESOLVE_OK", media_url, "", "")
 
 
@@ -497,7 +576,7 @@ def pick_archive_media_file(files: list) -> str:
     return best_name
 
 
-def search_request_archive(limit_text: str, query: str) -> None:
+def search_request_archive(limit_text: str, query: str, config: dict) -> None:
     try:
         limit = int(limit_text)
     except Exception:
@@ -515,7 +594,7 @@ def search_request_archive(limit_text: str, query: str) -> None:
         "page": "1",
         "output": "json",
     }
-    url = "https://archive.org/advancedsearch.php?" + urllib.parse.urlencode(params, doseq=True)
+    url = provider_base_url(config, "archive") + "/advancedsearch.php?" + urllib.parse.urlencode(params, doseq=True)
     data = http_json(url, timeout=20)
 
     docs = []
@@ -547,12 +626,13 @@ def search_request_archive(limit_text: str, query: str) -> None:
     write_fields("SEARCH_END", str(count))
 
 
-def resolve_request_archive(source_url: str) -> None:
+def resolve_request_archive(source_url: str, config: dict) -> None:
     identifier = extract_archive_identifier(source_url)
     if not identifier:
         raise RuntimeError("could not parse archive.org identifier")
 
-    metadata_url = f"https://archive.org/metadata/{urllib.parse.quote(identifier)}"
+    base = provider_base_url(config, "archive")
+    metadata_url = f"{base}/metadata/{urllib.parse.quote(identifier)}"
     data = http_json(metadata_url, timeout=20)
     if not isinstance(data, dict):
         raise RuntimeError("archive metadata returned invalid payload")
@@ -565,7 +645,8 @@ def resolve_request_archive(source_url: str) -> None:
     if not name:
         raise RuntimeError("archive item has no supported audio file")
 
-    media_url = "https://archive.org/download/{}/{}".format(
+    media_url = "{}/download/{}/{}".format(
+        base,
         urllib.parse.quote(identifier),
         urllib.parse.quote(name, safe="/"),
     )
@@ -585,7 +666,7 @@ def search_request(yt_dlp_mod, provider: str, limit_text: str, query: str) -> No
         search_request_freesound(limit_text, query, config)
         return
     if provider == "archive":
-        search_request_archive(limit_text, query)
+        search_request_archive(limit_text, query, config)
         return
 
     raise RuntimeError(f"unsupported provider: {provider}")
@@ -604,7 +685,7 @@ def resolve_request(yt_dlp_mod, provider: str, source_url: str) -> None:
         resolve_request_freesound(source_url, config)
         return
     if provider == "archive":
-        resolve_request_archive(source_url)
+        resolve_request_archive(source_url, config)
         return
 
     raise RuntimeError(f"unsupported provider: {provider}")
@@ -637,6 +718,7 @@ def parse_resolve_parts(parts: list):
 
 
 def main() -> int:
+    global reply_tag
     setup_import_path()
 
     yt_dlp_mod = None
@@ -653,6 +735,10 @@ def main() -> int:
         if not line:
             continue
         parts = line.split("\t")
+        reply_tag = ""
+        if parts[0].startswith("@"):
+            reply_tag = clean_field(parts[0])
+            parts = parts[1:] or [""]
         cmd = parts[0]
 
         try:
@@ -665,7 +751,11 @@ def main() -> int:
                 provider, source_url = parse_resolve_parts(parts)
                 resolve_request(yt_dlp_mod, provider, source_url)
             elif cmd == "QUIT":
-                write_fields("BYE")
+                try:
+                    write_fields("BYE")
+                except BrokenPipeError:
+                    # The plugin may close its end right after QUIT.
+                    os.dup2(os.open(os.devnull, os.O_WRONLY), sys.stdout.fileno())
                 break
             else:
                 write_fields("ERROR", f"unknown command: {cmd}")
@@ -0,0 +1,124 @@
+#ifndef WS_KEYMAP_H
+#define WS_KEYMAP_H
+
+/*
+ * Hashed key -> id lookup for get_param/set_param dispatch.
+ *
+ * Keys live in a static table; ws_keymap_build() indexes them once into an
+ * open-addressed array at least four times the key count, so a lookup costs
+ * one FNV-1a pass over the key and (almost always) one string compare no
+ * matter how many keys exist. Keys ending in '_' name indexed families:
+ * "search_result_url_3" finds "search_result_url_" with *index = 3. A '#'
+ * inside a key stands for an index in the middle: "voice2_gain" finds
+ * "voice#_gain" with *index = 2.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WS_KEYMAP_SLOTS 512     /* power of two */
+#define WS_KEYMAP_INDEX_DIGITS 6
+#define WS_KEYMAP_KEY_MAX 64    /* longest key an infix family lookup rewrites */
+
+typedef struct {
+    const char *key;
+    int id;
+} ws_key_t;
+
+typedef struct {
+    const ws_key_t *keys;
+    int count;
+    int max_probe;                      /* longest probe sequence seen at build time */
+    uint16_t slots[WS_KEYMAP_SLOTS];    /* position in keys + 1; 0 = empty */
+} ws_keymap_t;
+
+static inline uint32_t ws_key_hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Returns 0, or -1 if the table is too large for WS_KEYMAP_SLOTS or has duplicates. */
+static int ws_keymap_build(ws_keymap_t *m, const ws_key_t *keys, int count) {
+    int i;
+
+    memset(m, 0, sizeof(*m));
+    if (count <= 0 || count * 4 > WS_KEYMAP_SLOTS) return -1;
+    m->keys = keys;
+    m->count = count;
+    for (i = 0; i < count; i++) {
+        size_t len = strlen(keys[i].key);
+        uint32_t slot = ws_key_hash(keys[i].key, len) & (WS_KEYMAP_SLOTS - 1);
+        int probe = 1;
+        while (m->slots[slot] != 0) {
+            if (strcmp(keys[m->slots[slot] - 1].key, keys[i].key) == 0) return -1;
+            slot = (slot + 1) & (WS_KEYMAP_SLOTS - 1);
+            probe++;
+        }
+        m->slots[slot] = (uint16_t)(i + 1);
+        if (probe > m->max_probe) m->max_probe = probe;
+    }
+    return 0;
+}
+
+/* Id of the first len bytes of key, or -1. */
+static inline int ws_keymap_find(const ws_keymap_t *m, const char *key, size_t len) {
+    uint32_t slot = ws_key_hash(key, len) & (WS_KEYMAP_SLOTS - 1);
+    int probe;
+
+    for (probe = 0; probe < m->max_probe; probe++) {
+        uint16_t pos = m->slots[slot];
+        const char *k;
+        if (pos == 0) return -1;
+        k = m->keys[pos - 1].key;
+        if (strncmp(k, key, len) == 0 && k[len] == '\0') return m->keys[pos - 1].id;
+        slot = (slot + 1) & (WS_KEYMAP_SLOTS - 1);
+    }
+    return -1;
+}
+
+/* The first run of digits, with a name before it and more after, becomes '#'. */
+static inline int ws_keymap_lookup_infix(const ws_keymap_t *m, const char *key, size_t len, int *index) {
+    char norm[WS_KEYMAP_KEY_MAX];
+    size_t start = 0;
+    size_t end;
+    int id;
+
+    while (start < len && (key[start] < '0' || key[start] > '9')) start++;
+    if (start == 0 || start == len || len >= sizeof(norm)) return -1;
+    end = start;
+    while (end < len && key[end] >= '0' && key[end] <= '9') end++;
+    if (end == len || end - start > WS_KEYMAP_INDEX_DIGITS) return -1;
+    memcpy(norm, key, start);
+    norm[start] = '#';
+    memcpy(norm + start + 1, key + end, len - end);
+    id = ws_keymap_find(m, norm, start + 1 + len - end);
+    if (id >= 0) *index = atoi(key + start);
+    return id;
+}
+
+/* Id for key, or -1. *index gets the numeric suffix of an indexed family key, else -1. */
+static inline int ws_keymap_lookup(const ws_keymap_t *m, const char *key, int *index) {
+    size_t len = strlen(key);
+    size_t digits = len;
+    int id;
+
+    *index = -1;
+    id = ws_keymap_find(m, key, len);
+    if (id >= 0) return id;
+
+    while (digits > 0 && key[digits - 1] >= '0' && key[digits - 1] <= '9') digits--;
+    if (digits == len) return ws_keymap_lookup_infix(m, key, len, index);
+    if (digits == 0 || key[digits - 1] != '_' || len - digits > WS_KEYMAP_INDEX_DIGITS) return -1;
+    id = ws_keymap_find(m, key, digits);
+    if (id >= 0) *index = atoi(key + digits);
+    return id;
+}
+
+#endif
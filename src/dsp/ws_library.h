@@ -0,0 +1,373 @@
+#ifndef WS_LIBRARY_H
+#define WS_LIBRARY_H
+
+/*
+ * Offline library: media saved to a local directory and listed in an index.
+ *
+ * One library per process, shared by every instance: the first reference
+ * loads "index.tsv" from the directory and every change rewrites it through
+ * a temp file and rename, so a crash mid-write keeps the previous index.
+ * Index lines are "provider url title channel duration file bytes saved_s
+ * played_s", tab separated. Items whose file has gone missing are dropped on
+ * load. The directory is kept under a byte budget by evicting the least
+ * recently played (or, if never played, saved) items first.
+ *
+ * Everything below takes g_library.mutex; callers copy what they need out.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define WS_LIB_MAX_ITEMS 256
+#define WS_LIB_PROVIDER_MAX 24
+#define WS_LIB_URL_MAX 512
+#define WS_LIB_TEXT_MAX 192
+#define WS_LIB_DURATION_MAX 24
+#define WS_LIB_FILE_MAX 32
+#define WS_LIB_DIR_MAX 448
+#define WS_LIB_PATH_MAX (WS_LIB_DIR_MAX + WS_LIB_FILE_MAX + 8)
+
+typedef struct {
+    char provider[WS_LIB_PROVIDER_MAX];
+    char url[WS_LIB_URL_MAX];           /* the page URL a search returns, not the media URL */
+    char title[WS_LIB_TEXT_MAX];
+    char channel[WS_LIB_TEXT_MAX];
+    char duration[WS_LIB_DURATION_MAX];
+    char file[WS_LIB_FILE_MAX];         /* name inside the library directory */
+    uint64_t bytes;
+    uint64_t saved_s;                   /* wall clock */
+    uint64_t played_s;                  /* 0 = never */
+} ws_lib_item_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    int refs;
+    char dir[WS_LIB_DIR_MAX];
+    uint64_t budget_bytes;
+    uint64_t bytes;                     /* sum over items */
+    int count;
+    ws_lib_item_t items[WS_LIB_MAX_ITEMS];
+    /* Process-wide counters, read with relaxed loads by stats_json. */
+    uint64_t saves;
+    uint64_t save_failures;
+    uint64_t evictions;
+    uint64_t local_plays;
+} ws_library_t;
+
+static ws_library_t g_library = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+/* File name for an item: a hash of provider and page URL, so a re-save lands on the same file. */
+static void ws_lib_file_name(const char *provider, const char *url, char *out, size_t len) {
+    uint64_t h = 14695981039346656037ULL;
+    const char *parts[2] = { provider, url };
+    int k;
+    size_t i;
+
+    for (k = 0; k < 2; k++) {
+        for (i = 0; parts[k][i]; i++) {
+            h ^= (unsigned char)parts[k][i];
+            h *= 1099511628211ULL;
+        }
+        h ^= '\t';
+        h *= 1099511628211ULL;
+    }
+    snprintf(out, len, "%016llx.media", (unsigned long long)h);
+}
+
+static void ws_lib_path_locked(const char *file, char *out, size_t len) {
+    snprintf(out, len, "%s/%s", g_library.dir, file);
+}
+
+/* Index fields are tab separated, one item per line. */
+static void ws_lib_copy_field(char *dst, size_t len, const char *src) {
+    size_t i;
+
+    snprintf(dst, len, "%s", src ? src : "");
+    for (i = 0; dst[i]; i++) {
+        if (dst[i] == '\t' || dst[i] == '\n' || dst[i] == '\r') dst[i] = ' ';
+    }
+}
+
+static uint64_t ws_lib_last_used(const ws_lib_item_t *it) {
+    return it->played_s > it->saved_s ? it->played_s : it->saved_s;
+}
+
+static void ws_lib_remove_locked(int i, bool unlink_file) {
+    char path[WS_LIB_PATH_MAX];
+
+    if (unlink_file) {
+        ws_lib_path_locked(g_library.items[i].file, path, sizeof(path));
+        (void)unlink(path);
+    }
+    g_library.bytes -= g_library.items[i].bytes;
+    g_library.items[i] = g_library.items[--g_library.count];
+}
+
+static int ws_lib_find_locked(const char *provider, const char *url) {
+    int i;
+    for (i = 0; i < g_library.count; i++) {
+        if (strcmp(g_library.items[i].url, url) == 0 && strcmp(g_library.items[i].provider, provider) == 0) return i;
+    }
+    return -1;
+}
+
+static int ws_lib_store_locked(void) {
+    char path[WS_LIB_PATH_MAX];
+    char tmp[WS_LIB_PATH_MAX + 32];
+    FILE *fp;
+    int i;
+
+    ws_lib_path_locked("index.tsv", path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    fp = fopen(tmp, "w");
+    if (!fp) return -1;
+    fprintf(fp, "# provider\turl\ttitle\tchannel\tduration\tfile\tbytes\tsaved_s\tplayed_s\n");
+    for (i = 0; i < g_library.count; i++) {
+        const ws_lib_item_t *it = &g_library.items[i];
+        fprintf(fp, "%s\t%s\t%s\t%s\t%s\t%s\t%llu\t%llu\t%llu\n", it->provider, it->url, it->title, it->channel,
+                it->duration, it->file, (unsigned long long)it->bytes, (unsigned long long)it->saved_s,
+                (unsigned long long)it->played_s);
+    }
+    if (fclose(fp) != 0 || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+static void ws_lib_load_locked(void) {
+    char path[WS_LIB_PATH_MAX];
+    char line[WS_LIB_URL_MAX + WS_LIB_TEXT_MAX * 2 + 256];
+    FILE *fp;
+
+    g_library.count = 0;
+    g_library.bytes = 0;
+    (void)mkdir(g_library.dir, 0755);
+    ws_lib_path_locked("index.tsv", path, sizeof(path));
+    fp = fopen(path, "r");
+    if (!fp) return;
+    while (fgets(line, sizeof(line), fp) && g_library.count < WS_LIB_MAX_ITEMS) {
+        ws_lib_item_t *it = &g_library.items[g_library.count];
+        char *f[9];
+        char *p = line;
+        struct stat st;
+        int n = 0;
+
+        if (line[0] == '#') continue;
+        line[strcspn(line, "\r\n")] = '\0';
+        f[n++] = p;
+        while (*p && n < 9) {
+            if (*p == '\t') {
+                *p = '\0';
+                f[n++] = p + 1;
+            }
+            p++;
+        }
+        if (n != 9 || f[5][0] == '\0' || strchr(f[5], '/') != NULL) continue;
+        memset(it, 0, sizeof(*it));
+        snprintf(it->provider, sizeof(it->provider), "%s", f[0]);
+        snprintf(it->url, sizeof(it->url), "%s", f[1]);
+        snprintf(it->title, sizeof(it->title), "%s", f[2]);
+        snprintf(it->channel, sizeof(it->channel), "%s", f[3]);
+        snprintf(it->duration, sizeof(it->duration), "%s", f[4]);
+        snprintf(it->file, sizeof(it->file), "%s", f[5]);
+        it->saved_s = strtoull(f[7], NULL, 10);
+        it->played_s = strtoull(f[8], NULL, 10);
+        /* The file is the truth: gone means forgotten, and its size beats the index. */
+        ws_lib_path_locked(it->file, path, sizeof(path));
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        it->bytes = (uint64_t)st.st_size;
+        g_library.bytes += it->bytes;
+        g_library.count++;
+    }
+    fclose(fp);
+}
+
+/*
+ * Drops least recently used items until the library fits budget_bytes (and,
+ * with make_room, has a free slot). keep_file (may be NULL) is never evicted.
+ * Returns how many were evicted; the caller stores the index.
+ */
+static int ws_lib_evict_locked(const char *keep_file, bool make_room) {
+    int evicted = 0;
+
+    while (g_library.count > 0 &&
+           (g_library.bytes > g_library.budget_bytes || (make_room && g_library.count >= WS_LIB_MAX_ITEMS))) {
+        int oldest = -1;
+        int i;
+        for (i = 0; i < g_library.count; i++) {
+            if (keep_file && strcmp(g_library.items[i].file, keep_file) == 0) continue;
+            if (oldest < 0 || ws_lib_last_used(&g_library.items[i]) < ws_lib_last_used(&g_library.items[oldest])) {
+                oldest = i;
+            }
+        }
+        if (oldest < 0) break;
+        ws_lib_remove_locked(oldest, true);
+        evicted++;
+    }
+    __atomic_store_n(&g_library.evictions, g_library.evictions + (uint64_t)evicted, __ATOMIC_RELAXED);
+    return evicted;
+}
+
+/* Adds or replaces an item whose file is already in place, then evicts to the budget around it. */
+static int ws_lib_add(const ws_lib_item_t *item) {
+    ws_lib_item_t *it;
+    int i;
+
+    pthread_mutex_lock(&g_library.mutex);
+    i = ws_lib_find_locked(item->provider, item->url);
+    if (i >= 0) ws_lib_remove_locked(i, strcmp(g_library.items[i].file, item->file) != 0);
+    (void)ws_lib_evict_locked(NULL, true);
+    it = &g_library.items[g_library.count++];
+    *it = *item;
+    ws_lib_copy_field(it->title, sizeof(it->title), item->title);
+    ws_lib_copy_field(it->channel, sizeof(it->channel), item->channel);
+    ws_lib_copy_field(it->duration, sizeof(it->duration), item->duration);
+    g_library.bytes += it->bytes;
+    (void)ws_lib_evict_locked(item->file, false);
+    (void)ws_lib_store_locked();
+    pthread_mutex_unlock(&g_library.mutex);
+    return 0;
+}
+
+/* Copies the item out and marks it played now; false when it is not saved (or its file vanished). */
+static bool ws_lib_open(const char *provider, const char *url, uint64_t now_s, ws_lib_item_t *out, char *path, size_t len) {
+    struct stat st;
+    int i;
+
+    pthread_mutex_lock(&g_library.mutex);
+    i = ws_lib_find_locked(provider, url);
+    if (i >= 0) {
+        ws_lib_path_locked(g_library.items[i].file, path, len);
+        if (stat(path, &st) != 0) {
+            ws_lib_remove_locked(i, false);
+            (void)ws_lib_store_locked();
+            i = -1;
+        } else {
+            g_library.items[i].played_s = now_s;
+            *out = g_library.items[i];
+            (void)ws_lib_store_locked();
+        }
+    }
+    pthread_mutex_unlock(&g_library.mutex);
+    return i >= 0;
+}
+
+static void ws_lib_path(const char *file, char *out, size_t len) {
+    pthread_mutex_lock(&g_library.mutex);
+    ws_lib_path_locked(file, out, len);
+    pthread_mutex_unlock(&g_library.mutex);
+}
+
+static bool ws_lib_contains(const char *provider, const char *url) {
+    bool found;
+    pthread_mutex_lock(&g_library.mutex);
+    found = ws_lib_find_locked(provider, url) >= 0;
+    pthread_mutex_unlock(&g_library.mutex);
+    return found;
+}
+
+/* A saved file that failed to decode: forget it and delete it. */
+static void ws_lib_forget(const char *provider, const char *url) {
+    int i;
+
+    pthread_mutex_lock(&g_library.mutex);
+    i = ws_lib_find_locked(provider, url);
+    if (i >= 0) {
+        ws_lib_remove_locked(i, true);
+        (void)ws_lib_store_locked();
+    }
+    pthread_mutex_unlock(&g_library.mutex);
+}
+
+static void ws_lib_set_budget(uint64_t budget_bytes) {
+    pthread_mutex_lock(&g_library.mutex);
+    g_library.budget_bytes = budget_bytes;
+    if (ws_lib_evict_locked(NULL, false) > 0) (void)ws_lib_store_locked();
+    pthread_mutex_unlock(&g_library.mutex);
+}
+
+static bool ws_lib_contains_ci(const char *hay, const char *word, size_t word_len) {
+    size_t i;
+    size_t j;
+
+    for (i = 0; hay[i]; i++) {
+        for (j = 0; j < word_len && hay[i + j]; j++) {
+            if (tolower((unsigned char)hay[i + j]) != tolower((unsigned char)word[j])) break;
+        }
+        if (j == word_len) return true;
+    }
+    return false;
+}
+
+/* Every space-separated word of query in the title, channel or URL, ignoring case; "" matches all. */
+static bool ws_lib_match(const ws_lib_item_t *it, const char *query) {
+    const char *w = query;
+
+    while (*w) {
+        size_t len;
+        while (*w == ' ') w++;
+        len = strcspn(w, " ");
+        if (len > 0 && !ws_lib_contains_ci(it->title, w, len) && !ws_lib_contains_ci(it->channel, w, len) &&
+            !ws_lib_contains_ci(it->url, w, len)) {
+            return false;
+        }
+        w += len;
+    }
+    return true;
+}
+
+/* Up to max matches, most recently used first. */
+static int ws_lib_search(const char *query, ws_lib_item_t *out, int max) {
+    int n = 0;
+    int i;
+
+    pthread_mutex_lock(&g_library.mutex);
+    for (i = 0; i < g_library.count; i++) {
+        const ws_lib_item_t *it = &g_library.items[i];
+        int j;
+        if (!ws_lib_match(it, query)) continue;
+        /* Insertion into the sorted prefix; when full the least recent falls off the end. */
+        if (n < max) {
+            j = n++;
+        } else if (max > 0 && ws_lib_last_used(&out[max - 1]) < ws_lib_last_used(it)) {
+            j = max - 1;
+        } else {
+            continue;
+        }
+        while (j > 0 && ws_lib_last_used(&out[j - 1]) < ws_lib_last_used(it)) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = *it;
+    }
+    pthread_mutex_unlock(&g_library.mutex);
+    return n;
+}
+
+/* Called from create_instance; the first reference loads the index from dir. */
+static void ws_lib_acquire(const char *dir, uint64_t budget_bytes) {
+    pthread_mutex_lock(&g_library.mutex);
+    if (g_library.refs++ == 0) {
+        snprintf(g_library.dir, sizeof(g_library.dir), "%s", dir);
+        g_library.budget_bytes = budget_bytes;
+        ws_lib_load_locked();
+    }
+    pthread_mutex_unlock(&g_library.mutex);
+}
+
+static void ws_lib_release(void) {
+    pthread_mutex_lock(&g_library.mutex);
+    if (g_library.refs > 0) g_library.refs--;
+    pthread_mutex_unlock(&g_library.mutex);
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef WS_LOGQ_H
+#define WS_LOGQ_H
+
+/*
+ * Lock-free queue of log lines for threads that must not touch files.
+ *
+ * A bounded multi-producer, single-consumer ring: producers claim a slot by
+ * CAS on head and publish it through the slot's sequence number, the one
+ * consumer (the instance's stats/log thread) copies it out and hands the slot
+ * back. A full queue drops the line and counts it instead of waiting.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define WS_LOGQ_SLOTS 32    /* power of two */
+#define WS_LOGQ_LINE 192
+
+typedef struct {
+    uint64_t seq;       /* pos when free for the producer at pos, pos + 1 once published */
+    char line[WS_LOGQ_LINE];
+} ws_logq_slot_t;
+
+typedef struct {
+    uint64_t head;
+    uint64_t tail;      /* consumer only */
+    uint64_t dropped;
+    ws_logq_slot_t slots[WS_LOGQ_SLOTS];
+} ws_logq_t;
+
+static inline void ws_logq_init(ws_logq_t *q) {
+    uint64_t i;
+    q->head = 0;
+    q->tail = 0;
+    q->dropped = 0;
+    for (i = 0; i < WS_LOGQ_SLOTS; i++) __atomic_store_n(&q->slots[i].seq, i, __ATOMIC_RELAXED);
+}
+
+static inline bool ws_logq_push(ws_logq_t *q, const char *line) {
+    uint64_t pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    ws_logq_slot_t *slot;
+
+    for (;;) {
+        uint64_t seq;
+        slot = &q->slots[pos & (WS_LOGQ_SLOTS - 1)];
+        seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq == pos) {
+            if (__atomic_compare_exchange_n(&q->head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+        } else if (seq < pos) {
+            __atomic_fetch_add(&q->dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        } else {
+            pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+        }
+    }
+    snprintf(slot->line, sizeof(slot->line), "%s", line);
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* Consumer only: copies the oldest line into out; false when the queue is empty. */
+static inline bool ws_logq_pop(ws_logq_t *q, char *out, size_t out_len) {
+    ws_logq_slot_t *slot = &q->slots[q->tail & (WS_LOGQ_SLOTS - 1)];
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != q->tail + 1) return false;
+    snprintf(out, out_len, "%s", slot->line);
+    __atomic_store_n(&slot->seq, q->tail + WS_LOGQ_SLOTS, __ATOMIC_RELEASE);
+    q->tail++;
+    return true;
+}
+
+#endif
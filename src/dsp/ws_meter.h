@@ -0,0 +1,102 @@
+#ifndef WS_METER_H
+#define WS_METER_H
+
+/*
+ * Output gain stage fused with level metering for interleaved stereo s16.
+ *
+ * One pass applies gain (Q13 fixed point, round-to-nearest with
+ * saturation) and collects per-channel peak, sum of squares and the number
+ * of samples pinned at full scale. The NEON path and the scalar fallback
+ * produce bit-identical audio and meter values. Unity gain (8192) leaves
+ * samples unchanged.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define WS_METER_NEON 1
+#endif
+
+#define WS_METER_GAIN_SHIFT 13
+
+typedef struct {
+    uint32_t peak[2];       /* max |sample| per channel after gain, 0..32767 */
+    uint64_t sumsq[2];
+    uint32_t clips;         /* samples at +32767 or -32768 after gain */
+} ws_meter_block_t;
+
+static inline int32_t ws_meter_gain_q13(float gain) {
+    float q = gain * (float)(1 << WS_METER_GAIN_SHIFT) + 0.5f;
+    if (q < 0.0f) return 0;
+    if (q > 32767.0f) return 32767;
+    return (int32_t)q;
+}
+
+/* Branch-free so the scalar loop below can still be auto-vectorized off NEON. */
+static inline int16_t ws_meter_apply(int16_t x, int32_t g, ws_meter_block_t *m, int ch) {
+    int32_t v = ((int32_t)x * g + (1 << (WS_METER_GAIN_SHIFT - 1))) >> WS_METER_GAIN_SHIFT;
+    uint32_t a;
+    v = v > 32767 ? 32767 : v;
+    v = v < -32768 ? -32768 : v;
+    m->clips += (uint32_t)(v == 32767) + (uint32_t)(v == -32768);
+    a = (uint32_t)(v < 0 ? -v : v);
+    a = a > 32767U ? 32767U : a;
+    m->peak[ch] = a > m->peak[ch] ? a : m->peak[ch];
+    m->sumsq[ch] += (uint64_t)((int64_t)v * v);
+    return (int16_t)v;
+}
+
+static void ws_gain_meter(int16_t *lr, size_t frames, float gain, ws_meter_block_t *m) {
+    int32_t g = ws_meter_gain_q13(gain);
+    size_t i = 0;
+
+    m->peak[0] = m->peak[1] = 0;
+    m->sumsq[0] = m->sumsq[1] = 0;
+    m->clips = 0;
+#if defined(WS_METER_NEON)
+    {
+        const int16x8_t top = vdupq_n_s16(INT16_MAX);
+        const int16x8_t bottom = vdupq_n_s16(INT16_MIN);
+        uint16x8_t peak[2] = { vdupq_n_u16(0), vdupq_n_u16(0) };
+        uint64x2_t sq[2] = { vdupq_n_u64(0), vdupq_n_u64(0) };
+        uint16x8_t clips = vdupq_n_u16(0);
+        int16_t g16 = (int16_t)g;
+        int c;
+
+        /* clips counts at most 2 per lane per iteration, so cap the run below 2^15 iterations. */
+        for (; i + 8 <= frames && i < (size_t)8 * 32767; i += 8) {
+            int16x8x2_t v = vld2q_s16(lr + i * 2);
+            for (c = 0; c < 2; c++) {
+                int32x4_t lo = vmull_n_s16(vget_low_s16(v.val[c]), g16);
+                int32x4_t hi = vmull_high_n_s16(v.val[c], g16);
+                int16x8_t y = vcombine_s16(vqrshrn_n_s32(lo, WS_METER_GAIN_SHIFT), vqrshrn_n_s32(hi, WS_METER_GAIN_SHIFT));
+                uint16x8_t pinned = vorrq_u16(vceqq_s16(y, top), vceqq_s16(y, bottom));
+                v.val[c] = y;
+                clips = vsubq_u16(clips, pinned);       /* mask lanes are 0xFFFF == -1 */
+                peak[c] = vmaxq_u16(peak[c], vreinterpretq_u16_s16(vqabsq_s16(y)));
+                sq[c] = vpadalq_u32(sq[c], vreinterpretq_u32_s32(vmull_s16(vget_low_s16(y), vget_low_s16(y))));
+                sq[c] = vpadalq_u32(sq[c], vreinterpretq_u32_s32(vmull_high_s16(y, y)));
+            }
+            vst2q_s16(lr + i * 2, v);
+        }
+        for (c = 0; c < 2; c++) {
+            m->peak[c] = vmaxvq_u16(peak[c]);
+            m->sumsq[c] = vgetq_lane_u64(sq[c], 0) + vgetq_lane_u64(sq[c], 1);
+        }
+        m->clips = vaddlvq_u16(clips);
+    }
+#endif
+    {
+        /* Locals rather than m's fields, so the compiler can keep them in registers. */
+        ws_meter_block_t acc = *m;
+        for (; i < frames; i++) {
+            lr[i * 2] = ws_meter_apply(lr[i * 2], g, &acc, 0);
+            lr[i * 2 + 1] = ws_meter_apply(lr[i * 2 + 1], g, &acc, 1);
+        }
+        *m = acc;
+    }
+}
+
+#endif
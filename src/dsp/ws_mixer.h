@@ -0,0 +1,61 @@
+#ifndef WS_MIXER_H
+#define WS_MIXER_H
+
+/*
+ * Saturating sum of a gained voice into an interleaved s16 mix bus.
+ *
+ * The voice is scaled by a Q13 gain (same rounding as ws_meter.h) and added
+ * to the bus with saturation at each step, so a loud layer pins at full
+ * scale instead of wrapping. The NEON path and the scalar fallback produce
+ * bit-identical output; the scalar loop is branch-free so it still
+ * auto-vectorizes elsewhere.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define WS_MIXER_NEON 1
+#endif
+
+#define WS_MIX_GAIN_SHIFT 13
+#define WS_MIX_UNITY (1 << WS_MIX_GAIN_SHIFT)
+
+static inline int32_t ws_mix_gain_q13(float gain) {
+    float q = gain * (float)WS_MIX_UNITY + 0.5f;
+    if (q < 0.0f) return 0;
+    if (q > 32767.0f) return 32767;
+    return (int32_t)q;
+}
+
+static inline int16_t ws_mix_sat(int32_t v) {
+    v = v > 32767 ? 32767 : v;
+    v = v < -32768 ? -32768 : v;
+    return (int16_t)v;
+}
+
+/* bus[i] = sat(bus[i] + sat(round(src[i] * g / 8192))) for n samples. */
+static void ws_mix_add(int16_t *bus, const int16_t *src, size_t n, int32_t g) {
+    size_t i = 0;
+
+    if (g <= 0) return;
+#if defined(WS_MIXER_NEON)
+    {
+        int16_t g16 = (int16_t)g;
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t s = vld1q_s16(src + i);
+            int32x4_t lo = vmull_n_s16(vget_low_s16(s), g16);
+            int32x4_t hi = vmull_high_n_s16(s, g16);
+            int16x8_t y = vcombine_s16(vqrshrn_n_s32(lo, WS_MIX_GAIN_SHIFT), vqrshrn_n_s32(hi, WS_MIX_GAIN_SHIFT));
+            vst1q_s16(bus + i, vqaddq_s16(vld1q_s16(bus + i), y));
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        int32_t y = ws_mix_sat(((int32_t)src[i] * g + (1 << (WS_MIX_GAIN_SHIFT - 1))) >> WS_MIX_GAIN_SHIFT);
+        bus[i] = ws_mix_sat((int32_t)bus[i] + y);
+    }
+}
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef WS_PROCMAN_H
+#define WS_PROCMAN_H
+
+/*
+ * Process-wide child reaper.
+ *
+ * Children that are no longer wanted are handed to one lazily started
+ * manager thread instead of a thread per stop. Each entry carries an
+ * escalation timer: an optional grace period (for a child asked to exit
+ * politely), then SIGTERM, then SIGKILL. The thread sleeps in poll() on a
+ * wake pipe plus one pidfd per child, so it wakes exactly when a child exits
+ * or a timer is due; without pidfd support (older kernels) it falls back to
+ * a short waitpid(WNOHANG) polling interval while children are pending. It
+ * never touches SIGCHLD, which belongs to the host.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WS_PROC_MAX 64
+#define WS_PROC_POLL_MS 25          /* waitpid polling without pidfds */
+#define WS_PROC_KILL_RECHECK_MS 1000
+#define WS_PROC_THREAD_NICE 10      /* reaping can wait; the audio cannot */
+
+typedef struct {
+    pid_t pid;
+    int pidfd;          /* -1 without pidfd support */
+    bool group;         /* signal the child's process group */
+    int stage;          /* 0 grace, 1 SIGTERM sent, 2 SIGKILL sent */
+    uint32_t kill_ms;   /* SIGTERM -> SIGKILL delay */
+    uint64_t deadline_ms;
+} ws_proc_child_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    int wake[2];
+    bool running;
+    int count;
+    ws_proc_child_t children[WS_PROC_MAX];
+    uint64_t live;          /* spawned and not yet reaped, across all instances */
+    uint64_t spawned;
+    uint64_t reaped;
+    uint64_t escalations;   /* children that needed SIGKILL */
+} ws_procman_t;
+
+static ws_procman_t g_procman = { PTHREAD_MUTEX_INITIALIZER, { -1, -1 }, false, 0, { { 0 } }, 0, 0, 0, 0 };
+static pthread_once_t g_procman_once = PTHREAD_ONCE_INIT;
+
+static uint64_t ws_proc_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+static int ws_proc_pidfd_open(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+static void ws_proc_signal(const ws_proc_child_t *c, int sig) {
+    (void)kill(c->group ? -c->pid : c->pid, sig);
+}
+
+/* Called with the mutex held; returns true once the child is gone. */
+static bool ws_proc_try_reap(ws_proc_child_t *c) {
+    int status;
+    pid_t rc = waitpid(c->pid, &status, WNOHANG);
+    /* Gone only when reaped here or by someone else (ECHILD); EINTR and friends retry later. */
+    if (rc != c->pid && !(rc < 0 && errno == ECHILD)) return false;
+    if (c->pidfd >= 0) close(c->pidfd);
+    __atomic_fetch_add(&g_procman.reaped, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&g_procman.live, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+static void* ws_proc_thread_main(void *arg) {
+    struct pollfd fds[WS_PROC_MAX + 1];
+    char drain[64];
+    (void)arg;
+
+    (void)setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), WS_PROC_THREAD_NICE);
+
+    for (;;) {
+        int nfds = 1;
+        int timeout = -1;
+        bool polling = false;
+        uint64_t now;
+        int i;
+
+        pthread_mutex_lock(&g_procman.mutex);
+        now = ws_proc_now_ms();
+        for (i = 0; i < g_procman.count; i++) {
+            ws_proc_child_t *c = &g_procman.children[i];
+            int wait_ms = c->deadline_ms > now ? (int)(c->deadline_ms - now) : 0;
+            if (timeout < 0 || wait_ms < timeout) timeout = wait_ms;
+            if (c->pidfd >= 0) {
+                fds[nfds].fd = c->pidfd;
+                fds[nfds].events = POLLIN;
+                fds[nfds].revents = 0;
+                nfds++;
+            } else {
+                polling = true;
+            }
+        }
+        pthread_mutex_unlock(&g_procman.mutex);
+        if (polling && (timeout < 0 || timeout > WS_PROC_POLL_MS)) timeout = WS_PROC_POLL_MS;
+
+        fds[0].fd = g_procman.wake[0];
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        if (poll(fds, (nfds_t)nfds, timeout) > 0 && (fds[0].revents & POLLIN)) {
+            while (read(g_procman.wake[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+
+        pthread_mutex_lock(&g_procman.mutex);
+        now = ws_proc_now_ms();
+        for (i = 0; i < g_procman.count;) {
+            ws_proc_child_t *c = &g_procman.children[i];
+            if (ws_proc_try_reap(c)) {
+                g_procman.children[i] = g_procman.children[--g_procman.count];
+                continue;
+            }
+            if (now >= c->deadline_ms) {
+                if (c->stage == 0) {
+                    ws_proc_signal(c, SIGTERM);
+                    c->stage = 1;
+                    c->deadline_ms = now + c->kill_ms;
+                } else {
+                    if (c->stage == 1) __atomic_fetch_add(&g_procman.escalations, 1, __ATOMIC_RELAXED);
+                    ws_proc_signal(c, SIGKILL);
+                    c->stage = 2;
+                    c->deadline_ms = now + WS_PROC_KILL_RECHECK_MS;
+                }
+            }
+            i++;
+        }
+        pthread_mutex_unlock(&g_procman.mutex);
+    }
+    return NULL;
+}
+
+static void ws_proc_init(void) {
+    pthread_t thread;
+    int i;
+
+    if (pipe(g_procman.wake) != 0) return;
+    for (i = 0; i < 2; i++) {
+        (void)fcntl(g_procman.wake[i], F_SETFD, FD_CLOEXEC);
+        (void)fcntl(g_procman.wake[i], F_SETFL, fcntl(g_procman.wake[i], F_GETFL, 0) | O_NONBLOCK);
+    }
+    if (pthread_create(&thread, NULL, ws_proc_thread_main, NULL) == 0) {
+        pthread_detach(thread);
+        g_procman.running = true;
+    }
+}
+
+static void ws_proc_note_spawn(void) {
+    __atomic_fetch_add(&g_procman.spawned, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&g_procman.live, 1, __ATOMIC_RELAXED);
+}
+
+/* For children their owner waited on directly (e.g. the probe thread). */
+static void ws_proc_note_reaped(void) {
+    __atomic_fetch_add(&g_procman.reaped, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&g_procman.live, 1, __ATOMIC_RELAXED);
+}
+
+/* Synchronous fallback when the manager cannot take the child. */
+static void ws_proc_terminate_now(pid_t pid, bool group, uint32_t kill_ms) {
+    ws_proc_child_t c;
+    int status;
+
+    c.pid = pid;
+    c.group = group;
+    if (waitpid(pid, &status, WNOHANG) == 0) {
+        ws_proc_signal(&c, SIGTERM);
+        usleep(kill_ms * 1000U);
+        if (waitpid(pid, &status, WNOHANG) == 0) {
+            __atomic_fetch_add(&g_procman.escalations, 1, __ATOMIC_RELAXED);
+            ws_proc_signal(&c, SIGKILL);
+            (void)waitpid(pid, &status, 0);
+        }
+    }
+    ws_proc_note_reaped();
+}
+
+/*
+ * Hands a child to the manager: SIGTERM after grace_ms (0 = now), SIGKILL
+ * kill_ms later, reaped whenever it exits. Never blocks on the child.
+ */
+static void ws_proc_release(pid_t pid, bool group, uint32_t grace_ms, uint32_t kill_ms) {
+    ws_proc_child_t *c;
+    uint64_t now;
+
+    if (pid <= 0) return;
+    pthread_once(&g_procman_once, ws_proc_init);
+
+    pthread_mutex_lock(&g_procman.mutex);
+    if (!g_procman.running || g_procman.count >= WS_PROC_MAX) {
+        pthread_mutex_unlock(&g_procman.mutex);
+        ws_proc_terminate_now(pid, group, kill_ms);
+        return;
+    }
+    now = ws_proc_now_ms();
+    c = &g_procman.children[g_procman.count++];
+    c->pid = pid;
+    c->pidfd = ws_proc_pidfd_open(pid);
+    c->group = group;
+    c->kill_ms = kill_ms;
+    if (grace_ms == 0) {
+        ws_proc_signal(c, SIGTERM);
+        c->stage = 1;
+        c->deadline_ms = now + kill_ms;
+    } else {
+        c->stage = 0;
+        c->deadline_ms = now + grace_ms;
+    }
+    pthread_mutex_unlock(&g_procman.mutex);
+    if (write(g_procman.wake[1], "x", 1) < 0) {
+        /* Pipe full: the thread already has a wakeup pending. */
+    }
+}
+
+#endif
@@ -0,0 +1,322 @@
+#ifndef WS_RESAMPLER_H
+#define WS_RESAMPLER_H
+
+/*
+ * Streaming polyphase resampler for interleaved stereo s16.
+ *
+ * Rates are reduced to an exact L/M ratio; each of the L phases holds a
+ * windowed-sinc kernel of `taps` coefficients. Kernel tables are shared per
+ * (L, M, taps) and built by ws_resampler_prepare off the audio thread;
+ * ws_resampler_attach and process never allocate and can run on it.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define WS_RESAMPLER_NEON 1
+#endif
+
+#define WS_RESAMPLER_MAX_TAPS 32
+#define WS_RESAMPLER_MAX_PHASES 1024
+#define WS_RESAMPLER_TAPS_LOW 16
+#define WS_RESAMPLER_TAPS_HIGH 32
+#define WS_RESAMPLER_TABLES 64      /* distinct (L, M, taps) kept for the process lifetime */
+
+typedef struct {
+    uint32_t up;
+    uint32_t down;      /* 0 for the generic grid attach falls back on */
+    int taps;
+    float coeffs[];     /* up * taps */
+} ws_rs_table_t;
+
+typedef struct {
+    int in_rate;
+    int out_rate;
+    int taps;
+    uint32_t up;        /* L: phases per input frame */
+    uint32_t down;      /* M: input step per output frame, in phases */
+    uint32_t phase;
+    uint32_t advance;   /* input frames to consume before the next output */
+    uint32_t hist_pos;
+    bool passthrough;
+    const float *coeffs;
+    float hist_l[WS_RESAMPLER_MAX_TAPS * 2];
+    float hist_r[WS_RESAMPLER_MAX_TAPS * 2];
+} ws_resampler_t;
+
+/* Tables are published with one release store of count, so lookups take no lock. */
+static struct {
+    pthread_mutex_t mutex;
+    uint32_t count;
+    ws_rs_table_t *tables[WS_RESAMPLER_TABLES];
+} g_ws_rs_tables = { PTHREAD_MUTEX_INITIALIZER, 0, { NULL } };
+
+static uint32_t ws_rs_gcd(uint32_t a, uint32_t b) {
+    while (b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static void ws_resampler_reset(ws_resampler_t *rs) {
+    rs->phase = 0;
+    rs->advance = 0;
+    rs->hist_pos = 0;
+    memset(rs->hist_l, 0, sizeof(rs->hist_l));
+    memset(rs->hist_r, 0, sizeof(rs->hist_r));
+}
+
+static int ws_rs_taps(int taps) {
+    return taps == WS_RESAMPLER_TAPS_LOW || taps == WS_RESAMPLER_TAPS_HIGH ? taps : WS_RESAMPLER_TAPS_HIGH;
+}
+
+/* Returns 1 for equal rates, 0 with the reduced ratio in up and down, -1 if it cannot be held. */
+static int ws_rs_ratio(int in_rate, int out_rate, uint32_t *up, uint32_t *down) {
+    uint32_t g;
+
+    if (in_rate <= 0 || out_rate <= 0) return -1;
+    if (in_rate == out_rate) return 1;
+    g = ws_rs_gcd((uint32_t)in_rate, (uint32_t)out_rate);
+    *up = (uint32_t)out_rate / g;
+    *down = (uint32_t)in_rate / g;
+    if (*up > WS_RESAMPLER_MAX_PHASES) {
+        /* Odd ratios: approximate with the finest phase grid we can hold. */
+        *down = (uint32_t)(((uint64_t)*down * WS_RESAMPLER_MAX_PHASES + *up / 2) / *up);
+        *up = WS_RESAMPLER_MAX_PHASES;
+        if (*down == 0) return -1;
+    }
+    return 0;
+}
+
+static const ws_rs_table_t *ws_rs_table_find(uint32_t up, uint32_t down, int taps) {
+    uint32_t n = __atomic_load_n(&g_ws_rs_tables.count, __ATOMIC_ACQUIRE);
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        const ws_rs_table_t *t = g_ws_rs_tables.tables[i];
+        if (t->up == up && t->down == down && t->taps == taps) return t;
+    }
+    return NULL;
+}
+
+static const ws_rs_table_t *ws_rs_table_build(uint32_t up, uint32_t down, int taps) {
+    const ws_rs_table_t *found;
+    ws_rs_table_t *t = NULL;
+    uint32_t p;
+    int j;
+    double cutoff;
+    const double pi = 3.14159265358979323846;
+
+    pthread_mutex_lock(&g_ws_rs_tables.mutex);
+    found = ws_rs_table_find(up, down, taps);
+    if (found || g_ws_rs_tables.count >= WS_RESAMPLER_TABLES) goto out;
+    t = malloc(sizeof(*t) + (size_t)up * (size_t)taps * sizeof(float));
+    if (!t) goto out;
+    t->up = up;
+    t->down = down;
+    t->taps = taps;
+
+    /* Cut off just below the lower Nyquist so downsampling does not alias. */
+    cutoff = down != 0 && up < down ? (double)up / (double)down : 1.0;
+    cutoff *= taps >= WS_RESAMPLER_TAPS_HIGH ? 0.94 : 0.88;
+
+    for (p = 0; p < up; p++) {
+        float *h = &t->coeffs[(size_t)p * (size_t)taps];
+        double frac = (double)p / (double)up;
+        double sum = 0.0;
+        for (j = 0; j < taps; j++) {
+            double x0 = (double)j - (double)(taps / 2 - 1) - frac;
+            double x = (x0 + (double)taps / 2.0) / (double)taps;
+            double w = 0.42 - 0.5 * cos(2.0 * pi * x) + 0.08 * cos(4.0 * pi * x);
+            double arg = pi * cutoff * x0;
+            double s = fabs(arg) < 1e-9 ? 1.0 : sin(arg) / arg;
+            double v = cutoff * s * w;
+            h[j] = (float)v;
+            sum += v;
+        }
+        if (sum != 0.0) {
+            for (j = 0; j < taps; j++) h[j] = (float)(h[j] / sum);
+        }
+    }
+    g_ws_rs_tables.tables[g_ws_rs_tables.count] = t;
+    __atomic_store_n(&g_ws_rs_tables.count, g_ws_rs_tables.count + 1, __ATOMIC_RELEASE);
+    found = t;
+out:
+    pthread_mutex_unlock(&g_ws_rs_tables.mutex);
+    return found;
+}
+
+/*
+ * Builds the kernel table for a rate pair, plus the generic WS_RESAMPLER_MAX_PHASES
+ * grid attach falls back on. May allocate; call it off the audio thread.
+ */
+static int ws_resampler_prepare(int in_rate, int out_rate, int taps) {
+    uint32_t up = 0;
+    uint32_t down = 0;
+    int r;
+
+    taps = ws_rs_taps(taps);
+    if (!ws_rs_table_find(WS_RESAMPLER_MAX_PHASES, 0, taps) && !ws_rs_table_build(WS_RESAMPLER_MAX_PHASES, 0, taps)) {
+        return -1;
+    }
+    r = ws_rs_ratio(in_rate, out_rate, &up, &down);
+    if (r != 0) return r < 0 ? -1 : 0;
+    if (ws_rs_table_find(up, down, taps)) return 0;
+    return ws_rs_table_build(up, down, taps) ? 0 : -1;
+}
+
+/*
+ * Audio-thread safe: points rs at the prepared table for the pair and resets it.
+ * A pair nobody prepared runs on the generic grid at full bandwidth, with the
+ * ratio rounded to it the way odd ratios are. Returns 0 on success.
+ */
+static int ws_resampler_attach(ws_resampler_t *rs, int in_rate, int out_rate, int taps) {
+    const ws_rs_table_t *t;
+    uint32_t up = 0;
+    uint32_t down = 0;
+    int r;
+
+    if (!rs) return -1;
+    taps = ws_rs_taps(taps);
+    r = ws_rs_ratio(in_rate, out_rate, &up, &down);
+    if (r < 0) return -1;
+    ws_resampler_reset(rs);
+    rs->in_rate = in_rate;
+    rs->out_rate = out_rate;
+    rs->taps = taps;
+    rs->passthrough = r == 1;
+    if (rs->passthrough) return 0;
+
+    t = ws_rs_table_find(up, down, taps);
+    if (!t) {
+        t = ws_rs_table_find(WS_RESAMPLER_MAX_PHASES, 0, taps);
+        if (!t) return -1;
+        down = (uint32_t)(((uint64_t)in_rate * WS_RESAMPLER_MAX_PHASES + (uint64_t)out_rate / 2) / (uint64_t)out_rate);
+        up = WS_RESAMPLER_MAX_PHASES;
+        if (down == 0) return -1;
+    }
+    rs->up = up;
+    rs->down = down;
+    rs->coeffs = t->coeffs;
+    return 0;
+}
+
+/* Prepare and attach in one call, for callers that are not on the audio thread. */
+static int ws_resampler_configure(ws_resampler_t *rs, int in_rate, int out_rate, int taps) {
+    if (ws_resampler_prepare(in_rate, out_rate, taps) != 0) return -1;
+    return ws_resampler_attach(rs, in_rate, out_rate, taps);
+}
+
+static inline void ws_rs_dot2(const float *h, const float *xl, const float *xr, int taps, float *yl, float *yr) {
+#if defined(WS_RESAMPLER_NEON)
+    float32x4_t al = vdupq_n_f32(0.0f);
+    float32x4_t ar = vdupq_n_f32(0.0f);
+    int j;
+    for (j = 0; j < taps; j += 4) {
+        float32x4_t c = vld1q_f32(h + j);
+        al = vfmaq_f32(al, c, vld1q_f32(xl + j));
+        ar = vfmaq_f32(ar, c, vld1q_f32(xr + j));
+    }
+    *yl = vaddvq_f32(al);
+    *yr = vaddvq_f32(ar);
+#else
+    float al[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float ar[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    int j;
+    int k;
+    for (j = 0; j < taps; j += 4) {
+        for (k = 0; k < 4; k++) {
+            al[k] += h[j + k] * xl[j + k];
+            ar[k] += h[j + k] * xr[j + k];
+        }
+    }
+    *yl = (al[0] + al[1]) + (al[2] + al[3]);
+    *yr = (ar[0] + ar[1]) + (ar[2] + ar[3]);
+#endif
+}
+
+static inline int16_t ws_rs_to_s16(float v) {
+    if (v > 32767.0f) return 32767;
+    if (v < -32768.0f) return -32768;
+    return (int16_t)lrintf(v);
+}
+
+/*
+ * Output frames between an input frame and its centred image in the output,
+ * i.e. output frame n reflects input time (n - latency) / out_rate. Callers
+ * that splice in audio resampled elsewhere shift it by this much.
+ */
+static uint32_t ws_resampler_latency_frames(const ws_resampler_t *rs) {
+    uint64_t in_frames;
+    if (!rs || rs->passthrough || rs->in_rate <= 0) return 0;
+    in_frames = (uint64_t)(rs->taps / 2 + 1);
+    return (uint32_t)((in_frames * (uint64_t)rs->out_rate * 2ULL + (uint64_t)rs->in_rate) / ((uint64_t)rs->in_rate * 2ULL));
+}
+
+/*
+ * Converts up to in_frames input frames into at most out_cap output frames.
+ * *consumed receives the number of input frames used; returns frames written.
+ */
+static size_t ws_resampler_process(ws_resampler_t *rs,
+                                   const int16_t *in,
+                                   size_t in_frames,
+                                   int16_t *out,
+                                   size_t out_cap,
+                                   size_t *consumed) {
+    size_t used = 0;
+    size_t made = 0;
+    int taps;
+
+    if (consumed) *consumed = 0;
+    if (!rs || !in || !out) return 0;
+
+    if (rs->passthrough) {
+        size_t n = in_frames < out_cap ? in_frames : out_cap;
+        memcpy(out, in, n * 2 * sizeof(int16_t));
+        if (consumed) *consumed = n;
+        return n;
+    }
+
+    taps = rs->taps;
+    while (made < out_cap) {
+        const float *h;
+        float yl;
+        float yr;
+
+        while (rs->advance > 0) {
+            uint32_t w;
+            if (used >= in_frames) goto done;
+            w = rs->hist_pos;
+            rs->hist_l[w] = rs->hist_l[w + (uint32_t)taps] = (float)in[used * 2];
+            rs->hist_r[w] = rs->hist_r[w + (uint32_t)taps] = (float)in[used * 2 + 1];
+            rs->hist_pos = (w + 1U) % (uint32_t)taps;
+            rs->advance--;
+            used++;
+        }
+
+        h = &rs->coeffs[(size_t)rs->phase * (size_t)taps];
+        ws_rs_dot2(h, &rs->hist_l[rs->hist_pos], &rs->hist_r[rs->hist_pos], taps, &yl, &yr);
+        out[made * 2] = ws_rs_to_s16(yl);
+        out[made * 2 + 1] = ws_rs_to_s16(yr);
+        made++;
+
+        rs->phase += rs->down;
+        rs->advance = rs->phase / rs->up;
+        rs->phase %= rs->up;
+    }
+
+done:
+    if (consumed) *consumed = used;
+    return made;
+}
+
+#endif
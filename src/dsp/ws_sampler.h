@@ -0,0 +1,246 @@
+#ifndef WS_SAMPLER_H
+#define WS_SAMPLER_H
+
+/*
+ * One-shot pad sampler over a caller-owned pool of interleaved s16 stereo.
+ *
+ * Slots are regions of the pool, placed first-fit so a recapture can reuse
+ * the gap a cleared slot leaves. Notes cross from on_midi to the render
+ * thread through a single-producer ring stamped with their arrival time.
+ * Each block starts the events that arrived during the previous block at the
+ * same relative offset inside this one. Every trigger therefore sounds one
+ * block after it arrived, and the spacing between triggers is kept to the
+ * sample. A note takes the voice already playing its slot, then a free
+ * voice, then the oldest voice; a taken voice fades out over
+ * WS_SMP_STEAL_FRAMES instead of clicking.
+ *
+ * Nothing here allocates. Everything except ws_smp_post runs on the render
+ * thread.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ws_mixer.h"
+
+#define WS_SMP_SLOTS 16
+#define WS_SMP_VOICES 8
+#define WS_SMP_EVENTS 64            /* power of two */
+#define WS_SMP_STEAL_FRAMES 32
+#define WS_SMP_DEFAULT_BASE_NOTE 36
+
+typedef struct {
+    size_t off;                     /* frames into the pool */
+    size_t len;                     /* frames reserved; 0 = empty */
+    bool ready;                     /* audio copied in; triggers play it */
+    int32_t gain_q13;               /* atomic; written by set_param */
+} ws_smp_slot_t;
+
+typedef struct {
+    int slot;                       /* -1 = free */
+    size_t pos;                     /* next frame of the slot */
+    int32_t gain_q13;               /* slot gain scaled by velocity */
+    int start;                      /* first frame it sounds in this block */
+    uint64_t serial;                /* trigger order, for stealing the oldest */
+} ws_smp_voice_t;
+
+typedef struct {
+    uint64_t at_us;
+    uint8_t msg[3];
+} ws_smp_event_t;
+
+typedef struct {
+    int16_t *pool;
+    size_t pool_frames;
+    ws_smp_slot_t slots[WS_SMP_SLOTS];
+    ws_smp_voice_t voices[WS_SMP_VOICES];
+    uint64_t serial;
+    uint64_t last_block_us;         /* start of the previous block; 0 before the first */
+    int base_note;                  /* atomic; slot i plays on base_note + i */
+
+    /* on_midi -> render thread. */
+    ws_smp_event_t events[WS_SMP_EVENTS];
+    uint32_t head;                  /* atomic; advanced by ws_smp_post */
+    uint32_t tail;                  /* atomic; advanced by ws_smp_render */
+
+    /* Counters, read lock-free by stats. */
+    uint64_t triggers;
+    uint64_t steals;
+    uint64_t dropped;
+} ws_sampler_t;
+
+static inline void ws_smp_init(ws_sampler_t *s, int16_t *pool, size_t pool_frames) {
+    int i;
+
+    memset(s, 0, sizeof(*s));
+    s->pool = pool;
+    s->pool_frames = pool_frames;
+    s->base_note = WS_SMP_DEFAULT_BASE_NOTE;
+    for (i = 0; i < WS_SMP_SLOTS; i++) s->slots[i].gain_q13 = WS_MIX_UNITY;
+    for (i = 0; i < WS_SMP_VOICES; i++) s->voices[i].slot = -1;
+}
+
+/* Lowest pool offset with room for frames outside every other slot; (size_t)-1 if none. */
+static size_t ws_smp_place(const ws_sampler_t *s, int slot, size_t frames) {
+    size_t at = 0;
+    int j = 0;
+
+    while (j < WS_SMP_SLOTS) {
+        const ws_smp_slot_t *o = &s->slots[j];
+        if (j != slot && o->len > 0 && at < o->off + o->len && o->off < at + frames) {
+            at = o->off + o->len;
+            j = 0;
+            continue;
+        }
+        j++;
+    }
+    return at + frames <= s->pool_frames ? at : (size_t)-1;
+}
+
+/* Silences the slot's voices and frees its region. */
+static void ws_smp_release(ws_sampler_t *s, int slot) {
+    int i;
+
+    for (i = 0; i < WS_SMP_VOICES; i++) {
+        if (s->voices[i].slot == slot) s->voices[i].slot = -1;
+    }
+    s->slots[slot].len = 0;
+    s->slots[slot].ready = false;
+}
+
+/* on_midi: queues a note on/off or controller; false when it is not one or the queue is full. */
+static inline bool ws_smp_post(ws_sampler_t *s, const uint8_t *msg, int len, uint64_t at_us) {
+    uint32_t head = __atomic_load_n(&s->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&s->tail, __ATOMIC_ACQUIRE);
+    ws_smp_event_t *ev;
+    uint8_t status;
+
+    if (!msg || len < 3) return false;
+    status = (uint8_t)(msg[0] & 0xF0);
+    if (status != 0x80 && status != 0x90 && status != 0xB0) return false;
+    if (head - tail >= WS_SMP_EVENTS) {
+        __atomic_fetch_add(&s->dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    ev = &s->events[head & (WS_SMP_EVENTS - 1)];
+    ev->at_us = at_us;
+    memcpy(ev->msg, msg, 3);
+    __atomic_store_n(&s->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* Mixes frames [from, to) of the block from the voice's slot; returns how many it had left. */
+static size_t ws_smp_voice_mix(ws_sampler_t *s, ws_smp_voice_t *v, int16_t *bus, int from, int to) {
+    const ws_smp_slot_t *slot = &s->slots[v->slot];
+    size_t left = slot->len - v->pos;
+    size_t n = (size_t)(to - from) < left ? (size_t)(to - from) : left;
+
+    ws_mix_add(bus + (size_t)from * 2, s->pool + (slot->off + v->pos) * 2, n * 2, v->gain_q13);
+    v->pos += n;
+    return n;
+}
+
+/* Ends a sounding voice at frame at: plays it up to there, then ramps it out. */
+static void ws_smp_cut(ws_sampler_t *s, ws_smp_voice_t *v, int16_t *bus, int frames, int at) {
+    const ws_smp_slot_t *slot;
+    const int16_t *src;
+    size_t left;
+    int n;
+    int i;
+
+    if (v->slot < 0) return;
+    if (at > v->start) ws_smp_voice_mix(s, v, bus, v->start, at);
+    slot = &s->slots[v->slot];
+    left = slot->len - v->pos;
+    n = frames - at < WS_SMP_STEAL_FRAMES ? frames - at : WS_SMP_STEAL_FRAMES;
+    if ((size_t)n > left) n = (int)left;
+    src = s->pool + (slot->off + v->pos) * 2;
+    for (i = 0; i < n; i++) {
+        int32_t g = v->gain_q13 * (WS_SMP_STEAL_FRAMES - i) / WS_SMP_STEAL_FRAMES;
+        int16_t *b = bus + (size_t)(at + i) * 2;
+        b[0] = ws_mix_sat((int32_t)b[0] + ws_mix_sat(((int32_t)src[i * 2] * g + (1 << (WS_MIX_GAIN_SHIFT - 1))) >> WS_MIX_GAIN_SHIFT));
+        b[1] = ws_mix_sat((int32_t)b[1] + ws_mix_sat(((int32_t)src[i * 2 + 1] * g + (1 << (WS_MIX_GAIN_SHIFT - 1))) >> WS_MIX_GAIN_SHIFT));
+    }
+    v->slot = -1;
+}
+
+/* Starts slot at frame at of the current block with a velocity-scaled gain. */
+static void ws_smp_trigger(ws_sampler_t *s, int16_t *bus, int frames, int slot, int velocity, int at) {
+    ws_smp_voice_t *v = NULL;
+    int32_t gain = __atomic_load_n(&s->slots[slot].gain_q13, __ATOMIC_RELAXED);
+    int i;
+
+    for (i = 0; i < WS_SMP_VOICES && !v; i++) {
+        if (s->voices[i].slot == slot) v = &s->voices[i];
+    }
+    for (i = 0; i < WS_SMP_VOICES && !v; i++) {
+        if (s->voices[i].slot < 0) v = &s->voices[i];
+    }
+    if (!v) {
+        v = &s->voices[0];
+        for (i = 1; i < WS_SMP_VOICES; i++) {
+            if (s->voices[i].serial < v->serial) v = &s->voices[i];
+        }
+        __atomic_fetch_add(&s->steals, 1, __ATOMIC_RELAXED);
+    }
+    ws_smp_cut(s, v, bus, frames, at);
+    v->slot = slot;
+    v->pos = 0;
+    v->gain_q13 = (int32_t)((int64_t)gain * velocity / 127);
+    v->start = at;
+    v->serial = ++s->serial;
+    __atomic_fetch_add(&s->triggers, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * Render thread: applies the events that arrived before now_us, then mixes
+ * every sounding voice into bus. Returns the number of voices still sounding.
+ */
+static int ws_smp_render(ws_sampler_t *s, int16_t *bus, int frames, uint64_t now_us) {
+    uint32_t tail = __atomic_load_n(&s->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&s->head, __ATOMIC_ACQUIRE);
+    uint64_t span = s->last_block_us && now_us > s->last_block_us ? now_us - s->last_block_us : 0;
+    int base = __atomic_load_n(&s->base_note, __ATOMIC_RELAXED);
+    int active = 0;
+    int i;
+
+    for (; tail != head; tail++) {
+        const ws_smp_event_t *ev = &s->events[tail & (WS_SMP_EVENTS - 1)];
+        uint8_t status = (uint8_t)(ev->msg[0] & 0xF0);
+        int at = 0;
+
+        if (ev->at_us > now_us) break;
+        if (span > 0 && ev->at_us > s->last_block_us) {
+            at = (int)((ev->at_us - s->last_block_us) * (uint64_t)frames / span);
+            if (at >= frames) at = frames - 1;
+        }
+        if (status == 0x90 && ev->msg[2] > 0) {
+            int slot = (int)ev->msg[1] - base;
+            if (slot >= 0 && slot < WS_SMP_SLOTS && s->slots[slot].ready) {
+                ws_smp_trigger(s, bus, frames, slot, ev->msg[2], at);
+            }
+        } else if (status == 0xB0 && (ev->msg[1] == 120 || ev->msg[1] == 123)) {
+            /* All sound off / all notes off; plain note offs leave one-shots ringing. */
+            for (i = 0; i < WS_SMP_VOICES; i++) ws_smp_cut(s, &s->voices[i], bus, frames, at);
+        }
+    }
+    __atomic_store_n(&s->tail, tail, __ATOMIC_RELEASE);
+    s->last_block_us = now_us;
+
+    for (i = 0; i < WS_SMP_VOICES; i++) {
+        ws_smp_voice_t *v = &s->voices[i];
+        if (v->slot < 0) continue;
+        ws_smp_voice_mix(s, v, bus, v->start, frames);
+        v->start = 0;
+        if (v->pos >= s->slots[v->slot].len) {
+            v->slot = -1;
+        } else {
+            active++;
+        }
+    }
+    return active;
+}
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef WS_SCHED_H
+#define WS_SCHED_H
+
+/*
+ * Scheduling policy for helper children (decoder pipelines, probes, the
+ * daemon) and for the plugin's own background threads.
+ *
+ * A child policy is parsed from a short spec such as
+ * "nice=10 policy=batch cpus=auto ioprio=be7" and applied in the child
+ * between fork() and exec(). That matters most when the render thread
+ * itself forks a decoder: without it the child would inherit the host's
+ * real-time audio priority. cpus=auto keeps children off the core the render
+ * thread was last seen on, when there is more than one core. Every step is
+ * best effort; a kernel or container that refuses one still gets the rest.
+ * "off" leaves children with the spawning thread's settings.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define WS_SCHED_SPEC_MAX 96
+#define WS_SCHED_NICE_KEEP 100
+#define WS_SCHED_POLICY_KEEP (-1)
+#define WS_SCHED_MAX_CPUS 64
+#define WS_SCHED_DEFAULT "nice=10 policy=batch cpus=auto ioprio=off"
+
+#ifndef SCHED_BATCH
+#define SCHED_BATCH 3
+#endif
+#ifndef SCHED_IDLE
+#define SCHED_IDLE 5
+#endif
+
+#define WS_IOPRIO_CLASS_SHIFT 13
+#define WS_IOPRIO_CLASS_BE 2
+#define WS_IOPRIO_CLASS_IDLE 3
+
+typedef struct {
+    bool enabled;
+    int nice;               /* -20..19, or WS_SCHED_NICE_KEEP */
+    int policy;             /* SCHED_OTHER/BATCH/IDLE, or WS_SCHED_POLICY_KEEP */
+    bool cpus_auto;         /* every allowed core but the audio core */
+    uint64_t cpus;          /* explicit core mask; 0 with !cpus_auto = unchanged */
+    int ioprio;             /* ioprio_set() value, 0 = unchanged */
+} ws_sched_policy_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    ws_sched_policy_t child;
+    int audio_cpu;          /* last core render ran on, -1 until seen; atomic */
+    uint64_t isolated;      /* children spawned with a policy; atomic */
+} ws_sched_t;
+
+static ws_sched_t g_sched = {
+    PTHREAD_MUTEX_INITIALIZER,
+    { true, 10, SCHED_BATCH, true, 0, 0 },
+    -1,
+    0,
+};
+
+static int ws_sched_parse_cpus(const char *s, uint64_t *mask) {
+    uint64_t m = 0;
+
+    while (*s) {
+        char *end;
+        long lo = strtol(s, &end, 10);
+        long hi = lo;
+        if (end == s || lo < 0 || lo >= WS_SCHED_MAX_CPUS) return -1;
+        s = end;
+        if (*s == '-') {
+            hi = strtol(s + 1, &end, 10);
+            if (end == s + 1 || hi < lo || hi >= WS_SCHED_MAX_CPUS) return -1;
+            s = end;
+        }
+        for (; lo <= hi; lo++) m |= 1ULL << lo;
+        if (*s == ',') s++;
+        else if (*s) return -1;
+    }
+    if (m == 0) return -1;
+    *mask = m;
+    return 0;
+}
+
+/* Fills *out from spec; returns -1 (and leaves *out alone) on any unknown token. */
+static int ws_sched_parse(const char *spec, ws_sched_policy_t *out) {
+    ws_sched_policy_t p = { true, WS_SCHED_NICE_KEEP, WS_SCHED_POLICY_KEEP, false, 0, 0 };
+    char buf[WS_SCHED_SPEC_MAX];
+    char *save = NULL;
+    char *tok;
+
+    if (!spec || !out) return -1;
+    snprintf(buf, sizeof(buf), "%s", spec);
+    for (tok = strtok_r(buf, " \t", &save); tok; tok = strtok_r(NULL, " \t", &save)) {
+        const char *v = strchr(tok, '=');
+        char *end;
+
+        if (strcmp(tok, "off") == 0) {
+            p.enabled = false;
+            continue;
+        }
+        if (!v) return -1;
+        v++;
+        if (strncmp(tok, "nice=", 5) == 0) {
+            long n = strtol(v, &end, 10);
+            if (end == v || *end || n < -20 || n > 19) return -1;
+            p.nice = (int)n;
+        } else if (strncmp(tok, "policy=", 7) == 0) {
+            if (strcmp(v, "other") == 0) p.policy = SCHED_OTHER;
+            else if (strcmp(v, "batch") == 0) p.policy = SCHED_BATCH;
+            else if (strcmp(v, "idle") == 0) p.policy = SCHED_IDLE;
+            else if (strcmp(v, "keep") == 0) p.policy = WS_SCHED_POLICY_KEEP;
+            else return -1;
+        } else if (strncmp(tok, "cpus=", 5) == 0) {
+            p.cpus_auto = strcmp(v, "auto") == 0;
+            p.cpus = 0;
+            if (!p.cpus_auto && strcmp(v, "all") != 0 && ws_sched_parse_cpus(v, &p.cpus) != 0) return -1;
+        } else if (strncmp(tok, "ioprio=", 7) == 0) {
+            if (strcmp(v, "off") == 0) {
+                p.ioprio = 0;
+            } else if (strcmp(v, "idle") == 0) {
+                p.ioprio = WS_IOPRIO_CLASS_IDLE << WS_IOPRIO_CLASS_SHIFT;
+            } else if (strncmp(v, "be", 2) == 0 && v[2] >= '0' && v[2] <= '7' && v[3] == '\0') {
+                p.ioprio = (WS_IOPRIO_CLASS_BE << WS_IOPRIO_CLASS_SHIFT) | (v[2] - '0');
+            } else {
+                return -1;
+            }
+        } else {
+            return -1;
+        }
+    }
+    *out = p;
+    return 0;
+}
+
+static int ws_sched_format(const ws_sched_policy_t *p, char *buf, size_t len) {
+    char nice[16];
+    char cpus[48];
+    char io[8];
+    const char *policy = "keep";
+    int i;
+
+    if (!p->enabled) return snprintf(buf, len, "off");
+    if (p->nice == WS_SCHED_NICE_KEEP) snprintf(nice, sizeof(nice), "keep");
+    else snprintf(nice, sizeof(nice), "%d", p->nice);
+    if (p->policy == SCHED_OTHER) policy = "other";
+    else if (p->policy == SCHED_BATCH) policy = "batch";
+    else if (p->policy == SCHED_IDLE) policy = "idle";
+    if (p->cpus_auto) {
+        snprintf(cpus, sizeof(cpus), "auto");
+    } else if (p->cpus == 0) {
+        snprintf(cpus, sizeof(cpus), "all");
+    } else {
+        size_t used = 0;
+        cpus[0] = '\0';
+        for (i = 0; i < WS_SCHED_MAX_CPUS && used < sizeof(cpus); i++) {
+            int j = i;
+            if (!(p->cpus & (1ULL << i))) continue;
+            while (j + 1 < WS_SCHED_MAX_CPUS && (p->cpus & (1ULL << (j + 1)))) j++;
+            if (j > i) used += (size_t)snprintf(cpus + used, sizeof(cpus) - used, "%s%d-%d", used ? "," : "", i, j);
+            else used += (size_t)snprintf(cpus + used, sizeof(cpus) - used, "%s%d", used ? "," : "", i);
+            i = j;
+        }
+    }
+    if (p->ioprio == 0) snprintf(io, sizeof(io), "off");
+    else if ((p->ioprio >> WS_IOPRIO_CLASS_SHIFT) == WS_IOPRIO_CLASS_IDLE) snprintf(io, sizeof(io), "idle");
+    else snprintf(io, sizeof(io), "be%d", p->ioprio & 7);
+    if (p->nice == WS_SCHED_NICE_KEEP && p->policy == WS_SCHED_POLICY_KEEP && !p->cpus_auto && p->cpus == 0 && p->ioprio == 0) {
+        return snprintf(buf, len, "off");
+    }
+    return snprintf(buf, len, "nice=%s policy=%s cpus=%s ioprio=%s", nice, policy, cpus, io);
+}
+
+/* Render thread, every so often: remembers which core the audio runs on. */
+static void ws_sched_note_audio_cpu(void) {
+    int cpu = sched_getcpu();
+    if (cpu >= 0) __atomic_store_n(&g_sched.audio_cpu, cpu, __ATOMIC_RELAXED);
+}
+
+/*
+ * Parent side, before fork(): snapshots the child policy and works out the
+ * affinity mask, so the child only makes syscalls. Returns false for "off".
+ */
+static bool ws_sched_prepare(ws_sched_policy_t *p, cpu_set_t *mask, bool *has_mask) {
+    int audio_cpu;
+    int i;
+
+    pthread_mutex_lock(&g_sched.mutex);
+    *p = g_sched.child;
+    pthread_mutex_unlock(&g_sched.mutex);
+    *has_mask = false;
+    if (!p->enabled) return false;
+
+    if (p->cpus_auto) {
+        audio_cpu = __atomic_load_n(&g_sched.audio_cpu, __ATOMIC_RELAXED);
+        if (audio_cpu >= 0 && audio_cpu < CPU_SETSIZE && sched_getaffinity(0, sizeof(*mask), mask) == 0 &&
+            CPU_ISSET(audio_cpu, mask) && CPU_COUNT(mask) > 1) {
+            CPU_CLR(audio_cpu, mask);
+            *has_mask = true;
+        }
+    } else if (p->cpus != 0) {
+        CPU_ZERO(mask);
+        for (i = 0; i < WS_SCHED_MAX_CPUS; i++) {
+            if (p->cpus & (1ULL << i)) CPU_SET(i, mask);
+        }
+        *has_mask = true;
+    }
+    __atomic_fetch_add(&g_sched.isolated, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+/* Child side, between fork() and exec(): syscalls only, failures ignored. */
+static void ws_sched_apply_child(const ws_sched_policy_t *p, const cpu_set_t *mask) {
+    struct sched_param sp;
+
+    if (!p->enabled) return;
+    sp.sched_priority = 0;
+    /* Also drops an inherited SCHED_FIFO/RR when the render thread forked us. */
+    if (p->policy != WS_SCHED_POLICY_KEEP) (void)sched_setscheduler(0, p->policy, &sp);
+    if (p->nice != WS_SCHED_NICE_KEEP) (void)setpriority(PRIO_PROCESS, 0, p->nice);
+    if (mask) (void)sched_setaffinity(0, sizeof(*mask), mask);
+#ifdef SYS_ioprio_set
+    if (p->ioprio != 0) (void)syscall(SYS_ioprio_set, 1 /* IOPRIO_WHO_PROCESS */, 0, p->ioprio);
+#endif
+}
+
+/* For the calling thread only (Linux nice is per thread). */
+static void ws_sched_self(int nice, int policy) {
+    struct sched_param sp;
+
+    sp.sched_priority = 0;
+    if (policy != WS_SCHED_POLICY_KEEP) (void)pthread_setschedparam(pthread_self(), policy, &sp);
+    if (nice != WS_SCHED_NICE_KEEP) (void)setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice);
+}
+
+#endif
@@ -0,0 +1,319 @@
+#ifndef WS_SHCACHE_H
+#define WS_SHCACHE_H
+
+/*
+ * Search/resolve result cache in a shared memory segment.
+ *
+ * One file under /dev/shm is mapped by every instance of the module, in
+ * this process and any other, and outlives instance destroy/create and
+ * module reloads (tmpfs, so not reboots). The segment is a fixed
+ * open-addressed table: an entry lives in one of WS_SHC_PROBE slots after
+ * its hash, and a store into a full window evicts the oldest of them.
+ *
+ * Every slot is its own seqlock. A writer claims a slot by moving seq from
+ * even to odd with a CAS (a busy slot is skipped, not waited for: the cache
+ * is best effort) and publishes by making it even again. Readers copy the
+ * slot word by word with atomic loads and retry a bounded number of times
+ * if seq moved, so neither side ever blocks and no lock is shared between
+ * processes. An all-zero segment is a valid empty table.
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define WS_SHC_MAGIC 0x31435357u        /* "WSC1" */
+#define WS_SHC_MAGIC_INIT 0x69435357u   /* "WSCi": the creator is still stamping the layout */
+#define WS_SHC_INIT_WAIT_MS 100
+#define WS_SHC_VERSION 1U
+#define WS_SHC_ENTRIES 128              /* power of two */
+#define WS_SHC_PROBE 8
+#define WS_SHC_KEY_MAX 512
+#define WS_SHC_VAL_MAX 6144
+#define WS_SHC_KINDS 2
+#define WS_SHC_READ_TRIES 16
+
+typedef struct {
+    uint32_t seq;                       /* odd while a store is in progress */
+    uint32_t kind;
+    uint64_t hash;                      /* 0 = empty */
+    uint64_t stored_ms;                 /* wall clock, comparable across processes */
+    uint32_t key_len;
+    uint32_t val_len;
+    uint64_t key[WS_SHC_KEY_MAX / 8];
+    uint64_t val[WS_SHC_VAL_MAX / 8];
+} ws_shc_entry_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entries;
+    uint32_t entry_size;
+    /* Cumulative for the segment, across every instance and process that used it. */
+    uint64_t hits[WS_SHC_KINDS];
+    uint64_t misses[WS_SHC_KINDS];
+    uint64_t stores[WS_SHC_KINDS];
+    uint64_t evictions;
+    ws_shc_entry_t slot[WS_SHC_ENTRIES];
+} ws_shc_segment_t;
+
+typedef struct {
+    pthread_mutex_t mutex;              /* acquire/release only */
+    int refs;
+    ws_shc_segment_t *seg;
+    bool shared;                        /* false: process-private fallback mapping */
+} ws_shc_t;
+
+static ws_shc_t g_shcache = { PTHREAD_MUTEX_INITIALIZER, 0, NULL, false };
+
+static inline uint64_t ws_shc_hash(uint32_t kind, const char *key, size_t len) {
+    uint64_t h = 14695981039346656037ULL ^ kind;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 1099511628211ULL;
+    }
+    return h ? h : 1;
+}
+
+static inline void ws_shc_store_words(uint64_t *dst, const void *src, size_t len) {
+    size_t i;
+    for (i = 0; i < (len + 7) / 8; i++) {
+        uint64_t w = 0;
+        memcpy(&w, (const char *)src + i * 8, len - i * 8 < 8 ? len - i * 8 : 8);
+        __atomic_store_n(&dst[i], w, __ATOMIC_RELAXED);
+    }
+}
+
+static inline void ws_shc_load_words(uint64_t *dst, const uint64_t *src, size_t len) {
+    size_t i;
+    for (i = 0; i < (len + 7) / 8; i++) dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+}
+
+static inline bool ws_shc_claim(ws_shc_entry_t *e, uint32_t *seq) {
+    *seq = __atomic_load_n(&e->seq, __ATOMIC_RELAXED);
+    if (*seq & 1U) return false;
+    if (!__atomic_compare_exchange_n(&e->seq, seq, *seq + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) return false;
+    return true;
+}
+
+static inline void ws_shc_publish(ws_shc_entry_t *e, uint32_t seq) {
+    __atomic_store_n(&e->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/*
+ * Copies the value stored under (kind, key) into val (NUL-terminated) if it
+ * is younger than max_age_ms. Returns its length, or -1 on a miss.
+ */
+static int ws_shc_get(ws_shc_segment_t *seg, uint32_t kind, const char *key,
+                      uint64_t max_age_ms, uint64_t now_ms, char *val, size_t val_len) {
+    uint64_t key_words[WS_SHC_KEY_MAX / 8];
+    uint64_t val_words[WS_SHC_VAL_MAX / 8];
+    size_t len = strlen(key);
+    uint64_t hash;
+    int p;
+
+    if (!seg || kind >= WS_SHC_KINDS) return -1;
+    if (len > WS_SHC_KEY_MAX || val_len == 0) goto miss;
+    hash = ws_shc_hash(kind, key, len);
+    for (p = 0; p < WS_SHC_PROBE; p++) {
+        ws_shc_entry_t *e = &seg->slot[(hash + (uint64_t)p) & (WS_SHC_ENTRIES - 1)];
+        int tries;
+
+        if (__atomic_load_n(&e->hash, __ATOMIC_RELAXED) != hash) continue;
+        for (tries = 0; tries < WS_SHC_READ_TRIES; tries++) {
+            uint32_t seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+            uint32_t got_kind;
+            uint32_t key_len;
+            uint32_t got_len;
+            uint64_t stored;
+            bool same;
+
+            if (seq & 1U) continue;
+            got_kind = __atomic_load_n(&e->kind, __ATOMIC_RELAXED);
+            key_len = __atomic_load_n(&e->key_len, __ATOMIC_RELAXED);
+            got_len = __atomic_load_n(&e->val_len, __ATOMIC_RELAXED);
+            stored = __atomic_load_n(&e->stored_ms, __ATOMIC_RELAXED);
+            same = got_kind == kind && key_len == len && __atomic_load_n(&e->hash, __ATOMIC_RELAXED) == hash &&
+                   got_len <= WS_SHC_VAL_MAX;
+            if (same) {
+                ws_shc_load_words(key_words, e->key, len);
+                ws_shc_load_words(val_words, e->val, got_len);
+            }
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&e->seq, __ATOMIC_RELAXED) != seq) continue;
+            if (!same || memcmp(key_words, key, len) != 0) break;
+            if (now_ms - stored > max_age_ms || got_len + 1 > val_len) goto miss;
+            memcpy(val, val_words, got_len);
+            val[got_len] = '\0';
+            __atomic_fetch_add(&seg->hits[kind], 1, __ATOMIC_RELAXED);
+            return (int)got_len;
+        }
+    }
+miss:
+    __atomic_fetch_add(&seg->misses[kind], 1, __ATOMIC_RELAXED);
+    return -1;
+}
+
+/* Stores val under (kind, key), replacing an older copy; silently skipped if it does not fit or its slot is busy. */
+static void ws_shc_put(ws_shc_segment_t *seg, uint32_t kind, const char *key, const char *val, size_t val_len, uint64_t now_ms) {
+    size_t len = strlen(key);
+    ws_shc_entry_t *victim = NULL;
+    uint64_t hash;
+    uint64_t old;
+    uint32_t seq;
+    int p;
+
+    if (!seg || kind >= WS_SHC_KINDS || len > WS_SHC_KEY_MAX || val_len > WS_SHC_VAL_MAX) return;
+    hash = ws_shc_hash(kind, key, len);
+    for (p = 0; p < WS_SHC_PROBE; p++) {
+        ws_shc_entry_t *e = &seg->slot[(hash + (uint64_t)p) & (WS_SHC_ENTRIES - 1)];
+        uint64_t h = __atomic_load_n(&e->hash, __ATOMIC_RELAXED);
+
+        if (h == hash) {
+            victim = e;
+            break;
+        }
+        if (h == 0) {
+            if (!victim || __atomic_load_n(&victim->hash, __ATOMIC_RELAXED) != 0) victim = e;
+        } else if (!victim || (__atomic_load_n(&victim->hash, __ATOMIC_RELAXED) != 0 &&
+                               __atomic_load_n(&e->stored_ms, __ATOMIC_RELAXED) <
+                                   __atomic_load_n(&victim->stored_ms, __ATOMIC_RELAXED))) {
+            victim = e;
+        }
+    }
+    if (!victim || !ws_shc_claim(victim, &seq)) return;
+
+    old = __atomic_load_n(&victim->hash, __ATOMIC_RELAXED);
+    if (old != 0 && old != hash) __atomic_fetch_add(&seg->evictions, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&victim->kind, kind, __ATOMIC_RELAXED);
+    __atomic_store_n(&victim->key_len, (uint32_t)len, __ATOMIC_RELAXED);
+    __atomic_store_n(&victim->val_len, (uint32_t)val_len, __ATOMIC_RELAXED);
+    __atomic_store_n(&victim->stored_ms, now_ms, __ATOMIC_RELAXED);
+    ws_shc_store_words(victim->key, key, len);
+    ws_shc_store_words(victim->val, val, val_len);
+    __atomic_store_n(&victim->hash, hash, __ATOMIC_RELAXED);
+    ws_shc_publish(victim, seq);
+    __atomic_fetch_add(&seg->stores[kind], 1, __ATOMIC_RELAXED);
+}
+
+/* Forgets (kind, key), e.g. a resolved URL that turned out to be dead. */
+static void ws_shc_drop(ws_shc_segment_t *seg, uint32_t kind, const char *key) {
+    size_t len = strlen(key);
+    uint64_t hash;
+    int p;
+
+    if (!seg || kind >= WS_SHC_KINDS || len > WS_SHC_KEY_MAX) return;
+    hash = ws_shc_hash(kind, key, len);
+    for (p = 0; p < WS_SHC_PROBE; p++) {
+        ws_shc_entry_t *e = &seg->slot[(hash + (uint64_t)p) & (WS_SHC_ENTRIES - 1)];
+        uint32_t seq;
+
+        if (__atomic_load_n(&e->hash, __ATOMIC_RELAXED) != hash || !ws_shc_claim(e, &seq)) continue;
+        if (__atomic_load_n(&e->hash, __ATOMIC_RELAXED) == hash) __atomic_store_n(&e->hash, 0, __ATOMIC_RELAXED);
+        ws_shc_publish(e, seq);
+    }
+}
+
+/*
+ * Empties every slot and resets the counters. A slot left odd by a writer
+ * that died mid-store is forced back to even, so this also recovers those.
+ */
+static void ws_shc_clear(ws_shc_segment_t *seg) {
+    int i;
+
+    if (!seg) return;
+    for (i = 0; i < WS_SHC_ENTRIES; i++) {
+        ws_shc_entry_t *e = &seg->slot[i];
+        uint32_t seq = __atomic_load_n(&e->seq, __ATOMIC_RELAXED) | 1U;
+
+        __atomic_store_n(&e->seq, seq, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&e->hash, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&e->seq, seq + 1, __ATOMIC_RELEASE);
+    }
+    for (i = 0; i < WS_SHC_KINDS; i++) {
+        __atomic_store_n(&seg->hits[i], 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&seg->misses[i], 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&seg->stores[i], 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&seg->evictions, 0, __ATOMIC_RELAXED);
+}
+
+/*
+ * Maps path (created if missing); NULL if it cannot be used, e.g. no /dev/shm
+ * or a foreign layout left by another build. Only the process that claims a
+ * zeroed file stamps the layout; everyone else checks it.
+ */
+static ws_shc_segment_t *ws_shc_map_file(const char *path) {
+    ws_shc_segment_t *seg;
+    struct stat st;
+    uint32_t expected = 0;
+    uint32_t magic;
+    int waited = 0;
+    int fd;
+
+    if (!path || !path[0]) return NULL;
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) return NULL;
+    /* Only a just-created (empty) file is grown; a shorter existing one is some other layout. */
+    if (fstat(fd, &st) != 0 || (st.st_size != 0 && (size_t)st.st_size < sizeof(*seg)) ||
+        (st.st_size == 0 && ftruncate(fd, (off_t)sizeof(*seg)) != 0)) {
+        close(fd);
+        return NULL;
+    }
+    seg = mmap(NULL, sizeof(*seg), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED) return NULL;
+
+    if (__atomic_compare_exchange_n(&seg->magic, &expected, WS_SHC_MAGIC_INIT, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&seg->version, WS_SHC_VERSION, __ATOMIC_RELAXED);
+        __atomic_store_n(&seg->entries, (uint32_t)WS_SHC_ENTRIES, __ATOMIC_RELAXED);
+        __atomic_store_n(&seg->entry_size, (uint32_t)sizeof(ws_shc_entry_t), __ATOMIC_RELAXED);
+        __atomic_store_n(&seg->magic, WS_SHC_MAGIC, __ATOMIC_RELEASE);
+        return seg;
+    }
+    while ((magic = __atomic_load_n(&seg->magic, __ATOMIC_ACQUIRE)) == WS_SHC_MAGIC_INIT && waited++ < WS_SHC_INIT_WAIT_MS) {
+        usleep(1000);
+    }
+    if (magic != WS_SHC_MAGIC || __atomic_load_n(&seg->version, __ATOMIC_RELAXED) != WS_SHC_VERSION ||
+        __atomic_load_n(&seg->entries, __ATOMIC_RELAXED) != (uint32_t)WS_SHC_ENTRIES ||
+        __atomic_load_n(&seg->entry_size, __ATOMIC_RELAXED) != (uint32_t)sizeof(ws_shc_entry_t)) {
+        munmap(seg, sizeof(*seg));
+        return NULL;
+    }
+    return seg;
+}
+
+/* Called from create_instance; the first reference maps the segment, falling back to process-private memory. */
+static void ws_shc_acquire(const char *path) {
+    pthread_mutex_lock(&g_shcache.mutex);
+    if (g_shcache.refs++ == 0) {
+        g_shcache.seg = ws_shc_map_file(path);
+        g_shcache.shared = g_shcache.seg != NULL;
+        if (!g_shcache.seg) {
+            void *mem = mmap(NULL, sizeof(ws_shc_segment_t), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            g_shcache.seg = mem == MAP_FAILED ? NULL : (ws_shc_segment_t *)mem;
+        }
+    }
+    pthread_mutex_unlock(&g_shcache.mutex);
+}
+
+/* Called from destroy_instance once no job can touch the cache; the last reference unmaps (the file stays). */
+static void ws_shc_release(void) {
+    pthread_mutex_lock(&g_shcache.mutex);
+    if (g_shcache.refs > 0 && --g_shcache.refs == 0 && g_shcache.seg) {
+        munmap(g_shcache.seg, sizeof(ws_shc_segment_t));
+        g_shcache.seg = NULL;
+        g_shcache.shared = false;
+    }
+    pthread_mutex_unlock(&g_shcache.mutex);
+}
+
+#endif
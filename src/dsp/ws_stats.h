@@ -0,0 +1,112 @@
+#ifndef WS_STATS_H
+#define WS_STATS_H
+
+/*
+ * Lock-free runtime counters and log2 histograms.
+ *
+ * Every field is a plain uint64_t updated with relaxed __atomic builtins, so
+ * the render thread, background threads and get_param readers never take a
+ * lock. Readers see each value individually consistent; a snapshot across
+ * fields may be a few events apart, which is fine for monitoring.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define WS_HIST_BUCKETS 20      /* bucket i holds values in [2^(i-1), 2^i); bucket 0 holds 0 */
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[WS_HIST_BUCKETS];
+} ws_hist_t;
+
+static inline void ws_stat_add(uint64_t *counter, uint64_t v) {
+    __atomic_fetch_add(counter, v, __ATOMIC_RELAXED);
+}
+
+static inline void ws_stat_inc(uint64_t *counter) {
+    __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+static inline void ws_stat_store(uint64_t *counter, uint64_t v) {
+    __atomic_store_n(counter, v, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t ws_stat_load(const uint64_t *counter) {
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+static inline int ws_hist_bucket(uint64_t v) {
+    int b = 0;
+    if (v == 0) return 0;
+    b = 64 - __builtin_clzll(v);
+    return b < WS_HIST_BUCKETS ? b : WS_HIST_BUCKETS - 1;
+}
+
+static inline void ws_hist_record(ws_hist_t *h, uint64_t v) {
+    uint64_t prev = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->buckets[ws_hist_bucket(v)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->sum, v, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+    while (v > prev &&
+           !__atomic_compare_exchange_n(&h->max, &prev, v, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/* Upper bound of the bucket containing the pct-th percentile (clamped to max). */
+static inline uint64_t ws_hist_percentile(const ws_hist_t *h, const uint64_t *buckets, uint64_t count, unsigned pct) {
+    uint64_t target;
+    uint64_t seen = 0;
+    uint64_t max = ws_stat_load(&h->max);
+    int i;
+
+    if (count == 0) return 0;
+    target = (count * pct + 99) / 100;
+    if (target == 0) target = 1;
+    for (i = 0; i < WS_HIST_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= target) {
+            uint64_t upper = i == 0 ? 0 : (1ULL << i) - 1;
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+/* {"n":..,"mean":..,"p50":..,"p99":..,"max":..,"hist":[...]}; returns bytes written like snprintf. */
+static inline int ws_hist_format(const ws_hist_t *h, char *buf, size_t len) {
+    uint64_t buckets[WS_HIST_BUCKETS];
+    uint64_t count = 0;
+    size_t pos;
+    int last = 0;
+    int i;
+    int n;
+
+    for (i = 0; i < WS_HIST_BUCKETS; i++) {
+        buckets[i] = ws_stat_load(&h->buckets[i]);
+        count += buckets[i];
+        if (buckets[i] != 0) last = i;
+    }
+    n = snprintf(buf,
+                 len,
+                 "{\"n\":%llu,\"mean\":%llu,\"p50\":%llu,\"p99\":%llu,\"max\":%llu,\"hist\":[",
+                 (unsigned long long)count,
+                 (unsigned long long)(count ? ws_stat_load(&h->sum) / count : 0),
+                 (unsigned long long)ws_hist_percentile(h, buckets, count, 50),
+                 (unsigned long long)ws_hist_percentile(h, buckets, count, 99),
+                 (unsigned long long)ws_stat_load(&h->max));
+    if (n < 0) return n;
+    pos = (size_t)n;
+    for (i = 0; i <= last && count > 0; i++) {
+        n = snprintf(pos < len ? buf + pos : NULL, pos < len ? len - pos : 0, "%s%llu", i ? "," : "", (unsigned long long)buckets[i]);
+        if (n < 0) return n;
+        pos += (size_t)n;
+    }
+    n = snprintf(pos < len ? buf + pos : NULL, pos < len ? len - pos : 0, "]}");
+    if (n < 0) return n;
+    return (int)(pos + (size_t)n);
+}
+
+#endif
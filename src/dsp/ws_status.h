@@ -0,0 +1,83 @@
+#ifndef WS_STATUS_H
+#define WS_STATUS_H
+
+/*
+ * Transport status published by the render thread once per block.
+ *
+ * A single-writer seqlock: the writer makes seq odd, stores the fields and
+ * makes it even again. Readers on any thread copy the fields and retry if
+ * seq moved; a reader that keeps colliding gives up after a bounded number
+ * of attempts and keeps its last copy, whose fields are each individually
+ * atomic. Neither side ever blocks.
+ */
+
+#include <stdint.h>
+
+#define WS_STATUS_READ_TRIES 64
+
+typedef struct {
+    uint32_t state;         /* caller-defined enum */
+    uint32_t level;         /* peak |sample| of the last block, 0..32767 */
+    uint32_t peak[2];       /* per channel (L, R), same scale */
+    uint32_t rms[2];
+    uint32_t hold[2];       /* peak-hold */
+    uint64_t version;       /* bumped by the writer when state or underruns change */
+    uint64_t position_ms;
+    uint64_t buffered_ms;
+    uint64_t underruns;
+    uint64_t clips;         /* samples pinned at full scale after gain */
+} ws_status_t;
+
+typedef struct {
+    uint32_t seq;           /* odd while a write is in progress */
+    ws_status_t s;
+} ws_status_cell_t;
+
+static inline void ws_status_publish(ws_status_cell_t *c, const ws_status_t *s) {
+    uint32_t seq = __atomic_load_n(&c->seq, __ATOMIC_RELAXED);
+    int i;
+
+    __atomic_store_n(&c->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&c->s.state, s->state, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->s.level, s->level, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->s.version, s->version, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->s.position_ms, s->position_ms, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->s.buffered_ms, s->buffered_ms, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->s.underruns, s->underruns, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->s.clips, s->clips, __ATOMIC_RELAXED);
+    for (i = 0; i < 2; i++) {
+        __atomic_store_n(&c->s.peak[i], s->peak[i], __ATOMIC_RELAXED);
+        __atomic_store_n(&c->s.rms[i], s->rms[i], __ATOMIC_RELAXED);
+        __atomic_store_n(&c->s.hold[i], s->hold[i], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&c->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/* Returns 1 for a consistent copy, 0 if every attempt overlapped a write. */
+static inline int ws_status_read(const ws_status_cell_t *c, ws_status_t *out) {
+    int tries;
+    int i;
+
+    for (tries = 0; tries < WS_STATUS_READ_TRIES; tries++) {
+        uint32_t seq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+
+        out->state = __atomic_load_n(&c->s.state, __ATOMIC_RELAXED);
+        out->level = __atomic_load_n(&c->s.level, __ATOMIC_RELAXED);
+        out->version = __atomic_load_n(&c->s.version, __ATOMIC_RELAXED);
+        out->position_ms = __atomic_load_n(&c->s.position_ms, __ATOMIC_RELAXED);
+        out->buffered_ms = __atomic_load_n(&c->s.buffered_ms, __ATOMIC_RELAXED);
+        out->underruns = __atomic_load_n(&c->s.underruns, __ATOMIC_RELAXED);
+        out->clips = __atomic_load_n(&c->s.clips, __ATOMIC_RELAXED);
+        for (i = 0; i < 2; i++) {
+            out->peak[i] = __atomic_load_n(&c->s.peak[i], __ATOMIC_RELAXED);
+            out->rms[i] = __atomic_load_n(&c->s.rms[i], __ATOMIC_RELAXED);
+            out->hold[i] = __atomic_load_n(&c->s.hold[i], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if ((seq & 1U) == 0 && __atomic_load_n(&c->seq, __ATOMIC_RELAXED) == seq) return 1;
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef WS_TRACE_H
+#define WS_TRACE_H
+
+/*
+ * Lock-free in-memory trace ring for phase timing.
+ *
+ * Writers on any thread claim a slot with one atomic increment and publish
+ * it through a per-slot sequence number (a one-writer seqlock), so emitting
+ * never blocks the render thread. Readers copy slots and drop any that were
+ * overwritten mid-copy. The ring keeps the last WS_TRACE_CAPACITY events.
+ */
+
+#include <stdint.h>
+
+#define WS_TRACE_CAPACITY 256   /* power of two */
+
+typedef struct {
+    uint64_t seq;       /* slot index + 1 once published, 0 while being written */
+    uint64_t ts_us;     /* CLOCK_MONOTONIC */
+    uint64_t arg;
+    const char *name;   /* static string */
+    uint32_t session;
+    uint32_t tid;
+    uint32_t ph;        /* Chrome trace_event phase: 'B', 'E', 'i' */
+} ws_trace_event_t;
+
+typedef struct {
+    uint64_t head;
+    ws_trace_event_t events[WS_TRACE_CAPACITY];
+} ws_trace_t;
+
+static inline void ws_trace_emit(ws_trace_t *t, uint64_t ts_us, const char *name, char ph,
+                                 uint32_t tid, uint32_t session, uint64_t arg) {
+    uint64_t idx = __atomic_fetch_add(&t->head, 1, __ATOMIC_RELAXED);
+    ws_trace_event_t *ev = &t->events[idx & (WS_TRACE_CAPACITY - 1)];
+
+    __atomic_store_n(&ev->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&ev->ts_us, ts_us, __ATOMIC_RELAXED);
+    __atomic_store_n(&ev->arg, arg, __ATOMIC_RELAXED);
+    __atomic_store_n(&ev->name, name, __ATOMIC_RELAXED);
+    __atomic_store_n(&ev->session, session, __ATOMIC_RELAXED);
+    __atomic_store_n(&ev->tid, tid, __ATOMIC_RELAXED);
+    __atomic_store_n(&ev->ph, (uint32_t)(unsigned char)ph, __ATOMIC_RELAXED);
+    __atomic_store_n(&ev->seq, idx + 1, __ATOMIC_RELEASE);
+}
+
+/* Copies up to max published events, oldest first; returns the number copied. */
+static inline int ws_trace_snapshot(const ws_trace_t *t, ws_trace_event_t *out, int max) {
+    uint64_t head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+    uint64_t first = head > WS_TRACE_CAPACITY ? head - WS_TRACE_CAPACITY : 0;
+    uint64_t idx;
+    int n = 0;
+
+    if ((uint64_t)max < head - first) first = head - (uint64_t)max;
+    for (idx = first; idx < head; idx++) {
+        const ws_trace_event_t *ev = &t->events[idx & (WS_TRACE_CAPACITY - 1)];
+        ws_trace_event_t copy;
+        uint64_t seq = __atomic_load_n(&ev->seq, __ATOMIC_ACQUIRE);
+
+        if (seq != idx + 1) continue;   /* unpublished or already reused */
+        copy.ts_us = __atomic_load_n(&ev->ts_us, __ATOMIC_RELAXED);
+        copy.arg = __atomic_load_n(&ev->arg, __ATOMIC_RELAXED);
+        copy.name = __atomic_load_n(&ev->name, __ATOMIC_RELAXED);
+        copy.session = __atomic_load_n(&ev->session, __ATOMIC_RELAXED);
+        copy.tid = __atomic_load_n(&ev->tid, __ATOMIC_RELAXED);
+        copy.ph = __atomic_load_n(&ev->ph, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&ev->seq, __ATOMIC_RELAXED) != seq) continue;
+        copy.seq = seq;
+        out[n++] = copy;
+    }
+    return n;
+}
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef WS_WAVEFORM_H
+#define WS_WAVEFORM_H
+
+/*
+ * Incremental waveform overview of interleaved s16 audio.
+ *
+ * Samples are reduced to min/max/RMS per fixed-size bucket as they are
+ * pushed, so the overview never rescans audio. Buckets are numbered by
+ * absolute sample position (index = abs / bucket_samples) and the last
+ * WS_WAVE_BUCKETS are kept; the bucket being filled is republished after
+ * every push as the live edge. Each bucket is one packed 64-bit word, so a
+ * single writer (the thread pushing audio) and any number of readers need
+ * no lock: readers copy a range and drop buckets that were recycled while
+ * they copied, as in ws_trace.h.
+ */
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define WS_WAVE_NEON 1
+#endif
+
+#define WS_WAVE_BUCKETS 256     /* power of two */
+
+typedef struct {
+    int16_t min;
+    int16_t max;
+    uint16_t rms;
+} ws_wave_bucket_t;
+
+typedef struct {
+    uint32_t bucket_samples;    /* interleaved samples per bucket */
+    uint64_t start;             /* first valid bucket index since the last reset */
+    uint64_t live;              /* index of the bucket being filled */
+    /* Accumulators for the live bucket; writer only. */
+    uint32_t fill;              /* samples into the live bucket, counting any skipped by a reset */
+    uint32_t cur_n;             /* samples actually reduced into it */
+    int32_t cur_min;
+    int32_t cur_max;
+    uint64_t cur_sumsq;
+    uint64_t slots[WS_WAVE_BUCKETS];    /* packed bucket | (index low bits) */
+} ws_wave_t;
+
+/* Packs a bucket with the low 16 bits of its index so readers can detect reuse. */
+static inline uint64_t ws_wave_pack(uint64_t index, int32_t mn, int32_t mx, uint64_t sumsq, uint32_t n) {
+    uint32_t rms = n ? (uint32_t)sqrt((double)sumsq / (double)n) : 0;
+    if (rms > 65535U) rms = 65535U;
+    return ((uint64_t)(uint16_t)(int16_t)mn) | ((uint64_t)(uint16_t)(int16_t)mx << 16) |
+           ((uint64_t)rms << 32) | ((index & 0xFFFFULL) << 48);
+}
+
+static inline void ws_wave_unpack(uint64_t v, ws_wave_bucket_t *b) {
+    b->min = (int16_t)(uint16_t)(v & 0xFFFFU);
+    b->max = (int16_t)(uint16_t)((v >> 16) & 0xFFFFU);
+    b->rms = (uint16_t)((v >> 32) & 0xFFFFU);
+}
+
+/* min/max/sum of squares over n samples; the loop is the hot part of every push. */
+static inline void ws_wave_reduce(const int16_t *s, size_t n, int32_t *mn, int32_t *mx, uint64_t *sumsq) {
+    int32_t lo = *mn;
+    int32_t hi = *mx;
+    uint64_t acc = 0;
+    size_t i = 0;
+#if defined(WS_WAVE_NEON)
+    if (n >= 8) {
+        int16x8_t vlo = vdupq_n_s16(INT16_MAX);
+        int16x8_t vhi = vdupq_n_s16(INT16_MIN);
+        uint64x2_t vacc = vdupq_n_u64(0);
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t v = vld1q_s16(s + i);
+            int32x4_t sq_lo = vmull_s16(vget_low_s16(v), vget_low_s16(v));
+            int32x4_t sq_hi = vmull_high_s16(v, v);
+            vlo = vminq_s16(vlo, v);
+            vhi = vmaxq_s16(vhi, v);
+            /* Squares are <= 2^30, so each pairwise sum fits in 32 bits unsigned. */
+            vacc = vpadalq_u32(vacc, vreinterpretq_u32_s32(sq_lo));
+            vacc = vpadalq_u32(vacc, vreinterpretq_u32_s32(sq_hi));
+        }
+        if (vminvq_s16(vlo) < lo) lo = vminvq_s16(vlo);
+        if (vmaxvq_s16(vhi) > hi) hi = vmaxvq_s16(vhi);
+        acc = vgetq_lane_u64(vacc, 0) + vgetq_lane_u64(vacc, 1);
+    }
+#else
+    {
+        /* Fixed-width lanes with no cross-iteration dependency so -O3 vectorizes it. */
+        int32_t lane_lo[8] = { INT16_MAX, INT16_MAX, INT16_MAX, INT16_MAX, INT16_MAX, INT16_MAX, INT16_MAX, INT16_MAX };
+        int32_t lane_hi[8] = { INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN };
+        uint64_t lane_sq[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        int k;
+        for (; i + 8 <= n; i += 8) {
+            for (k = 0; k < 8; k++) {
+                int32_t v = s[i + (size_t)k];
+                lane_lo[k] = v < lane_lo[k] ? v : lane_lo[k];
+                lane_hi[k] = v > lane_hi[k] ? v : lane_hi[k];
+                lane_sq[k] += (uint64_t)(v * v);
+            }
+        }
+        for (k = 0; k < 8; k++) {
+            if (lane_lo[k] < lo) lo = lane_lo[k];
+            if (lane_hi[k] > hi) hi = lane_hi[k];
+            acc += lane_sq[k];
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        int32_t v = s[i];
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+        acc += (uint64_t)(v * v);
+    }
+    *mn = lo;
+    *mx = hi;
+    *sumsq += acc;
+}
+
+static inline void ws_wave_begin_bucket(ws_wave_t *w) {
+    w->fill = 0;
+    w->cur_n = 0;
+    w->cur_min = INT16_MAX;
+    w->cur_max = INT16_MIN;
+    w->cur_sumsq = 0;
+}
+
+/* Restarts the overview at abs (stream start or a far seek). Writer thread, or before it starts. */
+static void ws_wave_reset(ws_wave_t *w, uint64_t abs, uint32_t bucket_samples) {
+    uint64_t index;
+    if (bucket_samples == 0) bucket_samples = 1;
+    index = abs / bucket_samples;
+    __atomic_store_n(&w->bucket_samples, bucket_samples, __ATOMIC_RELAXED);
+    ws_wave_begin_bucket(w);
+    w->fill = (uint32_t)(abs - index * bucket_samples);
+    __atomic_store_n(&w->start, index, __ATOMIC_RELAXED);
+    __atomic_store_n(&w->slots[index & (WS_WAVE_BUCKETS - 1)], ws_wave_pack(index, 0, 0, 0, 0), __ATOMIC_RELAXED);
+    __atomic_store_n(&w->live, index, __ATOMIC_RELEASE);
+}
+
+static inline void ws_wave_push(ws_wave_t *w, const int16_t *s, size_t n) {
+    uint64_t live = w->live;
+    uint32_t fill = w->fill;
+
+    while (n > 0) {
+        size_t take = w->bucket_samples - fill;
+        if (take > n) take = n;
+        ws_wave_reduce(s, take, &w->cur_min, &w->cur_max, &w->cur_sumsq);
+        fill += (uint32_t)take;
+        w->cur_n += (uint32_t)take;
+        s += take;
+        n -= take;
+        w->fill = fill;
+        __atomic_store_n(&w->slots[live & (WS_WAVE_BUCKETS - 1)],
+                         ws_wave_pack(live, w->cur_min, w->cur_max, w->cur_sumsq, w->cur_n), __ATOMIC_RELAXED);
+        if (fill >= w->bucket_samples) {
+            live++;
+            ws_wave_begin_bucket(w);
+            fill = 0;
+            __atomic_store_n(&w->slots[live & (WS_WAVE_BUCKETS - 1)], ws_wave_pack(live, 0, 0, 0, 0), __ATOMIC_RELAXED);
+            __atomic_store_n(&w->live, live, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+/* Index of the bucket being filled; the newest one a reader can ask for. */
+static inline uint64_t ws_wave_live(const ws_wave_t *w) {
+    return __atomic_load_n(&w->live, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Copies up to max buckets starting at from (clamped to what is retained)
+ * into out, oldest first; the live edge is the last one. *first gets the
+ * index of out[0]. Returns the count.
+ */
+static inline int ws_wave_read(const ws_wave_t *w, uint64_t from, ws_wave_bucket_t *out, int max, uint64_t *first) {
+    uint64_t live = __atomic_load_n(&w->live, __ATOMIC_ACQUIRE);
+    uint64_t start = __atomic_load_n(&w->start, __ATOMIC_RELAXED);
+    uint64_t lo = live + 1 > WS_WAVE_BUCKETS ? live + 1 - WS_WAVE_BUCKETS : 0;
+    uint64_t idx;
+    int n = 0;
+
+    if (lo < start) lo = start;
+    if (from > lo) lo = from;
+    if (max <= 0 || lo > live) {
+        *first = live + 1;
+        return 0;
+    }
+    *first = lo;
+    for (idx = lo; idx <= live && n < max; idx++) {
+        uint64_t v = __atomic_load_n(&w->slots[idx & (WS_WAVE_BUCKETS - 1)], __ATOMIC_RELAXED);
+        if ((v >> 48) != (idx & 0xFFFFULL)) {
+            /* Recycled after we read live: restart the copy just past it. */
+            n = 0;
+            *first = idx + 1;
+            continue;
+        }
+        ws_wave_unpack(v, &out[n++]);
+    }
+    return n;
+}
+
+#endif
@@ -0,0 +1,267 @@
+#ifndef WS_WORKPOOL_H
+#define WS_WORKPOOL_H
+
+/*
+ * Process-wide worker pool with typed, prioritised jobs.
+ *
+ * A fixed set of workers starts when the first instance acquires the pool
+ * and is joined when the last one releases it. Jobs are keyed by
+ * (owner, type): at most one job per key runs at a time, and submitting
+ * while one is already queued coalesces into it. Jobs read their inputs
+ * from the owner when they start, so the latest request wins. A free worker
+ * takes the lowest-numbered type first (FIFO within a type), so a
+ * user-initiated resolve overtakes queued searches, warmups, probes, library
+ * upkeep and offline saves. Only WS_POOL_SAVE_RUNNING saves run at once across
+ * all instances, since a rate-limited download holds its worker until it
+ * finishes; the other workers stay available for resolves.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WS_POOL_WORKERS 3
+#define WS_POOL_MAX_JOBS 32
+#define WS_POOL_WORKER_NICE 5   /* below the host, above decoder children */
+#define WS_POOL_SAVE_RUNNING 1  /* saves block a worker for minutes; the rest stay free for resolves */
+
+typedef enum {
+    WS_JOB_RESOLVE = 0,     /* highest priority */
+    WS_JOB_SEARCH,
+    WS_JOB_WARMUP,
+    WS_JOB_PROBE,
+    WS_JOB_LIBRARY,         /* library index upkeep asked for by the render thread */
+    WS_JOB_SAVE,            /* offline library downloads, lowest priority */
+    WS_JOB_TYPES
+} ws_job_type_t;
+
+typedef void (*ws_job_fn)(void *owner);
+
+typedef struct {
+    void *owner;
+    ws_job_fn fn;
+    int type;
+    uint64_t seq;           /* FIFO order within a type */
+    uint64_t queued_us;
+} ws_job_t;
+
+typedef struct {
+    void *owner;            /* NULL while the worker is idle */
+    int type;
+} ws_pool_slot_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t work;    /* a job became runnable, or the pool is stopping */
+    pthread_cond_t idle;    /* a job finished */
+    int refs;
+    bool stopping;
+    int nworkers;
+    pthread_t workers[WS_POOL_WORKERS];
+    ws_pool_slot_t running[WS_POOL_WORKERS];
+    int count;
+    ws_job_t jobs[WS_POOL_MAX_JOBS];
+    uint64_t next_seq;
+    /* Written under the mutex, read with relaxed loads by stats_json. */
+    uint64_t run[WS_JOB_TYPES];
+    uint64_t wait_max_us[WS_JOB_TYPES];
+    uint64_t coalesced;
+} ws_pool_t;
+
+static ws_pool_t g_pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .work = PTHREAD_COND_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER,
+};
+
+static const char *const ws_job_type_names[WS_JOB_TYPES] = { "resolve", "search", "warmup", "probe", "library", "save" };
+
+static uint64_t ws_pool_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static bool ws_pool_key_running_locked(void *owner, int type) {
+    int i;
+    for (i = 0; i < g_pool.nworkers; i++) {
+        if (g_pool.running[i].owner == owner && g_pool.running[i].type == type) return true;
+    }
+    return false;
+}
+
+static int ws_pool_type_running_locked(int type) {
+    int n = 0;
+    int i;
+    for (i = 0; i < g_pool.nworkers; i++) {
+        if (g_pool.running[i].owner && g_pool.running[i].type == type) n++;
+    }
+    return n;
+}
+
+/* Highest-priority queued job whose key is not already running, or -1. Saves run one at a time pool-wide. */
+static int ws_pool_pick_locked(void) {
+    bool saves_full = ws_pool_type_running_locked(WS_JOB_SAVE) >= WS_POOL_SAVE_RUNNING;
+    int best = -1;
+    int i;
+    for (i = 0; i < g_pool.count; i++) {
+        const ws_job_t *j = &g_pool.jobs[i];
+        if (ws_pool_key_running_locked(j->owner, j->type)) continue;
+        if (j->type == WS_JOB_SAVE && saves_full) continue;
+        if (best < 0 || j->type < g_pool.jobs[best].type ||
+            (j->type == g_pool.jobs[best].type && j->seq < g_pool.jobs[best].seq)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static void* ws_pool_worker_main(void *arg) {
+    int slot = (int)(intptr_t)arg;
+
+    /* Linux nice is per thread; jobs mostly wait on pipes, so this only matters under load. */
+    (void)setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), WS_POOL_WORKER_NICE);
+    pthread_mutex_lock(&g_pool.mutex);
+    for (;;) {
+        ws_job_t job;
+        uint64_t waited;
+        int i;
+
+        while (!g_pool.stopping && (i = ws_pool_pick_locked()) < 0) {
+            pthread_cond_wait(&g_pool.work, &g_pool.mutex);
+        }
+        if (g_pool.stopping) break;
+
+        job = g_pool.jobs[i];
+        g_pool.jobs[i] = g_pool.jobs[--g_pool.count];
+        g_pool.running[slot].owner = job.owner;
+        g_pool.running[slot].type = job.type;
+        waited = ws_pool_now_us() - job.queued_us;
+        __atomic_store_n(&g_pool.run[job.type], g_pool.run[job.type] + 1, __ATOMIC_RELAXED);
+        if (waited > g_pool.wait_max_us[job.type]) {
+            __atomic_store_n(&g_pool.wait_max_us[job.type], waited, __ATOMIC_RELAXED);
+        }
+        pthread_mutex_unlock(&g_pool.mutex);
+
+        job.fn(job.owner);
+
+        pthread_mutex_lock(&g_pool.mutex);
+        g_pool.running[slot].owner = NULL;
+        pthread_cond_broadcast(&g_pool.idle);
+        /* A job queued behind this key may now be runnable. */
+        pthread_cond_broadcast(&g_pool.work);
+    }
+    pthread_mutex_unlock(&g_pool.mutex);
+    return NULL;
+}
+
+/* Called from create_instance; the first reference starts the workers. */
+static void ws_pool_acquire(void) {
+    int i;
+
+    pthread_mutex_lock(&g_pool.mutex);
+    if (g_pool.refs++ == 0) {
+        g_pool.stopping = false;
+        g_pool.nworkers = 0;
+        for (i = 0; i < WS_POOL_WORKERS; i++) {
+            g_pool.running[i].owner = NULL;
+            if (pthread_create(&g_pool.workers[i], NULL, ws_pool_worker_main, (void *)(intptr_t)i) != 0) break;
+            g_pool.nworkers++;
+        }
+    }
+    pthread_mutex_unlock(&g_pool.mutex);
+}
+
+/* Called from destroy_instance after ws_pool_cancel; the last reference joins the workers. */
+static void ws_pool_release(void) {
+    pthread_t workers[WS_POOL_WORKERS];
+    int n;
+    int i;
+
+    pthread_mutex_lock(&g_pool.mutex);
+    if (g_pool.refs == 0 || --g_pool.refs > 0) {
+        pthread_mutex_unlock(&g_pool.mutex);
+        return;
+    }
+    g_pool.stopping = true;
+    n = g_pool.nworkers;
+    for (i = 0; i < n; i++) workers[i] = g_pool.workers[i];
+    pthread_cond_broadcast(&g_pool.work);
+    pthread_mutex_unlock(&g_pool.mutex);
+
+    for (i = 0; i < n; i++) pthread_join(workers[i], NULL);
+
+    pthread_mutex_lock(&g_pool.mutex);
+    g_pool.nworkers = 0;
+    g_pool.count = 0;
+    pthread_mutex_unlock(&g_pool.mutex);
+}
+
+/*
+ * Queues fn(owner) as a job of the given type. Returns 0 when it will run
+ * on the next free worker, 1 when it waits behind (or was merged into) a
+ * job with the same owner and type, -1 when the pool is unavailable or full.
+ */
+static int ws_pool_submit(ws_job_type_t type, void *owner, ws_job_fn fn) {
+    ws_job_t *j;
+    bool busy;
+    int i;
+
+    pthread_mutex_lock(&g_pool.mutex);
+    if (g_pool.nworkers == 0 || g_pool.stopping) {
+        pthread_mutex_unlock(&g_pool.mutex);
+        return -1;
+    }
+    for (i = 0; i < g_pool.count; i++) {
+        if (g_pool.jobs[i].owner == owner && g_pool.jobs[i].type == (int)type) {
+            g_pool.jobs[i].fn = fn;
+            __atomic_store_n(&g_pool.coalesced, g_pool.coalesced + 1, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&g_pool.mutex);
+            return 1;
+        }
+    }
+    if (g_pool.count >= WS_POOL_MAX_JOBS) {
+        pthread_mutex_unlock(&g_pool.mutex);
+        return -1;
+    }
+    j = &g_pool.jobs[g_pool.count++];
+    j->owner = owner;
+    j->fn = fn;
+    j->type = (int)type;
+    j->seq = g_pool.next_seq++;
+    j->queued_us = ws_pool_now_us();
+    busy = ws_pool_key_running_locked(owner, (int)type);
+    if (!busy) pthread_cond_signal(&g_pool.work);
+    pthread_mutex_unlock(&g_pool.mutex);
+    return busy ? 1 : 0;
+}
+
+/* Drops the owner's queued jobs and waits for its running ones to return. */
+static void ws_pool_cancel(void *owner) {
+    int i;
+
+    pthread_mutex_lock(&g_pool.mutex);
+    for (;;) {
+        bool running = false;
+        /* Repeated after every wait: a running job may queue follow-up work. */
+        for (i = 0; i < g_pool.count;) {
+            if (g_pool.jobs[i].owner == owner) {
+                g_pool.jobs[i] = g_pool.jobs[--g_pool.count];
+            } else {
+                i++;
+            }
+        }
+        for (i = 0; i < g_pool.nworkers; i++) {
+            if (g_pool.running[i].owner == owner) running = true;
+        }
+        if (!running) break;
+        pthread_cond_wait(&g_pool.idle, &g_pool.mutex);
+    }
+    pthread_mutex_unlock(&g_pool.mutex);
+}
+
+#endif
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -9,21 +10,102 @@
 #include <string.h>
 #include <poll.h>
 #include <signal.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "plugin_api_v1.h"
+#include "ws_keymap.h"
+#include "ws_library.h"
+#include "ws_logq.h"
+#include "ws_meter.h"
+#include "ws_mixer.h"
+#include "ws_resampler.h"
+#include "ws_sampler.h"
+#include "ws_procman.h"
+#include "ws_sched.h"
+#include "ws_shcache.h"
+#include "ws_stats.h"
+#include "ws_status.h"
+#include "ws_trace.h"
+#include "ws_waveform.h"
+#include "ws_workpool.h"
 
 #define RING_SECONDS 60
-#define RING_SAMPLES (MOVE_SAMPLE_RATE * 2 * RING_SECONDS) /* stereo ring */
+#define RING_SAMPLES (MOVE_SAMPLE_RATE * 2 * RING_SECONDS) /* stereo ring; ~55s at 48kHz hosts */
 #define RESTART_RETRY_BLOCKS 64                 /* ~186ms at 128f blocks */
 #define DEBOUNCE_PLAY_PAUSE_MS 220ULL
 #define DEBOUNCE_SEEK_MS 140ULL
 #define DEBOUNCE_STOP_MS 220ULL
 #define DEBOUNCE_RESTART_MS 220ULL
 
+#define BUFFER_PRIME_MIN_MS 200U
+#define BUFFER_PRIME_MAX_MS 4000U
+#define BUFFER_REBUFFER_MIN_MS 150U
+#define BUFFER_REBUFFER_MAX_MS 3000U
+#define BUFFER_STABLE_DECAY_MS 30000ULL         /* underrun-free time before shrinking */
+#define BUFFER_FADE_FRAMES 64U                  /* ~1.5ms ramp around underruns */
+#define BUFFER_PROFILE_COUNT 5
+#define STARTUP_PROFILES 3
+#define STARTUP_TRIALS 2U                       /* starts per profile before the tuner compares them */
+#define STARTUP_RETRY_EVERY 16U                 /* then every Nth start re-tries the least used one */
+#define STARTUP_MAX_FAIL_PCT 20U                /* more failed starts than this and a profile is skipped */
+#define STARTUP_HISTORY 32U                     /* counts halve here so old results fade */
+#define STARTUP_TIMEOUT_MS 15000ULL             /* no audio by then counts as a failed start */
+#define STARTUP_SETTLE_MS 5000ULL               /* an underrun this soon after first audio also fails it */
+#define ARRIVAL_WINDOW_MS 500ULL
+#define WAVEFORM_BUCKET_MS 250U                 /* 240 buckets span the 60 s ring */
+#define METER_HOLD_MS 1500U                     /* peak-hold before falling back to the block peak */
+#define METER_FLOOR_DB -96.0                    /* reported for digital silence */
+
+#define STREAM_STALL_MS 6000ULL                 /* no decoder bytes while the ring has room */
+#define STREAM_RESUME_MAX_ATTEMPTS 3
+#define STREAM_RESUME_HEALTHY_MS 10000U         /* clean audio after a resume before attempts reset */
+#define STREAM_EOF_TOLERANCE_MS 3000ULL         /* EOF this close to the known duration is the real end */
+#define PUMP_GAP_RESET_MS 1000ULL               /* pump gaps (pause) do not count toward stalls */
+
+#define LADDER_MAX_RUNGS 2                      /* fast-start formats kept per resolve */
+#define LADDER_LOW_AHEAD_MS 8000U               /* read-ahead cap while on a fast-start rung */
+#define LADDER_HOLD_MS 3000U                    /* read-ahead of the rung while the upgrade catches up */
+#define LADDER_MIN_AHEAD_MS 4000U               /* buffered audio needed before starting an upgrade */
+#define LADDER_DECIDE_MS 3000U                  /* throughput window when the cap is not reached first */
+#define LADDER_UPGRADE_PCT 150U                 /* upgrade when throughput >= 1.5x the full bitrate */
+#define LADDER_SKIP_PCT 400U                    /* known throughput this far above a bitrate starts on it */
+#define LADDER_UPGRADE_TIMEOUT_MS 12000ULL
+#define LADDER_XFADE_FRAMES 256U                /* ~6ms crossfade at the splice */
+#define LADDER_SPLICE_STEP_MS 40ULL             /* a whole number of frames at 8k..192k common rates */
+
+#define PROBE_RW_TIMEOUT_US "8000000"          /* ffprobe network read timeout */
+#define PROBE_CODEC_MAX 32
+
+#define RANGE_PREFETCH_CONNECTIONS 4
+#define RANGE_PREFETCH_CACHE_DIR "/data/UserData/move-anything/cache/prefetch"
+
+#define WAV_HEADER_MAX 64                       /* RIFF/WAVE preamble + chunk headers */
+#define SOURCE_RATE_MIN 8000
+#define SOURCE_RATE_MAX 192000
+
+enum {
+    WAV_PREAMBLE = 0,
+    WAV_CHUNK_HEADER,
+    WAV_FMT_BODY,
+    WAV_DATA
+};
+
+/* Incremental parse of ffmpeg's streaming WAV header. */
+typedef struct {
+    int state;
+    uint8_t header[WAV_HEADER_MAX];
+    size_t header_len;
+    size_t fmt_len;
+    uint32_t chunk_size;
+    uint64_t skip_bytes;
+    int rate;                           /* from the fmt chunk, 0 until seen */
+} wav_reader_t;
+
 #define SEARCH_MAX_RESULTS 20
 #define SEARCH_QUERY_MAX 256
 #define SEARCH_ID_MAX 32
@@ -32,23 +114,64 @@
 #define PROVIDER_MAX 24
 #define STREAM_URL_MAX 4096
 #define HTTP_HEADER_MAX 384
-#define DAEMON_LINE_MAX 4096
+#define DAEMON_LINE_MAX 16384                  /* fits a resolve reply with its fast-start ladder */
+#define RESOLVE_BLOB_MAX (STREAM_URL_MAX * (LADDER_MAX_RUNGS + 1) + HTTP_HEADER_MAX * 2 + 64)
 #define DAEMON_START_TIMEOUT_MS 12000
 #define DAEMON_SEARCH_TIMEOUT_MS 12000
 #define DAEMON_RESOLVE_TIMEOUT_MS 12000
+#define DAEMON_YIELD_US 2000                    /* search backoff while a resolve waits */
+#define DAEMON_CANCEL_POLL_MS 100U              /* how often daemon waits check for destroy_instance */
+#define DAEMON_QUIT_GRACE_MS 300U               /* after QUIT, before SIGTERM */
+#define DAEMON_KILL_MS 200U                     /* SIGTERM -> SIGKILL */
+#define STREAM_KILL_MS 120U
 #define WS_RUNTIME_LOG_PATH "/data/UserData/move-anything/cache/webstream-runtime.log"
+#define WS_STATS_LOG_PATH "/data/UserData/move-anything/cache/webstream-stats.jsonl"
+#define STATS_LOG_INTERVAL_MS_DEFAULT 60000U
+#define STATS_LOG_INTERVAL_MS_MIN 1000U
+#define RENDER_LOG_DRAIN_MS 100U
+#define STATS_JSON_MAX 2560
+#define CACHE_SHM_PATH "/dev/shm/webstream-cache-v1"
+#define STARTUP_PROFILE_PATH "/data/UserData/move-anything/cache/webstream-startup.tsv"
+#define LIBRARY_DIR "/data/UserData/move-anything/webstream-library"
+#define LIBRARY_PROVIDER "library"              /* search provider served from the index */
+#define LIBRARY_BUDGET_MB_DEFAULT 2048U
+#define OFFLINE_QUEUE_MAX 8
+#define OFFLINE_RATE_KBPS_DEFAULT 4000U         /* leaves most of a venue link to the live stream */
+#define CACHE_SEARCH_TTL_MS (10U * 60U * 1000U)
+#define CACHE_RESOLVE_TTL_MS (30U * 60U * 1000U)  /* signed media URLs (googlevideo) expire after a few hours */
+#define AUDIO_CPU_SAMPLE_BLOCKS 256U            /* ~0.75s at 128f blocks; feeds child_sched cpus=auto */
+#define VOICE_MAX 3                             /* layered voices besides the main stream */
+#define VOICE_RING_SECONDS 10
+#define VOICE_RING_SAMPLES (MOVE_SAMPLE_RATE * 2 * VOICE_RING_SECONDS)
+#define VOICE_PRIME_MS 750U                     /* buffered before a voice starts or resumes after an underrun */
+#define SAMPLER_POOL_SECONDS 20                 /* shared by every pad slot */
+#define SAMPLER_POOL_FRAMES (MOVE_SAMPLE_RATE * SAMPLER_POOL_SECONDS)
+#define SAMPLER_COPY_FRAMES 16384               /* capture copied per block, so a long grab never spikes render */
+#define LOOP_XFADE_FRAMES 256U                  /* ~6ms equal-power crossfade at the loop wrap */
+#define LOOP_MIN_AHEAD_MS 5000ULL               /* decode room a held loop_start must leave in the ring */
+#define LOOP_UNSET UINT64_MAX                   /* loop point not set */
+#define LOOP_REQ_NONE UINT64_MAX                /* loop_start/loop_end requests, else a frame */
+#define LOOP_REQ_CLEAR (UINT64_MAX - 1U)
+#define LOOP_REQ_HERE (UINT64_MAX - 2U)
+
+/* Trace "threads" group events by subsystem in the trace viewer. */
+#define TRACE_TID_CONTROL 1
+#define TRACE_TID_RESOLVE 2
+#define TRACE_TID_PIPELINE 3
+#define TRACE_TID_PROBE 4
+#define TRACE_TID_DAEMON 5
 
 static const host_api_v1_t *g_host = NULL;
 
-static void* search_thread_main(void *arg);
-static void* resolve_thread_main(void *arg);
-static void* warmup_thread_main(void *arg);
-static void* stream_reap_thread_main(void *arg);
+/* Fade-in half of the loop crossfade in Q15; the fade-out is the same table read backwards. */
+static int16_t g_loop_xfade[LOOP_XFADE_FRAMES];
+static pthread_once_t g_loop_xfade_once = PTHREAD_ONCE_INIT;
 
-typedef struct {
-    FILE *pipe;
-    pid_t pid;
-} stream_reap_job_t;
+static void search_job(void *owner);
+static void resolve_job(void *owner);
+static void warmup_job(void *owner);
+static void probe_job(void *owner);
+static void* stats_log_thread_main(void *arg);
 
 typedef struct {
     char provider[PROVIDER_MAX];
@@ -59,7 +182,274 @@ typedef struct {
     char url[SEARCH_URL_MAX];
 } search_result_t;
 
+/* Entry kinds in the shared search/resolve cache (ws_shcache.h). */
+enum {
+    CACHE_KIND_SEARCH = 0,
+    CACHE_KIND_RESOLVE
+};
+
+/* One way to open a stream: ffmpeg input options and how much of the provider's prime to wait for. */
+typedef struct {
+    const char *name;
+    const char *input_opts;             /* ahead of -i, each followed by a space */
+    uint32_t prime_pct;
+} startup_profile_t;
+
+/*
+ * Candidates per provider, in buffer_profiles order. "default" is ffmpeg's own
+ * probing and always stays available; the others probe less and reconnect
+ * dropped HTTP reads.
+ */
+#define STARTUP_RECONNECT "-reconnect 1 -reconnect_streamed 1 -reconnect_delay_max 2 "
+static const startup_profile_t g_startup_profiles[BUFFER_PROFILE_COUNT][STARTUP_PROFILES] = {
+    /* youtube: googlevideo m4a/webm, moov or cues up front */
+    { { "default", "", 100 },
+      { "quick", "-probesize 131072 -analyzeduration 1000000 " STARTUP_RECONNECT, 100 },
+      { "lowdelay", "-probesize 32768 -analyzeduration 0 -fflags +nobuffer " STARTUP_RECONNECT, 75 } },
+    /* soundcloud: progressive MP3 or HLS */
+    { { "default", "", 100 },
+      { "quick", "-probesize 65536 -analyzeduration 500000 " STARTUP_RECONNECT, 100 },
+      { "lowdelay", "-probesize 32768 -analyzeduration 0 -fflags +nobuffer " STARTUP_RECONNECT, 75 } },
+    /* archive: large FLAC/MP3/WAV files, STREAMINFO or a header up front */
+    { { "default", "", 100 },
+      { "quick", "-probesize 65536 -analyzeduration 500000 " STARTUP_RECONNECT, 100 },
+      { "lowdelay", "-probesize 32768 -analyzeduration 0 -fflags +nobuffer " STARTUP_RECONNECT, 75 } },
+    /* freesound: short MP3 previews */
+    { { "default", "", 100 },
+      { "quick", "-probesize 32768 -analyzeduration 250000 ", 100 },
+      { "lowdelay", "-probesize 8192 -analyzeduration 0 -fflags +nobuffer ", 75 } },
+    /* other */
+    { { "default", "", 100 },
+      { "quick", "-probesize 131072 -analyzeduration 1000000 " STARTUP_RECONNECT, 100 },
+      { "lowdelay", "-probesize 32768 -analyzeduration 0 -fflags +nobuffer " STARTUP_RECONNECT, 75 } },
+};
+
+/* Finished starts with a profile; ttfa_ms averages the successful ones (decoder spawn to first audio). */
+typedef struct {
+    uint32_t starts;
+    uint32_t failures;
+    uint32_t ttfa_ms;
+} startup_stats_t;
+
+/* Per-provider jitter buffer thresholds, adapted from observed underruns. */
+typedef struct {
+    char provider[PROVIDER_MAX];
+    uint32_t prime_ms;
+    uint32_t rebuffer_ms;
+    uint32_t min_prime_ms;
+    uint32_t min_rebuffer_ms;
+    uint64_t underruns;
+    uint64_t stable_since_ms;
+    uint32_t net_kbps;                  /* last fast-start throughput estimate, 0 if never measured */
+    startup_stats_t startup[STARTUP_PROFILES];
+    uint32_t startup_count;             /* fresh starts, paces re-trials */
+    int startup_pick;                   /* profile of the latest fresh start */
+} buffer_profile_t;
+
+/*
+ * Fast-start quality ladder: a fresh start may open a smaller format from the
+ * resolve reply, then splice to the full-quality URL once a second decoder has
+ * caught up (stream_quality get_param).
+ */
+typedef enum {
+    LADDER_FULL = 0,                    /* full quality from the start, or no ladder */
+    LADDER_LOW,                         /* on a fast-start rung, measuring throughput */
+    LADDER_UPGRADING,                   /* full-quality decoder catching up in the background */
+    LADDER_UPGRADED,
+    LADDER_STAYED,                      /* throughput too low (or quality_ladder low): kept the rung */
+    LADDER_STATES
+} ladder_state_t;
+
+static const char *const g_ladder_state_names[LADDER_STATES] = {
+    "full", "low", "upgrading", "upgraded", "stayed_low"
+};
+
+enum {
+    LADDER_MODE_AUTO = 0,
+    LADDER_MODE_OFF,
+    LADDER_MODE_LOW,                    /* start on the smallest rung and keep it */
+    LADDER_MODES
+};
+
+static const char *const g_ladder_mode_names[LADDER_MODES] = { "auto", "off", "low" };
+
+typedef struct {
+    uint32_t kbps;
+    char url[STREAM_URL_MAX];
+} ladder_rung_t;
+
+/* A parsed RESOLVE blob; pointers into the blob. */
+typedef struct {
+    const char *media_url;
+    const char *user_agent;
+    const char *referer;
+    uint32_t kbps;                      /* full-quality bitrate, 0 if unknown */
+    int rung_count;
+    uint32_t rung_kbps[LADDER_MAX_RUNGS];
+    const char *rung_url[LADDER_MAX_RUNGS];
+} resolve_reply_t;
+
+/* stream_status values, computed on the render thread and published through ws_status.h. */
+typedef enum {
+    TRANSPORT_STOPPED = 0,
+    TRANSPORT_LOADING,
+    TRANSPORT_BUFFERING,
+    TRANSPORT_STREAMING,
+    TRANSPORT_PAUSED,
+    TRANSPORT_SEEKING,
+    TRANSPORT_RECONNECTING,
+    TRANSPORT_EOF,
+    TRANSPORT_STATES
+} transport_state_t;
+
+static const char *const g_transport_state_names[TRANSPORT_STATES] = {
+    "stopped", "loading", "buffering", "streaming", "paused", "seeking", "reconnecting", "eof"
+};
+
+/* voice<n>_status values, computed on the render thread. */
+typedef enum {
+    VOICE_IDLE = 0,
+    VOICE_LOADING,
+    VOICE_BUFFERING,
+    VOICE_PLAYING,
+    VOICE_PAUSED,
+    VOICE_ENDED,
+    VOICE_FAILED,
+    VOICE_STATES
+} voice_state_t;
+
+static const char *const g_voice_state_names[VOICE_STATES] = {
+    "idle", "loading", "buffering", "playing", "paused", "ended", "failed"
+};
+
+/* voice<n>_transport commands, handed to the render thread through voice_t.command. */
+enum {
+    VOICE_CMD_NONE = 0,
+    VOICE_CMD_PLAY,
+    VOICE_CMD_PAUSE,
+    VOICE_CMD_TOGGLE,
+    VOICE_CMD_STOP,
+    VOICE_CMD_RESTART
+};
+
+/* Pad slot lifecycle, published to slot<n>_status. */
+typedef enum {
+    SLOT_EMPTY = 0,
+    SLOT_CAPTURING,
+    SLOT_READY,
+    SLOT_FAILED,
+    SLOT_STATES
+} slot_state_t;
+
+static const char *const g_slot_state_names[SLOT_STATES] = {
+    "empty", "capturing", "ready", "failed"
+};
+
+struct yt_instance;
+
+/*
+ * A layered voice: its own source, decoder, ring region, gain and transport,
+ * mixed over the main stream. Resolves go through the shared daemon, cache
+ * and library like the main stream's; there is no fast-start ladder, range
+ * prefetch or seeking.
+ */
+typedef struct {
+    struct yt_instance *inst;           /* for daemon requests from the resolve job */
+    int index;                          /* 1-based, as in the voice<n>_ keys */
+
+    /* Requested source and its resolve; guarded by the instance's voice_mutex. */
+    char provider[PROVIDER_MAX];
+    char url[STREAM_URL_MAX];
+    char media_url[STREAM_URL_MAX];     /* http URL or library file, "" until resolved */
+    uint32_t ready_generation;          /* generation media_url was resolved for */
+    bool resolve_failed;
+    char error[192];
+
+    /* set_param -> render thread. */
+    uint32_t generation;                /* atomic; bumped by every voice<n>_stream_url */
+    int32_t gain_q13;                   /* atomic */
+    uint32_t command;                   /* atomic VOICE_CMD_*, taken by the render thread */
+
+    /* Render thread only. */
+    uint32_t play_generation;           /* the source the decoder and ring hold */
+    bool has_source;
+    bool stopped;
+    bool paused;
+    bool failed;
+    bool eof;
+    FILE *pipe;
+    int fd;
+    pid_t pid;
+    wav_reader_t wav;
+    ws_resampler_t resampler;
+    uint8_t pending[4];
+    uint8_t pending_len;
+    int16_t *ring;                      /* VOICE_RING_SAMPLES, allocated by the first voice<n>_stream_url */
+    uint64_t write_abs;
+    uint64_t play_abs;
+    size_t prime_samples;               /* buffered audio wanted before playing (again) */
+
+    /* Render thread -> get_param. */
+    uint32_t state;                     /* atomic voice_state_t */
+    uint64_t position_ms;               /* atomic */
+} voice_t;
+
+/* slot<n>_capture: clear, the last_ms before the play position, or [start_ms, end_ms) of the stream. */
+typedef struct {
+    bool clear;
+    uint64_t last_ms;
+    uint64_t start_ms;
+    uint64_t end_ms;
+} slot_request_t;
+
+/* Capture bookkeeping for one pad slot of the instance's ws_sampler_t. */
+typedef struct {
+    /* set_param -> render thread; guarded by the instance's sampler_mutex. */
+    uint32_t request;                   /* bumped by every slot<n>_capture */
+    slot_request_t req;
+
+    /* Render thread only. */
+    uint32_t taken;
+    uint64_t src_abs;                   /* next ring sample to copy */
+    size_t copied;                      /* frames already in the pool */
+
+    /* Render thread -> get_param. */
+    uint32_t state;                     /* atomic slot_state_t */
+    uint64_t length_ms;                 /* atomic */
+} sampler_slot_t;
+
+/* Cumulative since create_instance; every field is updated lock-free (ws_stats.h). */
 typedef struct {
+    uint64_t created_ms;
+    ws_hist_t render_us;
+    uint64_t deadline_misses;
+    uint64_t underruns;
+    uint64_t dropped_samples;
+    uint64_t clipped_samples;
+    uint64_t pipe_bytes;
+    uint64_t pipe_bytes_per_sec;
+    uint64_t pipe_window_start_ms;   /* render thread only */
+    uint64_t pipe_window_bytes;      /* render thread only */
+    ws_hist_t resolve_ms;
+    uint64_t resolve_failures;
+    uint64_t daemon_starts;
+    uint64_t legacy_fallbacks;
+    uint64_t resumes;
+    uint64_t spawns_stream;
+    uint64_t spawns_daemon;
+    uint64_t spawns_probe;
+    uint64_t ladder_fast_starts;
+    uint64_t ladder_upgrades;
+    uint64_t ladder_stayed;
+    uint64_t voice_starts;
+    uint64_t voice_underruns;
+    uint64_t loop_wraps;
+    uint64_t sampler_voices;         /* gauge: pad voices sounding after the last block */
+    uint64_t ttfa_start_ms;          /* set on stream_url, cleared by the first audible block */
+    ws_hist_t ttfa_ms;
+} plugin_stats_t;
+
+typedef struct yt_instance {
     char module_dir[512];
     char stream_provider[PROVIDER_MAX];
     char stream_url[STREAM_URL_MAX];
@@ -72,16 +462,58 @@ typedef struct {
     int restart_countdown;
     bool active_stream_resolved;
     bool resolved_fallback_attempted;
+    uint64_t stream_duration_ms;
+    uint64_t decoder_start_abs;
+    uint64_t last_data_ms;
+    uint64_t last_pump_ms;
+    uint64_t resume_from_ms;
+    uint32_t resume_attempts;
+    uint64_t resume_count;
+    bool reconnecting;
+    bool range_prefetch;
+    uint64_t ring_floor_abs;
+    uint32_t stream_bitrate_kbps;
+    char stream_codec[PROBE_CODEC_MAX];
 
     int16_t ring[RING_SAMPLES];
     size_t write_pos;
     uint64_t write_abs;
     uint64_t play_abs;
+
+    /* A/B loop: set_param posts LOOP_REQ_* or a frame; the points are written by the render thread only. */
+    uint64_t loop_start_req;            /* atomic */
+    uint64_t loop_end_req;              /* atomic */
+    int loop_decode_pause;              /* atomic: hold the decoder once the loop is buffered */
+    uint64_t loop_start_abs;            /* LOOP_UNSET or a ring position; read atomically by get_param */
+    uint64_t loop_end_abs;
+    uint32_t loop_xfade_frames;         /* fits the loop length and the history before loop_start */
+    uint64_t loop_tail_abs;             /* entering from past loop_end: what would have played next */
+    size_t loop_tail_left;              /* samples of it still fading out */
+    int loop_decode_held;               /* atomic, for stats */
     uint64_t dropped_samples;
     uint64_t dropped_log_next;
     uint8_t pending_bytes[4];
     uint8_t pending_len;
+    int sample_rate;
+    int block_frames;
+    int source_rate;
+    int resampler_taps;
+    wav_reader_t wav;
+    ws_resampler_t *resampler;          /* one of resamplers[]; splice_upgrade swaps it with up_resampler */
+    ws_resampler_t resamplers[2];
     size_t prime_needed_samples;
+    buffer_profile_t buffer_profiles[BUFFER_PROFILE_COUNT];
+    buffer_profile_t *buffer_profile;
+    bool rebuffering;
+    size_t rebuffer_needed_samples;
+    uint64_t underrun_count;
+    uint64_t underrun_total_ms;
+    uint64_t underrun_started_ms;
+    uint32_t fade_in_pos;
+    uint64_t arrival_window_start_ms;
+    uint64_t arrival_window_samples;
+    bool arrival_window_throttled;
+    uint32_t arrival_ratio_pct;
     bool paused;
     size_t played_samples;
     size_t seek_discard_samples;
@@ -96,42 +528,135 @@ typedef struct {
     uint64_t last_stop_ms;
     uint64_t last_restart_ms;
     bool warmup_started;
-    pthread_t warmup_thread;
-    bool warmup_thread_valid;
 
-    pthread_mutex_t daemon_mutex;
-    FILE *daemon_in;
-    FILE *daemon_out;
-    pid_t daemon_pid;
-    bool daemon_ready;
+    /* The yt-dlp daemon is shared by all instances (g_daemon); these tag our requests to it. */
+    uint32_t daemon_tag;
+    uint32_t daemon_seq;                /* guarded by g_daemon.mutex */
+    uint32_t daemon_cancel;             /* set by destroy_instance; daemon waits give up */
 
+    /* Background jobs run on the shared worker pool; see ws_workpool.h. */
     pthread_mutex_t resolve_mutex;
-    pthread_t resolve_thread;
-    bool resolve_thread_valid;
-    bool resolve_thread_running;
+    bool resolve_pending;               /* resolve job queued or running */
     bool resolve_ready;
     bool resolve_failed;
     char resolved_media_url[STREAM_URL_MAX];
     char resolved_user_agent[HTTP_HEADER_MAX];
     char resolved_referer[HTTP_HEADER_MAX];
+    uint32_t resolved_kbps;
+    int resolved_rung_count;
+    ladder_rung_t resolved_rungs[LADDER_MAX_RUNGS];  /* fast-start formats, lowest bitrate first */
     char resolve_error[256];
+    bool resolved_local;                /* resolved_media_url is a library file (ws_library.h) */
+    char forget_provider[PROVIDER_MAX]; /* saved copy that would not decode; dropped by forget_job */
+    char forget_url[STREAM_URL_MAX];
+
+    /* Background ffprobe of the resolved URL; guarded by resolve_mutex. */
+    pid_t probe_pid;
+    uint32_t probe_generation;
+    uint32_t probe_url_generation;      /* generation probe_url was queued for */
+    bool probe_ready;
+    uint64_t probe_duration_ms;
+    uint32_t probe_bitrate_kbps;
+    char probe_codec[PROBE_CODEC_MAX];
+    char probe_url[STREAM_URL_MAX];
 
     float gain;
 
+    /* search_provider/search_query are the latest request; a queued search job picks them up when it starts. */
     pthread_mutex_t search_mutex;
-    pthread_t search_thread;
-    bool search_thread_valid;
-    bool search_thread_running;
     char search_provider[PROVIDER_MAX];
     char search_query[SEARCH_QUERY_MAX];
-    char queued_search_provider[PROVIDER_MAX];
-    char queued_search_query[SEARCH_QUERY_MAX];
-    bool queued_search_pending;
     char search_status[24];
     char search_error[256];
     uint64_t search_elapsed_ms;
     int search_count;
     search_result_t search_results[SEARCH_MAX_RESULTS];
+    uint32_t search_generation;         /* bumped under search_mutex on any change; read lock-free */
+
+    /* Offline saves wait here for the save job, which takes them one at a time; guarded by offline_mutex. */
+    pthread_mutex_t offline_mutex;
+    search_result_t offline_queue[OFFLINE_QUEUE_MAX];
+    int offline_queued;
+    pid_t offline_pid;                  /* library_fetch.py, -1 when idle */
+    char offline_title[SEARCH_TEXT_MAX];   /* being saved, "" when idle */
+    uint64_t offline_done_bytes;
+    uint64_t offline_total_bytes;       /* 0 when the origin did not say */
+    char offline_error[192];            /* last failure */
+    uint32_t offline_rate_kbps;         /* 0 = unlimited */
+
+    /* min/max/RMS per WAVEFORM_BUCKET_MS of ring audio, updated by ring_push (ws_waveform.h). */
+    ws_wave_t wave;
+
+    /* Transport status for get_param; written once per block by the render thread (ws_status.h). */
+    ws_status_cell_t status;
+    ws_status_t status_last;            /* render thread only */
+    uint32_t meter_hold_frames[2];      /* render thread only: frames left before hold releases */
+    uint32_t meter_reset_pending;       /* set by meter_reset, applied by the render thread */
+
+    plugin_stats_t stats;
+    /*
+     * The stats/log thread drains render_log and writes periodic JSON-lines
+     * snapshots of stats_json; the fields below are guarded by stats_log_mutex.
+     */
+    pthread_mutex_t stats_log_mutex;
+    pthread_cond_t stats_log_cond;
+    pthread_t stats_log_thread;
+    bool stats_log_thread_valid;
+    bool stats_log_stop;
+    char stats_log_path[512];
+    uint32_t stats_log_interval_ms;
+    uint64_t stats_log_last_ms;         /* last snapshot, or when the log was configured */
+    ws_logq_t render_log;               /* lines from threads that must not touch files; see ws_logq.h */
+
+    /* Time-to-first-audio phase events; see ws_trace.h. */
+    ws_trace_t trace;
+    uint32_t trace_session;             /* bumped on every stream_url */
+    uint32_t trace_first_audio_pending; /* session awaiting its first non-silent block, 0 if none */
+    bool trace_first_byte_pending;      /* render thread only */
+    uint32_t audio_cpu_countdown;       /* render thread only: blocks until the core is sampled again */
+
+    /* Fast-start quality ladder; render thread only except ladder_mode. */
+    int ladder_mode;
+    int ladder_state;
+    uint32_t ladder_rung_kbps;
+    uint32_t ladder_full_kbps;
+    char ladder_full_url[STREAM_URL_MAX];
+    uint64_t ladder_t0_ms;              /* first rung data; throughput is measured from here */
+    uint64_t ladder_t0_abs;
+    uint64_t ladder_up_started_ms;
+    size_t read_ahead_cap_samples;      /* 0 = only the ring size limits pump_pipe */
+    FILE *up_pipe;                      /* full-quality decoder, native-rate WAV like the rung's */
+    int up_fd;
+    pid_t up_pid;
+    wav_reader_t up_wav;
+    ws_resampler_t *up_resampler;
+    uint64_t up_at_frames;              /* where it starts, in host frames of the decoder's timeline */
+    uint64_t up_start_abs;              /* ring position of its first sample, once its header is in */
+    uint64_t up_abs;                    /* ring position of its next sample */
+    uint8_t up_pending[4];
+    uint8_t up_pending_len;
+    int16_t up_tail[LADDER_XFADE_FRAMES * 2];  /* its last samples before write_abs, by abs % size */
+
+    /* Startup profile tuning; render thread only except startup_mode and startup_dirty. */
+    int startup_mode;                   /* -1 tunes, else a fixed profile index */
+    int startup_dirty;                  /* atomic: stats changed since the last save */
+    bool startup_pending;               /* a fresh start is waiting for its first audio */
+    uint64_t startup_spawn_ms;
+    uint64_t startup_settle_until_ms;   /* early underruns until then fail the start after all */
+    buffer_profile_t *startup_owner;    /* whose stats that start counts toward */
+    int startup_idx;
+
+    /* Layered voices (voice<n>_* params); voice_mutex guards their request and resolve fields. */
+    pthread_mutex_t voice_mutex;
+    voice_t voices[VOICE_MAX];
+
+    /* Pad sampler (slot<n>_* params, notes from on_midi); sampler_mutex guards the capture requests. */
+    pthread_mutex_t sampler_mutex;
+    uint32_t sampler_requests;          /* atomic; bumped with any slot's request */
+    uint32_t sampler_taken;             /* render thread only */
+    sampler_slot_t sampler_slots[WS_SMP_SLOTS];
+    ws_sampler_t sampler;
+    int16_t *sampler_pool;              /* SAMPLER_POOL_FRAMES, allocated by the first slot<n>_capture */
 } yt_instance_t;
 
 static void append_ws_log(const char *msg) {
@@ -152,12 +677,33 @@ static void yt_log(const char *msg) {
     }
 }
 
+/* Render thread: queue the line for the stats/log thread instead of appending to the log file. */
+static void render_log(yt_instance_t *inst, const char *msg) {
+    ws_logq_push(&inst->render_log, msg);
+}
+
+static uint64_t mono_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+/* Monotonic, so debounce, stall and latency intervals survive wall-clock steps (NTP on boot). */
 static uint64_t now_ms(void) {
+    return mono_us() / 1000ULL;
+}
+
+/* Wall clock, only for timestamps written to files. */
+static uint64_t wall_ms(void) {
     struct timeval tv;
     gettimeofday(&tv, NULL);
     return (uint64_t)tv.tv_sec * 1000ULL + (uint64_t)tv.tv_usec / 1000ULL;
 }
 
+static void trace_event(yt_instance_t *inst, const char *name, char ph, uint32_t tid, uint64_t arg) {
+    ws_trace_emit(&inst->trace, mono_us(), name, ph, tid, __atomic_load_n(&inst->trace_session, __ATOMIC_RELAXED), arg);
+}
+
 static void trim_line_end(char *line) {
     size_t len;
     if (!line) return;
@@ -183,81 +729,213 @@ static int split_tab_fields(char *line, char **fields, int max_fields) {
     return count;
 }
 
-static void stop_daemon_locked(yt_instance_t *inst) {
-    int status;
-    pid_t rc;
+/*
+ * One yt-dlp daemon per process, shared by every instance: each instance
+ * holds a reference from create to destroy, the daemon starts on the first
+ * warmup or request and is stopped when the last reference goes.
+ *
+ * The daemon is serial, so requests take turns under the mutex. Each request
+ * is tagged "@<instance>.<seq>" and the daemon echoes the tag on every reply
+ * line; when a caller gives up on a request (its instance is being
+ * destroyed), the rest of that reply is recognised and dropped by whoever
+ * reads next instead of being taken as their answer.
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+    int refs;                           /* live instances; atomic */
+    uint32_t next_tag;
+    uint32_t resolve_waiting;           /* searches hold off while a resolve wants the daemon */
+    FILE *in;
+    int out_fd;
+    char rbuf[DAEMON_LINE_MAX];         /* partial reply lines, see read_daemon_line_locked */
+    size_t rlen;
+    pid_t pid;
+    bool ready;
+    /* Updated under the mutex, read with relaxed loads by stats_json. */
+    uint64_t starts;
+    uint64_t requests;
+    uint64_t stale_lines;
+} shared_daemon_t;
+
+static shared_daemon_t g_daemon = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .out_fd = -1,
+    .pid = -1,
+};
 
-    if (!inst) return;
+static bool daemon_cancelled(const yt_instance_t *inst) {
+    return inst && __atomic_load_n(&inst->daemon_cancel, __ATOMIC_ACQUIRE) != 0;
+}
 
-    if (inst->daemon_in) {
-        fprintf(inst->daemon_in, "QUIT\n");
-        fflush(inst->daemon_in);
-        fclose(inst->daemon_in);
-        inst->daemon_in = NULL;
+/* Takes g_daemon.mutex, or returns -1 if inst is destroyed while it waits its turn. */
+static int daemon_lock(yt_instance_t *inst) {
+    for (;;) {
+        struct timespec until;
+
+        if (daemon_cancelled(inst)) return -1;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_nsec += (long)DAEMON_CANCEL_POLL_MS * 1000000L;
+        if (until.tv_nsec >= 1000000000L) {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        if (pthread_mutex_timedlock(&g_daemon.mutex, &until) == 0) return 0;
     }
+}
 
-    if (inst->daemon_out) {
-        fclose(inst->daemon_out);
-        inst->daemon_out = NULL;
+/* Caller holds g_daemon.mutex. */
+static void daemon_request_tag(yt_instance_t *inst, char *tag, size_t tag_len) {
+    snprintf(tag, tag_len, "@%u.%u", inst->daemon_tag, ++inst->daemon_seq);
+    ws_stat_inc(&g_daemon.requests);
+}
+
+/*
+ * A write to a daemon that already exited raises SIGPIPE, whose default action
+ * would take the whole host down. Daemon writes run with it blocked and any
+ * resulting pending SIGPIPE is discarded before unblocking.
+ */
+static void block_sigpipe(sigset_t *old_set) {
+    sigset_t pipe_set;
+    sigemptyset(&pipe_set);
+    sigaddset(&pipe_set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe_set, old_set);
+}
+
+static void unblock_sigpipe(const sigset_t *old_set) {
+    sigset_t pipe_set;
+    sigset_t pending;
+    struct timespec zero = { 0, 0 };
+
+    sigemptyset(&pipe_set);
+    sigaddset(&pipe_set, SIGPIPE);
+    if (sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE) && !sigismember(old_set, SIGPIPE)) {
+        (void)sigtimedwait(&pipe_set, NULL, &zero);
     }
+    pthread_sigmask(SIG_SETMASK, old_set, NULL);
+}
 
-    if (inst->daemon_pid > 0) {
-        rc = waitpid(inst->daemon_pid, &status, WNOHANG);
-        if (rc == 0) {
-            (void)kill(inst->daemon_pid, SIGTERM);
-            usleep(200000);
-            rc = waitpid(inst->daemon_pid, &status, WNOHANG);
-            if (rc == 0) {
-                (void)kill(inst->daemon_pid, SIGKILL);
-                (void)waitpid(inst->daemon_pid, &status, 0);
-            }
-        }
-        inst->daemon_pid = -1;
+static int daemon_write_locked(const char *line) {
+    sigset_t old_set;
+    int rc = 0;
+
+    block_sigpipe(&old_set);
+    if (fputs(line, g_daemon.in) == EOF || fflush(g_daemon.in) != 0) rc = -1;
+    unblock_sigpipe(&old_set);
+    return rc;
+}
+
+/* Asks the daemon to QUIT; the process manager escalates if it lingers. */
+static void stop_daemon_locked(void) {
+    sigset_t old_set;
+
+    if (g_daemon.in) {
+        block_sigpipe(&old_set);
+        fputs("QUIT\n", g_daemon.in);
+        fclose(g_daemon.in);
+        unblock_sigpipe(&old_set);
+        g_daemon.in = NULL;
+    }
+
+    if (g_daemon.out_fd >= 0) {
+        close(g_daemon.out_fd);
+        g_daemon.out_fd = -1;
     }
+    g_daemon.rlen = 0;
 
-    inst->daemon_ready = false;
+    if (g_daemon.pid > 0) {
+        ws_proc_release(g_daemon.pid, false, DAEMON_QUIT_GRACE_MS, DAEMON_KILL_MS);
+        g_daemon.pid = -1;
+    }
+
+    g_daemon.ready = false;
 }
 
+/*
+ * Lines are split from our own buffer rather than stdio: replies arrive in
+ * bursts (SEARCH_ITEM...SEARCH_END), and polling the fd while stdio already
+ * holds the rest of a burst would stall until the timeout. The wait also
+ * ends early if inst is being destroyed.
+ */
 static int read_daemon_line_locked(yt_instance_t *inst, char *line, size_t line_len, int timeout_ms) {
-    struct pollfd pfd;
-    int rc;
+    uint64_t deadline;
+
+    if (g_daemon.out_fd < 0 || !line || line_len < 2) return -1;
+    deadline = now_ms() + (uint64_t)(timeout_ms > 0 ? timeout_ms : 0);
+
+    for (;;) {
+        char *nl = memchr(g_daemon.rbuf, '\n', g_daemon.rlen);
+        struct pollfd pfd;
+        uint64_t now;
+        uint64_t wait_ms;
+        int ready;
+        ssize_t got;
+
+        if (nl || g_daemon.rlen == sizeof(g_daemon.rbuf)) {
+            size_t used = nl ? (size_t)(nl - g_daemon.rbuf) + 1 : g_daemon.rlen;
+            size_t copy = used < line_len - 1 ? used : line_len - 1;
+            memcpy(line, g_daemon.rbuf, copy);
+            line[copy] = '\0';
+            memmove(g_daemon.rbuf, g_daemon.rbuf + used, g_daemon.rlen - used);
+            g_daemon.rlen -= used;
+            trim_line_end(line);
+            return 0;
+        }
 
-    if (!inst || !inst->daemon_out || !line || line_len < 2) return -1;
-    pfd.fd = fileno(inst->daemon_out);
-    pfd.events = POLLIN;
-    pfd.revents = 0;
+        now = now_ms();
+        if (now >= deadline || daemon_cancelled(inst)) return -1;
+        wait_ms = deadline - now < DAEMON_CANCEL_POLL_MS ? deadline - now : DAEMON_CANCEL_POLL_MS;
+        pfd.fd = g_daemon.out_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        ready = poll(&pfd, 1, (int)wait_ms);
+        if (ready < 0) return -1;
+        if (ready == 0) continue;
+        got = read(g_daemon.out_fd,
+                   g_daemon.rbuf + g_daemon.rlen,
+                   sizeof(g_daemon.rbuf) - g_daemon.rlen);
+        if (got <= 0) return -1;
+        g_daemon.rlen += (size_t)got;
+    }
+}
 
-    rc = poll(&pfd, 1, timeout_ms);
-    if (rc <= 0) return -1;
-    if (!(pfd.revents & POLLIN)) return -1;
+/* Next reply line to the request tagged tag, with the tag stripped; replies to abandoned requests are skipped. */
+static int read_daemon_reply_locked(yt_instance_t *inst, const char *tag, char *line, size_t line_len, int timeout_ms) {
+    size_t tag_len = strlen(tag);
+    uint64_t deadline = now_ms() + (uint64_t)(timeout_ms > 0 ? timeout_ms : 0);
 
-    if (!fgets(line, (int)line_len, inst->daemon_out)) {
-        return -1;
+    for (;;) {
+        uint64_t now = now_ms();
+
+        if (now >= deadline) return -1;
+        if (read_daemon_line_locked(inst, line, line_len, (int)(deadline - now)) != 0) return -1;
+        if (line[0] != '@') return 0;               /* untagged: a daemon without tag support */
+        if (strncmp(line, tag, tag_len) == 0 && line[tag_len] == '\t') {
+            memmove(line, line + tag_len + 1, strlen(line + tag_len + 1) + 1);
+            return 0;
+        }
+        ws_stat_inc(&g_daemon.stale_lines);
     }
-    trim_line_end(line);
-    return 0;
 }
 
-static int start_daemon_locked(yt_instance_t *inst, char *err, size_t err_len) {
+static int spawn_daemon_locked(yt_instance_t *inst, char *err, size_t err_len) {
     int parent_to_child[2];
     int child_to_parent[2];
     pid_t pid;
     char daemon_path[1024];
     char ytdlp_path[1024];
     char line[DAEMON_LINE_MAX];
+    ws_sched_policy_t sched;
+    cpu_set_t cpus;
+    bool pin;
 
-    if (!inst) return -1;
-    if (inst->daemon_ready && inst->daemon_in && inst->daemon_out && inst->daemon_pid > 0) {
-        return 0;
-    }
-
-    stop_daemon_locked(inst);
+    stop_daemon_locked();
 
-    if (pipe(parent_to_child) != 0 || pipe(child_to_parent) != 0) {
+    if (pipe2(parent_to_child, O_CLOEXEC) != 0 || pipe2(child_to_parent, O_CLOEXEC) != 0) {
         if (err && err_len > 0) snprintf(err, err_len, "daemon pipe failed");
         return -1;
     }
 
+    (void)ws_sched_prepare(&sched, &cpus, &pin);
     pid = fork();
     if (pid < 0) {
         close(parent_to_child[0]);
@@ -269,6 +947,7 @@ static int start_daemon_locked(yt_instance_t *inst, char *err, size_t err_len) {
     }
 
     if (pid == 0) {
+        ws_sched_apply_child(&sched, pin ? &cpus : NULL);
         snprintf(daemon_path, sizeof(daemon_path), "%s/bin/yt_dlp_daemon.py", inst->module_dir);
         snprintf(ytdlp_path, sizeof(ytdlp_path), "%s/bin/yt-dlp", inst->module_dir);
 
@@ -282,49 +961,86 @@ static int start_daemon_locked(yt_instance_t *inst, char *err, size_t err_len) {
         _exit(127);
     }
 
+    ws_stat_inc(&inst->stats.spawns_daemon);
+    ws_proc_note_spawn();
     close(parent_to_child[0]);
     close(child_to_parent[1]);
-    inst->daemon_in = fdopen(parent_to_child[1], "w");
-    inst->daemon_out = fdopen(child_to_parent[0], "r");
-    inst->daemon_pid = pid;
-    if (!inst->daemon_in || !inst->daemon_out) {
+    g_daemon.in = fdopen(parent_to_child[1], "w");
+    g_daemon.out_fd = child_to_parent[0];
+    g_daemon.rlen = 0;
+    g_daemon.pid = pid;
+    if (!g_daemon.in) {
         if (err && err_len > 0) snprintf(err, err_len, "daemon fdopen failed");
-        stop_daemon_locked(inst);
+        stop_daemon_locked();
         return -1;
     }
 
-    setvbuf(inst->daemon_in, NULL, _IOLBF, 0);
-    setvbuf(inst->daemon_out, NULL, _IOLBF, 0);
+    setvbuf(g_daemon.in, NULL, _IOLBF, 0);
 
     if (read_daemon_line_locked(inst, line, sizeof(line), DAEMON_START_TIMEOUT_MS) != 0) {
         if (err && err_len > 0) snprintf(err, err_len, "daemon startup timeout");
-        stop_daemon_locked(inst);
+        stop_daemon_locked();
         return -1;
     }
 
     if (strcmp(line, "READY") != 0) {
         if (err && err_len > 0) snprintf(err, err_len, "daemon startup failed: %s", line);
-        stop_daemon_locked(inst);
+        stop_daemon_locked();
         return -1;
     }
 
-    inst->daemon_ready = true;
+    g_daemon.ready = true;
+    ws_stat_inc(&g_daemon.starts);
+    ws_stat_inc(&inst->stats.daemon_starts);
     return 0;
 }
 
+static int start_daemon_locked(yt_instance_t *inst, char *err, size_t err_len) {
+    int rc;
+    if (!inst) return -1;
+    if (g_daemon.ready && g_daemon.in && g_daemon.out_fd >= 0 && g_daemon.pid > 0) {
+        return 0;
+    }
+    trace_event(inst, "daemon_start", 'B', TRACE_TID_DAEMON, 0);
+    rc = spawn_daemon_locked(inst, err, err_len);
+    trace_event(inst, "daemon_start", 'E', TRACE_TID_DAEMON, rc == 0 ? 0 : 1);
+    return rc;
+}
+
 static int ensure_daemon_started(yt_instance_t *inst, char *err, size_t err_len) {
     int rc;
     if (!inst) return -1;
-    pthread_mutex_lock(&inst->daemon_mutex);
+    if (daemon_lock(inst) != 0) {
+        if (err && err_len > 0) snprintf(err, err_len, "cancelled");
+        return -1;
+    }
     rc = start_daemon_locked(inst, err, err_len);
-    pthread_mutex_unlock(&inst->daemon_mutex);
+    pthread_mutex_unlock(&g_daemon.mutex);
     return rc;
 }
 
-static void* warmup_thread_main(void *arg) {
-    yt_instance_t *inst = (yt_instance_t *)arg;
+/* Called from create_instance; the daemon itself starts on warmup or the first request. */
+static void daemon_acquire(yt_instance_t *inst) {
+    __atomic_add_fetch(&g_daemon.refs, 1, __ATOMIC_ACQ_REL);
+    inst->daemon_tag = __atomic_add_fetch(&g_daemon.next_tag, 1U, __ATOMIC_RELAXED);
+}
+
+/*
+ * Called from destroy_instance after ws_pool_cancel; the last reference stops
+ * the daemon. Others must not wait for the mutex, which another instance's
+ * request may hold for seconds.
+ */
+static void daemon_release(void) {
+    if (__atomic_sub_fetch(&g_daemon.refs, 1, __ATOMIC_ACQ_REL) != 0) return;
+    pthread_mutex_lock(&g_daemon.mutex);
+    if (__atomic_load_n(&g_daemon.refs, __ATOMIC_ACQUIRE) == 0) stop_daemon_locked();
+    pthread_mutex_unlock(&g_daemon.mutex);
+}
+
+static void warmup_job(void *owner) {
+    yt_instance_t *inst = (yt_instance_t *)owner;
     char err[256];
-    if (!inst) return NULL;
+    if (!inst) return;
     err[0] = '\0';
     if (ensure_daemon_started(inst, err, sizeof(err)) == 0) {
         yt_log("yt-dlp daemon warmed");
@@ -333,18 +1049,14 @@ static void* warmup_thread_main(void *arg) {
         snprintf(msg, sizeof(msg), "yt-dlp daemon warmup failed: %s", err[0] ? err : "unknown");
         yt_log(msg);
     }
-    return NULL;
 }
 
 static void start_warmup_if_needed(yt_instance_t *inst) {
     if (!inst || inst->warmup_started) return;
     inst->warmup_started = true;
 
-    if (pthread_create(&inst->warmup_thread, NULL, warmup_thread_main, inst) == 0) {
-        inst->warmup_thread_valid = true;
-        yt_log("started yt-dlp daemon warmup thread");
-    } else {
-        inst->warmup_thread_valid = false;
+    if (ws_pool_submit(WS_JOB_WARMUP, inst, warmup_job) >= 0) {
+        yt_log("queued yt-dlp daemon warmup");
     }
 }
 
@@ -360,10 +1072,12 @@ static void clear_error(yt_instance_t *inst) {
     inst->error_msg[0] = '\0';
 }
 
+/* Caller must hold search_mutex; results and count are published before the status that announces them. */
 static void set_search_status(yt_instance_t *inst, const char *status, const char *err) {
     if (!inst) return;
     snprintf(inst->search_status, sizeof(inst->search_status), "%s", status ? status : "idle");
     snprintf(inst->search_error, sizeof(inst->search_error), "%s", err ? err : "");
+    __atomic_store_n(&inst->search_generation, inst->search_generation + 1, __ATOMIC_RELEASE);
 }
 
 static void normalize_provider_value(const char *in, char *out, size_t out_len) {
@@ -556,12 +1270,30 @@ static void infer_provider_from_url(const char *url, char *out, size_t out_len)
     snprintf(out, out_len, "%s", normalized);
 }
 
+/* ring_floor_abs marks where the current ring contents start after a far seek. */
 static uint64_t ring_oldest_abs(const yt_instance_t *inst) {
     if (!inst) return 0;
-    if (inst->write_abs > (uint64_t)RING_SAMPLES) {
+    if (inst->write_abs > inst->ring_floor_abs + (uint64_t)RING_SAMPLES) {
         return inst->write_abs - (uint64_t)RING_SAMPLES;
     }
-    return 0;
+    return inst->ring_floor_abs;
+}
+
+/* Oldest position the A/B loop still needs, crossfade pre-roll included; LOOP_UNSET if none. */
+static uint64_t loop_keep_abs(const yt_instance_t *inst) {
+    if (inst->loop_start_abs == LOOP_UNSET) return LOOP_UNSET;
+    return inst->loop_start_abs - (uint64_t)inst->loop_xfade_frames * 2U;
+}
+
+/* What the decoder must not overwrite: unplayed audio plus loop history behind the play position. */
+static size_t ring_retained(const yt_instance_t *inst) {
+    uint64_t from = inst->play_abs;
+    uint64_t keep = loop_keep_abs(inst);
+
+    if (keep < from) from = keep;
+    if (inst->write_abs <= from) return 0;
+    if (inst->write_abs - from > (uint64_t)RING_SAMPLES) return RING_SAMPLES;
+    return (size_t)(inst->write_abs - from);
 }
 
 static size_t ring_available(const yt_instance_t *inst) {
@@ -581,22 +1313,102 @@ static void ring_push(yt_instance_t *inst, const int16_t *samples, size_t n) {
         inst->write_pos = (inst->write_pos + 1) % RING_SAMPLES;
         inst->write_abs++;
     }
+    ws_wave_push(&inst->wave, samples, n);
 
     oldest = ring_oldest_abs(inst);
     if (inst->play_abs < oldest) {
         inst->dropped_samples += (oldest - inst->play_abs);
+        ws_stat_add(&inst->stats.dropped_samples, oldest - inst->play_abs);
         inst->play_abs = oldest;
         inst->played_samples = (size_t)inst->play_abs;
     }
 }
 
+static void init_loop_xfade(void) {
+    uint32_t k;
+    for (k = 0; k < LOOP_XFADE_FRAMES; k++) {
+        g_loop_xfade[k] = (int16_t)lrint(32767.0 * sin(1.57079632679489661923 * ((double)k + 0.5) / (double)LOOP_XFADE_FRAMES));
+    }
+}
+
+/* Equal-power mix of a sample fading in and one fading out, k of xf frames into the fade. */
+static int16_t loop_xfade(int32_t in, int32_t out, uint64_t k, uint32_t xf) {
+    uint32_t t = (uint32_t)(k * LOOP_XFADE_FRAMES / xf);
+    return ws_mix_sat((in * g_loop_xfade[t] + out * g_loop_xfade[LOOP_XFADE_FRAMES - 1U - t] + (1 << 14)) >> 15);
+}
+
+/*
+ * ring_pop inside an A/B loop. The last loop_xfade_frames before loop_end are
+ * crossfaded with the same stretch before loop_start, so the wrap back to
+ * loop_start continues seamlessly and the period stays exactly end - start.
+ */
+static size_t ring_pop_loop(yt_instance_t *inst, int16_t *out, size_t n, uint64_t start, uint64_t end) {
+    const uint32_t xf = inst->loop_xfade_frames;
+    const uint64_t fade_from = end - (uint64_t)xf * 2U;
+    uint64_t abs = inst->play_abs;
+    size_t got = 0;
+
+    if (abs >= end) {
+        /* Set behind the play position (loop_end "here"): fade what would have played next into loop_start. */
+        if (xf > 0 && abs + (uint64_t)xf * 2U <= inst->write_abs) {
+            inst->loop_tail_abs = abs;
+            inst->loop_tail_left = (size_t)xf * 2U;
+        } else {
+            inst->fade_in_pos = 0;
+        }
+        abs = start;
+        ws_stat_inc(&inst->stats.loop_wraps);
+    }
+    while (got < n) {
+        uint64_t stop = end < inst->write_abs ? end : inst->write_abs;
+        size_t take;
+        size_t i;
+
+        if (abs >= end) {
+            abs = start;
+            ws_stat_inc(&inst->stats.loop_wraps);
+            continue;
+        }
+        if (abs >= stop) break; /* loop_end is not decoded yet */
+        take = n - got < stop - abs ? n - got : (size_t)(stop - abs);
+        for (i = 0; i < take; i++, abs++) {
+            int32_t v = inst->ring[(size_t)(abs % (uint64_t)RING_SAMPLES)];
+            if (abs >= fade_from) {
+                v = loop_xfade(inst->ring[(size_t)((abs - (end - start)) % (uint64_t)RING_SAMPLES)], v,
+                               (abs - fade_from) / 2U, xf);
+            } else if (inst->loop_tail_left > 0) {
+                v = loop_xfade(v, inst->ring[(size_t)(inst->loop_tail_abs % (uint64_t)RING_SAMPLES)],
+                               ((uint64_t)xf * 2U - inst->loop_tail_left) / 2U, xf);
+                inst->loop_tail_abs++;
+                inst->loop_tail_left--;
+            }
+            out[got + i] = (int16_t)v;
+        }
+        got += take;
+    }
+    if (abs == end) {
+        /* Wrap now so a block ending on loop_end is not mistaken for a jump past it next time. */
+        abs = start;
+        ws_stat_inc(&inst->stats.loop_wraps);
+    }
+    inst->play_abs = abs;
+    inst->played_samples = (size_t)abs;
+    return got;
+}
+
 static size_t ring_pop(yt_instance_t *inst, int16_t *out, size_t n) {
     size_t got;
     size_t i;
     uint64_t abs_pos;
+    uint64_t loop_start;
+    uint64_t loop_end;
 
     if (!inst || !out || n == 0) return 0;
 
+    loop_start = inst->loop_start_abs;
+    loop_end = inst->loop_end_abs;
+    if (loop_start != LOOP_UNSET && loop_end != LOOP_UNSET) return ring_pop_loop(inst, out, n, loop_start, loop_end);
+
     got = ring_available(inst);
     if (got > n) got = n;
     abs_pos = inst->play_abs;
@@ -611,87 +1423,389 @@ static size_t ring_pop(yt_instance_t *inst, int16_t *out, size_t n) {
     return got;
 }
 
-static bool supports_legacy_fallback(const yt_instance_t *inst) {
-    char provider[PROVIDER_MAX];
-    if (!inst) return false;
-    normalize_provider_value(inst->stream_provider, provider, sizeof(provider));
-    return strcmp(provider, "youtube") == 0 || strcmp(provider, "soundcloud") == 0;
+static int host_sample_rate(void) {
+    if (g_host && g_host->sample_rate >= SOURCE_RATE_MIN && g_host->sample_rate <= SOURCE_RATE_MAX) {
+        return g_host->sample_rate;
+    }
+    return MOVE_SAMPLE_RATE;
 }
 
-static bool prefer_legacy_pipeline(const yt_instance_t *inst) {
+static size_t ms_to_ring_samples(const yt_instance_t *inst, uint64_t ms) {
+    return (size_t)(ms * (uint64_t)inst->sample_rate * 2ULL / 1000ULL);
+}
+
+static uint64_t ring_samples_to_ms(const yt_instance_t *inst, uint64_t samples) {
+    return samples * 1000ULL / ((uint64_t)inst->sample_rate * 2ULL);
+}
+
+static uint32_t clamp_u32(uint32_t v, uint32_t lo, uint32_t hi) {
+    if (v < lo) return lo;
+    if (v > hi) return hi;
+    return v;
+}
+
+static void init_buffer_profile(buffer_profile_t *p, const char *provider, uint32_t prime_ms, uint32_t rebuffer_ms) {
+    snprintf(p->provider, sizeof(p->provider), "%s", provider);
+    p->prime_ms = prime_ms;
+    p->rebuffer_ms = rebuffer_ms;
+    p->min_prime_ms = prime_ms;
+    p->min_rebuffer_ms = rebuffer_ms;
+    p->underruns = 0;
+    p->stable_since_ms = 0;
+    p->net_kbps = 0;
+}
+
+static void init_buffer_profiles(yt_instance_t *inst) {
+    /* Starting points; each profile grows on underruns and decays back when stable. */
+    init_buffer_profile(&inst->buffer_profiles[0], "youtube", 500, 300);
+    init_buffer_profile(&inst->buffer_profiles[1], "soundcloud", 500, 300);
+    init_buffer_profile(&inst->buffer_profiles[2], "archive", 750, 500);
+    init_buffer_profile(&inst->buffer_profiles[3], "freesound", 300, 200);
+    init_buffer_profile(&inst->buffer_profiles[4], "other", 500, 300);
+    inst->buffer_profile = NULL;
+}
+
+static buffer_profile_t* select_buffer_profile(yt_instance_t *inst) {
     char provider[PROVIDER_MAX];
-    if (!inst) return false;
+    int i;
+
     normalize_provider_value(inst->stream_provider, provider, sizeof(provider));
-    return strcmp(provider, "soundcloud") == 0;
+    for (i = 0; i < BUFFER_PROFILE_COUNT - 1; i++) {
+        if (strcmp(inst->buffer_profiles[i].provider, provider) == 0) {
+            return &inst->buffer_profiles[i];
+        }
+    }
+    return &inst->buffer_profiles[BUFFER_PROFILE_COUNT - 1];
 }
 
-static void terminate_stream_process(pid_t pid) {
-    int status;
-    pid_t rc;
+static const startup_profile_t *startup_profile_of(const yt_instance_t *inst, const buffer_profile_t *p) {
+    return &g_startup_profiles[p - inst->buffer_profiles][p->startup_pick];
+}
 
-    if (pid <= 0) return;
+/* Each profile gets STARTUP_TRIALS fresh starts, then the fastest that rarely fails wins. */
+static int choose_startup_profile(const buffer_profile_t *p) {
+    int best = -1;
+    int fewest = 0;
+    int i;
+
+    for (i = 0; i < STARTUP_PROFILES; i++) {
+        const startup_stats_t *st = &p->startup[i];
+        if (st->starts < STARTUP_TRIALS) return i;
+        if (st->starts < p->startup[fewest].starts) fewest = i;
+        if (st->failures * 100U > st->starts * STARTUP_MAX_FAIL_PCT || st->ttfa_ms == 0) continue;
+        if (best < 0 || st->ttfa_ms < p->startup[best].ttfa_ms) best = i;
+    }
+    /* Links and CDNs change; now and then give the least used profile another go. */
+    if (p->startup_count % STARTUP_RETRY_EVERY == STARTUP_RETRY_EVERY - 1U) return fewest;
+    return best >= 0 ? best : 0;
+}
 
-    rc = waitpid(pid, &status, WNOHANG);
-    if (rc == pid) return;
+/* Render thread, after stop_stream and before a resolved decoder spawns: the profile to open it with. */
+static const startup_profile_t *begin_startup(yt_instance_t *inst) {
+    buffer_profile_t *p = select_buffer_profile(inst);
+    int mode = __atomic_load_n(&inst->startup_mode, __ATOMIC_RELAXED);
+
+    /* Resumes, seeks and reconnects reuse the provider's latest pick without being timed. */
+    if (inst->write_abs == 0 && inst->resume_from_ms == 0 && !inst->reconnecting) {
+        p->startup_pick = mode >= 0 && mode < STARTUP_PROFILES ? mode : choose_startup_profile(p);
+        p->startup_count++;
+        inst->startup_pending = true;
+        inst->startup_spawn_ms = now_ms();
+        inst->startup_settle_until_ms = 0;
+        inst->startup_owner = p;
+        inst->startup_idx = p->startup_pick;
+    }
+    return startup_profile_of(inst, p);
+}
 
-    (void)kill(-pid, SIGTERM);
-    usleep(120000);
-    rc = waitpid(pid, &status, WNOHANG);
-    if (rc == 0) {
-        (void)kill(-pid, SIGKILL);
-        (void)waitpid(pid, &status, 0);
+/* Render thread: the pending fresh start produced audio, or gave up. */
+static void finish_startup(yt_instance_t *inst, bool ok, const char *why) {
+    startup_stats_t *st;
+    uint64_t now = now_ms();
+    uint64_t ms = now - inst->startup_spawn_ms;
+    char log_msg[160];
+
+    if (!inst->startup_pending) return;
+    inst->startup_pending = false;
+    st = &inst->startup_owner->startup[inst->startup_idx];
+    if (st->starts >= STARTUP_HISTORY) {
+        st->starts /= 2U;
+        st->failures /= 2U;
+    }
+    st->starts++;
+    if (ok) {
+        if (ms > 60000ULL) ms = 60000ULL;
+        st->ttfa_ms = st->ttfa_ms == 0 ? (uint32_t)ms : (st->ttfa_ms * 3U + (uint32_t)ms) / 4U;
+        inst->startup_settle_until_ms = now + STARTUP_SETTLE_MS;
+        snprintf(log_msg, sizeof(log_msg), "startup %s/%s: first audio after %llu ms", inst->startup_owner->provider,
+                 g_startup_profiles[inst->startup_owner - inst->buffer_profiles][inst->startup_idx].name,
+                 (unsigned long long)ms);
+    } else {
+        st->failures++;
+        snprintf(log_msg, sizeof(log_msg), "startup %s/%s failed: %s", inst->startup_owner->provider,
+                 g_startup_profiles[inst->startup_owner - inst->buffer_profiles][inst->startup_idx].name, why);
     }
+    __atomic_store_n(&inst->startup_dirty, 1, __ATOMIC_RELAXED);
+    render_log(inst, log_msg);
 }
 
-static void* stream_reap_thread_main(void *arg) {
-    stream_reap_job_t *job = (stream_reap_job_t *)arg;
-    FILE *pipe = NULL;
-    pid_t pid = -1;
+static void reset_underrun_stats(yt_instance_t *inst) {
+    inst->rebuffering = false;
+    inst->rebuffer_needed_samples = 0;
+    inst->underrun_count = 0;
+    inst->underrun_total_ms = 0;
+    inst->underrun_started_ms = 0;
+    inst->fade_in_pos = BUFFER_FADE_FRAMES;
+}
+
+static void finish_underrun(yt_instance_t *inst) {
+    uint64_t now = now_ms();
+    if (now > inst->underrun_started_ms) {
+        inst->underrun_total_ms += now - inst->underrun_started_ms;
+    }
+    inst->underrun_started_ms = 0;
+    inst->rebuffering = false;
+    inst->rebuffer_needed_samples = 0;
+    inst->fade_in_pos = 0;
+}
+
+/* Called whenever a new decoder process starts filling an empty ring. */
+static void begin_stream_buffering(yt_instance_t *inst) {
+    buffer_profile_t *p = select_buffer_profile(inst);
+    uint32_t prime_ms = p->prime_ms * startup_profile_of(inst, p)->prime_pct / 100U;
+
+    if (inst->rebuffering) finish_underrun(inst);
+    inst->buffer_profile = p;
+    inst->prime_needed_samples = ms_to_ring_samples(inst, clamp_u32(prime_ms, BUFFER_PRIME_MIN_MS, BUFFER_PRIME_MAX_MS));
+    inst->fade_in_pos = BUFFER_FADE_FRAMES;
+    inst->arrival_window_start_ms = 0;
+    inst->arrival_window_samples = 0;
+    inst->arrival_window_throttled = false;
+    inst->arrival_ratio_pct = 0;
+    if (p->stable_since_ms == 0) p->stable_since_ms = now_ms();
+}
+
+static void adapt_buffer_profile(yt_instance_t *inst, uint64_t now) {
+    buffer_profile_t *p = inst->buffer_profile;
 
-    if (job) {
-        pipe = job->pipe;
-        pid = job->pid;
-        free(job);
+    if (!p || inst->rebuffering || p->stable_since_ms == 0) return;
+    if (now < p->stable_since_ms || now - p->stable_since_ms < BUFFER_STABLE_DECAY_MS) return;
+    /* Only shrink when the source keeps up comfortably faster than realtime. */
+    if (inst->arrival_ratio_pct < 125) return;
+
+    p->rebuffer_ms = clamp_u32(p->rebuffer_ms - p->rebuffer_ms / 10, p->min_rebuffer_ms, BUFFER_REBUFFER_MAX_MS);
+    p->prime_ms = clamp_u32(p->prime_ms - p->prime_ms / 10, p->min_prime_ms, BUFFER_PRIME_MAX_MS);
+    if (p->prime_ms < p->rebuffer_ms) p->prime_ms = p->rebuffer_ms;
+    p->stable_since_ms = now;
+}
+
+/* Tracks decoded-sample arrival speed relative to realtime, in windows not limited by a full ring. */
+static void note_arrival(yt_instance_t *inst, size_t samples, bool throttled) {
+    uint64_t now = now_ms();
+    uint64_t elapsed;
+    uint64_t realtime_samples;
+    uint32_t pct;
+
+    if (inst->arrival_window_start_ms == 0 || now < inst->arrival_window_start_ms) {
+        inst->arrival_window_start_ms = now;
+        inst->arrival_window_samples = 0;
+        inst->arrival_window_throttled = false;
     }
 
-    if (pipe) {
-        fclose(pipe);
+    inst->arrival_window_samples += samples;
+    if (throttled) inst->arrival_window_throttled = true;
+
+    elapsed = now - inst->arrival_window_start_ms;
+    if (elapsed < ARRIVAL_WINDOW_MS) return;
+
+    /* Long gaps mean pumping was suspended (pause, loading); that is not a slow network. */
+    if (!inst->arrival_window_throttled && elapsed < ARRIVAL_WINDOW_MS * 4ULL) {
+        realtime_samples = ms_to_ring_samples(inst, elapsed);
+        if (realtime_samples > 0) {
+            uint64_t raw = inst->arrival_window_samples * 100ULL / realtime_samples;
+            pct = raw > 10000ULL ? 10000U : (uint32_t)raw;
+            inst->arrival_ratio_pct = inst->arrival_ratio_pct == 0 ? pct : (inst->arrival_ratio_pct * 3U + pct) / 4U;
+        }
     }
 
-    terminate_stream_process(pid);
-    return NULL;
+    inst->arrival_window_start_ms = now;
+    inst->arrival_window_samples = 0;
+    inst->arrival_window_throttled = false;
+    adapt_buffer_profile(inst, now);
 }
 
-static void schedule_stream_reap(FILE *pipe, pid_t pid) {
-    stream_reap_job_t *job;
-    pthread_t thread;
+static void apply_fade_out(int16_t *buf, size_t samples) {
+    size_t frames = samples / 2;
+    size_t fade = frames < BUFFER_FADE_FRAMES ? frames : BUFFER_FADE_FRAMES;
+    size_t start = frames - fade;
+    size_t i;
+
+    for (i = 0; i < fade; i++) {
+        int32_t w = (int32_t)(fade - i);
+        buf[(start + i) * 2] = (int16_t)((int32_t)buf[(start + i) * 2] * w / (int32_t)fade);
+        buf[(start + i) * 2 + 1] = (int16_t)((int32_t)buf[(start + i) * 2 + 1] * w / (int32_t)fade);
+    }
+}
 
-    if (!pipe && pid <= 0) return;
+static void apply_fade_in(yt_instance_t *inst, int16_t *buf, size_t samples) {
+    size_t frames = samples / 2;
+    size_t i;
 
-    job = calloc(1, sizeof(*job));
-    if (!job) {
-        if (pipe) fclose(pipe);
-        terminate_stream_process(pid);
-        return;
+    for (i = 0; i < frames && inst->fade_in_pos < BUFFER_FADE_FRAMES; i++, inst->fade_in_pos++) {
+        int32_t w = (int32_t)inst->fade_in_pos;
+        buf[i * 2] = (int16_t)((int32_t)buf[i * 2] * w / (int32_t)BUFFER_FADE_FRAMES);
+        buf[i * 2 + 1] = (int16_t)((int32_t)buf[i * 2 + 1] * w / (int32_t)BUFFER_FADE_FRAMES);
+    }
+}
+
+/* The ring ran dry mid-stream: ramp the partial block down and hold until rebuffered. */
+static void begin_underrun(yt_instance_t *inst, int16_t *buf, size_t got) {
+    buffer_profile_t *p = inst->buffer_profile;
+    uint64_t now = now_ms();
+    char log_msg[160];
+
+    apply_fade_out(buf, got);
+    if (inst->startup_settle_until_ms != 0 && now < inst->startup_settle_until_ms) {
+        /* Quick to start but too little buffered: the start counts against its profile after all. */
+        inst->startup_owner->startup[inst->startup_idx].failures++;
+        inst->startup_settle_until_ms = 0;
+    }
+    inst->underrun_count++;
+    ws_stat_inc(&inst->stats.underruns);
+    inst->underrun_started_ms = now;
+    inst->rebuffering = true;
+
+    if (p) {
+        p->underruns++;
+        p->rebuffer_ms = clamp_u32(p->rebuffer_ms + p->rebuffer_ms / 2, BUFFER_REBUFFER_MIN_MS, BUFFER_REBUFFER_MAX_MS);
+        if (p->prime_ms < p->rebuffer_ms) {
+            p->prime_ms = clamp_u32(p->rebuffer_ms, BUFFER_PRIME_MIN_MS, BUFFER_PRIME_MAX_MS);
+        }
+        p->stable_since_ms = now;
+        inst->rebuffer_needed_samples = ms_to_ring_samples(inst, p->rebuffer_ms);
+    } else {
+        inst->rebuffer_needed_samples = ms_to_ring_samples(inst, BUFFER_REBUFFER_MIN_MS);
     }
 
-    job->pipe = pipe;
-    job->pid = pid;
+    snprintf(log_msg,
+             sizeof(log_msg),
+             "underrun count=%llu rebuffer_ms=%u arrival_pct=%u",
+             (unsigned long long)inst->underrun_count,
+             p ? p->rebuffer_ms : BUFFER_REBUFFER_MIN_MS,
+             inst->arrival_ratio_pct);
+    render_log(inst, log_msg);
+}
 
-    if (pthread_create(&thread, NULL, stream_reap_thread_main, job) == 0) {
-        pthread_detach(thread);
-        return;
+static uint64_t underrun_ms_total(const yt_instance_t *inst) {
+    uint64_t total = inst->underrun_total_ms;
+    uint64_t now;
+    if (inst->rebuffering && inst->underrun_started_ms > 0) {
+        now = now_ms();
+        if (now > inst->underrun_started_ms) total += now - inst->underrun_started_ms;
+    }
+    return total;
+}
+
+/* After EOF the ring still holds decoded audio; keep playing until it drains. */
+static bool stream_playable(const yt_instance_t *inst) {
+    if (!inst || inst->stream_url[0] == '\0') return false;
+    return !inst->stream_eof || ring_available(inst) > 0;
+}
+
+/* Parses "s", "m:ss" or "h:mm:ss" as shown in search results; 0 when unknown. */
+static uint64_t parse_duration_text_ms(const char *text) {
+    uint64_t total = 0;
+    uint64_t part = 0;
+    bool digits = false;
+    const char *p;
+
+    if (!text) return 0;
+    for (p = text; *p; p++) {
+        if (*p >= '0' && *p <= '9') {
+            part = part * 10ULL + (uint64_t)(*p - '0');
+            digits = true;
+        } else if (*p == ':' && digits) {
+            total = (total + part) * 60ULL;
+            part = 0;
+            digits = false;
+        } else {
+            return 0;
+        }
     }
+    if (!digits) return 0;
+    return (total + part) * 1000ULL;
+}
+
+static uint64_t lookup_result_duration_ms(yt_instance_t *inst, const char *url) {
+    uint64_t duration_ms = 0;
+    int i;
+
+    pthread_mutex_lock(&inst->search_mutex);
+    for (i = 0; i < inst->search_count; i++) {
+        if (strcmp(inst->search_results[i].url, url) == 0) {
+            duration_ms = parse_duration_text_ms(inst->search_results[i].duration);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&inst->search_mutex);
+    return duration_ms;
+}
+
+static bool supports_legacy_fallback(const yt_instance_t *inst) {
+    char provider[PROVIDER_MAX];
+    if (!inst) return false;
+    normalize_provider_value(inst->stream_provider, provider, sizeof(provider));
+    return strcmp(provider, "youtube") == 0 || strcmp(provider, "soundcloud") == 0;
+}
+
+static bool prefer_legacy_pipeline(const yt_instance_t *inst) {
+    char provider[PROVIDER_MAX];
+    if (!inst) return false;
+    normalize_provider_value(inst->stream_provider, provider, sizeof(provider));
+    return strcmp(provider, "soundcloud") == 0;
+}
+
+/* Large archive.org files are fetched with parallel ranges; other hosts stream directly. */
+static bool use_range_prefetch(const yt_instance_t *inst) {
+    char provider[PROVIDER_MAX];
+    char helper[640];
+    if (!inst || !inst->range_prefetch) return false;
+    normalize_provider_value(inst->stream_provider, provider, sizeof(provider));
+    if (strcmp(provider, "archive") != 0) return false;
+    snprintf(helper, sizeof(helper), "%s/bin/range_prefetch.py", inst->module_dir);
+    return access(helper, R_OK) == 0;
+}
 
+/* Closes our end of the pipe and hands the pipeline's process group to the process manager. */
+static void schedule_stream_reap(FILE *pipe, pid_t pid) {
     if (pipe) fclose(pipe);
-    terminate_stream_process(pid);
-    free(job);
+    ws_proc_release(pid, true, 0, STREAM_KILL_MS);
+}
+
+/* Drops a background full-quality decoder that has not been spliced in yet. */
+static void cancel_ladder_upgrade(yt_instance_t *inst) {
+    FILE *pipe = inst->up_pipe;
+    pid_t pid = inst->up_pid;
+
+    inst->up_pipe = NULL;
+    inst->up_fd = -1;
+    inst->up_pid = -1;
+    inst->up_pending_len = 0;
+    if (pipe) schedule_stream_reap(pipe, pid);
 }
 
 static void stop_stream(yt_instance_t *inst) {
     FILE *pipe;
     pid_t pid;
-    if (!inst || !inst->pipe) return;
+    if (!inst) return;
+    if (inst->up_pipe) {
+        cancel_ladder_upgrade(inst);
+        inst->ladder_state = LADDER_STAYED;
+    }
+    /* A start stopped before it finished says nothing about its profile. */
+    inst->startup_pending = false;
+    inst->startup_settle_until_ms = 0;
+    if (!inst->pipe) return;
     pipe = inst->pipe;
     pid = inst->stream_pid;
     inst->pipe = NULL;
@@ -700,53 +1814,165 @@ static void stop_stream(yt_instance_t *inst) {
     schedule_stream_reap(pipe, pid);
 }
 
+static uint32_t waveform_bucket_samples(const yt_instance_t *inst) {
+    return (uint32_t)ms_to_ring_samples(inst, WAVEFORM_BUCKET_MS);
+}
+
+/* The loop points name positions of the current ring timeline; a new timeline drops them. */
+static void clear_loop(yt_instance_t *inst) {
+    __atomic_store_n(&inst->loop_start_abs, LOOP_UNSET, __ATOMIC_RELAXED);
+    __atomic_store_n(&inst->loop_end_abs, LOOP_UNSET, __ATOMIC_RELAXED);
+    inst->loop_xfade_frames = 0;
+    inst->loop_tail_left = 0;
+}
+
 static void clear_ring(yt_instance_t *inst) {
     if (!inst) return;
+    clear_loop(inst);
     inst->write_pos = 0;
     inst->write_abs = 0;
     inst->play_abs = 0;
+    inst->ring_floor_abs = 0;
     inst->dropped_samples = 0;
-    inst->dropped_log_next = (uint64_t)MOVE_SAMPLE_RATE * 2ULL;
+    inst->dropped_log_next = (uint64_t)inst->sample_rate * 2ULL;
     inst->pending_len = 0;
     memset(inst->pending_bytes, 0, sizeof(inst->pending_bytes));
     inst->prime_needed_samples = 0;
     inst->played_samples = 0;
+    ws_wave_reset(&inst->wave, 0, waveform_bucket_samples(inst));
 }
 
-static void restart_stream_from_beginning(yt_instance_t *inst, size_t discard_samples) {
+static void reset_pcm_decoder(yt_instance_t *inst) {
     if (!inst) return;
-    stop_stream(inst);
-    clear_ring(inst);
-    clear_error(inst);
+    inst->pending_len = 0;
+    memset(inst->pending_bytes, 0, sizeof(inst->pending_bytes));
+    memset(&inst->wav, 0, sizeof(inst->wav));
+    inst->wav.state = WAV_PREAMBLE;
+    inst->source_rate = 0;
+}
+
+static void reset_resume_state(yt_instance_t *inst) {
+    inst->decoder_start_abs = 0;
+    inst->last_data_ms = 0;
+    inst->resume_from_ms = 0;
+    inst->resume_attempts = 0;
+    inst->reconnecting = false;
+}
+
+static void restart_stream_from_beginning(yt_instance_t *inst, size_t discard_samples) {
+    if (!inst) return;
+    stop_stream(inst);
+    clear_ring(inst);
+    clear_error(inst);
     inst->stream_eof = false;
     inst->restart_countdown = 0;
     inst->paused = false;
     inst->played_samples = 0;
     inst->seek_discard_samples = discard_samples;
+    reset_underrun_stats(inst);
+    reset_resume_state(inst);
     inst->active_stream_resolved = false;
     inst->resolved_fallback_attempted = false;
 }
 
-static void seek_relative_seconds(yt_instance_t *inst, long delta_sec) {
-    int64_t current_samples;
-    int64_t target_samples;
-    int64_t delta_samples;
-    int64_t oldest_samples;
-    int64_t newest_samples;
+/* Restarts the ring timeline at abs so a decoder started at that position appends seamlessly. */
+static void reset_ring_at(yt_instance_t *inst, uint64_t abs) {
+    abs &= ~1ULL;
+    clear_loop(inst);
+    inst->write_abs = abs;
+    inst->play_abs = abs;
+    inst->ring_floor_abs = abs;
+    inst->write_pos = (size_t)(abs % (uint64_t)RING_SAMPLES);
+    inst->played_samples = (size_t)abs;
+    inst->pending_len = 0;
+    inst->prime_needed_samples = 0;
+    ws_wave_reset(&inst->wave, abs, waveform_bucket_samples(inst));
+}
+
+/* Copies a finished background probe into the stream state (control paths only, never per block). */
+static void apply_probe_result(yt_instance_t *inst) {
+    pthread_mutex_lock(&inst->resolve_mutex);
+    if (inst->probe_ready) {
+        if (inst->probe_duration_ms > 0) inst->stream_duration_ms = inst->probe_duration_ms;
+        /* The probe saw the full-quality URL; a fast-start rung keeps its own bitrate. */
+        if (inst->probe_bitrate_kbps > 0 &&
+            (inst->ladder_state == LADDER_FULL || inst->ladder_state == LADDER_UPGRADED)) {
+            inst->stream_bitrate_kbps = inst->probe_bitrate_kbps;
+        }
+        if (inst->probe_codec[0] != '\0') {
+            snprintf(inst->stream_codec, sizeof(inst->stream_codec), "%s", inst->probe_codec);
+        }
+        inst->probe_ready = false;
+    }
+    pthread_mutex_unlock(&inst->resolve_mutex);
+}
+
+/*
+ * Positions inside the ring are instant. Anything else respawns the decoder at
+ * the target (ffmpeg -ss) on a fresh ring timeline, which needs a known duration
+ * for forward targets so we never seek past the end.
+ */
+static void seek_to_ms(yt_instance_t *inst, uint64_t target_ms) {
+    uint64_t target_abs;
+    uint64_t oldest_abs;
+    char log_msg[160];
 
     if (!inst || inst->stream_url[0] == '\0') return;
 
-    current_samples = (int64_t)inst->play_abs;
-    delta_samples = (int64_t)delta_sec * (int64_t)MOVE_SAMPLE_RATE * 2LL;
-    target_samples = current_samples + delta_samples;
+    apply_probe_result(inst);
+    if (inst->stream_duration_ms > 0 && target_ms + 1000ULL > inst->stream_duration_ms) {
+        target_ms = inst->stream_duration_ms > 1000ULL ? inst->stream_duration_ms - 1000ULL : 0;
+    }
+    target_abs = (uint64_t)ms_to_ring_samples(inst, target_ms) & ~1ULL;
+    oldest_abs = ring_oldest_abs(inst);
+
+    if (target_abs >= oldest_abs && target_abs <= inst->write_abs) {
+        inst->play_abs = target_abs;
+        inst->played_samples = (size_t)inst->play_abs;
+        return;
+    }
 
-    oldest_samples = (int64_t)ring_oldest_abs(inst);
-    newest_samples = (int64_t)inst->write_abs;
-    if (target_samples < oldest_samples) target_samples = oldest_samples;
-    if (target_samples > newest_samples) target_samples = newest_samples;
+    /* Nothing decoded yet, or an unknown end: stay within what the ring holds. */
+    if ((!inst->pipe && !inst->stream_eof && !inst->reconnecting) ||
+        (target_abs > inst->write_abs && inst->stream_duration_ms == 0)) {
+        inst->play_abs = target_abs < oldest_abs ? oldest_abs : inst->write_abs;
+        inst->played_samples = (size_t)inst->play_abs;
+        return;
+    }
 
-    inst->play_abs = (uint64_t)target_samples;
-    inst->played_samples = (size_t)inst->play_abs;
+    stop_stream(inst);
+    reset_ring_at(inst, target_abs);
+    inst->stream_eof = false;
+    inst->reconnecting = false;
+    inst->resume_attempts = 0;
+    inst->resume_from_ms = target_ms;
+    inst->restart_countdown = 0;
+    if (!inst->active_stream_resolved) {
+        pthread_mutex_lock(&inst->resolve_mutex);
+        inst->resolve_ready = false;
+        inst->resolve_failed = true;
+        pthread_mutex_unlock(&inst->resolve_mutex);
+    }
+    snprintf(log_msg, sizeof(log_msg), "seek outside buffer to %llu ms, restarting decoder",
+             (unsigned long long)target_ms);
+    yt_log(log_msg);
+}
+
+static void seek_relative_seconds(yt_instance_t *inst, long delta_sec) {
+    int64_t target_ms;
+
+    if (!inst || inst->stream_url[0] == '\0') return;
+
+    target_ms = (int64_t)ring_samples_to_ms(inst, inst->play_abs) + (int64_t)delta_sec * 1000LL;
+    if (target_ms < 0) target_ms = 0;
+    seek_to_ms(inst, (uint64_t)target_ms);
+}
+
+/* Must be called with resolve_mutex held; a still-running stale probe is killed, not awaited. */
+static void cancel_probe_locked(yt_instance_t *inst) {
+    inst->probe_generation++;
+    inst->probe_ready = false;
+    if (inst->probe_pid > 0) (void)kill(-inst->probe_pid, SIGKILL);
 }
 
 static void stop_everything(yt_instance_t *inst) {
@@ -757,8 +1983,16 @@ static void stop_everything(yt_instance_t *inst) {
     inst->paused = false;
     inst->played_samples = 0;
     inst->seek_discard_samples = 0;
+    reset_underrun_stats(inst);
+    reset_resume_state(inst);
+    inst->stream_duration_ms = 0;
+    inst->stream_bitrate_kbps = 0;
+    inst->stream_codec[0] = '\0';
     inst->active_stream_resolved = false;
     inst->resolved_fallback_attempted = false;
+    inst->ladder_state = LADDER_FULL;
+    ws_stat_store(&inst->stats.ttfa_start_ms, 0);
+    __atomic_store_n(&inst->trace_first_audio_pending, 0, __ATOMIC_RELAXED);
     stop_stream(inst);
     clear_ring(inst);
     clear_error(inst);
@@ -768,32 +2002,41 @@ static void stop_everything(yt_instance_t *inst) {
     inst->resolved_media_url[0] = '\0';
     inst->resolved_user_agent[0] = '\0';
     inst->resolved_referer[0] = '\0';
+    inst->resolved_kbps = 0;
+    inst->resolved_rung_count = 0;
+    inst->resolved_local = false;
     inst->resolve_error[0] = '\0';
+    cancel_probe_locked(inst);
     pthread_mutex_unlock(&inst->resolve_mutex);
 }
 
-static int spawn_stream_command(yt_instance_t *inst, const char *cmd, const char *err_prefix) {
+/*
+ * Forks cmd in its own process group with stdout on a non-blocking pipe.
+ * Returns NULL on success, otherwise which step failed.
+ */
+static const char *open_decoder_pipe(yt_instance_t *inst, const char *cmd, FILE **out_fp, int *out_fd, pid_t *out_pid) {
     int pipefd[2];
     pid_t pid;
     FILE *fp;
+    int fd;
+    ws_sched_policy_t sched;
+    cpu_set_t cpus;
+    bool pin;
 
-    if (!inst || !cmd || cmd[0] == '\0') return -1;
-
-    if (pipe(pipefd) != 0) {
-        set_error(inst, err_prefix ? err_prefix : "stream pipe failed");
-        return -1;
-    }
+    /* CLOEXEC from the start: pool workers fork concurrently and must not inherit our write end. */
+    if (pipe2(pipefd, O_CLOEXEC) != 0) return "stream pipe failed";
 
+    (void)ws_sched_prepare(&sched, &cpus, &pin);
     pid = fork();
     if (pid < 0) {
         close(pipefd[0]);
         close(pipefd[1]);
-        set_error(inst, err_prefix ? err_prefix : "stream fork failed");
-        return -1;
+        return "stream fork failed";
     }
 
     if (pid == 0) {
         (void)setpgid(0, 0);
+        ws_sched_apply_child(&sched, pin ? &cpus : NULL);
         dup2(pipefd[1], STDOUT_FILENO);
         close(pipefd[0]);
         close(pipefd[1]);
@@ -801,48 +2044,100 @@ static int spawn_stream_command(yt_instance_t *inst, const char *cmd, const char
         _exit(127);
     }
 
+    ws_stat_inc(&inst->stats.spawns_stream);
+    ws_proc_note_spawn();
     close(pipefd[1]);
     fp = fdopen(pipefd[0], "r");
     if (!fp) {
         close(pipefd[0]);
-        terminate_stream_process(pid);
-        set_error(inst, err_prefix ? err_prefix : "stream fdopen failed");
-        return -1;
+        schedule_stream_reap(NULL, pid);
+        return "stream fdopen failed";
     }
 
-    inst->pipe = fp;
-    inst->pipe_fd = fileno(fp);
-    inst->stream_pid = pid;
-    if (inst->pipe_fd < 0) {
-        FILE *cleanup_pipe = inst->pipe;
-        pid_t cleanup_pid = inst->stream_pid;
-        inst->pipe = NULL;
-        inst->pipe_fd = -1;
-        inst->stream_pid = -1;
-        schedule_stream_reap(cleanup_pipe, cleanup_pid);
-        set_error(inst, err_prefix ? err_prefix : "stream fileno failed");
-        return -1;
+    fd = fileno(fp);
+    if (fd < 0) {
+        schedule_stream_reap(fp, pid);
+        return "stream fileno failed";
+    }
+
+    if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0) {
+        schedule_stream_reap(fp, pid);
+        return "stream non-blocking failed";
     }
 
-    if (fcntl(inst->pipe_fd, F_SETFL, fcntl(inst->pipe_fd, F_GETFL, 0) | O_NONBLOCK) < 0) {
-        FILE *cleanup_pipe = inst->pipe;
-        pid_t cleanup_pid = inst->stream_pid;
-        inst->pipe = NULL;
-        inst->pipe_fd = -1;
-        inst->stream_pid = -1;
-        schedule_stream_reap(cleanup_pipe, cleanup_pid);
-        set_error(inst, err_prefix ? err_prefix : "stream non-blocking failed");
+    *out_fp = fp;
+    *out_fd = fd;
+    *out_pid = pid;
+    return NULL;
+}
+
+static int spawn_stream_command(yt_instance_t *inst, const char *cmd, const char *err_prefix) {
+    const char *failed;
+    FILE *fp = NULL;
+    int fd = -1;
+    pid_t pid = -1;
+
+    if (!inst || !cmd || cmd[0] == '\0') return -1;
+
+    failed = open_decoder_pipe(inst, cmd, &fp, &fd, &pid);
+    if (failed) {
+        set_error(inst, err_prefix ? err_prefix : failed);
         return -1;
     }
 
+    inst->pipe = fp;
+    inst->pipe_fd = fd;
+    inst->stream_pid = pid;
+    reset_pcm_decoder(inst);
+    inst->trace_first_byte_pending = true;
+    trace_event(inst, "spawn", 'i', TRACE_TID_PIPELINE, (uint64_t)pid);
     return 0;
 }
 
+/* Empty unless a resume is pending; otherwise "-ss <sec.ms> " for the next decoder. */
+static void format_seek_option(const yt_instance_t *inst, char *out, size_t out_len) {
+    if (inst->resume_from_ms == 0) {
+        out[0] = '\0';
+        return;
+    }
+    snprintf(out,
+             out_len,
+             "-ss %llu.%03llu ",
+             (unsigned long long)(inst->resume_from_ms / 1000ULL),
+             (unsigned long long)(inst->resume_from_ms % 1000ULL));
+}
+
+/* A resumed decoder appends to the existing ring; only an empty ring (start, far seek) primes. */
+static void finish_decoder_spawn(yt_instance_t *inst, const char *kind) {
+    char log_msg[128];
+
+    inst->decoder_start_abs = inst->write_abs;
+    inst->last_data_ms = now_ms();
+    /* Full quality unless render follows up with begin_fast_start. */
+    inst->ladder_state = LADDER_FULL;
+    inst->read_ahead_cap_samples = 0;
+    if (inst->resume_from_ms == 0 || ring_available(inst) == 0) {
+        begin_stream_buffering(inst);
+    }
+    if (inst->resume_from_ms == 0) {
+        snprintf(log_msg, sizeof(log_msg), "stream pipeline started (%s)", kind);
+    } else {
+        snprintf(log_msg,
+                 sizeof(log_msg),
+                 "stream pipeline resumed (%s) at %llu ms",
+                 kind,
+                 (unsigned long long)inst->resume_from_ms);
+        inst->resume_from_ms = 0;
+    }
+    yt_log(log_msg);
+}
+
 static int start_stream_legacy(yt_instance_t *inst) {
     char cmd[8192];
     char provider[PROVIDER_MAX];
     const char *legacy_fmt = "bestaudio[ext=m4a]/bestaudio";
     const char *extractor_args = "--extractor-args \"youtube:player_skip=js\" ";
+    char seek_opt[48];
 
     stop_stream(inst);
     normalize_provider_value(inst->stream_provider, provider, sizeof(provider));
@@ -851,15 +2146,17 @@ static int start_stream_legacy(yt_instance_t *inst) {
         extractor_args = "";
     }
 
+    /* The download is a pipe, so seek on the output side: ffmpeg decodes and discards up to it. */
+    format_seek_option(inst, seek_opt, sizeof(seek_opt));
     snprintf(cmd, sizeof(cmd),
         "exec \"%s/bin/yt-dlp\" --no-playlist "
         "%s"
         "-f \"%s\" -o - \"%s\" 2>/dev/null | "
         "\"%s/bin/ffmpeg\" -hide_banner -loglevel error "
-        "-i pipe:0 -vn -sn -dn "
-        "-af \"aresample=%d:async=1:min_hard_comp=0.100:first_pts=0\" "
-        "-f s16le -ac 2 -ar %d pipe:1",
-        inst->module_dir, extractor_args, legacy_fmt, inst->stream_url, inst->module_dir, MOVE_SAMPLE_RATE, MOVE_SAMPLE_RATE);
+        "-i pipe:0 %s-vn -sn -dn "
+        "-af \"aresample=async=1:min_hard_comp=0.100:first_pts=0\" "
+        "-f wav -acodec pcm_s16le -ac 2 pipe:1",
+        inst->module_dir, extractor_args, legacy_fmt, inst->stream_url, inst->module_dir, seek_opt);
 
     if (spawn_stream_command(inst, cmd, "failed to launch yt-dlp/ffmpeg pipeline") != 0) {
         set_error(inst, "failed to launch yt-dlp/ffmpeg pipeline");
@@ -869,15 +2166,16 @@ static int start_stream_legacy(yt_instance_t *inst) {
     clear_error(inst);
     inst->stream_eof = false;
     inst->restart_countdown = 0;
-    inst->prime_needed_samples = (size_t)MOVE_SAMPLE_RATE; /* ~0.5s stereo */
     inst->active_stream_resolved = false;
-    yt_log("stream pipeline started (legacy)");
+    finish_decoder_spawn(inst, "legacy");
     return 0;
 }
 
 static int start_stream_resolved(yt_instance_t *inst, const char *media_url) {
     char cmd[8192];
     char clean_url[STREAM_URL_MAX];
+    char seek_opt[48];
+    const startup_profile_t *startup;
 
     if (!inst || !media_url || media_url[0] == '\0') {
         set_error(inst, "resolved media url missing");
@@ -890,17 +2188,74 @@ static int start_stream_resolved(yt_instance_t *inst, const char *media_url) {
     }
 
     stop_stream(inst);
+    startup = begin_startup(inst);
+
+    /* Input-side seek lets ffmpeg reopen the URL with an HTTP range near the position. */
+    format_seek_option(inst, seek_opt, sizeof(seek_opt));
+    if (use_range_prefetch(inst)) {
+        /* The helper serves its sparse cache on loopback and substitutes that URL for {input}. */
+        snprintf(cmd,
+                 sizeof(cmd),
+                 "exec python3 \"%s/bin/range_prefetch.py\" --url \"%s\" "
+                 "--cache-dir \"%s\" --connections %d -- "
+                 "\"%s/bin/ffmpeg\" -hide_banner -loglevel error %s"
+                 "%s-i \"{input}\" -vn -sn -dn "
+                 "-af \"aresample=async=1:min_hard_comp=0.100:first_pts=0\" "
+                 "-f wav -acodec pcm_s16le -ac 2 pipe:1",
+                 inst->module_dir,
+                 clean_url,
+                 RANGE_PREFETCH_CACHE_DIR,
+                 RANGE_PREFETCH_CONNECTIONS,
+                 inst->module_dir,
+                 startup->input_opts,
+                 seek_opt);
+    } else {
+        snprintf(cmd,
+                 sizeof(cmd),
+                 "exec \"%s/bin/ffmpeg\" -hide_banner -loglevel error %s"
+                 "%s-i \"%s\" -vn -sn -dn "
+                 "-af \"aresample=async=1:min_hard_comp=0.100:first_pts=0\" "
+                 "-f wav -acodec pcm_s16le -ac 2 pipe:1",
+                 inst->module_dir,
+                 startup->input_opts,
+                 seek_opt,
+                 clean_url);
+    }
+
+    if (spawn_stream_command(inst, cmd, "failed to launch ffmpeg pipeline") != 0) {
+        set_error(inst, "failed to launch ffmpeg pipeline");
+        return -1;
+    }
+
+    clear_error(inst);
+    inst->stream_eof = false;
+    inst->restart_countdown = 0;
+    inst->active_stream_resolved = true;
+    finish_decoder_spawn(inst, "resolved");
+    return 0;
+}
+
+/* A saved library item plays from disk: no resolve, startup profile, range prefetch or ladder. */
+static int start_stream_local(yt_instance_t *inst, const char *path) {
+    char cmd[8192];
+    char seek_opt[48];
+
+    if (!path || path[0] != '/' || strpbrk(path, "\"`$\\") != NULL) {
+        set_error(inst, "library path invalid");
+        return -1;
+    }
 
+    stop_stream(inst);
+    format_seek_option(inst, seek_opt, sizeof(seek_opt));
     snprintf(cmd,
              sizeof(cmd),
              "exec \"%s/bin/ffmpeg\" -hide_banner -loglevel error "
-             "-i \"%s\" -vn -sn -dn "
-             "-af \"aresample=%d:async=1:min_hard_comp=0.100:first_pts=0\" "
-             "-f s16le -ac 2 -ar %d pipe:1",
+             "%s-i \"%s\" -vn -sn -dn "
+             "-af \"aresample=async=1:min_hard_comp=0.100:first_pts=0\" "
+             "-f wav -acodec pcm_s16le -ac 2 pipe:1",
              inst->module_dir,
-             clean_url,
-             MOVE_SAMPLE_RATE,
-             MOVE_SAMPLE_RATE);
+             seek_opt,
+             path);
 
     if (spawn_stream_command(inst, cmd, "failed to launch ffmpeg pipeline") != 0) {
         set_error(inst, "failed to launch ffmpeg pipeline");
@@ -910,9 +2265,9 @@ static int start_stream_resolved(yt_instance_t *inst, const char *media_url) {
     clear_error(inst);
     inst->stream_eof = false;
     inst->restart_countdown = 0;
-    inst->prime_needed_samples = (size_t)MOVE_SAMPLE_RATE; /* ~0.5s stereo */
     inst->active_stream_resolved = true;
-    yt_log("stream pipeline started (resolved)");
+    if (inst->write_abs == 0 && inst->resume_from_ms == 0) ws_stat_inc(&g_library.local_plays);
+    finish_decoder_spawn(inst, "library");
     return 0;
 }
 
@@ -1029,7 +2384,8 @@ static int run_search_command_daemon(yt_instance_t *inst,
                                      size_t err_len) {
     char clean_provider[PROVIDER_MAX];
     char clean_query[SEARCH_QUERY_MAX];
-    char req[SEARCH_QUERY_MAX + PROVIDER_MAX + 64];
+    char req[SEARCH_QUERY_MAX + PROVIDER_MAX + 96];
+    char tag[32];
     char line[DAEMON_LINE_MAX];
     char *fields[8];
     int field_count;
@@ -1046,29 +2402,43 @@ static int run_search_command_daemon(yt_instance_t *inst,
     normalize_provider_value(provider, clean_provider, sizeof(clean_provider));
     sanitize_query(query, clean_query, sizeof(clean_query));
 
-    pthread_mutex_lock(&inst->daemon_mutex);
+    /* The daemon is serial; let a waiting resolve go first. */
+    while (__atomic_load_n(&g_daemon.resolve_waiting, __ATOMIC_ACQUIRE) > 0 && !daemon_cancelled(inst)) {
+        usleep(DAEMON_YIELD_US);
+    }
+    if (daemon_lock(inst) != 0) {
+        if (err && err_len > 0) snprintf(err, err_len, "cancelled");
+        return -1;
+    }
     for (attempt = 0; attempt < 2; attempt++) {
         count = 0;
         timed_out = 0;
 
         if (start_daemon_locked(inst, err, err_len) != 0) {
-            pthread_mutex_unlock(&inst->daemon_mutex);
+            pthread_mutex_unlock(&g_daemon.mutex);
             return -1;
         }
 
-        snprintf(req, sizeof(req), "SEARCH\t%s\t%d\t%s\n", clean_provider, SEARCH_MAX_RESULTS, clean_query);
-        if (fputs(req, inst->daemon_in) == EOF || fflush(inst->daemon_in) != 0) {
+        daemon_request_tag(inst, tag, sizeof(tag));
+        snprintf(req, sizeof(req), "%s\tSEARCH\t%s\t%d\t%s\n", tag, clean_provider, SEARCH_MAX_RESULTS, clean_query);
+        if (daemon_write_locked(req) != 0) {
             if (err && err_len > 0) snprintf(err, err_len, "daemon write failed");
-            stop_daemon_locked(inst);
-            pthread_mutex_unlock(&inst->daemon_mutex);
+            stop_daemon_locked();
+            pthread_mutex_unlock(&g_daemon.mutex);
             return -1;
         }
 
         while (1) {
-            if (read_daemon_line_locked(inst, line, sizeof(line), DAEMON_SEARCH_TIMEOUT_MS) != 0) {
+            if (read_daemon_reply_locked(inst, tag, line, sizeof(line), DAEMON_SEARCH_TIMEOUT_MS) != 0) {
+                if (daemon_cancelled(inst)) {
+                    /* Leave the daemon running for the other instances; its reply is dropped by tag. */
+                    if (err && err_len > 0) snprintf(err, err_len, "cancelled");
+                    pthread_mutex_unlock(&g_daemon.mutex);
+                    return -1;
+                }
                 timed_out = 1;
                 retryable_timeout = true;
-                stop_daemon_locked(inst);
+                stop_daemon_locked();
                 break;
             }
 
@@ -1114,12 +2484,12 @@ static int run_search_command_daemon(yt_instance_t *inst,
                 } else if (err && err_len > 0) {
                     err[0] = '\0';
                 }
-                pthread_mutex_unlock(&inst->daemon_mutex);
+                pthread_mutex_unlock(&g_daemon.mutex);
                 return 0;
             }
             if (strcmp(fields[0], "ERROR") == 0) {
                 if (err && err_len > 0) snprintf(err, err_len, "%s", field_count >= 2 ? fields[1] : "daemon search failed");
-                pthread_mutex_unlock(&inst->daemon_mutex);
+                pthread_mutex_unlock(&g_daemon.mutex);
                 return -1;
             }
         }
@@ -1133,15 +2503,80 @@ static int run_search_command_daemon(yt_instance_t *inst,
     if (retryable_timeout) {
         if (err && err_len > 0) snprintf(err, err_len, "daemon search timeout");
         *out_count = 0;
-        pthread_mutex_unlock(&inst->daemon_mutex);
+        pthread_mutex_unlock(&g_daemon.mutex);
         return -1;
     }
 
-    pthread_mutex_unlock(&inst->daemon_mutex);
+    pthread_mutex_unlock(&g_daemon.mutex);
     if (err && err_len > 0) snprintf(err, err_len, "daemon search failed");
     return -1;
 }
 
+/* One "id\ttitle\tchannel\tduration\turl" line per result; -1 if they do not all fit a cache entry. */
+static int format_cached_search(const search_result_t *results, int count, char *buf, size_t len) {
+    size_t pos = 0;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        int n = snprintf(buf + pos,
+                         len - pos,
+                         "%s\t%s\t%s\t%s\t%s\n",
+                         results[i].id,
+                         results[i].title,
+                         results[i].channel,
+                         results[i].duration,
+                         results[i].url);
+        if (n < 0 || (size_t)n >= len - pos) return -1;
+        pos += (size_t)n;
+    }
+    return (int)pos;
+}
+
+static int parse_cached_search(char *buf, const char *provider, search_result_t *results) {
+    char *line = buf;
+    int count = 0;
+
+    while (line && *line && count < SEARCH_MAX_RESULTS) {
+        char *next = strchr(line, '\n');
+        char *fields[5];
+
+        if (next) *next++ = '\0';
+        if (split_tab_fields(line, fields, 5) == 5) {
+            snprintf(results[count].id, sizeof(results[count].id), "%s", fields[0]);
+            snprintf(results[count].title, sizeof(results[count].title), "%s", fields[1]);
+            snprintf(results[count].channel, sizeof(results[count].channel), "%s", fields[2]);
+            snprintf(results[count].duration, sizeof(results[count].duration), "%s", fields[3]);
+            snprintf(results[count].url, sizeof(results[count].url), "%s", fields[4]);
+            snprintf(results[count].provider, sizeof(results[count].provider), "%s", provider);
+            count++;
+        }
+        line = next;
+    }
+    return count;
+}
+
+/* The "library" provider: saved items matching every word of query, most recently used first. */
+static int search_library(const char *query, search_result_t *results, int *out_count) {
+    ws_lib_item_t items[SEARCH_MAX_RESULTS];
+    int n = ws_lib_search(query, items, SEARCH_MAX_RESULTS);
+    int i;
+
+    for (i = 0; i < n; i++) {
+        search_result_t *r = &results[i];
+        memset(r, 0, sizeof(*r));
+        /* Rows keep their own provider, so selecting one finds the saved copy under its page URL. */
+        snprintf(r->provider, sizeof(r->provider), "%s", items[i].provider);
+        snprintf(r->id, sizeof(r->id), "%.16s", items[i].file);
+        snprintf(r->title, sizeof(r->title), "%s", items[i].title);
+        snprintf(r->channel, sizeof(r->channel), "%s", items[i].channel);
+        snprintf(r->duration, sizeof(r->duration), "%s", items[i].duration);
+        snprintf(r->url, sizeof(r->url), "%s", items[i].url);
+    }
+    *out_count = n;
+    return 0;
+}
+
+/* Searches go to the shared cache first (ws_shcache.h); only non-empty result sets are stored. */
 static int run_search_command(yt_instance_t *inst,
                               const char *provider,
                               const char *query,
@@ -1149,64 +2584,70 @@ static int run_search_command(yt_instance_t *inst,
                               int *out_count,
                               char *err,
                               size_t err_len) {
-    return run_search_command_daemon(inst, provider, query, results, out_count, err, err_len);
-}
-
-/* Caller must hold search_mutex. */
-static int spawn_search_thread_locked(yt_instance_t *inst, const char *provider, const char *query) {
     char clean_provider[PROVIDER_MAX];
-    if (!inst || !provider || !query || query[0] == '\0') return -1;
+    char clean_query[SEARCH_QUERY_MAX];
+    char key[PROVIDER_MAX + SEARCH_QUERY_MAX + 2];
+    char blob[WS_SHC_VAL_MAX];
+    int rc;
+    int len;
 
+    if (!provider || !query || !results || !out_count) {
+        return run_search_command_daemon(inst, provider, query, results, out_count, err, err_len);
+    }
     normalize_provider_value(provider, clean_provider, sizeof(clean_provider));
-    snprintf(inst->search_provider, sizeof(inst->search_provider), "%s", clean_provider);
-    snprintf(inst->search_query, sizeof(inst->search_query), "%s", query);
-    inst->search_count = 0;
-    inst->search_elapsed_ms = 0;
-    set_search_status(inst, "searching", "");
-    inst->search_thread_running = true;
-
-    if (pthread_create(&inst->search_thread, NULL, search_thread_main, inst) != 0) {
-        inst->search_thread_running = false;
-        set_search_status(inst, "error", "failed to start search thread");
-        return -1;
+    sanitize_query(query, clean_query, sizeof(clean_query));
+    if (strcmp(clean_provider, LIBRARY_PROVIDER) == 0) {
+        if (err && err_len > 0) err[0] = '\0';
+        return search_library(clean_query, results, out_count);
+    }
+    snprintf(key, sizeof(key), "%s\t%s", clean_provider, clean_query);
+    if (ws_shc_get(g_shcache.seg, CACHE_KIND_SEARCH, key, CACHE_SEARCH_TTL_MS, wall_ms(), blob, sizeof(blob)) >= 0) {
+        *out_count = parse_cached_search(blob, clean_provider, results);
+        if (*out_count > 0) {
+            if (err && err_len > 0) err[0] = '\0';
+            return 0;
+        }
     }
 
-    inst->search_thread_valid = true;
-    return 0;
+    rc = run_search_command_daemon(inst, provider, query, results, out_count, err, err_len);
+    if (rc == 0 && *out_count > 0 && (len = format_cached_search(results, *out_count, blob, sizeof(blob))) > 0) {
+        ws_shc_put(g_shcache.seg, CACHE_KIND_SEARCH, key, blob, (size_t)len, wall_ms());
+    }
+    return rc;
 }
 
 static void clear_search_locked(yt_instance_t *inst) {
     if (!inst) return;
     inst->search_query[0] = '\0';
-    inst->queued_search_provider[0] = '\0';
-    inst->queued_search_query[0] = '\0';
-    inst->queued_search_pending = false;
     inst->search_count = 0;
     inst->search_elapsed_ms = 0;
     memset(inst->search_results, 0, sizeof(inst->search_results));
     set_search_status(inst, "idle", "");
 }
 
-static void* search_thread_main(void *arg) {
-    yt_instance_t *inst = (yt_instance_t *)arg;
+static void search_job(void *owner) {
+    yt_instance_t *inst = (yt_instance_t *)owner;
     char provider[PROVIDER_MAX];
     char query[SEARCH_QUERY_MAX];
-    char next_provider[PROVIDER_MAX];
-    char next_query[SEARCH_QUERY_MAX];
     search_result_t local_results[SEARCH_MAX_RESULTS];
     int local_count = 0;
     char local_err[256] = {0};
     char log_msg[320];
     int rc;
-    int start_next;
     uint64_t start_ms;
     uint64_t elapsed_ms;
 
-    if (!inst) return NULL;
+    if (!inst) return;
 
+    /* Latest request wins: searches submitted while this job was queued coalesced into it. */
     pthread_mutex_lock(&inst->search_mutex);
     snprintf(provider, sizeof(provider), "%s", inst->search_provider);
     snprintf(query, sizeof(query), "%s", inst->search_query);
+    if (query[0] == '\0') {
+        pthread_mutex_unlock(&inst->search_mutex);
+        return;
+    }
+    set_search_status(inst, "searching", "");
     pthread_mutex_unlock(&inst->search_mutex);
 
     snprintf(log_msg, sizeof(log_msg), "search started provider=%s", provider);
@@ -1218,36 +2659,15 @@ static void* search_thread_main(void *arg) {
     pthread_mutex_lock(&inst->search_mutex);
 
     if (strcmp(inst->search_query, query) != 0 || strcmp(inst->search_provider, provider) != 0) {
-        start_next = 0;
-        next_provider[0] = '\0';
-        next_query[0] = '\0';
-        if (inst->queued_search_pending &&
-            inst->queued_search_provider[0] != '\0' &&
-            inst->queued_search_query[0] != '\0') {
-            snprintf(next_provider, sizeof(next_provider), "%s", inst->queued_search_provider);
-            snprintf(next_query, sizeof(next_query), "%s", inst->queued_search_query);
-            inst->queued_search_pending = false;
-            inst->queued_search_provider[0] = '\0';
-            inst->queued_search_query[0] = '\0';
-            start_next = 1;
-        } else {
-            inst->search_thread_running = false;
-        }
+        /* Superseded; the newer request is already queued behind this job. */
         pthread_mutex_unlock(&inst->search_mutex);
-
-        if (start_next) {
-            pthread_mutex_lock(&inst->search_mutex);
-            if (spawn_search_thread_locked(inst, next_provider, next_query) == 0) {
-                snprintf(log_msg,
-                         sizeof(log_msg),
-                         "starting queued search provider=%s query=%s",
-                         next_provider,
-                         next_query);
-                yt_log(log_msg);
-            }
-            pthread_mutex_unlock(&inst->search_mutex);
-        }
-        return NULL;
+        snprintf(log_msg,
+                 sizeof(log_msg),
+                 "search superseded provider=%s elapsed_ms=%llu",
+                 provider,
+                 (unsigned long long)elapsed_ms);
+        yt_log(log_msg);
+        return;
     }
 
     inst->search_elapsed_ms = elapsed_ms;
@@ -1274,117 +2694,153 @@ static void* search_thread_main(void *arg) {
              (unsigned long long)elapsed_ms,
              local_err[0] ? local_err : "-");
     yt_log(log_msg);
-
-    start_next = 0;
-    next_provider[0] = '\0';
-    next_query[0] = '\0';
-    if (inst->queued_search_pending &&
-        inst->queued_search_provider[0] != '\0' &&
-        inst->queued_search_query[0] != '\0') {
-        snprintf(next_provider, sizeof(next_provider), "%s", inst->queued_search_provider);
-        snprintf(next_query, sizeof(next_query), "%s", inst->queued_search_query);
-        inst->queued_search_pending = false;
-        inst->queued_search_provider[0] = '\0';
-        inst->queued_search_query[0] = '\0';
-        start_next = 1;
-    } else {
-        inst->search_thread_running = false;
-    }
     pthread_mutex_unlock(&inst->search_mutex);
-
-    if (start_next) {
-        pthread_mutex_lock(&inst->search_mutex);
-        if (spawn_search_thread_locked(inst, next_provider, next_query) == 0) {
-            snprintf(log_msg,
-                     sizeof(log_msg),
-                     "starting queued search provider=%s query=%s",
-                     next_provider,
-                     next_query);
-            yt_log(log_msg);
-        }
-        pthread_mutex_unlock(&inst->search_mutex);
-    }
-
-    return NULL;
 }
 
+/* Caller must hold search_mutex. */
 static int start_search_async(yt_instance_t *inst, const char *query) {
     char provider[PROVIDER_MAX];
+    int rc;
 
     if (!inst || !query || query[0] == '\0') return -1;
 
     normalize_provider_value(inst->search_provider, provider, sizeof(provider));
+    snprintf(inst->search_provider, sizeof(inst->search_provider), "%s", provider);
+    snprintf(inst->search_query, sizeof(inst->search_query), "%s", query);
+    inst->search_count = 0;
+    inst->search_elapsed_ms = 0;
 
-    if (inst->search_thread_valid && !inst->search_thread_running) {
-        pthread_join(inst->search_thread, NULL);
-        inst->search_thread_valid = false;
+    rc = ws_pool_submit(WS_JOB_SEARCH, inst, search_job);
+    if (rc < 0) {
+        set_search_status(inst, "error", "failed to queue search");
+    } else if (rc > 0) {
+        set_search_status(inst, "queued", "search queued");
+    } else {
+        set_search_status(inst, "searching", "");
     }
+    return rc;
+}
 
-    if (inst->search_thread_running) {
-        snprintf(inst->queued_search_provider, sizeof(inst->queued_search_provider), "%s", provider);
-        snprintf(inst->queued_search_query, sizeof(inst->queued_search_query), "%s", query);
-        inst->queued_search_pending = true;
-        set_search_status(inst, "queued", "search queued");
-        return 1;
+/*
+ * Splits a resolve blob in place: "media_url\tuser_agent\treferer", optionally
+ * followed by "\tkbps" and up to LADDER_MAX_RUNGS "\tkbps\turl" fast-start
+ * rungs, lowest bitrate first. Returns -1 without a media URL.
+ */
+static int parse_resolve_reply(char *blob, resolve_reply_t *r) {
+    char *fields[4 + LADDER_MAX_RUNGS * 2];
+    int n;
+    int i;
+
+    memset(r, 0, sizeof(*r));
+    n = split_tab_fields(blob, fields, (int)(sizeof(fields) / sizeof(fields[0])));
+    if (n < 1 || fields[0][0] == '\0') return -1;
+    r->media_url = fields[0];
+    r->user_agent = n >= 2 ? fields[1] : "";
+    r->referer = n >= 3 ? fields[2] : "";
+    if (n >= 4) r->kbps = (uint32_t)strtoul(fields[3], NULL, 10);
+    for (i = 4; i + 1 < n && r->rung_count < LADDER_MAX_RUNGS; i += 2) {
+        uint32_t kbps = (uint32_t)strtoul(fields[i], NULL, 10);
+        /* Only rungs clearly smaller than the full format are worth a second decoder. */
+        if (kbps == 0 || r->kbps == 0 || kbps >= r->kbps || fields[i + 1][0] == '\0') continue;
+        r->rung_kbps[r->rung_count] = kbps;
+        r->rung_url[r->rung_count] = fields[i + 1];
+        r->rung_count++;
     }
+    return 0;
+}
+
+/* Writes a sanitized resolve blob (see parse_resolve_reply) from the daemon's RESOLVE_OK fields. */
+static int format_resolve_blob(char **fields, int field_count, char *blob, size_t blob_len, char *err, size_t err_len) {
+    char url[STREAM_URL_MAX];
+    char user_agent[HTTP_HEADER_MAX];
+    char referer[HTTP_HEADER_MAX];
+    uint32_t kbps = field_count >= 5 ? (uint32_t)strtoul(fields[4], NULL, 10) : 0;
+    size_t pos;
+    int n;
+    int i;
 
-    return spawn_search_thread_locked(inst, provider, query);
+    if (!sanitize_any_http_url(fields[1], url, sizeof(url))) {
+        if (err && err_len > 0) snprintf(err, err_len, "daemon resolve url invalid");
+        return -1;
+    }
+    sanitize_header_text(field_count >= 3 ? fields[2] : "", user_agent, sizeof(user_agent));
+    sanitize_header_text(field_count >= 4 ? fields[3] : "", referer, sizeof(referer));
+    n = snprintf(blob, blob_len, "%s\t%s\t%s", url, user_agent, referer);
+    if (n < 0 || (size_t)n >= blob_len) return -1;
+    pos = (size_t)n;
+    if (kbps == 0) return 0;
+
+    n = snprintf(blob + pos, blob_len - pos, "\t%u", kbps);
+    if (n > 0 && (size_t)n < blob_len - pos) pos += (size_t)n;
+    for (i = 5; i + 1 < field_count && i < 5 + LADDER_MAX_RUNGS * 2; i += 2) {
+        uint32_t rung_kbps = (uint32_t)strtoul(fields[i], NULL, 10);
+        if (rung_kbps == 0 || !sanitize_any_http_url(fields[i + 1], url, sizeof(url))) continue;
+        n = snprintf(blob + pos, blob_len - pos, "\t%u\t%s", rung_kbps, url);
+        if (n < 0 || (size_t)n >= blob_len - pos) break;
+        pos += (size_t)n;
+    }
+    blob[pos] = '\0';
+    return 0;
 }
 
 static int resolve_stream_url_daemon(yt_instance_t *inst,
                                      const char *provider,
                                      const char *source_url,
-                                     char *media_url,
-                                     size_t media_url_len,
-                                     char *user_agent,
-                                     size_t user_agent_len,
-                                     char *referer,
-                                     size_t referer_len,
+                                     char *blob,
+                                     size_t blob_len,
                                      char *err,
                                      size_t err_len) {
     char clean_provider[PROVIDER_MAX];
-    char req[STREAM_URL_MAX + PROVIDER_MAX + 16];
+    char req[STREAM_URL_MAX + PROVIDER_MAX + 48];
+    char tag[32];
     char line[DAEMON_LINE_MAX];
-    char *fields[5];
+    char *fields[5 + LADDER_MAX_RUNGS * 2];
     int field_count;
+    int rc;
 
-    if (!inst || !provider || !source_url || !media_url || media_url_len == 0) return -1;
+    if (!inst || !provider || !source_url || !blob || blob_len == 0) return -1;
 
     normalize_provider_value(provider, clean_provider, sizeof(clean_provider));
 
-    pthread_mutex_lock(&inst->daemon_mutex);
+    __atomic_fetch_add(&g_daemon.resolve_waiting, 1, __ATOMIC_ACQ_REL);
+    rc = daemon_lock(inst);
+    __atomic_fetch_sub(&g_daemon.resolve_waiting, 1, __ATOMIC_ACQ_REL);
+    if (rc != 0) {
+        if (err && err_len > 0) snprintf(err, err_len, "cancelled");
+        return -1;
+    }
     if (start_daemon_locked(inst, err, err_len) != 0) {
-        pthread_mutex_unlock(&inst->daemon_mutex);
+        pthread_mutex_unlock(&g_daemon.mutex);
         return -1;
     }
 
-    snprintf(req, sizeof(req), "RESOLVE\t%s\t%s\n", clean_provider, source_url);
-    if (fputs(req, inst->daemon_in) == EOF || fflush(inst->daemon_in) != 0) {
+    daemon_request_tag(inst, tag, sizeof(tag));
+    snprintf(req, sizeof(req), "%s\tRESOLVE\t%s\t%s\n", tag, clean_provider, source_url);
+    if (daemon_write_locked(req) != 0) {
         if (err && err_len > 0) snprintf(err, err_len, "daemon write failed");
-        stop_daemon_locked(inst);
-        pthread_mutex_unlock(&inst->daemon_mutex);
+        stop_daemon_locked();
+        pthread_mutex_unlock(&g_daemon.mutex);
         return -1;
     }
 
-    if (read_daemon_line_locked(inst, line, sizeof(line), DAEMON_RESOLVE_TIMEOUT_MS) != 0) {
+    if (read_daemon_reply_locked(inst, tag, line, sizeof(line), DAEMON_RESOLVE_TIMEOUT_MS) != 0) {
+        if (daemon_cancelled(inst)) {
+            if (err && err_len > 0) snprintf(err, err_len, "cancelled");
+            pthread_mutex_unlock(&g_daemon.mutex);
+            return -1;
+        }
         if (err && err_len > 0) snprintf(err, err_len, "daemon resolve timeout");
-        stop_daemon_locked(inst);
-        pthread_mutex_unlock(&inst->daemon_mutex);
+        stop_daemon_locked();
+        pthread_mutex_unlock(&g_daemon.mutex);
         return -1;
     }
 
-    field_count = split_tab_fields(line, fields, 5);
+    field_count = split_tab_fields(line, fields, (int)(sizeof(fields) / sizeof(fields[0])));
     if (field_count >= 2 && strcmp(fields[0], "RESOLVE_OK") == 0) {
-        if (!sanitize_any_http_url(fields[1], media_url, media_url_len)) {
-            if (err && err_len > 0) snprintf(err, err_len, "daemon resolve url invalid");
-            pthread_mutex_unlock(&inst->daemon_mutex);
-            return -1;
-        }
-        sanitize_header_text(field_count >= 3 ? fields[2] : "", user_agent, user_agent_len);
-        sanitize_header_text(field_count >= 4 ? fields[3] : "", referer, referer_len);
-        if (err && err_len > 0) err[0] = '\0';
-        pthread_mutex_unlock(&inst->daemon_mutex);
-        return 0;
+        rc = format_resolve_blob(fields, field_count, blob, blob_len, err, err_len);
+        if (rc == 0 && err && err_len > 0) err[0] = '\0';
+        pthread_mutex_unlock(&g_daemon.mutex);
+        return rc;
     }
 
     if (field_count >= 2 && strcmp(fields[0], "ERROR") == 0) {
@@ -1392,7 +2848,7 @@ static int resolve_stream_url_daemon(yt_instance_t *inst,
     } else if (err && err_len > 0) {
         snprintf(err, err_len, "daemon resolve failed");
     }
-    pthread_mutex_unlock(&inst->daemon_mutex);
+    pthread_mutex_unlock(&g_daemon.mutex);
     return -1;
 }
 
@@ -1444,230 +2900,2246 @@ static int resolve_stream_url_legacy(const yt_instance_t *inst,
     return 0;
 }
 
+static void resolve_cache_key(const char *provider, const char *source_url, char *key, size_t key_len) {
+    char clean_provider[PROVIDER_MAX];
+    normalize_provider_value(provider, clean_provider, sizeof(clean_provider));
+    snprintf(key, key_len, "%s\t%s", clean_provider, source_url);
+}
+
+/* Resolve blobs (see parse_resolve_reply) are shared through the cache (ws_shcache.h). */
 static int resolve_stream_url(yt_instance_t *inst,
                               const char *provider,
                               const char *source_url,
-                              char *media_url,
-                              size_t media_url_len,
-                              char *user_agent,
-                              size_t user_agent_len,
-                              char *referer,
-                              size_t referer_len,
+                              char *blob,
+                              size_t blob_len,
                               char *err,
                               size_t err_len) {
-    return resolve_stream_url_daemon(inst,
-                                     provider,
-                                     source_url,
-                                     media_url,
-                                     media_url_len,
-                                     user_agent,
-                                     user_agent_len,
-                                     referer,
-                                     referer_len,
-                                     err,
-                                     err_len);
-}
-
-static void* resolve_thread_main(void *arg) {
-    yt_instance_t *inst = (yt_instance_t *)arg;
-    char source_provider[PROVIDER_MAX];
-    char source_url[STREAM_URL_MAX];
-    char media_url[STREAM_URL_MAX];
-    char user_agent[HTTP_HEADER_MAX];
-    char referer[HTTP_HEADER_MAX];
-    char err[256];
+    char key[PROVIDER_MAX + STREAM_URL_MAX + 2];
+    size_t len;
+    size_t i;
+    int tabs = 0;
     int rc;
-    char log_msg[320];
-
-    if (!inst) return NULL;
-
-    pthread_mutex_lock(&inst->resolve_mutex);
-    snprintf(source_provider, sizeof(source_provider), "%s", inst->stream_provider);
-    snprintf(source_url, sizeof(source_url), "%s", inst->stream_url);
-    pthread_mutex_unlock(&inst->resolve_mutex);
-    infer_provider_from_url(source_url, source_provider, sizeof(source_provider));
-    normalize_provider_value(source_provider, source_provider, sizeof(source_provider));
-    snprintf(log_msg, sizeof(log_msg), "resolve started provider=%s url=%s", source_provider, source_url);
-    yt_log(log_msg);
-
-    media_url[0] = '\0';
-    user_agent[0] = '\0';
-    referer[0] = '\0';
-    err[0] = '\0';
-    rc = resolve_stream_url(inst,
-                            source_provider,
-                            source_url,
-                            media_url,
-                            sizeof(media_url),
-                            user_agent,
-                            sizeof(user_agent),
-                            referer,
-                            sizeof(referer),
-                            err,
-                            sizeof(err));
 
-    pthread_mutex_lock(&inst->resolve_mutex);
-    if (strcmp(inst->stream_provider, source_provider) == 0 &&
-        strcmp(inst->stream_url, source_url) == 0 &&
-        source_url[0] != '\0') {
-        if (rc == 0) {
-            inst->resolve_ready = true;
-            inst->resolve_failed = false;
-            snprintf(inst->resolved_media_url, sizeof(inst->resolved_media_url), "%s", media_url);
-            snprintf(inst->resolved_user_agent, sizeof(inst->resolved_user_agent), "%s", user_agent);
-            snprintf(inst->resolved_referer, sizeof(inst->resolved_referer), "%s", referer);
-            inst->resolve_error[0] = '\0';
-        } else {
-            inst->resolve_ready = false;
-            inst->resolve_failed = true;
-            snprintf(inst->resolve_error, sizeof(inst->resolve_error), "%s", err[0] ? err : "resolve failed");
-        }
+    if (!provider || !source_url || !blob || blob_len == 0) return -1;
+    resolve_cache_key(provider, source_url, key, sizeof(key));
+    if (ws_shc_get(g_shcache.seg, CACHE_KIND_RESOLVE, key, CACHE_RESOLVE_TTL_MS, wall_ms(), blob, blob_len) >= 0 &&
+        blob[0] != '\0' && blob[0] != '\t') {
+        if (err && err_len > 0) err[0] = '\0';
+        return 0;
     }
-    inst->resolve_thread_running = false;
-    pthread_mutex_unlock(&inst->resolve_mutex);
 
+    rc = resolve_stream_url_daemon(inst, provider, source_url, blob, blob_len, err, err_len);
     if (rc == 0) {
-        snprintf(log_msg, sizeof(log_msg), "resolve finished provider=%s", source_provider);
-        yt_log(log_msg);
-    } else {
-        snprintf(log_msg, sizeof(log_msg), "resolve failed provider=%s: %s", source_provider, err[0] ? err : "unknown");
-        yt_log(log_msg);
+        len = strlen(blob);
+        /* Long signed URLs can overflow a cache slot with the ladder; keep the full-quality part. */
+        for (i = 0; i < len && len > WS_SHC_VAL_MAX; i++) {
+            if (blob[i] == '\t' && ++tabs == 4) len = i;
+        }
+        ws_shc_put(g_shcache.seg, CACHE_KIND_RESOLVE, key, blob, len, wall_ms());
     }
+    return rc;
+}
 
+/* key=value lines from ffprobe default output; stream values win over container values. */
+static void parse_probe_line(char *line, uint64_t *duration_ms, uint32_t *bitrate_kbps, char *codec, size_t codec_len) {
+    char *eq;
+    const char *val;
+
+    trim_line_end(line);
+    eq = strchr(line, '=');
+    if (!eq) return;
+    *eq = '\0';
+    val = eq + 1;
+    if (strcmp(val, "N/A") == 0 || val[0] == '\0') return;
+
+    if (strcmp(line, "duration") == 0 && *duration_ms == 0) {
+        double secs = strtod(val, NULL);
+        if (secs > 0.0) *duration_ms = (uint64_t)(secs * 1000.0);
+    } else if (strcmp(line, "bit_rate") == 0 && *bitrate_kbps == 0) {
+        long long bps = strtoll(val, NULL, 10);
+        if (bps > 0) *bitrate_kbps = (uint32_t)((bps + 500) / 1000);
+    } else if (strcmp(line, "codec_name") == 0 && codec[0] == '\0') {
+        snprintf(codec, codec_len, "%s", val);
+        sanitize_display_text(codec);
+    }
+}
+
+static void probe_job(void *owner) {
+    yt_instance_t *inst = (yt_instance_t *)owner;
+    char url[STREAM_URL_MAX];
+    char ffprobe_path[640];
+    char line[512];
+    char codec[PROBE_CODEC_MAX];
+    char log_msg[192];
+    uint64_t duration_ms = 0;
+    uint32_t bitrate_kbps = 0;
+    uint32_t generation;
+    int pipefd[2];
+    pid_t pid;
+    FILE *fp;
+    int status;
+    siginfo_t exited;
+    ws_sched_policy_t sched;
+    cpu_set_t cpus;
+    bool pin;
+
+    if (!inst) return;
+
+    pthread_mutex_lock(&inst->resolve_mutex);
+    snprintf(url, sizeof(url), "%s", inst->probe_url);
+    generation = inst->probe_url_generation;
+    if (generation != inst->probe_generation) {
+        /* Cancelled (stream stopped or replaced) while queued. */
+        pthread_mutex_unlock(&inst->resolve_mutex);
+        return;
+    }
+    pthread_mutex_unlock(&inst->resolve_mutex);
+
+    codec[0] = '\0';
+    snprintf(ffprobe_path, sizeof(ffprobe_path), "%s/bin/ffprobe", inst->module_dir);
+    if (access(ffprobe_path, X_OK) != 0 || pipe2(pipefd, O_CLOEXEC) != 0) goto done;
+
+    (void)ws_sched_prepare(&sched, &cpus, &pin);
+    pid = fork();
+    if (pid < 0) {
+        close(pipefd[0]);
+        close(pipefd[1]);
+        goto done;
+    }
+    if (pid == 0) {
+        (void)setpgid(0, 0);
+        ws_sched_apply_child(&sched, pin ? &cpus : NULL);
+        dup2(pipefd[1], STDOUT_FILENO);
+        close(pipefd[0]);
+        close(pipefd[1]);
+        execl(ffprobe_path, "ffprobe", "-v", "error",
+              "-rw_timeout", PROBE_RW_TIMEOUT_US,
+              "-select_streams", "a:0",
+              "-show_entries", "stream=codec_name,bit_rate,duration:format=duration,bit_rate",
+              "-of", "default=noprint_wrappers=1",
+              url, (char *)NULL);
+        _exit(127);
+    }
+    ws_stat_inc(&inst->stats.spawns_probe);
+    ws_proc_note_spawn();
+    trace_event(inst, "probe", 'B', TRACE_TID_PROBE, 0);
+    close(pipefd[1]);
+
+    pthread_mutex_lock(&inst->resolve_mutex);
+    inst->probe_pid = pid;
+    pthread_mutex_unlock(&inst->resolve_mutex);
+
+    fp = fdopen(pipefd[0], "r");
+    if (fp) {
+        while (fgets(line, sizeof(line), fp)) {
+            parse_probe_line(line, &duration_ms, &bitrate_kbps, codec, sizeof(codec));
+        }
+        fclose(fp);
+    } else {
+        close(pipefd[0]);
+    }
+    /* Wait without reaping so the pid (and group) cannot be reused while another thread may still kill it. */
+    while (waitid(P_PID, (id_t)pid, &exited, WEXITED | WNOWAIT) != 0 && errno == EINTR) {
+    }
+    pthread_mutex_lock(&inst->resolve_mutex);
+    inst->probe_pid = -1;
+    pthread_mutex_unlock(&inst->resolve_mutex);
+    (void)waitpid(pid, &status, 0);
+    ws_proc_note_reaped();
+    trace_event(inst, "probe", 'E', TRACE_TID_PROBE, duration_ms);
+
+done:
+    pthread_mutex_lock(&inst->resolve_mutex);
+    inst->probe_pid = -1;
+    if (generation == inst->probe_generation && (duration_ms > 0 || bitrate_kbps > 0 || codec[0] != '\0')) {
+        inst->probe_duration_ms = duration_ms;
+        inst->probe_bitrate_kbps = bitrate_kbps;
+        snprintf(inst->probe_codec, sizeof(inst->probe_codec), "%s", codec);
+        inst->probe_ready = true;
+    }
+    pthread_mutex_unlock(&inst->resolve_mutex);
+
+    snprintf(log_msg,
+             sizeof(log_msg),
+             "probe finished duration_ms=%llu bitrate_kbps=%u codec=%s",
+             (unsigned long long)duration_ms,
+             bitrate_kbps,
+             codec[0] ? codec : "?");
+    yt_log(log_msg);
+}
+
+/* Queued by the resolve job after the URL is published, so it never delays first audio. */
+static void start_probe_async(yt_instance_t *inst, const char *media_url) {
+    pthread_mutex_lock(&inst->resolve_mutex);
+    /* A probe of the previous URL is killed, not awaited; its job returns promptly. */
+    if (inst->probe_pid > 0) (void)kill(-inst->probe_pid, SIGKILL);
+    snprintf(inst->probe_url, sizeof(inst->probe_url), "%s", media_url);
+    inst->probe_url_generation = inst->probe_generation;
+    inst->probe_ready = false;
+    pthread_mutex_unlock(&inst->resolve_mutex);
+    (void)ws_pool_submit(WS_JOB_PROBE, inst, probe_job);
+}
+
+static void resolve_job(void *owner) {
+    yt_instance_t *inst = (yt_instance_t *)owner;
+    char source_provider[PROVIDER_MAX];
+    char source_url[STREAM_URL_MAX];
+    char blob[RESOLVE_BLOB_MAX];
+    char media_url[STREAM_URL_MAX];
+    resolve_reply_t reply;
+    char err[256];
+    int i;
+    int rc;
+    bool published = false;
+    char log_msg[320];
+    uint64_t started_ms;
+
+    if (!inst) return;
+
+    pthread_mutex_lock(&inst->resolve_mutex);
+    snprintf(source_provider, sizeof(source_provider), "%s", inst->stream_provider);
+    snprintf(source_url, sizeof(source_url), "%s", inst->stream_url);
+    pthread_mutex_unlock(&inst->resolve_mutex);
+    infer_provider_from_url(source_url, source_provider, sizeof(source_provider));
+    normalize_provider_value(source_provider, source_provider, sizeof(source_provider));
+    snprintf(log_msg, sizeof(log_msg), "resolve started provider=%s url=%s", source_provider, source_url);
+    yt_log(log_msg);
+
+    blob[0] = '\0';
+    err[0] = '\0';
+    started_ms = now_ms();
+    trace_event(inst, "resolve", 'B', TRACE_TID_RESOLVE, 0);
+    rc = resolve_stream_url(inst, source_provider, source_url, blob, sizeof(blob), err, sizeof(err));
+    if (rc == 0 && parse_resolve_reply(blob, &reply) != 0) {
+        snprintf(err, sizeof(err), "resolve reply malformed");
+        rc = -1;
+    }
+    if (rc == 0) snprintf(media_url, sizeof(media_url), "%s", reply.media_url);
+    trace_event(inst, "resolve", 'E', TRACE_TID_RESOLVE, rc == 0 ? 0 : 1);
+    ws_hist_record(&inst->stats.resolve_ms, now_ms() - started_ms);
+    if (rc != 0) ws_stat_inc(&inst->stats.resolve_failures);
+
+    pthread_mutex_lock(&inst->resolve_mutex);
+    if (strcmp(inst->stream_provider, source_provider) == 0 &&
+        strcmp(inst->stream_url, source_url) == 0 &&
+        source_url[0] != '\0') {
+        published = rc == 0;
+        if (rc == 0) {
+            inst->resolve_ready = true;
+            inst->resolve_failed = false;
+            snprintf(inst->resolved_media_url, sizeof(inst->resolved_media_url), "%s", media_url);
+            snprintf(inst->resolved_user_agent, sizeof(inst->resolved_user_agent), "%s", reply.user_agent);
+            snprintf(inst->resolved_referer, sizeof(inst->resolved_referer), "%s", reply.referer);
+            inst->resolved_kbps = reply.kbps;
+            inst->resolved_rung_count = reply.rung_count;
+            inst->resolved_local = false;
+            for (i = 0; i < reply.rung_count; i++) {
+                inst->resolved_rungs[i].kbps = reply.rung_kbps[i];
+                snprintf(inst->resolved_rungs[i].url, sizeof(inst->resolved_rungs[i].url), "%s", reply.rung_url[i]);
+            }
+            inst->resolve_error[0] = '\0';
+        } else {
+            inst->resolve_ready = false;
+            inst->resolve_failed = true;
+            snprintf(inst->resolve_error, sizeof(inst->resolve_error), "%s", err[0] ? err : "resolve failed");
+        }
+    }
+    inst->resolve_pending = false;
+    pthread_mutex_unlock(&inst->resolve_mutex);
+
+    if (rc == 0) {
+        snprintf(log_msg, sizeof(log_msg), "resolve finished provider=%s", source_provider);
+        yt_log(log_msg);
+        if (published) start_probe_async(inst, media_url);
+    } else {
+        snprintf(log_msg, sizeof(log_msg), "resolve failed provider=%s: %s", source_provider, err[0] ? err : "unknown");
+        yt_log(log_msg);
+    }
+}
+
+static int start_resolve_async(yt_instance_t *inst) {
+    if (!inst) return -1;
+
+    pthread_mutex_lock(&inst->resolve_mutex);
+    if (inst->stream_url[0] == '\0') {
+        pthread_mutex_unlock(&inst->resolve_mutex);
+        return -1;
+    }
+
+    if (inst->resolve_pending) {
+        pthread_mutex_unlock(&inst->resolve_mutex);
+        return 1;
+    }
+
+    inst->resolve_ready = false;
+    inst->resolve_failed = false;
+    inst->resolved_media_url[0] = '\0';
+    inst->resolved_user_agent[0] = '\0';
+    inst->resolved_referer[0] = '\0';
+    inst->resolved_kbps = 0;
+    inst->resolved_rung_count = 0;
+    inst->resolved_local = false;
+    inst->resolve_error[0] = '\0';
+    inst->resolve_pending = true;
+
+    /* Highest job priority: the user is waiting on this one. */
+    if (ws_pool_submit(WS_JOB_RESOLVE, inst, resolve_job) < 0) {
+        inst->resolve_pending = false;
+        inst->resolve_failed = true;
+        snprintf(inst->resolve_error, sizeof(inst->resolve_error), "failed to queue resolve");
+        pthread_mutex_unlock(&inst->resolve_mutex);
+        return -1;
+    }
+
+    pthread_mutex_unlock(&inst->resolve_mutex);
+    return 0;
+}
+
+static const char *library_dir(void) {
+    const char *dir = getenv("WEBSTREAM_LIBRARY_DIR");
+    return dir && dir[0] ? dir : LIBRARY_DIR;
+}
+
+static void offline_failed(yt_instance_t *inst, const search_result_t *item, const char *why) {
+    char log_msg[384];
+
+    ws_stat_inc(&g_library.save_failures);
+    pthread_mutex_lock(&inst->offline_mutex);
+    snprintf(inst->offline_error, sizeof(inst->offline_error), "%.96s: %s", item->title, why);
+    pthread_mutex_unlock(&inst->offline_mutex);
+    snprintf(log_msg, sizeof(log_msg), "offline save failed provider=%s url=%s: %s", item->provider, item->url, why);
+    yt_log(log_msg);
+}
+
+/*
+ * Saves one item into the library: the media URL comes through the shared
+ * cache and warm daemon like a play would, then library_fetch.py downloads
+ * it at offline_rate_kbps into a .part file that only becomes the library
+ * file once complete.
+ */
+static void save_library_item(yt_instance_t *inst, const search_result_t *item) {
+    char blob[RESOLVE_BLOB_MAX];
+    char err[256];
+    char helper[640];
+    char path[WS_LIB_PATH_MAX];
+    char part[WS_LIB_PATH_MAX + 8];
+    char rate[16];
+    char line[512];
+    char log_msg[384];
+    resolve_reply_t reply;
+    ws_lib_item_t saved;
+    ws_sched_policy_t sched;
+    cpu_set_t cpus;
+    bool pin;
+    bool cancelled;
+    bool done = false;
+    struct stat st;
+    int pipefd[2];
+    pid_t pid;
+    FILE *fp;
+    int status = 0;
+
+    if (ws_lib_contains(item->provider, item->url)) return;
+
+    err[0] = '\0';
+    if (resolve_stream_url(inst, item->provider, item->url, blob, sizeof(blob), err, sizeof(err)) != 0 ||
+        parse_resolve_reply(blob, &reply) != 0) {
+        offline_failed(inst, item, err[0] ? err : "resolve failed");
+        return;
+    }
+
+    memset(&saved, 0, sizeof(saved));
+    ws_lib_file_name(item->provider, item->url, saved.file, sizeof(saved.file));
+    ws_lib_path(saved.file, path, sizeof(path));
+    snprintf(part, sizeof(part), "%s.part", path);
+    snprintf(helper, sizeof(helper), "%s/bin/library_fetch.py", inst->module_dir);
+    snprintf(rate, sizeof(rate), "%u", __atomic_load_n(&inst->offline_rate_kbps, __ATOMIC_RELAXED));
+    if (access(helper, R_OK) != 0 || pipe2(pipefd, O_CLOEXEC) != 0) {
+        offline_failed(inst, item, "library_fetch.py unavailable");
+        return;
+    }
+
+    (void)ws_sched_prepare(&sched, &cpus, &pin);
+    pid = fork();
+    if (pid < 0) {
+        close(pipefd[0]);
+        close(pipefd[1]);
+        offline_failed(inst, item, "fork failed");
+        return;
+    }
+    if (pid == 0) {
+        (void)setpgid(0, 0);
+        ws_sched_apply_child(&sched, pin ? &cpus : NULL);
+        dup2(pipefd[1], STDOUT_FILENO);
+        close(pipefd[0]);
+        close(pipefd[1]);
+        execlp("python3", "python3", helper,
+               "--url", reply.media_url,
+               "--out", path,
+               "--rate-kbps", rate,
+               "--user-agent", reply.user_agent,
+               "--referer", reply.referer,
+               (char *)NULL);
+        _exit(127);
+    }
+    ws_proc_note_spawn();
+    close(pipefd[1]);
+
+    /* destroy_instance sets daemon_cancel before it looks for offline_pid; one of us kills it. */
+    pthread_mutex_lock(&inst->offline_mutex);
+    inst->offline_pid = pid;
+    cancelled = daemon_cancelled(inst);
+    pthread_mutex_unlock(&inst->offline_mutex);
+    if (cancelled) (void)kill(-pid, SIGKILL);
+
+    fp = fdopen(pipefd[0], "r");
+    if (fp) {
+        while (fgets(line, sizeof(line), fp)) {
+            unsigned long long got = 0;
+            unsigned long long total = 0;
+
+            trim_line_end(line);
+            if (sscanf(line, "PROGRESS %llu %llu", &got, &total) >= 1) {
+                pthread_mutex_lock(&inst->offline_mutex);
+                inst->offline_done_bytes = got;
+                inst->offline_total_bytes = total;
+                pthread_mutex_unlock(&inst->offline_mutex);
+            } else if (strncmp(line, "DONE ", 5) == 0) {
+                done = true;
+            } else if (strncmp(line, "ERROR ", 6) == 0) {
+                snprintf(err, sizeof(err), "%s", line + 6);
+            }
+        }
+        fclose(fp);
+    } else {
+        close(pipefd[0]);
+    }
+    (void)waitpid(pid, &status, 0);
+    ws_proc_note_reaped();
+    pthread_mutex_lock(&inst->offline_mutex);
+    inst->offline_pid = -1;
+    pthread_mutex_unlock(&inst->offline_mutex);
+
+    if (!done || !WIFEXITED(status) || WEXITSTATUS(status) != 0 || stat(path, &st) != 0) {
+        (void)unlink(part);
+        offline_failed(inst, item, err[0] ? err : (daemon_cancelled(inst) ? "cancelled" : "download failed"));
+        return;
+    }
+
+    snprintf(saved.provider, sizeof(saved.provider), "%s", item->provider);
+    snprintf(saved.url, sizeof(saved.url), "%s", item->url);
+    snprintf(saved.title, sizeof(saved.title), "%s", item->title);
+    snprintf(saved.channel, sizeof(saved.channel), "%s", item->channel);
+    snprintf(saved.duration, sizeof(saved.duration), "%s", item->duration);
+    saved.bytes = (uint64_t)st.st_size;
+    saved.saved_s = wall_ms() / 1000ULL;
+    ws_lib_add(&saved);
+    ws_stat_inc(&g_library.saves);
+    snprintf(log_msg, sizeof(log_msg), "offline saved provider=%s bytes=%llu url=%s", item->provider,
+             (unsigned long long)saved.bytes, item->url);
+    yt_log(log_msg);
+}
+
+static void save_job(void *owner) {
+    yt_instance_t *inst = (yt_instance_t *)owner;
+    search_result_t item;
+    bool more;
+
+    if (!inst) return;
+
+    pthread_mutex_lock(&inst->offline_mutex);
+    if (inst->offline_queued == 0 || daemon_cancelled(inst)) {
+        pthread_mutex_unlock(&inst->offline_mutex);
+        return;
+    }
+    item = inst->offline_queue[0];
+    inst->offline_queued--;
+    memmove(&inst->offline_queue[0], &inst->offline_queue[1], (size_t)inst->offline_queued * sizeof(item));
+    snprintf(inst->offline_title, sizeof(inst->offline_title), "%s", item.title);
+    inst->offline_done_bytes = 0;
+    inst->offline_total_bytes = 0;
+    pthread_mutex_unlock(&inst->offline_mutex);
+
+    save_library_item(inst, &item);
+
+    pthread_mutex_lock(&inst->offline_mutex);
+    inst->offline_title[0] = '\0';
+    more = inst->offline_queued > 0 && !daemon_cancelled(inst);
+    pthread_mutex_unlock(&inst->offline_mutex);
+    /* One item per job: a resolve queued meanwhile gets the next free worker first. */
+    if (more) (void)ws_pool_submit(WS_JOB_SAVE, inst, save_job);
+}
+
+/* Destroy: queued saves are dropped; one in progress is killed and its .part removed by the job. */
+static void cancel_offline_saves(yt_instance_t *inst) {
+    pthread_mutex_lock(&inst->offline_mutex);
+    inst->offline_queued = 0;
+    if (inst->offline_pid > 0) (void)kill(-inst->offline_pid, SIGKILL);
+    pthread_mutex_unlock(&inst->offline_mutex);
+}
+
+/* offline_save=<n>: queues search result n. Returns 1 when it is already saved or queued. */
+static int queue_offline_save(yt_instance_t *inst, int index) {
+    search_result_t item;
+    int i;
+
+    pthread_mutex_lock(&inst->search_mutex);
+    if (index < 0 || index >= inst->search_count) {
+        pthread_mutex_unlock(&inst->search_mutex);
+        return -1;
+    }
+    item = inst->search_results[index];
+    pthread_mutex_unlock(&inst->search_mutex);
+    if (item.url[0] == '\0') return -1;
+    infer_provider_from_url(item.url, item.provider, sizeof(item.provider));
+    normalize_provider_value(item.provider, item.provider, sizeof(item.provider));
+    if (ws_lib_contains(item.provider, item.url)) return 1;
+
+    pthread_mutex_lock(&inst->offline_mutex);
+    for (i = 0; i < inst->offline_queued; i++) {
+        if (strcmp(inst->offline_queue[i].url, item.url) == 0) {
+            pthread_mutex_unlock(&inst->offline_mutex);
+            return 1;
+        }
+    }
+    if (inst->offline_queued >= OFFLINE_QUEUE_MAX) {
+        snprintf(inst->offline_error, sizeof(inst->offline_error), "save queue full");
+        pthread_mutex_unlock(&inst->offline_mutex);
+        return -1;
+    }
+    inst->offline_queue[inst->offline_queued++] = item;
+    pthread_mutex_unlock(&inst->offline_mutex);
+    return ws_pool_submit(WS_JOB_SAVE, inst, save_job) < 0 ? -1 : 0;
+}
+
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t read_le16(const uint8_t *p) {
+    return (uint16_t)((uint16_t)p[0] | ((uint16_t)p[1] << 8));
+}
+
+/*
+ * ffmpeg writes a streaming WAV header (sizes unknown) ahead of the PCM so the
+ * native source rate arrives in-band. Consumes header bytes from data and
+ * reports how many were used; returns -1 for anything but 16-bit stereo PCM.
+ */
+static int consume_wav_header(wav_reader_t *w, const uint8_t *data, size_t len, size_t *used) {
+    size_t pos = 0;
+
+    while (pos < len && w->state != WAV_DATA) {
+        size_t want;
+        size_t take;
+
+        if (w->skip_bytes > 0) {
+            take = len - pos;
+            if ((uint64_t)take > w->skip_bytes) take = (size_t)w->skip_bytes;
+            w->skip_bytes -= take;
+            pos += take;
+            continue;
+        }
+
+        if (w->state == WAV_PREAMBLE) want = 12;
+        else if (w->state == WAV_CHUNK_HEADER) want = 8;
+        else want = w->fmt_len;
+
+        take = want - w->header_len;
+        if (take > len - pos) take = len - pos;
+        memcpy(w->header + w->header_len, data + pos, take);
+        w->header_len += take;
+        pos += take;
+        if (w->header_len < want) break;
+        w->header_len = 0;
+
+        if (w->state == WAV_PREAMBLE) {
+            if (memcmp(w->header, "RIFF", 4) != 0 || memcmp(w->header + 8, "WAVE", 4) != 0) {
+                return -1;
+            }
+            w->state = WAV_CHUNK_HEADER;
+        } else if (w->state == WAV_CHUNK_HEADER) {
+            w->chunk_size = read_le32(w->header + 4);
+            if (memcmp(w->header, "data", 4) == 0) {
+                if (w->rate == 0) return -1;
+                w->state = WAV_DATA;
+            } else if (memcmp(w->header, "fmt ", 4) == 0) {
+                if (w->chunk_size < 16) return -1;
+                w->fmt_len = w->chunk_size < WAV_HEADER_MAX ? w->chunk_size : WAV_HEADER_MAX;
+                w->state = WAV_FMT_BODY;
+            } else {
+                w->skip_bytes = (uint64_t)w->chunk_size + (w->chunk_size & 1U);
+            }
+        } else {
+            uint16_t tag = read_le16(w->header);
+            uint16_t channels = read_le16(w->header + 2);
+            uint32_t rate = read_le32(w->header + 4);
+            uint16_t bits = read_le16(w->header + 14);
+
+            if ((tag != 1 && tag != 0xFFFE) || channels != 2 || bits != 16) return -1;
+            if (rate < SOURCE_RATE_MIN || rate > SOURCE_RATE_MAX) return -1;
+            w->rate = (int)rate;
+            w->skip_bytes = (uint64_t)(w->chunk_size - w->fmt_len) + (w->chunk_size & 1U);
+            w->state = WAV_CHUNK_HEADER;
+        }
+    }
+
+    *used = pos;
+    return 0;
+}
+
+/* Rates decoders commonly report; their kernel tables are built before any stream starts. */
+static const int g_source_rates[] = { 8000, 11025, 12000, 16000, 22050, 24000, 32000, 44100, 48000, 64000, 88200, 96000, 176400, 192000 };
+
+/* Not on the render thread: builds the tables the WAV header handlers attach to. */
+static void prepare_resampler_tables(const yt_instance_t *inst) {
+    size_t i;
+    for (i = 0; i < sizeof(g_source_rates) / sizeof(g_source_rates[0]); i++) {
+        (void)ws_resampler_prepare(g_source_rates[i], inst->sample_rate, inst->resampler_taps);
+    }
+}
+
+/* The header is complete: resample from its rate to the host rate. */
+static int start_pcm_resampler(yt_instance_t *inst) {
+    if (ws_resampler_attach(inst->resampler, inst->wav.rate, inst->sample_rate, inst->resampler_taps) != 0) {
+        return -1;
+    }
+    inst->source_rate = inst->wav.rate;
+    return 0;
+}
+
+/* Converts native-rate decoder frames to the host rate on the way into the ring. */
+static size_t push_decoded_samples(yt_instance_t *inst, const int16_t *samples, size_t count) {
+    int16_t out[2048];
+    size_t frames = count / 2;
+    size_t pushed = 0;
+
+    if (inst->resampler->passthrough) {
+        ring_push(inst, samples, count);
+        return count;
+    }
+
+    while (frames > 0) {
+        size_t used = 0;
+        size_t made = ws_resampler_process(inst->resampler, samples, frames, out, sizeof(out) / (2 * sizeof(int16_t)), &used);
+        if (made > 0) {
+            ring_push(inst, out, made * 2);
+            pushed += made * 2;
+        }
+        samples += used * 2;
+        frames -= used;
+        if (made == 0 && used == 0) break;
+    }
+    return pushed;
+}
+
+/* EOF is only premature when we know how long the media is and stopped well short of it. */
+static bool stream_eof_premature(const yt_instance_t *inst) {
+    uint64_t pos_ms;
+    if (inst->stream_duration_ms == 0) return false;
+    pos_ms = ring_samples_to_ms(inst, inst->write_abs);
+    return pos_ms + STREAM_EOF_TOLERANCE_MS < inst->stream_duration_ms;
+}
+
+static void note_decoder_progress(yt_instance_t *inst) {
+    if (inst->reconnecting && inst->write_abs > inst->decoder_start_abs) {
+        inst->reconnecting = false;
+        clear_error(inst);
+    }
+    if (inst->resume_attempts > 0 &&
+        inst->write_abs - inst->decoder_start_abs >= ms_to_ring_samples(inst, STREAM_RESUME_HEALTHY_MS)) {
+        inst->resume_attempts = 0;
+    }
+}
+
+/* A resolved URL that failed before producing audio may have expired; make the next resolve ask the daemon. */
+static void forget_cached_resolve(yt_instance_t *inst) {
+    char provider[PROVIDER_MAX];
+    char key[PROVIDER_MAX + STREAM_URL_MAX + 2];
+
+    pthread_mutex_lock(&inst->resolve_mutex);
+    snprintf(provider, sizeof(provider), "%s", inst->stream_provider);
+    infer_provider_from_url(inst->stream_url, provider, sizeof(provider));
+    resolve_cache_key(provider, inst->stream_url, key, sizeof(key));
+    pthread_mutex_unlock(&inst->resolve_mutex);
+    ws_shc_drop(g_shcache.seg, CACHE_KIND_RESOLVE, key);
+}
+
+/* Worker: deletes the saved copy forget_local_copy gave up on; the library lock and file I/O stay off the render thread. */
+static void forget_job(void *owner) {
+    yt_instance_t *inst = (yt_instance_t *)owner;
+    char provider[PROVIDER_MAX];
+    char url[STREAM_URL_MAX];
+
+    if (!inst) return;
+    pthread_mutex_lock(&inst->resolve_mutex);
+    snprintf(provider, sizeof(provider), "%s", inst->forget_provider);
+    snprintf(url, sizeof(url), "%s", inst->forget_url);
+    inst->forget_url[0] = '\0';
+    pthread_mutex_unlock(&inst->resolve_mutex);
+    if (url[0] != '\0') ws_lib_forget(provider, url);
+}
+
+/* A library file that would not decode is dropped, and the next start resolves over the network. */
+static bool forget_local_copy(yt_instance_t *inst) {
+    bool local;
+
+    pthread_mutex_lock(&inst->resolve_mutex);
+    local = inst->resolved_local;
+    if (local) {
+        inst->resolved_local = false;
+        inst->resolve_ready = false;
+        inst->resolve_failed = false;
+        inst->resolved_media_url[0] = '\0';
+        snprintf(inst->forget_provider, sizeof(inst->forget_provider), "%s", inst->stream_provider);
+        snprintf(inst->forget_url, sizeof(inst->forget_url), "%s", inst->stream_url);
+    }
+    pthread_mutex_unlock(&inst->resolve_mutex);
+    if (local) (void)ws_pool_submit(WS_JOB_LIBRARY, inst, forget_job);
+    return local;
+}
+
+/*
+ * The decoder died, stalled, or hit EOF early. Once audio has been decoded the
+ * ring is kept and the pipeline is respawned at write_abs so the timeline stays
+ * continuous while playback drains what is buffered. Before any audio the old
+ * resolved -> legacy fallback applies. Returns true when the interruption was
+ * handed off to a new decoder (started from render on the next block).
+ */
+static bool recover_stream_interruption(yt_instance_t *inst, const char *what, bool at_eof) {
+    char log_msg[192];
+    bool fallback;
+
+    if (inst->write_abs == 0) {
+        finish_startup(inst, false, what);
+        if (forget_local_copy(inst)) {
+            snprintf(log_msg, sizeof(log_msg), "saved copy %s, streaming instead", what);
+            set_error(inst, log_msg);
+            stop_stream(inst);
+            clear_ring(inst);
+            inst->stream_eof = false;
+            inst->restart_countdown = 0;
+            return true;
+        }
+        if (!inst->active_stream_resolved ||
+            inst->resolved_fallback_attempted ||
+            !supports_legacy_fallback(inst)) {
+            return false;
+        }
+        forget_cached_resolve(inst);
+        pthread_mutex_lock(&inst->resolve_mutex);
+        inst->resolve_ready = false;
+        inst->resolve_failed = true;
+        pthread_mutex_unlock(&inst->resolve_mutex);
+        inst->resolved_fallback_attempted = true;
+        ws_stat_inc(&inst->stats.legacy_fallbacks);
+        snprintf(log_msg, sizeof(log_msg), "resolved stream %s, falling back", what);
+        set_error(inst, log_msg);
+        stop_stream(inst);
+        clear_ring(inst);
+        inst->stream_eof = false;
+        inst->restart_countdown = 0;
+        return true;
+    }
+
+    apply_probe_result(inst);
+    if (at_eof && !stream_eof_premature(inst)) return false;
+
+    fallback = false;
+    if (inst->resume_attempts >= STREAM_RESUME_MAX_ATTEMPTS) {
+        if (!inst->active_stream_resolved ||
+            inst->resolved_fallback_attempted ||
+            !supports_legacy_fallback(inst)) {
+            return false;
+        }
+        fallback = true;
+    }
+
+    inst->resume_attempts++;
+    inst->resume_count++;
+    ws_stat_inc(&inst->stats.resumes);
+    if (fallback) ws_stat_inc(&inst->stats.legacy_fallbacks);
+    inst->resume_from_ms = ring_samples_to_ms(inst, inst->write_abs);
+    if (inst->resume_from_ms == 0) inst->resume_from_ms = 1;
+    inst->reconnecting = true;
+
+    /* Render respawns through the usual path: resolve_ready -> same URL, resolve_failed -> legacy. */
+    if (fallback || !inst->active_stream_resolved) {
+        pthread_mutex_lock(&inst->resolve_mutex);
+        inst->resolve_ready = false;
+        inst->resolve_failed = true;
+        pthread_mutex_unlock(&inst->resolve_mutex);
+        if (fallback) inst->resolved_fallback_attempted = true;
+    }
+
+    snprintf(log_msg,
+             sizeof(log_msg),
+             "stream %s at %llu ms, resuming %s (attempt %u)",
+             what,
+             (unsigned long long)inst->resume_from_ms,
+             fallback ? "on legacy pipeline" : (inst->active_stream_resolved ? "resolved url" : "legacy pipeline"),
+             inst->resume_attempts);
+    yt_log(log_msg);
+    snprintf(log_msg, sizeof(log_msg), "stream %s, reconnecting", what);
+    set_error(inst, log_msg);
+
+    stop_stream(inst);
+    inst->stream_eof = false;
+    inst->restart_countdown = RESTART_RETRY_BLOCKS;
+    return true;
+}
+
+/* Pipe bytes/s over roughly the last second of pumping (render thread). */
+static void note_pipe_throughput(yt_instance_t *inst, size_t bytes, uint64_t now) {
+    plugin_stats_t *st = &inst->stats;
+    ws_stat_add(&st->pipe_bytes, bytes);
+    st->pipe_window_bytes += bytes;
+    if (st->pipe_window_start_ms == 0) {
+        st->pipe_window_start_ms = now;
+    } else if (now - st->pipe_window_start_ms >= 1000ULL) {
+        ws_stat_store(&st->pipe_bytes_per_sec, st->pipe_window_bytes * 1000ULL / (now - st->pipe_window_start_ms));
+        st->pipe_window_start_ms = now;
+        st->pipe_window_bytes = 0;
+    }
+}
+
+/* Upsampling expands each read, so leave proportionally more ring headroom. */
+static size_t pump_headroom_samples(const yt_instance_t *inst) {
+    size_t ratio = 1;
+    if (inst->source_rate > 0 && inst->sample_rate > inst->source_rate) {
+        ratio = (size_t)((inst->sample_rate + inst->source_rate - 1) / inst->source_rate);
+    }
+    return 2048 * ratio + 64;
+}
+
+static void pump_pipe(yt_instance_t *inst) {
+    uint8_t buf[4096];
+    uint8_t merged[4100];
+    int16_t samples[2048];
+    size_t pushed = 0;
+    size_t read_bytes = 0;
+    bool throttled = false;
+    uint64_t now = now_ms();
+
+    /* Time spent paused (no pumping) or with a full ring is not a stall. */
+    if (inst->last_pump_ms == 0 || now - inst->last_pump_ms >= PUMP_GAP_RESET_MS) {
+        inst->last_data_ms = now;
+    }
+    inst->last_pump_ms = now;
+
+    while (inst->pipe && !inst->stream_eof) {
+        if (ring_retained(inst) + pump_headroom_samples(inst) >= RING_SAMPLES ||
+            (inst->read_ahead_cap_samples > 0 && ring_available(inst) >= inst->read_ahead_cap_samples)) {
+            throttled = true;
+            inst->last_data_ms = now;
+            break; /* Let pipe backpressure pace producer; avoid dropping */
+        }
+
+        ssize_t n = read(inst->pipe_fd, buf, sizeof(buf));
+        if (n > 0) {
+            size_t merged_bytes = inst->pending_len;
+            size_t aligned_bytes;
+            size_t remainder;
+            size_t sample_count;
+            size_t header_bytes = 0;
+
+            read_bytes += (size_t)n;
+            if (inst->trace_first_byte_pending) {
+                inst->trace_first_byte_pending = false;
+                trace_event(inst, "first_byte", 'i', TRACE_TID_PIPELINE, (uint64_t)n);
+            }
+            if (inst->wav.state != WAV_DATA &&
+                (consume_wav_header(&inst->wav, buf, (size_t)n, &header_bytes) != 0 ||
+                 (inst->wav.state == WAV_DATA && start_pcm_resampler(inst) != 0))) {
+                inst->stream_eof = true;
+                set_error(inst, "unsupported decoder output format");
+                stop_stream(inst);
+                inst->restart_countdown = 0;
+                break;
+            }
+
+            if (inst->pending_len > 0) {
+                memcpy(merged, inst->pending_bytes, inst->pending_len);
+            }
+
+            memcpy(merged + merged_bytes, buf + header_bytes, (size_t)n - header_bytes);
+            merged_bytes += (size_t)n - header_bytes;
+
+            aligned_bytes = merged_bytes & ~((size_t)3U);
+            remainder = merged_bytes - aligned_bytes;
+            if (remainder > 0) {
+                memcpy(inst->pending_bytes, merged + aligned_bytes, remainder);
+            }
+            inst->pending_len = (uint8_t)remainder;
+
+            sample_count = aligned_bytes / sizeof(int16_t);
+            if (sample_count > 0) {
+                memcpy(samples, merged, sample_count * sizeof(int16_t));
+                pushed += push_decoded_samples(inst, samples, sample_count);
+            }
+            inst->last_data_ms = now;
+            note_decoder_progress(inst);
+            if ((size_t)n < sizeof(buf)) {
+                break;
+            }
+            continue;
+        }
+        if (n == 0) {
+            if (recover_stream_interruption(inst, "ended", true)) {
+                break;
+            }
+            inst->stream_eof = true;
+            set_error(inst, "stream ended");
+            stop_stream(inst);
+            inst->restart_countdown = 0;
+            break;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            if (inst->write_abs > 0 && now - inst->last_data_ms >= STREAM_STALL_MS) {
+                /* Give a stalled decoder a fresh window whether or not it was replaced. */
+                inst->last_data_ms = now;
+                (void)recover_stream_interruption(inst, "stalled", false);
+            }
+            break;
+        }
+        if (recover_stream_interruption(inst, "read error", false)) {
+            break;
+        }
+        inst->stream_eof = true;
+        set_error(inst, "stream read error");
+        stop_stream(inst);
+        inst->restart_countdown = 0;
+        break;
+    }
+
+    if (inst->pipe) {
+        note_arrival(inst, pushed, throttled);
+    }
+    note_pipe_throughput(inst, read_bytes, now);
+}
+
+/*
+ * Fast-start quality ladder. A fresh start may open a smaller format from the
+ * resolve reply. Once the rung's throughput shows the link can carry the full
+ * format, a second decoder opens the full-quality URL at a millisecond the
+ * ring already holds, through a resampler of its own; its output is discarded
+ * up to write_abs, crossfaded over the last LADDER_XFADE_FRAMES the rung
+ * wrote, and from there it becomes the stream's decoder.
+ */
+
+/* Render thread, resolve_mutex held: the URL to open. Returns the rung's bitrate, 0 for full quality. */
+static uint32_t pick_start_format_locked(yt_instance_t *inst, char *url, size_t url_len) {
+    const buffer_profile_t *p;
+    int rung = 0;
+    int i;
+
+    snprintf(url, url_len, "%s", inst->resolved_media_url);
+    /* Resumes and far seeks continue in full quality; only a fresh start can splice later. */
+    if (inst->ladder_mode == LADDER_MODE_OFF || inst->resolved_rung_count == 0 ||
+        inst->write_abs != 0 || inst->resume_from_ms != 0 || inst->reconnecting) {
+        return 0;
+    }
+    p = select_buffer_profile(inst);
+    if (inst->ladder_mode == LADDER_MODE_AUTO) {
+        /* A link measured fast enough starts on the full format, or on the biggest rung it carries. */
+        if ((uint64_t)p->net_kbps * 100ULL >= (uint64_t)inst->resolved_kbps * LADDER_SKIP_PCT) return 0;
+        for (i = 1; i < inst->resolved_rung_count; i++) {
+            if ((uint64_t)p->net_kbps * 100ULL >= (uint64_t)inst->resolved_rungs[i].kbps * LADDER_SKIP_PCT) rung = i;
+        }
+    }
+    snprintf(url, url_len, "%s", inst->resolved_rungs[rung].url);
+    snprintf(inst->ladder_full_url, sizeof(inst->ladder_full_url), "%s", inst->resolved_media_url);
+    inst->ladder_full_kbps = inst->resolved_kbps;
+    return inst->resolved_rungs[rung].kbps;
+}
+
+static void begin_fast_start(yt_instance_t *inst, uint32_t rung_kbps) {
+    char log_msg[128];
+
+    inst->ladder_state = LADDER_LOW;
+    inst->ladder_rung_kbps = rung_kbps;
+    inst->ladder_t0_ms = 0;
+    inst->ladder_t0_abs = 0;
+    inst->stream_bitrate_kbps = rung_kbps;
+    ws_stat_inc(&inst->stats.ladder_fast_starts);
+    trace_event(inst, "fast_start", 'i', TRACE_TID_PIPELINE, rung_kbps);
+    snprintf(log_msg, sizeof(log_msg), "fast start on %u kbps rung (full %u kbps)", rung_kbps, inst->ladder_full_kbps);
+    render_log(inst, log_msg);
+}
+
+static void settle_on_rung(yt_instance_t *inst, const char *why) {
+    char log_msg[160];
+
+    cancel_ladder_upgrade(inst);
+    if (inst->ladder_state == LADDER_UPGRADING) trace_event(inst, "ladder_upgrade", 'E', TRACE_TID_PIPELINE, 0);
+    inst->ladder_state = LADDER_STAYED;
+    ws_stat_inc(&inst->stats.ladder_stayed);
+    snprintf(log_msg, sizeof(log_msg), "staying on %u kbps rung: %s", inst->ladder_rung_kbps, why);
+    render_log(inst, log_msg);
+}
+
+static int start_ladder_upgrade(yt_instance_t *inst) {
+    char cmd[8192];
+    char clean_url[STREAM_URL_MAX];
+    char log_msg[160];
+    const char *failed;
+    uint64_t rate = (uint64_t)inst->sample_rate;
+    uint64_t latency = ws_resampler_latency_frames(inst->resampler);
+    uint64_t have_frames = (inst->write_abs - inst->decoder_start_abs) / 2ULL;
+    uint64_t at_ms;
+
+    if (!sanitize_any_http_url(inst->ladder_full_url, clean_url, sizeof(clean_url))) return -1;
+    if (have_frames <= latency + LADDER_XFADE_FRAMES) return -1;
+
+    /*
+     * A millisecond that is a whole number of frames at the host rate and at
+     * whatever rate the full format turns out to have, so both resamplers
+     * start on the same phase.
+     */
+    at_ms = (have_frames - latency - LADDER_XFADE_FRAMES) * 1000ULL / rate;
+    at_ms -= at_ms % LADDER_SPLICE_STEP_MS;
+    snprintf(cmd,
+             sizeof(cmd),
+             "exec \"%s/bin/ffmpeg\" -hide_banner -loglevel error "
+             "-ss %llu.%03llu -i \"%s\" -vn -sn -dn "
+             "-af \"aresample=async=1:min_hard_comp=0.100:first_pts=0\" "
+             "-f wav -acodec pcm_s16le -ac 2 pipe:1",
+             inst->module_dir,
+             (unsigned long long)(at_ms / 1000ULL),
+             (unsigned long long)(at_ms % 1000ULL),
+             clean_url);
+    failed = open_decoder_pipe(inst, cmd, &inst->up_pipe, &inst->up_fd, &inst->up_pid);
+    if (failed) {
+        render_log(inst, failed);
+        return -1;
+    }
+
+    memset(&inst->up_wav, 0, sizeof(inst->up_wav));
+    inst->up_wav.state = WAV_PREAMBLE;
+    inst->up_at_frames = at_ms * rate / 1000ULL;
+    inst->up_start_abs = 0;
+    inst->up_abs = 0;
+    inst->up_pending_len = 0;
+    inst->ladder_up_started_ms = now_ms();
+    inst->ladder_state = LADDER_UPGRADING;
+    trace_event(inst, "ladder_upgrade", 'B', TRACE_TID_PIPELINE, at_ms);
+    snprintf(log_msg, sizeof(log_msg), "fast start: fetching %u kbps from %llu ms", inst->ladder_full_kbps,
+             (unsigned long long)at_ms);
+    render_log(inst, log_msg);
+    return 0;
+}
+
+/* Render thread, on a rung: once throughput is known, start the upgrade or settle on the rung. */
+static void ladder_decide(yt_instance_t *inst) {
+    buffer_profile_t *p = inst->buffer_profile ? inst->buffer_profile : select_buffer_profile(inst);
+    uint64_t now = now_ms();
+    uint64_t elapsed;
+    uint64_t est_kbps;
+    bool capped;
+    bool fast_enough;
+    char why[96];
+
+    if (!inst->pipe || inst->stream_eof || inst->write_abs <= inst->decoder_start_abs) return;
+    if (inst->ladder_t0_ms == 0) {
+        inst->ladder_t0_ms = now;
+        inst->ladder_t0_abs = inst->write_abs;
+        return;
+    }
+    elapsed = now - inst->ladder_t0_ms;
+    capped = ring_available(inst) >= ms_to_ring_samples(inst, LADDER_LOW_AHEAD_MS);
+    if (!capped && elapsed < LADDER_DECIDE_MS) return;
+
+    /* Until the cap is hit nothing throttles the rung, so this is what the link delivers. */
+    est_kbps = (inst->write_abs - inst->ladder_t0_abs) * (uint64_t)inst->ladder_rung_kbps /
+               ms_to_ring_samples(inst, elapsed > 0 ? elapsed : 1);
+    if (est_kbps > 1000000ULL) est_kbps = 1000000ULL;
+    p->net_kbps = (uint32_t)est_kbps;
+    fast_enough = inst->ladder_mode == LADDER_MODE_AUTO &&
+                  est_kbps * 100ULL >= (uint64_t)inst->ladder_full_kbps * LADDER_UPGRADE_PCT;
+    if (fast_enough && ring_available(inst) < ms_to_ring_samples(inst, LADDER_MIN_AHEAD_MS) &&
+        elapsed < LADDER_DECIDE_MS * 3ULL) {
+        return; /* build a margin before a second download competes for the link */
+    }
+    if (fast_enough && start_ladder_upgrade(inst) == 0) return;
+
+    snprintf(why, sizeof(why), "%llu kbps measured", (unsigned long long)est_kbps);
+    settle_on_rung(inst, inst->ladder_mode == LADDER_MODE_LOW ? "quality_ladder low" : why);
+}
+
+/*
+ * The full-quality decoder has reached write_abs: crossfade its overlap into
+ * the unplayed end of the ring, then make it the stream's decoder.
+ */
+static void splice_upgrade(yt_instance_t *inst, const int16_t *rest, size_t n) {
+    const uint64_t tail = LADDER_XFADE_FRAMES * 2U;
+    uint64_t end = inst->write_abs;
+    uint64_t from = end > tail ? end - tail : 0;
+    uint32_t frames;
+    uint32_t f;
+    FILE *old_pipe = inst->pipe;
+    pid_t old_pid = inst->stream_pid;
+    ws_resampler_t *old_rs = inst->resampler;
+    char log_msg[160];
+
+    if (from < inst->up_start_abs) from = inst->up_start_abs;
+    if (from < inst->play_abs) from = inst->play_abs;
+    frames = from < end ? (uint32_t)((end - from) / 2ULL) : 0;
+    for (f = 0; f < frames; f++) {
+        uint64_t abs = from + (uint64_t)f * 2ULL;
+        int32_t w = (int32_t)f + 1;
+        int c;
+        for (c = 0; c < 2; c++) {
+            int16_t *dst = &inst->ring[(size_t)((abs + (uint64_t)c) % (uint64_t)RING_SAMPLES)];
+            int32_t hq = inst->up_tail[(size_t)((abs + (uint64_t)c) % tail)];
+            *dst = (int16_t)(*dst + (hq - *dst) * w / (int32_t)(frames + 1U));
+        }
+    }
+
+    inst->pipe = inst->up_pipe;
+    inst->pipe_fd = inst->up_fd;
+    inst->stream_pid = inst->up_pid;
+    inst->up_pipe = NULL;
+    inst->up_fd = -1;
+    inst->up_pid = -1;
+    schedule_stream_reap(old_pipe, old_pid);
+
+    /* Its header, resampler (swapped, not copied) and partial frame carry on as the stream's own. */
+    inst->wav = inst->up_wav;
+    inst->source_rate = inst->up_wav.rate;
+    inst->resampler = inst->up_resampler;
+    inst->up_resampler = old_rs;
+    memcpy(inst->pending_bytes, inst->up_pending, inst->up_pending_len);
+    inst->pending_len = inst->up_pending_len;
+    inst->up_pending_len = 0;
+    ring_push(inst, rest, n);
+
+    inst->decoder_start_abs = end;
+    inst->last_data_ms = now_ms();
+    inst->stream_bitrate_kbps = inst->ladder_full_kbps;
+    inst->ladder_state = LADDER_UPGRADED;
+    ws_stat_inc(&inst->stats.ladder_upgrades);
+    trace_event(inst, "ladder_upgrade", 'E', TRACE_TID_PIPELINE, frames);
+    snprintf(log_msg,
+             sizeof(log_msg),
+             "fast start upgraded to %u kbps at %llu ms (%u-frame crossfade)",
+             inst->ladder_full_kbps,
+             (unsigned long long)ring_samples_to_ms(inst, end),
+             frames);
+    render_log(inst, log_msg);
+}
+
+/* Keeps the upgrade's last samples before write_abs; returns 1 once it has spliced, -1 if it cannot line up. */
+static int feed_upgrade(yt_instance_t *inst, const int16_t *samples, size_t n) {
+    const size_t tail = LADDER_XFADE_FRAMES * 2U;
+    uint64_t at = inst->up_abs;
+    size_t before;
+    size_t i;
+
+    if (at > inst->write_abs) return -1;
+    before = at + n <= inst->write_abs ? n : (size_t)(inst->write_abs - at);
+    for (i = before > tail ? before - tail : 0; i < before; i++) {
+        inst->up_tail[(size_t)((at + i) % tail)] = samples[i];
+    }
+    inst->up_abs += before;
+    if (before == n) return 0;
+    splice_upgrade(inst, samples + before, n - before);
+    return 1;
+}
+
+/*
+ * Once the upgrade's header is in: ring frame F holds the rung's media frame
+ * F - rung latency, the upgrade's output frame k holds at + k - its own.
+ */
+static const char *start_upgrade_timeline(yt_instance_t *inst) {
+    uint64_t rung_latency = ws_resampler_latency_frames(inst->resampler);
+    uint64_t up_latency;
+
+    if (ws_resampler_attach(inst->up_resampler, inst->up_wav.rate, inst->sample_rate, inst->resampler_taps) != 0) {
+        return "upgrade format unsupported";
+    }
+    up_latency = ws_resampler_latency_frames(inst->up_resampler);
+    if (inst->up_at_frames + rung_latency < up_latency) return "upgrade misaligned";
+    inst->up_start_abs = inst->decoder_start_abs + (inst->up_at_frames + rung_latency - up_latency) * 2ULL;
+    inst->up_abs = inst->up_start_abs;
+    return NULL;
+}
+
+/* Render thread: reads the full-quality decoder until it catches up with the rung. */
+static void pump_upgrade(yt_instance_t *inst) {
+    uint8_t buf[4096];
+    uint8_t merged[sizeof(buf) + 4];
+    int16_t samples[2048];
+    int16_t out[2048];
+    const char *abandon = NULL;
+
+    if (now_ms() - inst->ladder_up_started_ms >= LADDER_UPGRADE_TIMEOUT_MS) abandon = "upgrade timed out";
+
+    while (!abandon && inst->up_pipe) {
+        size_t have = inst->up_pending_len;
+        size_t header_bytes = 0;
+        size_t aligned;
+        size_t frames;
+        const int16_t *in = samples;
+        ssize_t n;
+
+        /* Room for the batch upsampled 4x, should it splice and land in the ring. */
+        if (ring_retained(inst) + 4U * sizeof(samples) / sizeof(samples[0]) + 64 >= RING_SAMPLES) break;
+        n = read(inst->up_fd, buf, sizeof(buf));
+        if (n == 0) {
+            abandon = "upgrade ended early";
+            break;
+        }
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) abandon = "upgrade read error";
+            break;
+        }
+        if (inst->up_wav.state != WAV_DATA) {
+            if (consume_wav_header(&inst->up_wav, buf, (size_t)n, &header_bytes) != 0) {
+                abandon = "upgrade format unsupported";
+                break;
+            }
+            if (inst->up_wav.state != WAV_DATA) continue;
+            abandon = start_upgrade_timeline(inst);
+            if (abandon) break;
+        }
+
+        memcpy(merged, inst->up_pending, have);
+        memcpy(merged + have, buf + header_bytes, (size_t)n - header_bytes);
+        have += (size_t)n - header_bytes;
+        aligned = have & ~((size_t)3U);
+        inst->up_pending_len = (uint8_t)(have - aligned);
+        memcpy(inst->up_pending, merged + aligned, inst->up_pending_len);
+        memcpy(samples, merged, aligned);
+
+        frames = aligned / 4U;
+        while (frames > 0) {
+            size_t used = 0;
+            size_t made = ws_resampler_process(inst->up_resampler, in, frames, out, sizeof(out) / (2 * sizeof(int16_t)), &used);
+            int fed = made > 0 ? feed_upgrade(inst, out, made * 2) : 0;
+
+            in += used * 2;
+            frames -= used;
+            if (fed > 0) {
+                /* The rest of the batch goes through the resampler it just inherited. */
+                (void)push_decoded_samples(inst, in, frames * 2);
+                return;
+            }
+            if (fed < 0) {
+                abandon = "upgrade misaligned";
+                break;
+            }
+            if (made == 0 && used == 0) break;
+        }
+        if ((size_t)n < sizeof(buf)) break;
+    }
+    if (abandon) settle_on_rung(inst, abandon);
+}
+
+/* Render thread, before pump_pipe: advances the ladder and caps how far the rung reads ahead. */
+static void ladder_tick(yt_instance_t *inst) {
+    if (inst->ladder_state == LADDER_LOW) ladder_decide(inst);
+    if (inst->ladder_state == LADDER_UPGRADING) pump_upgrade(inst);
+
+    if (inst->ladder_state == LADDER_LOW) {
+        inst->read_ahead_cap_samples = ms_to_ring_samples(inst, LADDER_LOW_AHEAD_MS);
+    } else if (inst->ladder_state == LADDER_UPGRADING) {
+        inst->read_ahead_cap_samples = ms_to_ring_samples(inst, LADDER_HOLD_MS);
+    } else {
+        inst->read_ahead_cap_samples = 0;
+    }
+}
+
+static voice_t *voice_at(yt_instance_t *inst, int index) {
+    if (!inst || index < 1 || index > VOICE_MAX) return NULL;
+    return &inst->voices[index - 1];
+}
+
+static void set_voice_error(yt_instance_t *inst, voice_t *v, const char *msg) {
+    char log_msg[256];
+
+    pthread_mutex_lock(&inst->voice_mutex);
+    snprintf(v->error, sizeof(v->error), "%s", msg);
+    pthread_mutex_unlock(&inst->voice_mutex);
+    snprintf(log_msg, sizeof(log_msg), "voice%d: %s", v->index, msg);
+    yt_log(log_msg);
+}
+
+/* Pool job (owner = the voice): a saved copy or a resolve through the shared daemon and cache. */
+static void voice_resolve_job(void *owner) {
+    voice_t *v = (voice_t *)owner;
+    yt_instance_t *inst = v->inst;
+    char provider[PROVIDER_MAX];
+    char url[STREAM_URL_MAX];
+    char blob[RESOLVE_BLOB_MAX];
+    char media[STREAM_URL_MAX];
+    char err[256];
+    resolve_reply_t reply;
+    ws_lib_item_t saved;
+    uint32_t generation;
+    int rc = 0;
+
+    pthread_mutex_lock(&inst->voice_mutex);
+    snprintf(provider, sizeof(provider), "%s", v->provider);
+    snprintf(url, sizeof(url), "%s", v->url);
+    generation = __atomic_load_n(&v->generation, __ATOMIC_ACQUIRE);
+    pthread_mutex_unlock(&inst->voice_mutex);
+    if (url[0] == '\0') return;
+    infer_provider_from_url(url, provider, sizeof(provider));
+    normalize_provider_value(provider, provider, sizeof(provider));
+
+    err[0] = '\0';
+    if (!ws_lib_open(provider, url, wall_ms() / 1000ULL, &saved, media, sizeof(media))) {
+        rc = resolve_stream_url(inst, provider, url, blob, sizeof(blob), err, sizeof(err));
+        if (rc == 0 && parse_resolve_reply(blob, &reply) != 0) {
+            snprintf(err, sizeof(err), "resolve reply malformed");
+            rc = -1;
+        }
+        if (rc == 0) snprintf(media, sizeof(media), "%s", reply.media_url);
+        if (rc != 0) ws_stat_inc(&inst->stats.resolve_failures);
+    } else {
+        ws_stat_inc(&g_library.local_plays);
+    }
+
+    pthread_mutex_lock(&inst->voice_mutex);
+    if (__atomic_load_n(&v->generation, __ATOMIC_ACQUIRE) == generation) {
+        if (rc == 0) {
+            snprintf(v->media_url, sizeof(v->media_url), "%s", media);
+            v->ready_generation = generation;
+            v->resolve_failed = false;
+            v->error[0] = '\0';
+        } else {
+            v->resolve_failed = true;
+            snprintf(v->error, sizeof(v->error), "%s", err[0] ? err : "resolve failed");
+        }
+    }
+    pthread_mutex_unlock(&inst->voice_mutex);
+    snprintf(blob, sizeof(blob), "voice%d resolve %s provider=%s%s%s", v->index, rc == 0 ? "finished" : "failed",
+             provider, rc == 0 ? "" : ": ", rc == 0 ? "" : err);
+    yt_log(blob);
+}
+
+static void stop_voice_decoder(voice_t *v) {
+    FILE *pipe = v->pipe;
+    pid_t pid = v->pid;
+
+    v->pipe = NULL;
+    v->fd = -1;
+    v->pid = -1;
+    v->pending_len = 0;
+    if (pipe) schedule_stream_reap(pipe, pid);
+}
+
+static void reset_voice_ring(voice_t *v) {
+    v->write_abs = 0;
+    v->play_abs = 0;
+    v->eof = false;
+    v->prime_samples = 0;
+}
+
+/* Render thread: the same decoder command as a resolved or saved main stream, minus startup tuning. */
+static int start_voice_decoder(yt_instance_t *inst, voice_t *v, const char *media) {
+    char cmd[8192];
+    char clean_url[STREAM_URL_MAX];
+    const char *failed;
+
+    if (media[0] == '/') {
+        if (strpbrk(media, "\"`$\\") != NULL) {
+            set_voice_error(inst, v, "library path invalid");
+            return -1;
+        }
+        snprintf(clean_url, sizeof(clean_url), "%s", media);
+    } else if (!sanitize_any_http_url(media, clean_url, sizeof(clean_url))) {
+        set_voice_error(inst, v, "resolved media url invalid");
+        return -1;
+    }
+
+    snprintf(cmd,
+             sizeof(cmd),
+             "exec \"%s/bin/ffmpeg\" -hide_banner -loglevel error "
+             "-i \"%s\" -vn -sn -dn "
+             "-af \"aresample=async=1:min_hard_comp=0.100:first_pts=0\" "
+             "-f wav -acodec pcm_s16le -ac 2 pipe:1",
+             inst->module_dir,
+             clean_url);
+    failed = open_decoder_pipe(inst, cmd, &v->pipe, &v->fd, &v->pid);
+    if (failed) {
+        set_voice_error(inst, v, failed);
+        return -1;
+    }
+    memset(&v->wav, 0, sizeof(v->wav));
+    v->wav.state = WAV_PREAMBLE;
+    v->pending_len = 0;
+    v->prime_samples = ms_to_ring_samples(inst, VOICE_PRIME_MS);
+    ws_stat_inc(&inst->stats.voice_starts);
+    return 0;
+}
+
+static void voice_ring_push(voice_t *v, const int16_t *samples, size_t n) {
+    size_t pos = (size_t)(v->write_abs % (uint64_t)VOICE_RING_SAMPLES);
+    size_t first = n < (size_t)VOICE_RING_SAMPLES - pos ? n : (size_t)VOICE_RING_SAMPLES - pos;
+
+    memcpy(v->ring + pos, samples, first * sizeof(int16_t));
+    memcpy(v->ring, samples + first, (n - first) * sizeof(int16_t));
+    v->write_abs += n;
+}
+
+/* Sums up to n buffered samples into bus straight from the ring; returns how many. */
+static size_t voice_ring_mix(voice_t *v, int16_t *bus, size_t n, int32_t gain_q13) {
+    size_t avail = (size_t)(v->write_abs - v->play_abs);
+    size_t take = n < avail ? n : avail;
+    size_t pos = (size_t)(v->play_abs % (uint64_t)VOICE_RING_SAMPLES);
+    size_t first = take < (size_t)VOICE_RING_SAMPLES - pos ? take : (size_t)VOICE_RING_SAMPLES - pos;
+
+    ws_mix_add(bus, v->ring + pos, first, gain_q13);
+    ws_mix_add(bus + first, v->ring, take - first, gain_q13);
+    v->play_abs += take;
+    return take;
+}
+
+/* Render thread: reads what the voice's decoder has, resampled to the host rate, while its ring has room. */
+static const char *pump_voice(yt_instance_t *inst, voice_t *v) {
+    uint8_t buf[4096];
+    uint8_t merged[sizeof(buf) + 4];
+    int16_t samples[2048];
+    int16_t out[2048];
+    /* Worst case a batch grows by host rate / SOURCE_RATE_MIN. */
+    size_t headroom = sizeof(samples) / sizeof(samples[0]) * (size_t)(inst->sample_rate / SOURCE_RATE_MIN + 1) + 64;
+
+    while (v->pipe) {
+        size_t have = v->pending_len;
+        size_t header_bytes = 0;
+        size_t aligned;
+        size_t frames;
+        const int16_t *in = samples;
+        ssize_t n;
+
+        if ((size_t)(v->write_abs - v->play_abs) + headroom >= (size_t)VOICE_RING_SAMPLES) break;
+        n = read(v->fd, buf, sizeof(buf));
+        if (n == 0) {
+            v->eof = true;
+            stop_voice_decoder(v);
+            break;
+        }
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return "voice read error";
+            break;
+        }
+        if (v->wav.state != WAV_DATA) {
+            if (consume_wav_header(&v->wav, buf, (size_t)n, &header_bytes) != 0) return "voice format unsupported";
+            if (v->wav.state != WAV_DATA) continue;
+            if (ws_resampler_attach(&v->resampler, v->wav.rate, inst->sample_rate, inst->resampler_taps) != 0) {
+                return "voice resampler failed";
+            }
+        }
+
+        memcpy(merged, v->pending, have);
+        memcpy(merged + have, buf + header_bytes, (size_t)n - header_bytes);
+        have += (size_t)n - header_bytes;
+        aligned = have & ~((size_t)3U);
+        v->pending_len = (uint8_t)(have - aligned);
+        memcpy(v->pending, merged + aligned, v->pending_len);
+        memcpy(samples, merged, aligned);
+
+        frames = aligned / 4U;
+        if (v->resampler.passthrough) {
+            voice_ring_push(v, samples, frames * 2);
+        } else {
+            while (frames > 0) {
+                size_t used = 0;
+                size_t made = ws_resampler_process(&v->resampler, in, frames, out, sizeof(out) / (2 * sizeof(int16_t)), &used);
+                if (made > 0) voice_ring_push(v, out, made * 2);
+                in += used * 2;
+                frames -= used;
+                if (made == 0 && used == 0) break;
+            }
+        }
+        if ((size_t)n < sizeof(buf)) break;
+    }
     return NULL;
 }
 
-static int start_resolve_async(yt_instance_t *inst) {
-    if (!inst) return -1;
-
-    pthread_mutex_lock(&inst->resolve_mutex);
-    if (inst->stream_url[0] == '\0') {
-        pthread_mutex_unlock(&inst->resolve_mutex);
-        return -1;
+/* Render thread: applies the latest source and transport command, then mixes one block of the voice into bus. */
+static void render_voice(yt_instance_t *inst, voice_t *v, int16_t *bus, int frames) {
+    uint32_t generation = __atomic_load_n(&v->generation, __ATOMIC_ACQUIRE);
+    uint32_t cmd = __atomic_exchange_n(&v->command, VOICE_CMD_NONE, __ATOMIC_ACQ_REL);
+    voice_state_t state;
+    const char *failed;
+    size_t needed = (size_t)frames * 2;
+    size_t got;
+
+    if (generation != v->play_generation) {
+        stop_voice_decoder(v);
+        reset_voice_ring(v);
+        v->play_generation = generation;
+        v->stopped = false;
+        v->paused = false;
+        v->failed = false;
+        pthread_mutex_lock(&inst->voice_mutex);
+        v->has_source = v->url[0] != '\0';
+        pthread_mutex_unlock(&inst->voice_mutex);
+    }
+    if (!v->has_source) {
+        __atomic_store_n(&v->state, VOICE_IDLE, __ATOMIC_RELAXED);
+        return;
+    }
+
+    if (cmd == VOICE_CMD_TOGGLE) cmd = (v->stopped || v->paused) ? VOICE_CMD_PLAY : VOICE_CMD_PAUSE;
+    if (cmd == VOICE_CMD_PLAY && v->eof && v->write_abs == v->play_abs) cmd = VOICE_CMD_RESTART;
+    if (cmd == VOICE_CMD_STOP || cmd == VOICE_CMD_RESTART) {
+        stop_voice_decoder(v);
+        reset_voice_ring(v);
+        v->failed = false;
+        v->paused = false;
+        v->stopped = cmd == VOICE_CMD_STOP;
+    } else if (cmd == VOICE_CMD_PLAY) {
+        v->stopped = false;
+        v->paused = false;
+    } else if (cmd == VOICE_CMD_PAUSE) {
+        v->paused = !v->stopped;
+    }
+    if (v->stopped) {
+        __atomic_store_n(&v->state, VOICE_IDLE, __ATOMIC_RELAXED);
+        __atomic_store_n(&v->position_ms, 0, __ATOMIC_RELAXED);
+        return;
+    }
+
+    if (!v->failed && !v->pipe && !v->eof) {
+        char media[STREAM_URL_MAX];
+        bool resolve_failed;
+
+        media[0] = '\0';
+        pthread_mutex_lock(&inst->voice_mutex);
+        if (v->ready_generation == generation) snprintf(media, sizeof(media), "%s", v->media_url);
+        resolve_failed = v->resolve_failed;
+        pthread_mutex_unlock(&inst->voice_mutex);
+        if (resolve_failed || (media[0] != '\0' && start_voice_decoder(inst, v, media) != 0)) {
+            v->failed = true;
+        } else if (media[0] == '\0') {
+            __atomic_store_n(&v->state, VOICE_LOADING, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    if (v->failed) {
+        __atomic_store_n(&v->state, VOICE_FAILED, __ATOMIC_RELAXED);
+        return;
+    }
+
+    failed = pump_voice(inst, v);
+    if (failed) {
+        stop_voice_decoder(v);
+        set_voice_error(inst, v, failed);
+        v->failed = true;
+        __atomic_store_n(&v->state, VOICE_FAILED, __ATOMIC_RELAXED);
+        return;
+    }
+
+    if (v->paused) {
+        state = VOICE_PAUSED;
+    } else if (v->prime_samples > 0 && (size_t)(v->write_abs - v->play_abs) < v->prime_samples && !v->eof) {
+        state = v->write_abs == 0 ? VOICE_LOADING : VOICE_BUFFERING;
+    } else {
+        v->prime_samples = 0;
+        got = voice_ring_mix(v, bus, needed, __atomic_load_n(&v->gain_q13, __ATOMIC_RELAXED));
+        if (got < needed && !v->eof) {
+            /* Out of audio mid-stream: wait for a cushion again rather than stutter. */
+            v->prime_samples = ms_to_ring_samples(inst, VOICE_PRIME_MS);
+            ws_stat_inc(&inst->stats.voice_underruns);
+        }
+        state = v->eof && v->write_abs == v->play_abs ? VOICE_ENDED : VOICE_PLAYING;
+    }
+    __atomic_store_n(&v->state, state, __ATOMIC_RELAXED);
+    __atomic_store_n(&v->position_ms, ring_samples_to_ms(inst, v->play_abs), __ATOMIC_RELAXED);
+}
+
+/* Destroy, once daemon waits are cancelled: drops voice resolves, their decoders and rings. */
+static void stop_voices(yt_instance_t *inst) {
+    int i;
+    for (i = 0; i < VOICE_MAX; i++) {
+        ws_pool_cancel(&inst->voices[i]);
+        stop_voice_decoder(&inst->voices[i]);
+        free(inst->voices[i].ring);
+        inst->voices[i].ring = NULL;
+    }
+}
+
+/* Sums every voice into the finished main-stream block, before the master gain and meter. */
+static void render_voices(yt_instance_t *inst, int16_t *bus, int frames) {
+    int i;
+    for (i = 0; i < VOICE_MAX; i++) render_voice(inst, &inst->voices[i], bus, frames);
+}
+
+/* voice<n>_stream_url: "" clears the voice; anything else replaces its source and resolves it. */
+static void set_voice_source(yt_instance_t *inst, voice_t *v, const char *clean_url) {
+    /* The ring is only read once render sees a url, which the mutex below publishes after it. */
+    if (clean_url[0] != '\0' && !v->ring) {
+        v->ring = calloc(VOICE_RING_SAMPLES, sizeof(int16_t));
+        if (!v->ring) {
+            set_voice_error(inst, v, "out of memory for the voice ring");
+            return;
+        }
+    }
+    pthread_mutex_lock(&inst->voice_mutex);
+    snprintf(v->url, sizeof(v->url), "%s", clean_url);
+    v->media_url[0] = '\0';
+    v->resolve_failed = false;
+    v->error[0] = '\0';
+    __atomic_fetch_add(&v->generation, 1, __ATOMIC_ACQ_REL);
+    pthread_mutex_unlock(&inst->voice_mutex);
+    if (clean_url[0] != '\0' && ws_pool_submit(WS_JOB_RESOLVE, v, voice_resolve_job) < 0) {
+        set_voice_error(inst, v, "failed to queue resolve");
+        pthread_mutex_lock(&inst->voice_mutex);
+        v->resolve_failed = true;
+        pthread_mutex_unlock(&inst->voice_mutex);
+    }
+}
+
+static int count_active_voices(yt_instance_t *inst) {
+    int active = 0;
+    int i;
+    for (i = 0; i < VOICE_MAX; i++) {
+        if (__atomic_load_n(&inst->voices[i].state, __ATOMIC_RELAXED) != VOICE_IDLE) active++;
+    }
+    return active;
+}
+
+static sampler_slot_t *slot_at(yt_instance_t *inst, int index) {
+    if (!inst || index < 1 || index > WS_SMP_SLOTS) return NULL;
+    return &inst->sampler_slots[index - 1];
+}
+
+static int count_ready_slots(yt_instance_t *inst) {
+    int ready = 0;
+    int i;
+    for (i = 0; i < WS_SMP_SLOTS; i++) {
+        if (__atomic_load_n(&inst->sampler_slots[i].state, __ATOMIC_RELAXED) == SLOT_READY) ready++;
+    }
+    return ready;
+}
+
+static void fail_slot(yt_instance_t *inst, int i, const char *why) {
+    char log_msg[128];
+
+    ws_smp_release(&inst->sampler, i);
+    __atomic_store_n(&inst->sampler_slots[i].state, SLOT_FAILED, __ATOMIC_RELAXED);
+    snprintf(log_msg, sizeof(log_msg), "slot%d capture failed: %s", i + 1, why);
+    render_log(inst, log_msg);
+}
+
+/* Render thread: frees the slot and, for a capture, reserves pool space for a region still in the ring. */
+static void start_slot_capture(yt_instance_t *inst, int i, const slot_request_t *req) {
+    sampler_slot_t *ss = &inst->sampler_slots[i];
+    uint64_t start;
+    uint64_t end;
+    size_t frames;
+    size_t off;
+
+    ws_smp_release(&inst->sampler, i);
+    ss->copied = 0;
+    __atomic_store_n(&ss->length_ms, 0, __ATOMIC_RELAXED);
+    if (req->clear) {
+        __atomic_store_n(&ss->state, SLOT_EMPTY, __ATOMIC_RELAXED);
+        return;
+    }
+    if (req->last_ms > 0) {
+        uint64_t span = ms_to_ring_samples(inst, req->last_ms);
+        end = inst->play_abs;
+        start = end > span ? end - span : 0;
+    } else {
+        start = ms_to_ring_samples(inst, req->start_ms);
+        end = ms_to_ring_samples(inst, req->end_ms);
+    }
+    start &= ~(uint64_t)1U;
+    end &= ~(uint64_t)1U;
+    if (end <= start || start < ring_oldest_abs(inst) || end > inst->write_abs) {
+        fail_slot(inst, i, "region not buffered");
+        return;
+    }
+    frames = (size_t)((end - start) / 2U);
+    off = ws_smp_place(&inst->sampler, i, frames);
+    if (off == (size_t)-1) {
+        fail_slot(inst, i, "sample pool full");
+        return;
+    }
+    inst->sampler.slots[i].off = off;
+    inst->sampler.slots[i].len = frames;
+    ss->src_abs = start;
+    __atomic_store_n(&ss->state, SLOT_CAPTURING, __ATOMIC_RELAXED);
+}
+
+/* Render thread: copies up to budget frames of a capture from the ring into the pool; returns how many. */
+static size_t copy_slot_capture(yt_instance_t *inst, int i, size_t budget) {
+    sampler_slot_t *ss = &inst->sampler_slots[i];
+    ws_smp_slot_t *slot = &inst->sampler.slots[i];
+    size_t n = slot->len - ss->copied < budget ? slot->len - ss->copied : budget;
+    size_t pos = (size_t)(ss->src_abs % (uint64_t)RING_SAMPLES);
+    size_t first = n * 2 < (size_t)RING_SAMPLES - pos ? n * 2 : (size_t)RING_SAMPLES - pos;
+    int16_t *dst = inst->sampler.pool + (slot->off + ss->copied) * 2;
+
+    /* A seek, a new stream or the decoder lapping the ring can take the region away mid-copy. */
+    if (ss->src_abs < ring_oldest_abs(inst) || ss->src_abs + n * 2 > inst->write_abs) {
+        fail_slot(inst, i, "region left the ring");
+        return 0;
     }
-
-    if (inst->resolve_thread_valid && !inst->resolve_thread_running) {
-        pthread_join(inst->resolve_thread, NULL);
-        inst->resolve_thread_valid = false;
+    memcpy(dst, inst->ring + pos, first * sizeof(int16_t));
+    memcpy(dst + first, inst->ring, (n * 2 - first) * sizeof(int16_t));
+    ss->src_abs += n * 2;
+    ss->copied += n;
+    if (ss->copied == slot->len) {
+        slot->ready = true;
+        __atomic_store_n(&ss->length_ms, ring_samples_to_ms(inst, (uint64_t)slot->len * 2U), __ATOMIC_RELAXED);
+        __atomic_store_n(&ss->state, SLOT_READY, __ATOMIC_RELAXED);
     }
+    return n;
+}
 
-    if (inst->resolve_thread_running) {
-        pthread_mutex_unlock(&inst->resolve_mutex);
-        return 1;
+/*
+ * Render thread: takes new slot<n>_capture requests, moves captures along,
+ * then starts queued notes at their offset in this block and mixes the pads.
+ */
+static void render_sampler(yt_instance_t *inst, int16_t *bus, int frames, uint64_t block_us) {
+    size_t budget = SAMPLER_COPY_FRAMES;
+    int i;
+
+    if (__atomic_load_n(&inst->sampler_requests, __ATOMIC_ACQUIRE) != inst->sampler_taken) {
+        slot_request_t reqs[WS_SMP_SLOTS];
+        bool fresh[WS_SMP_SLOTS];
+
+        pthread_mutex_lock(&inst->sampler_mutex);
+        inst->sampler_taken = inst->sampler_requests;
+        for (i = 0; i < WS_SMP_SLOTS; i++) {
+            sampler_slot_t *ss = &inst->sampler_slots[i];
+            fresh[i] = ss->request != ss->taken;
+            reqs[i] = ss->req;
+            ss->taken = ss->request;
+        }
+        pthread_mutex_unlock(&inst->sampler_mutex);
+        for (i = 0; i < WS_SMP_SLOTS; i++) {
+            if (fresh[i]) start_slot_capture(inst, i, &reqs[i]);
+        }
+    }
+    for (i = 0; i < WS_SMP_SLOTS && budget > 0; i++) {
+        if (__atomic_load_n(&inst->sampler_slots[i].state, __ATOMIC_RELAXED) == SLOT_CAPTURING) {
+            budget -= copy_slot_capture(inst, i, budget);
+        }
     }
+    ws_stat_store(&inst->stats.sampler_voices, (uint64_t)ws_smp_render(&inst->sampler, bus, frames, block_us));
+}
 
-    inst->resolve_ready = false;
-    inst->resolve_failed = false;
-    inst->resolved_media_url[0] = '\0';
-    inst->resolved_user_agent[0] = '\0';
-    inst->resolved_referer[0] = '\0';
-    inst->resolve_error[0] = '\0';
-    inst->resolve_thread_running = true;
+/* Shared cache counters: {"shared":b,"search":{"hits":n,"misses":n,"stores":n},"resolve":{...},"evictions":n} */
+static void format_cache_json(char *buf, size_t len) {
+    const ws_shc_segment_t *seg = g_shcache.seg;
+    const char *kinds[WS_SHC_KINDS] = { "search", "resolve" };
+    size_t pos;
+    int n;
+    int k;
 
-    if (pthread_create(&inst->resolve_thread, NULL, resolve_thread_main, inst) != 0) {
-        inst->resolve_thread_running = false;
-        inst->resolve_failed = true;
-        snprintf(inst->resolve_error, sizeof(inst->resolve_error), "failed to start resolve thread");
-        pthread_mutex_unlock(&inst->resolve_mutex);
-        return -1;
+    if (!seg) {
+        snprintf(buf, len, "{}");
+        return;
     }
+    n = snprintf(buf, len, "{\"shared\":%s", g_shcache.shared ? "true" : "false");
+    pos = n > 0 ? (size_t)n : 0;
+    for (k = 0; k < WS_SHC_KINDS && pos < len; k++) {
+        n = snprintf(buf + pos,
+                     len - pos,
+                     ",\"%s\":{\"hits\":%llu,\"misses\":%llu,\"stores\":%llu}",
+                     kinds[k],
+                     (unsigned long long)ws_stat_load(&seg->hits[k]),
+                     (unsigned long long)ws_stat_load(&seg->misses[k]),
+                     (unsigned long long)ws_stat_load(&seg->stores[k]));
+        if (n > 0) pos += (size_t)n;
+    }
+    if (pos < len) n = snprintf(buf + pos, len - pos, ",\"evictions\":%llu}", (unsigned long long)ws_stat_load(&seg->evictions));
+    if (pos >= len || n < 0 || (size_t)n >= len - pos) snprintf(buf, len, "{}");
+}
 
-    inst->resolve_thread_valid = true;
-    pthread_mutex_unlock(&inst->resolve_mutex);
-    return 0;
+/* Whole-instance metrics as one JSON object; returns the length or -1 if it does not fit. */
+static int format_stats_json(yt_instance_t *inst, char *buf, size_t len) {
+    plugin_stats_t *st = &inst->stats;
+    char render_h[384];
+    char resolve_h[384];
+    char ttfa_h[384];
+    char jobs[320];
+    char cache[192];
+    size_t jobs_len;
+    uint64_t starts = ws_stat_load(&st->daemon_starts);
+    int n;
+    int t;
+
+    /* Process-wide, like procs: {"coalesced":n,"<type>":{"run":n,"wait_max_us":n},...} */
+    n = snprintf(jobs, sizeof(jobs), "{\"coalesced\":%llu", (unsigned long long)ws_stat_load(&g_pool.coalesced));
+    jobs_len = n > 0 ? (size_t)n : 0;
+    for (t = 0; t < WS_JOB_TYPES && jobs_len < sizeof(jobs); t++) {
+        n = snprintf(jobs + jobs_len,
+                     sizeof(jobs) - jobs_len,
+                     ",\"%s\":{\"run\":%llu,\"wait_max_us\":%llu}",
+                     ws_job_type_names[t],
+                     (unsigned long long)ws_stat_load(&g_pool.run[t]),
+                     (unsigned long long)ws_stat_load(&g_pool.wait_max_us[t]));
+        if (n > 0) jobs_len += (size_t)n;
+    }
+    if (jobs_len + 1 < sizeof(jobs)) {
+        jobs[jobs_len++] = '}';
+        jobs[jobs_len] = '\0';
+    } else {
+        snprintf(jobs, sizeof(jobs), "{}");
+    }
+
+    format_cache_json(cache, sizeof(cache));
+    (void)ws_hist_format(&st->render_us, render_h, sizeof(render_h));
+    (void)ws_hist_format(&st->resolve_ms, resolve_h, sizeof(resolve_h));
+    (void)ws_hist_format(&st->ttfa_ms, ttfa_h, sizeof(ttfa_h));
+    n = snprintf(buf,
+                 len,
+                 "{\"uptime_ms\":%llu,\"render_us\":%s,\"deadline_us\":%llu,\"deadline_misses\":%llu,"
+                 "\"underruns\":%llu,\"dropped_samples\":%llu,\"clipped_samples\":%llu,\"pipe_bytes\":%llu,\"pipe_bytes_per_sec\":%llu,"
+                 "\"resolve_ms\":%s,\"resolve_failures\":%llu,\"daemon_starts\":%llu,\"daemon_restarts\":%llu,"
+                 "\"legacy_fallbacks\":%llu,\"resumes\":%llu,"
+                 "\"ladder\":{\"fast_starts\":%llu,\"upgrades\":%llu,\"stayed\":%llu,\"net_kbps\":%u},"
+                 "\"voices\":{\"active\":%d,\"starts\":%llu,\"underruns\":%llu},"
+                 "\"loop\":{\"active\":%d,\"wraps\":%llu,\"decode_held\":%d},"
+                 "\"sampler\":{\"slots\":%d,\"voices\":%llu,\"triggers\":%llu,\"steals\":%llu,\"dropped_events\":%llu},"
+                 "\"spawns\":{\"stream\":%llu,\"daemon\":%llu,\"probe\":%llu},"
+                 "\"procs\":{\"live\":%llu,\"spawned\":%llu,\"reaped\":%llu,\"escalations\":%llu},"
+                 "\"daemon\":{\"instances\":%d,\"pid\":%d,\"starts\":%llu,\"requests\":%llu,\"stale_lines\":%llu},"
+                 "\"cache\":%s,\"sched\":{\"audio_cpu\":%d,\"isolated_spawns\":%llu},"
+                 "\"library\":{\"items\":%d,\"bytes\":%llu,\"saves\":%llu,\"save_failures\":%llu,\"evictions\":%llu,"
+                 "\"local_plays\":%llu},"
+                 "\"jobs\":%s,\"ttfa_ms\":%s}",
+                 (unsigned long long)(now_ms() - st->created_ms),
+                 render_h,
+                 (unsigned long long)((uint64_t)(inst->block_frames > 0 ? inst->block_frames : MOVE_FRAMES_PER_BLOCK) *
+                                      1000000ULL / (uint64_t)inst->sample_rate),
+                 (unsigned long long)ws_stat_load(&st->deadline_misses),
+                 (unsigned long long)ws_stat_load(&st->underruns),
+                 (unsigned long long)ws_stat_load(&st->dropped_samples),
+                 (unsigned long long)ws_stat_load(&st->clipped_samples),
+                 (unsigned long long)ws_stat_load(&st->pipe_bytes),
+                 (unsigned long long)ws_stat_load(&st->pipe_bytes_per_sec),
+                 resolve_h,
+                 (unsigned long long)ws_stat_load(&st->resolve_failures),
+                 (unsigned long long)starts,
+                 (unsigned long long)(starts > 0 ? starts - 1 : 0),
+                 (unsigned long long)ws_stat_load(&st->legacy_fallbacks),
+                 (unsigned long long)ws_stat_load(&st->resumes),
+                 (unsigned long long)ws_stat_load(&st->ladder_fast_starts),
+                 (unsigned long long)ws_stat_load(&st->ladder_upgrades),
+                 (unsigned long long)ws_stat_load(&st->ladder_stayed),
+                 inst->buffer_profile ? inst->buffer_profile->net_kbps : 0U,
+                 count_active_voices(inst),
+                 (unsigned long long)ws_stat_load(&st->voice_starts),
+                 (unsigned long long)ws_stat_load(&st->voice_underruns),
+                 __atomic_load_n(&inst->loop_start_abs, __ATOMIC_RELAXED) != LOOP_UNSET &&
+                     __atomic_load_n(&inst->loop_end_abs, __ATOMIC_RELAXED) != LOOP_UNSET,
+                 (unsigned long long)ws_stat_load(&st->loop_wraps),
+                 __atomic_load_n(&inst->loop_decode_held, __ATOMIC_RELAXED),
+                 count_ready_slots(inst),
+                 (unsigned long long)ws_stat_load(&st->sampler_voices),
+                 (unsigned long long)ws_stat_load(&inst->sampler.triggers),
+                 (unsigned long long)ws_stat_load(&inst->sampler.steals),
+                 (unsigned long long)ws_stat_load(&inst->sampler.dropped),
+                 (unsigned long long)ws_stat_load(&st->spawns_stream),
+                 (unsigned long long)ws_stat_load(&st->spawns_daemon),
+                 (unsigned long long)ws_stat_load(&st->spawns_probe),
+                 (unsigned long long)ws_stat_load(&g_procman.live),
+                 (unsigned long long)ws_stat_load(&g_procman.spawned),
+                 (unsigned long long)ws_stat_load(&g_procman.reaped),
+                 (unsigned long long)ws_stat_load(&g_procman.escalations),
+                 __atomic_load_n(&g_daemon.refs, __ATOMIC_RELAXED),
+                 (int)__atomic_load_n(&g_daemon.pid, __ATOMIC_RELAXED),
+                 (unsigned long long)ws_stat_load(&g_daemon.starts),
+                 (unsigned long long)ws_stat_load(&g_daemon.requests),
+                 (unsigned long long)ws_stat_load(&g_daemon.stale_lines),
+                 cache,
+                 __atomic_load_n(&g_sched.audio_cpu, __ATOMIC_RELAXED),
+                 (unsigned long long)ws_stat_load(&g_sched.isolated),
+                 __atomic_load_n(&g_library.count, __ATOMIC_RELAXED),
+                 (unsigned long long)ws_stat_load(&g_library.bytes),
+                 (unsigned long long)ws_stat_load(&g_library.saves),
+                 (unsigned long long)ws_stat_load(&g_library.save_failures),
+                 (unsigned long long)ws_stat_load(&g_library.evictions),
+                 (unsigned long long)ws_stat_load(&g_library.local_plays),
+                 jobs,
+                 ttfa_h);
+    if (n < 0 || (size_t)n >= len) return -1;
+    return n;
 }
 
-static void pump_pipe(yt_instance_t *inst) {
-    uint8_t buf[4096];
-    uint8_t merged[4100];
-    int16_t samples[2048];
+static void append_stats_snapshot(yt_instance_t *inst, const char *path) {
+    char json[STATS_JSON_MAX];
+    FILE *fp;
 
-    while (inst->pipe && !inst->stream_eof) {
-        if (ring_available(inst) + 2048 >= RING_SAMPLES) {
-            break; /* Let pipe backpressure pace producer; avoid dropping */
-        }
+    if (format_stats_json(inst, json, sizeof(json)) < 0) return;
+    fp = fopen(path, "a");
+    if (!fp) return;
+    fprintf(fp, "{\"ts_ms\":%llu,\"instance\":\"%p\",\"stats\":%s}\n", (unsigned long long)wall_ms(), (void *)inst, json);
+    fclose(fp);
+}
 
-        ssize_t n = read(inst->pipe_fd, buf, sizeof(buf));
-        if (n > 0) {
-            size_t merged_bytes = inst->pending_len;
-            size_t aligned_bytes;
-            size_t remainder;
-            size_t sample_count;
+static void drain_render_log(yt_instance_t *inst) {
+    char line[WS_LOGQ_LINE];
+    while (ws_logq_pop(&inst->render_log, line, sizeof(line))) yt_log(line);
+}
 
-            if (inst->pending_len > 0) {
-                memcpy(merged, inst->pending_bytes, inst->pending_len);
+static void* stats_log_thread_main(void *arg) {
+    yt_instance_t *inst = (yt_instance_t *)arg;
+    char path[sizeof(inst->stats_log_path)];
+    struct timespec deadline;
+    uint64_t now;
+    uint64_t wait_ms;
+    bool due;
+
+    /* File writes only; never worth a core the audio could use. */
+    ws_sched_self(WS_SCHED_NICE_KEEP, SCHED_IDLE);
+    pthread_mutex_lock(&inst->stats_log_mutex);
+    while (!inst->stats_log_stop) {
+        /* Wake often enough to keep render_log short, and again when a snapshot is due. */
+        now = now_ms();
+        wait_ms = RENDER_LOG_DRAIN_MS;
+        if (inst->stats_log_path[0]) {
+            uint64_t due_ms = inst->stats_log_last_ms + inst->stats_log_interval_ms;
+            if (due_ms <= now) {
+                wait_ms = 0;
+            } else if (due_ms - now < wait_ms) {
+                wait_ms = due_ms - now;
+            }
+        }
+        if (wait_ms > 0) {
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec += (time_t)(wait_ms / 1000U);
+            deadline.tv_nsec += (long)(wait_ms % 1000U) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
             }
+            pthread_cond_timedwait(&inst->stats_log_cond, &inst->stats_log_mutex, &deadline);
+        }
+        if (inst->stats_log_stop) break;
+        now = now_ms();
+        due = inst->stats_log_path[0] && now >= inst->stats_log_last_ms + inst->stats_log_interval_ms;
+        if (due) inst->stats_log_last_ms = now;
+        snprintf(path, sizeof(path), "%s", inst->stats_log_path);
+        pthread_mutex_unlock(&inst->stats_log_mutex);
+        drain_render_log(inst);
+        if (due) append_stats_snapshot(inst, path);
+        pthread_mutex_lock(&inst->stats_log_mutex);
+    }
+    pthread_mutex_unlock(&inst->stats_log_mutex);
+    return NULL;
+}
 
-            memcpy(merged + merged_bytes, buf, (size_t)n);
-            merged_bytes += (size_t)n;
+/* Runs for the instance's lifetime; stats snapshots only while stats_log names a path. */
+static void start_stats_log(yt_instance_t *inst) {
+    inst->stats_log_stop = false;
+    if (pthread_create(&inst->stats_log_thread, NULL, stats_log_thread_main, inst) == 0) {
+        inst->stats_log_thread_valid = true;
+    }
+}
 
-            aligned_bytes = merged_bytes & ~((size_t)3U);
-            remainder = merged_bytes - aligned_bytes;
-            if (remainder > 0) {
-                memcpy(inst->pending_bytes, merged + aligned_bytes, remainder);
-            }
-            inst->pending_len = (uint8_t)remainder;
+static void stop_stats_log(yt_instance_t *inst) {
+    pthread_mutex_lock(&inst->stats_log_mutex);
+    inst->stats_log_stop = true;
+    inst->stats_log_path[0] = '\0';
+    pthread_cond_broadcast(&inst->stats_log_cond);
+    pthread_mutex_unlock(&inst->stats_log_mutex);
+    if (inst->stats_log_thread_valid) {
+        pthread_join(inst->stats_log_thread, NULL);
+        inst->stats_log_thread_valid = false;
+    }
+    drain_render_log(inst);
+}
 
-            sample_count = aligned_bytes / sizeof(int16_t);
-            if (sample_count > 0) {
-                memcpy(samples, merged, sample_count * sizeof(int16_t));
-                ring_push(inst, samples, sample_count);
-            }
-            if ((size_t)n < sizeof(buf)) {
+/* "on" logs to WS_STATS_LOG_PATH, an absolute path logs there, anything else disables. */
+static void configure_stats_log(yt_instance_t *inst, const char *val) {
+    const char *path = NULL;
+    char log_msg[600];
+
+    if (strcmp(val, "on") == 0 || strcmp(val, "1") == 0) {
+        path = WS_STATS_LOG_PATH;
+    } else if (val[0] == '/') {
+        path = val;
+    }
+
+    pthread_mutex_lock(&inst->stats_log_mutex);
+    snprintf(inst->stats_log_path, sizeof(inst->stats_log_path), "%s", path ? path : "");
+    inst->stats_log_last_ms = now_ms();
+    pthread_cond_broadcast(&inst->stats_log_cond);
+    pthread_mutex_unlock(&inst->stats_log_mutex);
+    if (!path) return;
+
+    snprintf(log_msg, sizeof(log_msg), "stats snapshots %s every %u ms",
+             inst->stats_log_thread_valid ? path : "failed", inst->stats_log_interval_ms);
+    yt_log(log_msg);
+}
+
+static const char* trace_thread_name(uint32_t tid) {
+    switch (tid) {
+        case TRACE_TID_CONTROL: return "control";
+        case TRACE_TID_RESOLVE: return "resolve";
+        case TRACE_TID_PIPELINE: return "pipeline";
+        case TRACE_TID_PROBE: return "probe";
+        case TRACE_TID_DAEMON: return "daemon";
+        default: return "other";
+    }
+}
+
+/* Chrome trace_event JSON (chrome://tracing, Perfetto) of everything still in the ring. */
+static int write_trace_json(yt_instance_t *inst, const char *path) {
+    ws_trace_event_t *events;
+    FILE *fp;
+    int count;
+    int i;
+    uint32_t tid;
+
+    events = malloc(sizeof(*events) * WS_TRACE_CAPACITY);
+    if (!events) return -1;
+    count = ws_trace_snapshot(&inst->trace, events, WS_TRACE_CAPACITY);
+    fp = fopen(path, "w");
+    if (!fp) {
+        free(events);
+        return -1;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (tid = TRACE_TID_CONTROL; tid <= TRACE_TID_DAEMON; tid++) {
+        fprintf(fp,
+                "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                tid == TRACE_TID_CONTROL ? "" : ",",
+                tid,
+                trace_thread_name(tid));
+    }
+    for (i = 0; i < count; i++) {
+        fprintf(fp,
+                ",\n{\"name\":\"%s\",\"ph\":\"%c\",%s\"ts\":%llu,\"pid\":1,\"tid\":%u,"
+                "\"args\":{\"session\":%u,\"arg\":%llu}}",
+                events[i].name ? events[i].name : "?",
+                (char)events[i].ph,
+                events[i].ph == 'i' ? "\"s\":\"p\"," : "",
+                (unsigned long long)events[i].ts_us,
+                events[i].tid,
+                events[i].session,
+                (unsigned long long)events[i].arg);
+    }
+    fprintf(fp, "]}\n");
+    fclose(fp);
+    free(events);
+    return count;
+}
+
+/* Phase offsets (ms after stream_url) for the most recent session still in the ring. */
+static int format_ttfa_trace(yt_instance_t *inst, char *buf, size_t len) {
+    static const struct {
+        const char *name;
+        char ph;
+        const char *key;
+    } phases[] = {
+        { "resolve", 'B', "resolve_start" },
+        { "daemon_start", 'E', "daemon_ready" },
+        { "resolve", 'E', "resolve_end" },
+        { "spawn", 'i', "spawn" },
+        { "first_byte", 'i', "first_byte" },
+        { "primed", 'i', "primed" },
+        { "first_audio", 'i', "first_audio" },
+    };
+    ws_trace_event_t *events;
+    int count;
+    int i;
+    int start = -1;
+    size_t p;
+    size_t pos;
+    int n;
+
+    events = malloc(sizeof(*events) * WS_TRACE_CAPACITY);
+    if (!events) return -1;
+    count = ws_trace_snapshot(&inst->trace, events, WS_TRACE_CAPACITY);
+    for (i = count - 1; i >= 0; i--) {
+        if (events[i].ph == 'i' && events[i].name && strcmp(events[i].name, "stream_url") == 0) {
+            start = i;
+            break;
+        }
+    }
+    if (start < 0) {
+        free(events);
+        return snprintf(buf, len, "{}");
+    }
+
+    n = snprintf(buf, len, "{\"session\":%u", events[start].session);
+    pos = n > 0 ? (size_t)n : 0;
+    for (p = 0; p < sizeof(phases) / sizeof(phases[0]); p++) {
+        for (i = start + 1; i < count; i++) {
+            if (events[i].session == events[start].session &&
+                events[i].ph == (uint32_t)(unsigned char)phases[p].ph &&
+                events[i].name && strcmp(events[i].name, phases[p].name) == 0) {
+                n = snprintf(pos < len ? buf + pos : NULL,
+                             pos < len ? len - pos : 0,
+                             ",\"%s\":%.1f",
+                             phases[p].key,
+                             (double)(events[i].ts_us - events[start].ts_us) / 1000.0);
+                if (n > 0) pos += (size_t)n;
                 break;
             }
-            continue;
         }
-        if (n == 0) {
-            if (inst->active_stream_resolved &&
-                !inst->resolved_fallback_attempted &&
-                supports_legacy_fallback(inst)) {
-                pthread_mutex_lock(&inst->resolve_mutex);
-                inst->resolve_ready = false;
-                inst->resolve_failed = true;
-                pthread_mutex_unlock(&inst->resolve_mutex);
-                inst->resolved_fallback_attempted = true;
-                set_error(inst, "resolved stream ended, falling back");
-                stop_stream(inst);
-                clear_ring(inst);
-                inst->stream_eof = false;
-                inst->restart_countdown = 0;
-                break;
+    }
+    n = snprintf(pos < len ? buf + pos : NULL, pos < len ? len - pos : 0, "}");
+    if (n > 0) pos += (size_t)n;
+    free(events);
+    return (int)pos;
+}
+
+/* WEBSTREAM_CACHE_PATH lets offline runs (host_sim) use their own segment. */
+static const char *cache_shm_path(void) {
+    const char *path = getenv("WEBSTREAM_CACHE_PATH");
+    return path && path[0] ? path : CACHE_SHM_PATH;
+}
+
+static const char *startup_profile_path(void) {
+    const char *path = getenv("WEBSTREAM_STARTUP_PATH");
+    return path && path[0] ? path : STARTUP_PROFILE_PATH;
+}
+
+/*
+ * The tuner's state survives reloads in a small TSV: per provider the
+ * adapted prime/rebuffer, the last measured link speed, and
+ * name:starts/failures/ttfa_ms for each startup profile. Names that are no
+ * longer in the table are ignored.
+ */
+static void load_startup_profiles(yt_instance_t *inst) {
+    char line[512];
+    FILE *fp = fopen(startup_profile_path(), "r");
+
+    if (!fp) return;
+    while (fgets(line, sizeof(line), fp)) {
+        char *save = NULL;
+        char *tok = strtok_r(line, "\t\r\n", &save);
+        char *f[3];
+        buffer_profile_t *p = NULL;
+        int i;
+
+        if (!tok || tok[0] == '#') continue;
+        for (i = 0; i < BUFFER_PROFILE_COUNT; i++) {
+            if (strcmp(inst->buffer_profiles[i].provider, tok) == 0) p = &inst->buffer_profiles[i];
+        }
+        for (i = 0; i < 3; i++) f[i] = strtok_r(NULL, "\t\r\n", &save);
+        if (!p || !f[2]) continue;
+        p->prime_ms = clamp_u32((uint32_t)strtoul(f[0], NULL, 10), p->min_prime_ms, BUFFER_PRIME_MAX_MS);
+        p->rebuffer_ms = clamp_u32((uint32_t)strtoul(f[1], NULL, 10), p->min_rebuffer_ms, BUFFER_REBUFFER_MAX_MS);
+        p->net_kbps = (uint32_t)strtoul(f[2], NULL, 10);
+        while ((tok = strtok_r(NULL, "\t\r\n", &save)) != NULL) {
+            char name[16];
+            unsigned starts;
+            unsigned failures;
+            unsigned ms;
+            if (sscanf(tok, "%15[^:]:%u/%u/%u", name, &starts, &failures, &ms) != 4) continue;
+            for (i = 0; i < STARTUP_PROFILES; i++) {
+                startup_stats_t *st = &p->startup[i];
+                if (strcmp(g_startup_profiles[p - inst->buffer_profiles][i].name, name) != 0) continue;
+                st->starts = starts < STARTUP_HISTORY ? starts : STARTUP_HISTORY;
+                st->failures = failures < st->starts ? failures : st->starts;
+                st->ttfa_ms = ms;
             }
-            inst->stream_eof = true;
-            set_error(inst, "stream ended");
-            stop_stream(inst);
-            inst->restart_countdown = 0;
-            break;
         }
-        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
-            break;
+    }
+    fclose(fp);
+}
+
+/* Control thread: rewrites the file when something changed; a rename keeps readers off half-written files. */
+static void save_startup_profiles(yt_instance_t *inst) {
+    const char *path = startup_profile_path();
+    char tmp[600];
+    FILE *fp;
+    int i;
+    int k;
+
+    if (!__atomic_exchange_n(&inst->startup_dirty, 0, __ATOMIC_ACQ_REL)) return;
+    snprintf(tmp, sizeof(tmp), "%s.%d-%lx.tmp", path, (int)getpid(), (unsigned long)(uintptr_t)inst);
+    fp = fopen(tmp, "w");
+    if (!fp) return;
+    fprintf(fp, "# provider\tprime_ms\trebuffer_ms\tnet_kbps\tprofile:starts/failures/ttfa_ms...\n");
+    for (i = 0; i < BUFFER_PROFILE_COUNT; i++) {
+        const buffer_profile_t *p = &inst->buffer_profiles[i];
+        fprintf(fp, "%s\t%u\t%u\t%u", p->provider, p->prime_ms, p->rebuffer_ms, p->net_kbps);
+        for (k = 0; k < STARTUP_PROFILES; k++) {
+            fprintf(fp, "\t%s:%u/%u/%u", g_startup_profiles[i][k].name, p->startup[k].starts,
+                    p->startup[k].failures, p->startup[k].ttfa_ms);
         }
-        if (inst->active_stream_resolved &&
-            !inst->resolved_fallback_attempted &&
-            supports_legacy_fallback(inst)) {
-            pthread_mutex_lock(&inst->resolve_mutex);
-            inst->resolve_ready = false;
-            inst->resolve_failed = true;
-            pthread_mutex_unlock(&inst->resolve_mutex);
-            inst->resolved_fallback_attempted = true;
-            set_error(inst, "resolved stream read error, falling back");
-            stop_stream(inst);
-            clear_ring(inst);
-            inst->stream_eof = false;
-            inst->restart_countdown = 0;
-            break;
+        fputc('\n', fp);
+    }
+    if (fclose(fp) != 0 || rename(tmp, path) != 0) unlink(tmp);
+}
+
+/* {"youtube":{"pick":"default","prime_ms":n,"net_kbps":n,"profiles":{"default":{"starts":n,"failures":n,"ttfa_ms":n},...}},...} */
+static int format_startup_profiles_json(yt_instance_t *inst, char *buf, size_t len) {
+    size_t pos = 0;
+    int n;
+    int i;
+    int k;
+
+    for (i = 0; i < BUFFER_PROFILE_COUNT; i++) {
+        const buffer_profile_t *p = &inst->buffer_profiles[i];
+        n = snprintf(buf + pos, len - pos, "%s\"%s\":{\"pick\":\"%s\",\"prime_ms\":%u,\"net_kbps\":%u,\"profiles\":{",
+                     i == 0 ? "{" : ",", p->provider, g_startup_profiles[i][p->startup_pick].name, p->prime_ms, p->net_kbps);
+        if (n < 0 || (size_t)n >= len - pos) return -1;
+        pos += (size_t)n;
+        for (k = 0; k < STARTUP_PROFILES; k++) {
+            n = snprintf(buf + pos, len - pos, "%s\"%s\":{\"starts\":%u,\"failures\":%u,\"ttfa_ms\":%u}",
+                         k == 0 ? "" : ",", g_startup_profiles[i][k].name, p->startup[k].starts, p->startup[k].failures,
+                         p->startup[k].ttfa_ms);
+            if (n < 0 || (size_t)n >= len - pos) return -1;
+            pos += (size_t)n;
         }
-        inst->stream_eof = true;
-        set_error(inst, "stream read error");
-        stop_stream(inst);
-        inst->restart_countdown = 0;
-        break;
+        n = snprintf(buf + pos, len - pos, "}}%s", i == BUFFER_PROFILE_COUNT - 1 ? "}" : "");
+        if (n < 0 || (size_t)n >= len - pos) return -1;
+        pos += (size_t)n;
     }
+    return (int)pos;
+}
+
+/* Titles and errors go into JSON strings; quotes and backslashes are not worth escaping there. */
+static void json_safe_copy(char *dst, size_t len, const char *src) {
+    size_t i;
+
+    snprintf(dst, len, "%s", src);
+    for (i = 0; dst[i]; i++) {
+        if (dst[i] == '"') dst[i] = '\'';
+        else if (dst[i] == '\\') dst[i] = '/';
+        else if ((unsigned char)dst[i] < 32) dst[i] = ' ';
+    }
+}
+
+/* {"queued":n,"saving":"title","done_bytes":n,"total_bytes":n,"items":n,"bytes":n,"budget_mb":n,"rate_kbps":n,"error":"..."} */
+static int format_offline_status_json(yt_instance_t *inst, char *buf, size_t len) {
+    char title[SEARCH_TEXT_MAX];
+    char error[192];
+    int queued;
+    uint64_t done;
+    uint64_t total;
+    int items;
+    uint64_t bytes;
+    uint64_t budget;
+
+    pthread_mutex_lock(&inst->offline_mutex);
+    queued = inst->offline_queued;
+    json_safe_copy(title, sizeof(title), inst->offline_title);
+    json_safe_copy(error, sizeof(error), inst->offline_error);
+    done = inst->offline_done_bytes;
+    total = inst->offline_total_bytes;
+    pthread_mutex_unlock(&inst->offline_mutex);
+    pthread_mutex_lock(&g_library.mutex);
+    items = g_library.count;
+    bytes = g_library.bytes;
+    budget = g_library.budget_bytes;
+    pthread_mutex_unlock(&g_library.mutex);
+
+    return snprintf(buf, len,
+                    "{\"queued\":%d,\"saving\":\"%s\",\"done_bytes\":%llu,\"total_bytes\":%llu,\"items\":%d,"
+                    "\"bytes\":%llu,\"budget_mb\":%llu,\"rate_kbps\":%u,\"error\":\"%s\"}",
+                    queued, title, (unsigned long long)done, (unsigned long long)total, items,
+                    (unsigned long long)bytes, (unsigned long long)(budget / (1024ULL * 1024ULL)),
+                    __atomic_load_n(&inst->offline_rate_kbps, __ATOMIC_RELAXED), error);
 }
 
 static void* v2_create_instance(const char *module_dir, const char *json_defaults) {
     yt_instance_t *inst;
+    int i;
 
     inst = calloc(1, sizeof(*inst));
     if (!inst) return NULL;
@@ -1679,13 +5151,62 @@ static void* v2_create_instance(const char *module_dir, const char *json_default
     inst->gain = 1.0f;
     inst->pipe_fd = -1;
     inst->stream_pid = -1;
-    inst->daemon_pid = -1;
+    inst->up_fd = -1;
+    inst->up_pid = -1;
+    inst->sample_rate = host_sample_rate();
+    ws_wave_reset(&inst->wave, 0, waveform_bucket_samples(inst));
+    inst->block_frames = (g_host && g_host->frames_per_block > 0) ? g_host->frames_per_block : MOVE_FRAMES_PER_BLOCK;
+    inst->resampler_taps = WS_RESAMPLER_TAPS_HIGH;
+    inst->resampler = &inst->resamplers[0];
+    inst->up_resampler = &inst->resamplers[1];
+    prepare_resampler_tables(inst);
+    inst->range_prefetch = true;
+    inst->probe_pid = -1;
+    inst->stats.created_ms = now_ms();
+    inst->stats_log_interval_ms = STATS_LOG_INTERVAL_MS_DEFAULT;
+    init_buffer_profiles(inst);
+    load_startup_profiles(inst);
+    inst->startup_mode = -1;
+    reset_underrun_stats(inst);
+
+    inst->offline_pid = -1;
+    inst->offline_rate_kbps = OFFLINE_RATE_KBPS_DEFAULT;
+    for (i = 0; i < VOICE_MAX; i++) {
+        voice_t *v = &inst->voices[i];
+        v->inst = inst;
+        v->index = i + 1;
+        snprintf(v->provider, sizeof(v->provider), "youtube");
+        v->gain_q13 = WS_MIX_UNITY;
+        v->fd = -1;
+        v->pid = -1;
+    }
+    ws_smp_init(&inst->sampler, NULL, 0);
+    pthread_once(&g_loop_xfade_once, init_loop_xfade);
+    clear_loop(inst);
+    inst->loop_start_req = LOOP_REQ_NONE;
+    inst->loop_end_req = LOOP_REQ_NONE;
 
     pthread_mutex_init(&inst->search_mutex, NULL);
-    pthread_mutex_init(&inst->daemon_mutex, NULL);
     pthread_mutex_init(&inst->resolve_mutex, NULL);
+    pthread_mutex_init(&inst->offline_mutex, NULL);
+    pthread_mutex_init(&inst->voice_mutex, NULL);
+    pthread_mutex_init(&inst->sampler_mutex, NULL);
+    pthread_mutex_init(&inst->stats_log_mutex, NULL);
+    {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&inst->stats_log_cond, &attr);
+        pthread_condattr_destroy(&attr);
+    }
+    ws_logq_init(&inst->render_log);
+    start_stats_log(inst);
     snprintf(inst->search_status, sizeof(inst->search_status), "idle");
     (void)json_defaults;
+    ws_shc_acquire(cache_shm_path());
+    ws_lib_acquire(library_dir(), (uint64_t)LIBRARY_BUDGET_MB_DEFAULT * 1024ULL * 1024ULL);
+    ws_pool_acquire();
+    daemon_acquire(inst);
     start_warmup_if_needed(inst);
 
     return inst;
@@ -1693,48 +5214,61 @@ static void* v2_create_instance(const char *module_dir, const char *json_default
 
 static void v2_destroy_instance(void *instance) {
     yt_instance_t *inst = (yt_instance_t *)instance;
-    pid_t daemon_pid_snapshot;
     if (!inst) return;
 
+    stop_stats_log(inst);
     stop_stream(inst);
+    save_startup_profiles(inst);
 
-    daemon_pid_snapshot = inst->daemon_pid;
-    if (daemon_pid_snapshot > 0) {
-        (void)kill(daemon_pid_snapshot, SIGTERM);
-    }
-
-    if (inst->warmup_thread_valid) {
-        pthread_join(inst->warmup_thread, NULL);
-        inst->warmup_thread_valid = false;
-    }
+    /* Our daemon requests stop waiting; the shared daemon keeps serving the other instances. */
+    __atomic_store_n(&inst->daemon_cancel, 1U, __ATOMIC_RELEASE);
 
-    if (inst->resolve_thread_valid) {
-        pthread_join(inst->resolve_thread, NULL);
-        inst->resolve_thread_valid = false;
-        inst->resolve_thread_running = false;
-    }
+    pthread_mutex_lock(&inst->resolve_mutex);
+    cancel_probe_locked(inst);
+    pthread_mutex_unlock(&inst->resolve_mutex);
 
-    if (inst->search_thread_valid) {
-        pthread_join(inst->search_thread, NULL);
-        inst->search_thread_valid = false;
-        inst->search_thread_running = false;
-    }
+    cancel_offline_saves(inst);
 
-    pthread_mutex_lock(&inst->daemon_mutex);
-    stop_daemon_locked(inst);
-    pthread_mutex_unlock(&inst->daemon_mutex);
+    /* With daemon waits cancelled and the probe and download signalled, running jobs return promptly. */
+    ws_pool_cancel(inst);
+    stop_voices(inst);
+    ws_pool_release();
+    daemon_release();
+    ws_lib_release();
+    ws_shc_release();
 
+    pthread_cond_destroy(&inst->stats_log_cond);
+    pthread_mutex_destroy(&inst->stats_log_mutex);
     pthread_mutex_destroy(&inst->resolve_mutex);
-    pthread_mutex_destroy(&inst->daemon_mutex);
+    pthread_mutex_destroy(&inst->offline_mutex);
+    pthread_mutex_destroy(&inst->voice_mutex);
+    pthread_mutex_destroy(&inst->sampler_mutex);
     pthread_mutex_destroy(&inst->search_mutex);
+    free(inst->sampler_pool);
     free(inst);
 }
 
+/* Pads: notes are queued with their arrival time and started at the matching offset of the next block. */
 static void v2_on_midi(void *instance, const uint8_t *msg, int len, int source) {
-    (void)instance;
-    (void)msg;
-    (void)len;
+    yt_instance_t *inst = (yt_instance_t *)instance;
     (void)source;
+    if (!inst) return;
+    ws_smp_post(&inst->sampler, msg, len, mono_us());
+}
+
+/* An absolute frame at the host rate, "here"/"trigger" for the play position, or "" to clear. */
+static bool parse_loop_point(const char *val, uint64_t *req) {
+    if (val[0] == '\0' || strcmp(val, "clear") == 0 || strcmp(val, "off") == 0) {
+        *req = LOOP_REQ_CLEAR;
+    } else if (strcmp(val, "here") == 0 || strcmp(val, "trigger") == 0) {
+        *req = LOOP_REQ_HERE;
+    } else if (val[0] >= '0' && val[0] <= '9') {
+        *req = strtoull(val, NULL, 10);
+        if (*req >= LOOP_REQ_HERE) return false;
+    } else {
+        return false;
+    }
+    return true;
 }
 
 /* Accept new enum trigger values and legacy numeric step counters. */
@@ -1768,120 +5302,541 @@ static bool allow_trigger(uint64_t *last_ms, uint64_t debounce_ms) {
     return true;
 }
 
-static void v2_set_param(void *instance, const char *key, const char *val) {
-    yt_instance_t *inst = (yt_instance_t *)instance;
-    char log_msg[384];
-    if (!inst || !key || !val) return;
+/*
+ * Every get_param/set_param key, hashed once (ws_keymap.h) so dispatch is a
+ * single lookup plus a switch instead of a strcmp chain. Keys ending in '_'
+ * take a numeric index suffix, e.g. search_result_url_3.
+ */
+typedef enum {
+    PARAM_GAIN = 0,
+    PARAM_PRESET_NAME,
+    PARAM_STREAM_URL,
+    PARAM_STREAM_PROVIDER,
+    PARAM_STREAM_STATUS,
+    PARAM_STATE_VERSION,
+    PARAM_OUTPUT_LEVEL,
+    PARAM_WAVEFORM,
+    PARAM_METER,
+    PARAM_METER_RESET,
+    PARAM_CLIP_COUNT,
+    PARAM_STREAM_BITRATE_KBPS,
+    PARAM_STREAM_CODEC,
+    PARAM_PLAY_PAUSE_TOGGLE,
+    PARAM_PLAY_PAUSE_STEP,
+    PARAM_STOP,
+    PARAM_STOP_STEP,
+    PARAM_RESTART,
+    PARAM_RESTART_STEP,
+    PARAM_SEEK_DELTA_SECONDS,
+    PARAM_SEEK_POSITION_MS,
+    PARAM_LOOP_START,
+    PARAM_LOOP_END,
+    PARAM_LOOP_DECODE,
+    PARAM_REWIND_15_STEP,
+    PARAM_FORWARD_15_STEP,
+    PARAM_SAMPLE_RATE,
+    PARAM_SOURCE_SAMPLE_RATE,
+    PARAM_RESAMPLER_QUALITY,
+    PARAM_RANGE_PREFETCH,
+    PARAM_POSITION_MS,
+    PARAM_DURATION_MS,
+    PARAM_BUFFERED_AHEAD_MS,
+    PARAM_BUFFER_PRIME_MS,
+    PARAM_BUFFER_REBUFFER_MS,
+    PARAM_ARRIVAL_RATE_PCT,
+    PARAM_UNDERRUN_COUNT,
+    PARAM_UNDERRUN_MS,
+    PARAM_RESUME_COUNT,
+    PARAM_STATS_JSON,
+    PARAM_STATS_LOG,
+    PARAM_STATS_LOG_INTERVAL_MS,
+    PARAM_TTFA_TRACE,
+    PARAM_TRACE_DUMP,
+    PARAM_CACHE_CLEAR,
+    PARAM_CHILD_SCHED,
+    PARAM_QUALITY_LADDER,
+    PARAM_STREAM_QUALITY,
+    PARAM_STARTUP_PROFILE,
+    PARAM_STARTUP_PROFILES,
+    PARAM_OFFLINE_SAVE,
+    PARAM_OFFLINE_STATUS,
+    PARAM_OFFLINE_BUDGET_MB,
+    PARAM_OFFLINE_RATE_KBPS,
+    PARAM_VOICE_COUNT,
+    PARAM_VOICE_STREAM_URL,
+    PARAM_VOICE_STREAM_PROVIDER,
+    PARAM_VOICE_GAIN,
+    PARAM_VOICE_TRANSPORT,
+    PARAM_VOICE_STATUS,
+    PARAM_VOICE_POSITION_MS,
+    PARAM_VOICE_ERROR,
+    PARAM_SAMPLER_BASE_NOTE,
+    PARAM_SLOT_CAPTURE,
+    PARAM_SLOT_GAIN,
+    PARAM_SLOT_STATUS,
+    PARAM_SLOT_LENGTH_MS,
+    PARAM_SEARCH_QUERY,
+    PARAM_SEARCH_PROVIDER,
+    PARAM_SEARCH_STATUS,
+    PARAM_SEARCH_ERROR,
+    PARAM_SEARCH_COUNT,
+    PARAM_SEARCH_ELAPSED_MS,
+    PARAM_SEARCH_GENERATION,
+    PARAM_SEARCH_RESULTS_SNAPSHOT,
+    PARAM_SEARCH_RESULT_ROW,
+    PARAM_SEARCH_RESULT_TITLE,
+    PARAM_SEARCH_RESULT_CHANNEL,
+    PARAM_SEARCH_RESULT_DURATION,
+    PARAM_SEARCH_RESULT_URL,
+    PARAM_SEARCH_RESULT_PROVIDER
+} param_id_t;
+
+static const ws_key_t g_param_keys[] = {
+    { "gain", PARAM_GAIN },
+    { "preset_name", PARAM_PRESET_NAME },
+    { "name", PARAM_PRESET_NAME },
+    { "stream_url", PARAM_STREAM_URL },
+    { "stream_provider", PARAM_STREAM_PROVIDER },
+    { "stream_status", PARAM_STREAM_STATUS },
+    { "state_version", PARAM_STATE_VERSION },
+    { "output_level", PARAM_OUTPUT_LEVEL },
+    { "waveform", PARAM_WAVEFORM },
+    { "waveform_", PARAM_WAVEFORM },
+    { "meter", PARAM_METER },
+    { "meter_reset", PARAM_METER_RESET },
+    { "clip_count", PARAM_CLIP_COUNT },
+    { "stream_bitrate_kbps", PARAM_STREAM_BITRATE_KBPS },
+    { "stream_codec", PARAM_STREAM_CODEC },
+    { "play_pause_toggle", PARAM_PLAY_PAUSE_TOGGLE },
+    { "play_pause_step", PARAM_PLAY_PAUSE_STEP },
+    { "stop", PARAM_STOP },
+    { "stop_step", PARAM_STOP_STEP },
+    { "restart", PARAM_RESTART },
+    { "restart_step", PARAM_RESTART_STEP },
+    { "seek_delta_seconds", PARAM_SEEK_DELTA_SECONDS },
+    { "seek_position_ms", PARAM_SEEK_POSITION_MS },
+    { "loop_start", PARAM_LOOP_START },
+    { "loop_end", PARAM_LOOP_END },
+    { "loop_decode", PARAM_LOOP_DECODE },
+    { "rewind_15_step", PARAM_REWIND_15_STEP },
+    { "forward_15_step", PARAM_FORWARD_15_STEP },
+    { "sample_rate", PARAM_SAMPLE_RATE },
+    { "source_sample_rate", PARAM_SOURCE_SAMPLE_RATE },
+    { "resampler_quality", PARAM_RESAMPLER_QUALITY },
+    { "range_prefetch", PARAM_RANGE_PREFETCH },
+    { "position_ms", PARAM_POSITION_MS },
+    { "duration_ms", PARAM_DURATION_MS },
+    { "buffered_ahead_ms", PARAM_BUFFERED_AHEAD_MS },
+    { "buffer_prime_ms", PARAM_BUFFER_PRIME_MS },
+    { "buffer_rebuffer_ms", PARAM_BUFFER_REBUFFER_MS },
+    { "arrival_rate_pct", PARAM_ARRIVAL_RATE_PCT },
+    { "underrun_count", PARAM_UNDERRUN_COUNT },
+    { "underrun_ms", PARAM_UNDERRUN_MS },
+    { "resume_count", PARAM_RESUME_COUNT },
+    { "stats_json", PARAM_STATS_JSON },
+    { "stats_log", PARAM_STATS_LOG },
+    { "stats_log_interval_ms", PARAM_STATS_LOG_INTERVAL_MS },
+    { "ttfa_trace", PARAM_TTFA_TRACE },
+    { "trace_dump", PARAM_TRACE_DUMP },
+    { "cache_clear", PARAM_CACHE_CLEAR },
+    { "child_sched", PARAM_CHILD_SCHED },
+    { "quality_ladder", PARAM_QUALITY_LADDER },
+    { "stream_quality", PARAM_STREAM_QUALITY },
+    { "startup_profile", PARAM_STARTUP_PROFILE },
+    { "startup_profiles", PARAM_STARTUP_PROFILES },
+    { "offline_save", PARAM_OFFLINE_SAVE },
+    { "offline_status", PARAM_OFFLINE_STATUS },
+    { "offline_budget_mb", PARAM_OFFLINE_BUDGET_MB },
+    { "offline_rate_kbps", PARAM_OFFLINE_RATE_KBPS },
+    { "voice_count", PARAM_VOICE_COUNT },
+    { "voice#_stream_url", PARAM_VOICE_STREAM_URL },
+    { "voice#_stream_provider", PARAM_VOICE_STREAM_PROVIDER },
+    { "voice#_gain", PARAM_VOICE_GAIN },
+    { "voice#_transport", PARAM_VOICE_TRANSPORT },
+    { "voice#_status", PARAM_VOICE_STATUS },
+    { "voice#_position_ms", PARAM_VOICE_POSITION_MS },
+    { "voice#_error", PARAM_VOICE_ERROR },
+    { "sampler_base_note", PARAM_SAMPLER_BASE_NOTE },
+    { "slot#_capture", PARAM_SLOT_CAPTURE },
+    { "slot#_gain", PARAM_SLOT_GAIN },
+    { "slot#_status", PARAM_SLOT_STATUS },
+    { "slot#_length_ms", PARAM_SLOT_LENGTH_MS },
+    { "search_query", PARAM_SEARCH_QUERY },
+    { "search_provider", PARAM_SEARCH_PROVIDER },
+    { "search_status", PARAM_SEARCH_STATUS },
+    { "search_error", PARAM_SEARCH_ERROR },
+    { "search_count", PARAM_SEARCH_COUNT },
+    { "search_elapsed_ms", PARAM_SEARCH_ELAPSED_MS },
+    { "search_generation", PARAM_SEARCH_GENERATION },
+    { "search_results_snapshot", PARAM_SEARCH_RESULTS_SNAPSHOT },
+    { "search_results_snapshot_", PARAM_SEARCH_RESULTS_SNAPSHOT },
+    { "search_result_", PARAM_SEARCH_RESULT_ROW },
+    { "search_result_title_", PARAM_SEARCH_RESULT_TITLE },
+    { "search_result_channel_", PARAM_SEARCH_RESULT_CHANNEL },
+    { "search_result_duration_", PARAM_SEARCH_RESULT_DURATION },
+    { "search_result_url_", PARAM_SEARCH_RESULT_URL },
+    { "search_result_provider_", PARAM_SEARCH_RESULT_PROVIDER },
+};
+
+static ws_keymap_t g_param_map;
+static pthread_once_t g_param_map_once = PTHREAD_ONCE_INIT;
+
+static void build_param_map(void) {
+    if (ws_keymap_build(&g_param_map, g_param_keys, (int)(sizeof(g_param_keys) / sizeof(g_param_keys[0]))) != 0) {
+        yt_log("param key table failed to build");
+    }
+}
+
+/* param_id_t for key, or -1; *index gets the suffix of an indexed key, else -1. */
+static int param_lookup(const char *key, int *index) {
+    pthread_once(&g_param_map_once, build_param_map);
+    return ws_keymap_lookup(&g_param_map, key, index);
+}
+
+static void v2_set_param(void *instance, const char *key, const char *val) {
+    yt_instance_t *inst = (yt_instance_t *)instance;
+    char log_msg[384];
+    int index;
+    if (!inst || !key || !val) return;
+
+    switch (param_lookup(key, &index)) {
+        case PARAM_GAIN: {
+            float g = (float)atof(val);
+            if (g < 0.0f) g = 0.0f;
+            if (g > 2.0f) g = 2.0f;
+            inst->gain = g;
+            return;
+        }
+
+        case PARAM_METER_RESET:
+            __atomic_store_n(&inst->meter_reset_pending, 1, __ATOMIC_RELEASE);
+            return;
+
+        case PARAM_STREAM_URL: {
+            char clean_url[STREAM_URL_MAX];
+            char clean_provider[PROVIDER_MAX];
+            char local_path[WS_LIB_PATH_MAX];
+            ws_lib_item_t saved;
+            bool local;
+            /* Between streams is a quiet moment to persist what the last start taught us. */
+            save_startup_profiles(inst);
+            if (val[0] == '\0') {
+                stop_everything(inst);
+                return;
+            }
+
+            if (!sanitize_stream_url(val, clean_url, sizeof(clean_url))) {
+                set_error(inst, "invalid stream_url");
+                return;
+            }
+
+            snprintf(clean_provider, sizeof(clean_provider), "%s", inst->stream_provider);
+            infer_provider_from_url(clean_url, clean_provider, sizeof(clean_provider));
+            normalize_provider_value(clean_provider, clean_provider, sizeof(clean_provider));
+            snprintf(inst->stream_url, sizeof(inst->stream_url), "%s", clean_url);
+            inst->stream_duration_ms = lookup_result_duration_ms(inst, clean_url);
+            inst->stream_bitrate_kbps = 0;
+            inst->stream_codec[0] = '\0';
+            /* A saved copy stands in for the resolve: no daemon, no network. */
+            local = ws_lib_open(clean_provider, clean_url, wall_ms() / 1000ULL, &saved, local_path, sizeof(local_path));
+            if (local && inst->stream_duration_ms == 0) inst->stream_duration_ms = parse_duration_text_ms(saved.duration);
+            pthread_mutex_lock(&inst->resolve_mutex);
+            cancel_probe_locked(inst);
+            snprintf(inst->stream_provider, sizeof(inst->stream_provider), "%s", clean_provider);
+            inst->resolve_ready = false;
+            inst->resolve_failed = false;
+            inst->resolved_media_url[0] = '\0';
+            inst->resolved_user_agent[0] = '\0';
+            inst->resolved_referer[0] = '\0';
+            inst->resolved_kbps = 0;
+            inst->resolved_rung_count = 0;
+            inst->resolved_local = local;
+            inst->resolve_error[0] = '\0';
+            if (local) {
+                inst->resolve_ready = true;
+                snprintf(inst->resolved_media_url, sizeof(inst->resolved_media_url), "%s", local_path);
+            }
+            pthread_mutex_unlock(&inst->resolve_mutex);
+            snprintf(log_msg, sizeof(log_msg), "stream_url set provider=%s url=%s%s", clean_provider, clean_url,
+                     local ? " (saved copy)" : "");
+            yt_log(log_msg);
+            ws_stat_store(&inst->stats.ttfa_start_ms, now_ms());
+            {
+                uint32_t session = __atomic_add_fetch(&inst->trace_session, 1, __ATOMIC_RELAXED);
+                trace_event(inst, "stream_url", 'i', TRACE_TID_CONTROL, 0);
+                __atomic_store_n(&inst->trace_first_audio_pending, session, __ATOMIC_RELAXED);
+            }
+            restart_stream_from_beginning(inst, 0);
+            if (local) {
+                start_probe_async(inst, local_path);
+            } else if (prefer_legacy_pipeline(inst)) {
+                snprintf(log_msg, sizeof(log_msg), "stream_url using legacy pipeline provider=%s", clean_provider);
+                yt_log(log_msg);
+                if (start_stream_legacy(inst) != 0) {
+                    inst->stream_eof = true;
+                    inst->restart_countdown = 0;
+                }
+            } else {
+                (void)start_resolve_async(inst);
+            }
+            return;
+        }
+
+        case PARAM_RANGE_PREFETCH: {
+            /* Applied from the next decoder spawn. */
+            inst->range_prefetch = strcmp(val, "off") != 0 && strcmp(val, "0") != 0;
+            return;
+        }
+
+        case PARAM_QUALITY_LADDER: {
+            /* Applied from the next fresh start; a stream already on a rung finishes its decision. */
+            int mode;
+            for (mode = 0; mode < LADDER_MODES; mode++) {
+                if (strcmp(val, g_ladder_mode_names[mode]) == 0) {
+                    inst->ladder_mode = mode;
+                    return;
+                }
+            }
+            snprintf(log_msg, sizeof(log_msg), "quality_ladder: ignoring \"%s\" (auto, off or low)", val);
+            yt_log(log_msg);
+            return;
+        }
+
+        case PARAM_STARTUP_PROFILE: {
+            /* "auto" tunes per provider; a profile name pins every provider to it (still timed). */
+            int k;
+            if (strcmp(val, "auto") == 0) {
+                __atomic_store_n(&inst->startup_mode, -1, __ATOMIC_RELAXED);
+                return;
+            }
+            for (k = 0; k < STARTUP_PROFILES; k++) {
+                if (strcmp(val, g_startup_profiles[0][k].name) == 0) {
+                    __atomic_store_n(&inst->startup_mode, k, __ATOMIC_RELAXED);
+                    return;
+                }
+            }
+            snprintf(log_msg, sizeof(log_msg), "startup_profile: ignoring \"%s\" (auto, default, quick or lowdelay)", val);
+            yt_log(log_msg);
+            return;
+        }
+
+        case PARAM_OFFLINE_SAVE: {
+            /* The index of a row in the current search results. */
+            int rc = queue_offline_save(inst, atoi(val));
+            snprintf(log_msg, sizeof(log_msg), "offline_save %s: %s", val,
+                     rc == 0 ? "queued" : (rc > 0 ? "already saved or queued" : "not queued"));
+            yt_log(log_msg);
+            return;
+        }
+
+        case PARAM_OFFLINE_BUDGET_MB: {
+            /* Process-wide; shrinking it evicts least recently used items right away. */
+            unsigned long mb = strtoul(val, NULL, 10);
+            ws_lib_set_budget((uint64_t)mb * 1024ULL * 1024ULL);
+            return;
+        }
+
+        case PARAM_OFFLINE_RATE_KBPS: {
+            /* Applied from the next download; 0 lifts the limit. */
+            __atomic_store_n(&inst->offline_rate_kbps, (uint32_t)strtoul(val, NULL, 10), __ATOMIC_RELAXED);
+            return;
+        }
+
+        case PARAM_VOICE_STREAM_URL: {
+            char clean_url[STREAM_URL_MAX];
+            voice_t *v = voice_at(inst, index);
+            if (!v) return;
+            if (val[0] != '\0' && !sanitize_stream_url(val, clean_url, sizeof(clean_url))) {
+                set_voice_error(inst, v, "invalid stream_url");
+                return;
+            }
+            set_voice_source(inst, v, val[0] != '\0' ? clean_url : "");
+            snprintf(log_msg, sizeof(log_msg), "voice%d stream_url set: %s", index, val[0] != '\0' ? clean_url : "(cleared)");
+            yt_log(log_msg);
+            return;
+        }
+
+        case PARAM_VOICE_STREAM_PROVIDER: {
+            voice_t *v = voice_at(inst, index);
+            if (!v) return;
+            pthread_mutex_lock(&inst->voice_mutex);
+            normalize_provider_value(val, v->provider, sizeof(v->provider));
+            pthread_mutex_unlock(&inst->voice_mutex);
+            return;
+        }
+
+        case PARAM_VOICE_GAIN: {
+            voice_t *v = voice_at(inst, index);
+            float g = (float)atof(val);
+            if (!v) return;
+            if (g < 0.0f) g = 0.0f;
+            if (g > 2.0f) g = 2.0f;
+            __atomic_store_n(&v->gain_q13, ws_mix_gain_q13(g), __ATOMIC_RELAXED);
+            return;
+        }
+
+        case PARAM_VOICE_TRANSPORT: {
+            voice_t *v = voice_at(inst, index);
+            uint32_t cmd = VOICE_CMD_NONE;
+            if (!v) return;
+            if (strcmp(val, "play") == 0) cmd = VOICE_CMD_PLAY;
+            else if (strcmp(val, "pause") == 0) cmd = VOICE_CMD_PAUSE;
+            else if (strcmp(val, "toggle") == 0) cmd = VOICE_CMD_TOGGLE;
+            else if (strcmp(val, "stop") == 0) cmd = VOICE_CMD_STOP;
+            else if (strcmp(val, "restart") == 0) cmd = VOICE_CMD_RESTART;
+            if (cmd != VOICE_CMD_NONE) __atomic_store_n(&v->command, cmd, __ATOMIC_RELEASE);
+            return;
+        }
+
+        case PARAM_SAMPLER_BASE_NOTE: {
+            int note = atoi(val);
+            if (note < 0) note = 0;
+            if (note > 127) note = 127;
+            __atomic_store_n(&inst->sampler.base_note, note, __ATOMIC_RELAXED);
+            return;
+        }
+
+        case PARAM_SLOT_CAPTURE: {
+            /* "<start_ms> <end_ms>" of the stream, "last <ms>" before the play position, or "" to clear. */
+            sampler_slot_t *ss = slot_at(inst, index);
+            slot_request_t req;
+            char *end = NULL;
+            if (!ss) return;
+            memset(&req, 0, sizeof(req));
+            if (val[0] == '\0' || strcmp(val, "clear") == 0) {
+                req.clear = true;
+            } else if (strncmp(val, "last ", 5) == 0) {
+                req.last_ms = strtoull(val + 5, NULL, 10);
+                if (req.last_ms == 0) return;
+            } else {
+                req.start_ms = strtoull(val, &end, 10);
+                req.end_ms = strtoull(end, NULL, 10);
+                if (end == val || req.end_ms <= req.start_ms) return;
+            }
+            if (!req.clear && !inst->sampler_pool) {
+                inst->sampler_pool = calloc((size_t)SAMPLER_POOL_FRAMES * 2U, sizeof(int16_t));
+                if (!inst->sampler_pool) {
+                    yt_log("sampler pool allocation failed");
+                    return;
+                }
+            }
+            pthread_mutex_lock(&inst->sampler_mutex);
+            /* Render only reaches the pool through a capture request, taken under this mutex. */
+            if (inst->sampler_pool && !inst->sampler.pool) {
+                inst->sampler.pool = inst->sampler_pool;
+                inst->sampler.pool_frames = SAMPLER_POOL_FRAMES;
+            }
+            ss->req = req;
+            ss->request++;
+            __atomic_fetch_add(&inst->sampler_requests, 1, __ATOMIC_RELEASE);
+            pthread_mutex_unlock(&inst->sampler_mutex);
+            snprintf(log_msg, sizeof(log_msg), "slot%d capture: %s", index, req.clear ? "(cleared)" : val);
+            yt_log(log_msg);
+            return;
+        }
 
-    if (strcmp(key, "gain") == 0) {
-        float g = (float)atof(val);
-        if (g < 0.0f) g = 0.0f;
-        if (g > 2.0f) g = 2.0f;
-        inst->gain = g;
-        return;
-    }
+        case PARAM_SLOT_GAIN: {
+            float g = (float)atof(val);
+            if (!slot_at(inst, index)) return;
+            if (g < 0.0f) g = 0.0f;
+            if (g > 2.0f) g = 2.0f;
+            __atomic_store_n(&inst->sampler.slots[index - 1].gain_q13, ws_mix_gain_q13(g), __ATOMIC_RELAXED);
+            return;
+        }
 
-    if (strcmp(key, "stream_url") == 0) {
-        char clean_url[STREAM_URL_MAX];
-        char clean_provider[PROVIDER_MAX];
-        if (val[0] == '\0') {
-            stop_everything(inst);
+        case PARAM_STATS_LOG: {
+            configure_stats_log(inst, val);
             return;
         }
 
-        if (!sanitize_stream_url(val, clean_url, sizeof(clean_url))) {
-            set_error(inst, "invalid stream_url");
+        case PARAM_TRACE_DUMP: {
+            /* Absolute path only; written on this (control) thread. */
+            if (val[0] == '/') {
+                int count = write_trace_json(inst, val);
+                snprintf(log_msg, sizeof(log_msg), "trace dump %s: %d events", val, count);
+                yt_log(log_msg);
+            }
             return;
         }
 
-        snprintf(clean_provider, sizeof(clean_provider), "%s", inst->stream_provider);
-        infer_provider_from_url(clean_url, clean_provider, sizeof(clean_provider));
-        normalize_provider_value(clean_provider, clean_provider, sizeof(clean_provider));
-        snprintf(inst->stream_url, sizeof(inst->stream_url), "%s", clean_url);
-        pthread_mutex_lock(&inst->resolve_mutex);
-        snprintf(inst->stream_provider, sizeof(inst->stream_provider), "%s", clean_provider);
-        inst->resolve_ready = false;
-        inst->resolve_failed = false;
-        inst->resolved_media_url[0] = '\0';
-        inst->resolved_user_agent[0] = '\0';
-        inst->resolved_referer[0] = '\0';
-        inst->resolve_error[0] = '\0';
-        pthread_mutex_unlock(&inst->resolve_mutex);
-        snprintf(log_msg, sizeof(log_msg), "stream_url set provider=%s url=%s", clean_provider, clean_url);
-        yt_log(log_msg);
-        restart_stream_from_beginning(inst, 0);
-        if (prefer_legacy_pipeline(inst)) {
-            snprintf(log_msg, sizeof(log_msg), "stream_url using legacy pipeline provider=%s", clean_provider);
-            yt_log(log_msg);
-            if (start_stream_legacy(inst) != 0) {
-                inst->stream_eof = true;
-                inst->restart_countdown = 0;
+        case PARAM_CACHE_CLEAR: {
+            /* Empties the search/resolve cache for every instance sharing it. */
+            ws_shc_clear(g_shcache.seg);
+            yt_log("search/resolve cache cleared");
+            return;
+        }
+
+        case PARAM_CHILD_SCHED: {
+            /* Process-wide (the daemon is shared); applied from the next spawn. */
+            ws_sched_policy_t policy;
+            if (ws_sched_parse(val, &policy) != 0) {
+                snprintf(log_msg, sizeof(log_msg), "child_sched: ignoring invalid spec \"%s\"", val);
+                yt_log(log_msg);
+                return;
             }
-        } else {
-            (void)start_resolve_async(inst);
+            pthread_mutex_lock(&g_sched.mutex);
+            g_sched.child = policy;
+            pthread_mutex_unlock(&g_sched.mutex);
+            return;
         }
-        return;
-    }
 
-    if (strcmp(key, "stream_provider") == 0) {
-        char clean_provider[PROVIDER_MAX];
-        normalize_provider_value(val, clean_provider, sizeof(clean_provider));
-        pthread_mutex_lock(&inst->resolve_mutex);
-        snprintf(inst->stream_provider, sizeof(inst->stream_provider), "%s", clean_provider);
-        pthread_mutex_unlock(&inst->resolve_mutex);
-        return;
-    }
+        case PARAM_STATS_LOG_INTERVAL_MS: {
+            long ms = strtol(val, NULL, 10);
+            pthread_mutex_lock(&inst->stats_log_mutex);
+            inst->stats_log_interval_ms = ms < (long)STATS_LOG_INTERVAL_MS_MIN ? STATS_LOG_INTERVAL_MS_MIN : (uint32_t)ms;
+            pthread_cond_broadcast(&inst->stats_log_cond);
+            pthread_mutex_unlock(&inst->stats_log_mutex);
+            return;
+        }
 
-    if (strcmp(key, "play_pause_toggle") == 0) {
-        if (inst->stream_url[0] != '\0' && !inst->stream_eof) {
-            inst->paused = !inst->paused;
+        case PARAM_RESAMPLER_QUALITY: {
+            /* Applied when the next decoder reports its source rate. */
+            inst->resampler_taps = strcmp(val, "low") == 0 ? WS_RESAMPLER_TAPS_LOW : WS_RESAMPLER_TAPS_HIGH;
+            prepare_resampler_tables(inst);
+            return;
+        }
+
+        case PARAM_STREAM_PROVIDER: {
+            char clean_provider[PROVIDER_MAX];
+            normalize_provider_value(val, clean_provider, sizeof(clean_provider));
+            pthread_mutex_lock(&inst->resolve_mutex);
+            snprintf(inst->stream_provider, sizeof(inst->stream_provider), "%s", clean_provider);
+            pthread_mutex_unlock(&inst->resolve_mutex);
+            return;
         }
-        return;
-    }
 
-    if (strcmp(key, "play_pause_step") == 0) {
-        if (parse_trigger_value(val, &inst->play_pause_step)) {
-            if (allow_trigger(&inst->last_play_pause_ms, DEBOUNCE_PLAY_PAUSE_MS) &&
-                inst->stream_url[0] != '\0' &&
-                !inst->stream_eof) {
+        case PARAM_PLAY_PAUSE_TOGGLE: {
+            if (stream_playable(inst)) {
                 inst->paused = !inst->paused;
             }
+            return;
         }
-        return;
-    }
 
-    if (strcmp(key, "stop") == 0) {
-        stop_everything(inst);
-        return;
-    }
+        case PARAM_PLAY_PAUSE_STEP: {
+            if (parse_trigger_value(val, &inst->play_pause_step)) {
+                if (allow_trigger(&inst->last_play_pause_ms, DEBOUNCE_PLAY_PAUSE_MS) &&
+                    stream_playable(inst)) {
+                    inst->paused = !inst->paused;
+                }
+            }
+            return;
+        }
 
-    if (strcmp(key, "stop_step") == 0) {
-        if (parse_trigger_value(val, &inst->stop_step) &&
-            allow_trigger(&inst->last_stop_ms, DEBOUNCE_STOP_MS)) {
+        case PARAM_STOP: {
             stop_everything(inst);
+            return;
         }
-        return;
-    }
 
-    if (strcmp(key, "restart") == 0) {
-        if (inst->stream_url[0] != '\0') {
-            restart_stream_from_beginning(inst, 0);
-            if (prefer_legacy_pipeline(inst)) {
-                if (start_stream_legacy(inst) != 0) {
-                    inst->stream_eof = true;
-                    inst->restart_countdown = 0;
-                }
-            } else {
-                (void)start_resolve_async(inst);
+        case PARAM_STOP_STEP: {
+            if (parse_trigger_value(val, &inst->stop_step) &&
+                allow_trigger(&inst->last_stop_ms, DEBOUNCE_STOP_MS)) {
+                stop_everything(inst);
             }
+            return;
         }
-        return;
-    }
 
-    if (strcmp(key, "restart_step") == 0) {
-        if (parse_trigger_value(val, &inst->restart_step)) {
-            if (allow_trigger(&inst->last_restart_ms, DEBOUNCE_RESTART_MS) &&
-                inst->stream_url[0] != '\0') {
+        case PARAM_RESTART: {
+            if (inst->stream_url[0] != '\0') {
                 restart_stream_from_beginning(inst, 0);
                 if (prefer_legacy_pipeline(inst)) {
                     if (start_stream_legacy(inst) != 0) {
@@ -1892,220 +5847,502 @@ static void v2_set_param(void *instance, const char *key, const char *val) {
                     (void)start_resolve_async(inst);
                 }
             }
+            return;
         }
-        return;
-    }
 
-    if (strcmp(key, "seek_delta_seconds") == 0) {
-        long delta_sec = strtol(val, NULL, 10);
-        seek_relative_seconds(inst, delta_sec);
-        return;
-    }
+        case PARAM_RESTART_STEP: {
+            if (parse_trigger_value(val, &inst->restart_step)) {
+                if (allow_trigger(&inst->last_restart_ms, DEBOUNCE_RESTART_MS) &&
+                    inst->stream_url[0] != '\0') {
+                    restart_stream_from_beginning(inst, 0);
+                    if (prefer_legacy_pipeline(inst)) {
+                        if (start_stream_legacy(inst) != 0) {
+                            inst->stream_eof = true;
+                            inst->restart_countdown = 0;
+                        }
+                    } else {
+                        (void)start_resolve_async(inst);
+                    }
+                }
+            }
+            return;
+        }
 
-    if (strcmp(key, "rewind_15_step") == 0) {
-        if (parse_trigger_value(val, &inst->rewind_15_step) &&
-            allow_trigger(&inst->last_rewind_ms, DEBOUNCE_SEEK_MS)) {
-            seek_relative_seconds(inst, -15);
+        case PARAM_SEEK_DELTA_SECONDS: {
+            long delta_sec = strtol(val, NULL, 10);
+            seek_relative_seconds(inst, delta_sec);
+            return;
         }
-        return;
-    }
 
-    if (strcmp(key, "forward_15_step") == 0) {
-        if (parse_trigger_value(val, &inst->forward_15_step) &&
-            allow_trigger(&inst->last_forward_ms, DEBOUNCE_SEEK_MS)) {
-            seek_relative_seconds(inst, 15);
+        case PARAM_SEEK_POSITION_MS: {
+            long long target_ms = strtoll(val, NULL, 10);
+            seek_to_ms(inst, target_ms > 0 ? (uint64_t)target_ms : 0);
+            return;
         }
-        return;
-    }
 
-    if (strcmp(key, "search_query") == 0) {
-        pthread_mutex_lock(&inst->search_mutex);
-        if (val[0] == '\0') {
-            clear_search_locked(inst);
-        } else {
-            (void)start_search_async(inst, val);
+        case PARAM_LOOP_START: {
+            uint64_t req;
+            if (parse_loop_point(val, &req)) __atomic_store_n(&inst->loop_start_req, req, __ATOMIC_RELEASE);
+            return;
         }
-        pthread_mutex_unlock(&inst->search_mutex);
-        return;
-    }
 
-    if (strcmp(key, "search_provider") == 0) {
-        char clean_provider[PROVIDER_MAX];
-        normalize_provider_value(val, clean_provider, sizeof(clean_provider));
-        pthread_mutex_lock(&inst->search_mutex);
-        snprintf(inst->search_provider, sizeof(inst->search_provider), "%s", clean_provider);
-        pthread_mutex_unlock(&inst->search_mutex);
-        return;
+        case PARAM_LOOP_END: {
+            uint64_t req;
+            if (parse_loop_point(val, &req)) __atomic_store_n(&inst->loop_end_req, req, __ATOMIC_RELEASE);
+            return;
+        }
+
+        case PARAM_LOOP_DECODE: {
+            if (strcmp(val, "pause") == 0 || strcmp(val, "continue") == 0) {
+                __atomic_store_n(&inst->loop_decode_pause, val[0] == 'p', __ATOMIC_RELAXED);
+            }
+            return;
+        }
+
+        case PARAM_REWIND_15_STEP: {
+            if (parse_trigger_value(val, &inst->rewind_15_step) &&
+                allow_trigger(&inst->last_rewind_ms, DEBOUNCE_SEEK_MS)) {
+                seek_relative_seconds(inst, -15);
+            }
+            return;
+        }
+
+        case PARAM_FORWARD_15_STEP: {
+            if (parse_trigger_value(val, &inst->forward_15_step) &&
+                allow_trigger(&inst->last_forward_ms, DEBOUNCE_SEEK_MS)) {
+                seek_relative_seconds(inst, 15);
+            }
+            return;
+        }
+
+        case PARAM_SEARCH_QUERY: {
+            pthread_mutex_lock(&inst->search_mutex);
+            if (val[0] == '\0') {
+                clear_search_locked(inst);
+            } else {
+                (void)start_search_async(inst, val);
+            }
+            pthread_mutex_unlock(&inst->search_mutex);
+            return;
+        }
+
+        case PARAM_SEARCH_PROVIDER: {
+            char clean_provider[PROVIDER_MAX];
+            normalize_provider_value(val, clean_provider, sizeof(clean_provider));
+            pthread_mutex_lock(&inst->search_mutex);
+            snprintf(inst->search_provider, sizeof(inst->search_provider), "%s", clean_provider);
+            __atomic_store_n(&inst->search_generation, inst->search_generation + 1, __ATOMIC_RELEASE);
+            pthread_mutex_unlock(&inst->search_mutex);
+            return;
+        }
+        default:
+            return;
     }
 }
 
-static int get_result_index(const char *key, const char *prefix) {
-    size_t len;
-    int idx;
+/*
+ * search_results_snapshot[_<first>]: a header line
+ *   <generation>\t<status>\t<provider>\t<count>\t<first>\t<rows>
+ * followed by <rows> lines of provider\ttitle\tchannel\tduration\turl. Rows
+ * that do not fit in buf are left for a follow-up call at first + rows.
+ * Fields never contain tabs or newlines (sanitize_display_text/_stream_url).
+ * Caller must hold search_mutex.
+ */
+static int format_search_snapshot_locked(yt_instance_t *inst, int first, char *buf, size_t len) {
+    static const char row_fmt[] = "%s\t%s\t%s\t%s\t%s\n";
+    uint32_t generation = inst->search_generation;
+    int count = inst->search_count;
+    int rows = 0;
+    int header;
+    size_t body = 0;
+    size_t pos;
+    int i;
+
+    if (first < 0 || first > count) first = count;
+    /* rows <= count, so this bounds the final header length. */
+    header = snprintf(NULL, 0, "%u\t%s\t%s\t%d\t%d\t%d\n",
+                      generation, inst->search_status, inst->search_provider, count, first, count);
+    if (header < 0 || (size_t)header >= len) return -1;
+    for (i = first; i < count; i++) {
+        const search_result_t *r = &inst->search_results[i];
+        int n = snprintf(NULL, 0, row_fmt, r->provider, r->title, r->channel, r->duration, r->url);
+        if (n < 0 || (size_t)header + body + (size_t)n >= len) break;
+        body += (size_t)n;
+        rows++;
+    }
+
+    header = snprintf(buf, len, "%u\t%s\t%s\t%d\t%d\t%d\n",
+                      generation, inst->search_status, inst->search_provider, count, first, rows);
+    pos = (size_t)header;
+    for (i = first; i < first + rows; i++) {
+        const search_result_t *r = &inst->search_results[i];
+        pos += (size_t)snprintf(buf + pos, len - pos, row_fmt, r->provider, r->title, r->channel, r->duration, r->url);
+    }
+    return (int)pos;
+}
 
-    if (!key || !prefix) return -1;
-    len = strlen(prefix);
-    if (strncmp(key, prefix, len) != 0) return -1;
-    idx = atoi(key + len);
-    if (idx < 0 || idx >= SEARCH_MAX_RESULTS) return -1;
-    return idx;
+/*
+ * Transport getters read the render thread's last published block instead of
+ * live render state; wait-free, and all zero (stopped) before the first block.
+ */
+static ws_status_t read_status(const yt_instance_t *inst) {
+    ws_status_t status;
+    memset(&status, 0, sizeof(status));
+    if (inst) (void)ws_status_read(&inst->status, &status);
+    return status;
+}
+
+static double level_dbfs(uint32_t level) {
+    double db;
+    if (level == 0) return METER_FLOOR_DB;
+    db = 20.0 * log10((double)level / 32768.0);
+    return db < METER_FLOOR_DB ? METER_FLOOR_DB : db;
+}
+
+static const char *transport_state_name(uint32_t state) {
+    return g_transport_state_names[state < TRANSPORT_STATES ? state : TRANSPORT_STOPPED];
+}
+
+/*
+ * waveform[_<first>]: a header line <first>\t<bucket_ms>\t<count>\t<position_ms>
+ * then six hex digits per bucket (min, max, RMS scaled to 0..255; min/max
+ * centred on 0x80), oldest first, the last being the live edge. Bucket n
+ * starts at n * bucket_ms on the ring timeline. Without an index this is
+ * the newest buckets that fit in buf; with one it starts at bucket first, so
+ * a poller only fetches what changed since its last live edge.
+ */
+static int format_waveform(yt_instance_t *inst, int first, char *buf, size_t len) {
+    ws_wave_bucket_t buckets[WS_WAVE_BUCKETS];
+    char header[96];
+    uint64_t live = ws_wave_live(&inst->wave);
+    uint64_t from;
+    uint64_t start;
+    size_t pos;
+    int cap;
+    int n;
+    int i;
+
+    /* The header's first and count are at most as long as these, so this bounds cap. */
+    n = snprintf(header, sizeof(header), "%llu\t%u\t%d\t%llu\n", (unsigned long long)live, WAVEFORM_BUCKET_MS,
+                 WS_WAVE_BUCKETS, (unsigned long long)read_status(inst).position_ms);
+    if (n < 0 || (size_t)n + 2 > len) return -1;
+    cap = (int)((len - (size_t)n - 2) / 6);
+    if (cap > WS_WAVE_BUCKETS) cap = WS_WAVE_BUCKETS;
+    if (first >= 0) {
+        from = (uint64_t)first;
+    } else {
+        from = live + 1 > (uint64_t)cap ? live + 1 - (uint64_t)cap : 0;
+    }
+    n = ws_wave_read(&inst->wave, from, buckets, cap, &start);
+
+    pos = (size_t)snprintf(buf, len, "%llu\t%u\t%d\t%llu\n", (unsigned long long)start, WAVEFORM_BUCKET_MS, n,
+                           (unsigned long long)read_status(inst).position_ms);
+    for (i = 0; i < n; i++) {
+        unsigned rms = (unsigned)buckets[i].rms >> 7;
+        pos += (size_t)snprintf(buf + pos, len - pos, "%02x%02x%02x",
+                                (unsigned)((buckets[i].min >> 8) + 128), (unsigned)((buckets[i].max >> 8) + 128),
+                                rms > 255U ? 255U : rms);
+    }
+    pos += (size_t)snprintf(buf + pos, len - pos, "\n");
+    return (int)pos;
 }
 
 static int v2_get_param(void *instance, const char *key, char *buf, int buf_len) {
     yt_instance_t *inst = (yt_instance_t *)instance;
+    int index;
+    int id;
     if (!key || !buf || buf_len <= 0) return -1;
 
-    if (strcmp(key, "gain") == 0) {
-        return snprintf(buf, (size_t)buf_len, "%.2f", inst ? inst->gain : 1.0f);
-    }
-    if (strcmp(key, "play_pause_step") == 0) {
-        return snprintf(buf, (size_t)buf_len, "idle");
-    }
-    if (strcmp(key, "rewind_15_step") == 0) {
-        return snprintf(buf, (size_t)buf_len, "idle");
-    }
-    if (strcmp(key, "forward_15_step") == 0) {
-        return snprintf(buf, (size_t)buf_len, "idle");
-    }
-    if (strcmp(key, "stop_step") == 0) {
-        return snprintf(buf, (size_t)buf_len, "idle");
-    }
-    if (strcmp(key, "restart_step") == 0) {
-        return snprintf(buf, (size_t)buf_len, "idle");
-    }
-    if (strcmp(key, "preset_name") == 0 || strcmp(key, "name") == 0) {
-        return snprintf(buf, (size_t)buf_len, "Webstream");
-    }
-    if (strcmp(key, "stream_url") == 0) {
-        return snprintf(buf, (size_t)buf_len, "%s", inst ? inst->stream_url : "");
-    }
-    if (strcmp(key, "stream_provider") == 0) {
-        return snprintf(buf, (size_t)buf_len, "%s", inst ? inst->stream_provider : "youtube");
-    }
-    if (strcmp(key, "stream_status") == 0) {
-        size_t avail;
-        if (!inst) return snprintf(buf, (size_t)buf_len, "stopped");
-        if (inst->stream_url[0] == '\0') return snprintf(buf, (size_t)buf_len, "stopped");
-        if (inst->paused) return snprintf(buf, (size_t)buf_len, "paused");
-        if (inst->seek_discard_samples > 0) return snprintf(buf, (size_t)buf_len, "seeking");
-        if (!inst->pipe && inst->restart_countdown > 0) return snprintf(buf, (size_t)buf_len, "loading");
-        if (!inst->pipe && !inst->stream_eof) return snprintf(buf, (size_t)buf_len, "loading");
-        if (inst->stream_eof) return snprintf(buf, (size_t)buf_len, "eof");
-        avail = ring_available(inst);
-        if (inst->prime_needed_samples > 0 && avail < inst->prime_needed_samples) {
-            return snprintf(buf, (size_t)buf_len, "buffering");
+    id = param_lookup(key, &index);
+    switch (id) {
+        case PARAM_GAIN:
+            return snprintf(buf, (size_t)buf_len, "%.2f", inst ? inst->gain : 1.0f);
+        case PARAM_PLAY_PAUSE_STEP:
+            return snprintf(buf, (size_t)buf_len, "idle");
+        case PARAM_REWIND_15_STEP:
+            return snprintf(buf, (size_t)buf_len, "idle");
+        case PARAM_FORWARD_15_STEP:
+            return snprintf(buf, (size_t)buf_len, "idle");
+        case PARAM_STOP_STEP:
+            return snprintf(buf, (size_t)buf_len, "idle");
+        case PARAM_RESTART_STEP:
+            return snprintf(buf, (size_t)buf_len, "idle");
+        case PARAM_LOOP_START:
+        case PARAM_LOOP_END: {
+            uint64_t abs;
+            if (!inst) return -1;
+            abs = __atomic_load_n(id == PARAM_LOOP_START ? &inst->loop_start_abs : &inst->loop_end_abs, __ATOMIC_RELAXED);
+            if (abs == LOOP_UNSET) return snprintf(buf, (size_t)buf_len, "%s", "");
+            return snprintf(buf, (size_t)buf_len, "%llu", (unsigned long long)(abs / 2U));
         }
-        return snprintf(buf, (size_t)buf_len, "streaming");
-    }
-
-    if (inst && strcmp(key, "search_status") == 0) {
-        int ret;
-        pthread_mutex_lock(&inst->search_mutex);
-        ret = snprintf(buf, (size_t)buf_len, "%s", inst->search_status);
-        pthread_mutex_unlock(&inst->search_mutex);
-        return ret;
-    }
-    if (inst && strcmp(key, "search_query") == 0) {
-        int ret;
-        pthread_mutex_lock(&inst->search_mutex);
-        ret = snprintf(buf, (size_t)buf_len, "%s", inst->search_query);
-        pthread_mutex_unlock(&inst->search_mutex);
-        return ret;
-    }
-    if (inst && strcmp(key, "search_provider") == 0) {
-        int ret;
-        pthread_mutex_lock(&inst->search_mutex);
-        ret = snprintf(buf, (size_t)buf_len, "%s", inst->search_provider);
-        pthread_mutex_unlock(&inst->search_mutex);
-        return ret;
-    }
-    if (inst && strcmp(key, "search_error") == 0) {
-        int ret;
-        pthread_mutex_lock(&inst->search_mutex);
-        ret = snprintf(buf, (size_t)buf_len, "%s", inst->search_error);
-        pthread_mutex_unlock(&inst->search_mutex);
-        return ret;
-    }
-    if (inst && strcmp(key, "search_count") == 0) {
-        int ret;
-        pthread_mutex_lock(&inst->search_mutex);
-        ret = snprintf(buf, (size_t)buf_len, "%d", inst->search_count);
-        pthread_mutex_unlock(&inst->search_mutex);
-        return ret;
-    }
-    if (inst && strcmp(key, "search_elapsed_ms") == 0) {
-        int ret;
-        pthread_mutex_lock(&inst->search_mutex);
-        ret = snprintf(buf, (size_t)buf_len, "%llu", (unsigned long long)inst->search_elapsed_ms);
-        pthread_mutex_unlock(&inst->search_mutex);
-        return ret;
-    }
+        case PARAM_LOOP_DECODE:
+            return snprintf(buf, (size_t)buf_len, "%s",
+                            inst && __atomic_load_n(&inst->loop_decode_pause, __ATOMIC_RELAXED) ? "pause" : "continue");
+        case PARAM_PRESET_NAME:
+            return snprintf(buf, (size_t)buf_len, "Webstream");
+        case PARAM_STREAM_URL:
+            return snprintf(buf, (size_t)buf_len, "%s", inst ? inst->stream_url : "");
+        case PARAM_STREAM_PROVIDER:
+            return snprintf(buf, (size_t)buf_len, "%s", inst ? inst->stream_provider : "youtube");
+        case PARAM_STREAM_STATUS:
+            return snprintf(buf, (size_t)buf_len, "%s", transport_state_name(read_status(inst).state));
+        case PARAM_STATE_VERSION:
+            return snprintf(buf, (size_t)buf_len, "%llu", (unsigned long long)read_status(inst).version);
+        case PARAM_OUTPUT_LEVEL:
+            return snprintf(buf, (size_t)buf_len, "%u", read_status(inst).level);
+        case PARAM_WAVEFORM:
+            if (!inst) return -1;
+            return format_waveform(inst, index, buf, (size_t)buf_len);
+        case PARAM_METER: {
+            ws_status_t st = read_status(inst);
+            return snprintf(buf, (size_t)buf_len, "%.1f\t%.1f\t%.1f\t%.1f\t%.1f\t%.1f\t%llu",
+                            level_dbfs(st.peak[0]), level_dbfs(st.peak[1]), level_dbfs(st.rms[0]), level_dbfs(st.rms[1]),
+                            level_dbfs(st.hold[0]), level_dbfs(st.hold[1]), (unsigned long long)st.clips);
+        }
+        case PARAM_CLIP_COUNT:
+            return snprintf(buf, (size_t)buf_len, "%llu", (unsigned long long)read_status(inst).clips);
+        case PARAM_SAMPLE_RATE:
+            return snprintf(buf, (size_t)buf_len, "%d", inst ? inst->sample_rate : host_sample_rate());
+        case PARAM_SOURCE_SAMPLE_RATE:
+            return snprintf(buf, (size_t)buf_len, "%d", inst ? inst->source_rate : 0);
+        case PARAM_RESAMPLER_QUALITY:
+            return snprintf(buf, (size_t)buf_len, "%s",
+                            inst && inst->resampler_taps == WS_RESAMPLER_TAPS_LOW ? "low" : "high");
+        case PARAM_RANGE_PREFETCH:
+            return snprintf(buf, (size_t)buf_len, "%s", inst && !inst->range_prefetch ? "off" : "on");
+        case PARAM_CHILD_SCHED: {
+            ws_sched_policy_t policy;
+            pthread_mutex_lock(&g_sched.mutex);
+            policy = g_sched.child;
+            pthread_mutex_unlock(&g_sched.mutex);
+            return ws_sched_format(&policy, buf, (size_t)buf_len);
+        }
+        case PARAM_QUALITY_LADDER:
+            return snprintf(buf, (size_t)buf_len, "%s", g_ladder_mode_names[inst ? inst->ladder_mode : LADDER_MODE_AUTO]);
+        case PARAM_STREAM_QUALITY:
+            return snprintf(buf, (size_t)buf_len, "%s", g_ladder_state_names[inst ? inst->ladder_state : LADDER_FULL]);
+        case PARAM_STARTUP_PROFILE: {
+            buffer_profile_t *p;
+            if (!inst) return -1;
+            p = select_buffer_profile(inst);
+            return snprintf(buf, (size_t)buf_len, "%s", startup_profile_of(inst, p)->name);
+        }
+        case PARAM_STARTUP_PROFILES: {
+            char json[STATS_JSON_MAX];
+            int n;
+            if (!inst) return -1;
+            n = format_startup_profiles_json(inst, json, sizeof(json));
+            if (n < 0 || (size_t)n >= (size_t)buf_len) return -1;
+            return snprintf(buf, (size_t)buf_len, "%s", json);
+        }
+        case PARAM_OFFLINE_STATUS: {
+            char json[768];
+            int n;
+            if (!inst) return -1;
+            n = format_offline_status_json(inst, json, sizeof(json));
+            if (n < 0 || (size_t)n >= (size_t)buf_len) return -1;
+            return snprintf(buf, (size_t)buf_len, "%s", json);
+        }
+        case PARAM_OFFLINE_BUDGET_MB:
+            return snprintf(buf, (size_t)buf_len, "%llu",
+                            (unsigned long long)(__atomic_load_n(&g_library.budget_bytes, __ATOMIC_RELAXED) / (1024ULL * 1024ULL)));
+        case PARAM_OFFLINE_RATE_KBPS:
+            return snprintf(buf, (size_t)buf_len, "%u", inst ? __atomic_load_n(&inst->offline_rate_kbps, __ATOMIC_RELAXED) : 0U);
+        case PARAM_VOICE_COUNT:
+            return snprintf(buf, (size_t)buf_len, "%d", VOICE_MAX);
+        case PARAM_VOICE_STREAM_URL:
+        case PARAM_VOICE_STREAM_PROVIDER:
+        case PARAM_VOICE_ERROR: {
+            voice_t *v = voice_at(inst, index);
+            int n;
+            if (!v) return -1;
+            pthread_mutex_lock(&inst->voice_mutex);
+            n = snprintf(buf, (size_t)buf_len, "%s",
+                         id == PARAM_VOICE_STREAM_URL ? v->url : (id == PARAM_VOICE_ERROR ? v->error : v->provider));
+            pthread_mutex_unlock(&inst->voice_mutex);
+            return n;
+        }
+        case PARAM_VOICE_GAIN: {
+            voice_t *v = voice_at(inst, index);
+            if (!v) return -1;
+            return snprintf(buf, (size_t)buf_len, "%.2f",
+                            (double)__atomic_load_n(&v->gain_q13, __ATOMIC_RELAXED) / (double)WS_MIX_UNITY);
+        }
+        case PARAM_VOICE_TRANSPORT:
+        case PARAM_VOICE_STATUS: {
+            voice_t *v = voice_at(inst, index);
+            if (!v) return -1;
+            return snprintf(buf, (size_t)buf_len, "%s", g_voice_state_names[__atomic_load_n(&v->state, __ATOMIC_RELAXED)]);
+        }
+        case PARAM_VOICE_POSITION_MS: {
+            voice_t *v = voice_at(inst, index);
+            if (!v) return -1;
+            return snprintf(buf, (size_t)buf_len, "%llu", (unsigned long long)__atomic_load_n(&v->position_ms, __ATOMIC_RELAXED));
+        }
+        case PARAM_SAMPLER_BASE_NOTE:
+            if (!inst) return -1;
+            return snprintf(buf, (size_t)buf_len, "%d", __atomic_load_n(&inst->sampler.base_note, __ATOMIC_RELAXED));
+        case PARAM_SLOT_CAPTURE:
+        case PARAM_SLOT_STATUS: {
+            sampler_slot_t *ss = slot_at(inst, index);
+            if (!ss) return -1;
+            return snprintf(buf, (size_t)buf_len, "%s", g_slot_state_names[__atomic_load_n(&ss->state, __ATOMIC_RELAXED)]);
+        }
+        case PARAM_SLOT_GAIN:
+            if (!slot_at(inst, index)) return -1;
+            return snprintf(buf, (size_t)buf_len, "%.2f",
+                            (double)__atomic_load_n(&inst->sampler.slots[index - 1].gain_q13, __ATOMIC_RELAXED) /
+                                (double)WS_MIX_UNITY);
+        case PARAM_SLOT_LENGTH_MS: {
+            sampler_slot_t *ss = slot_at(inst, index);
+            if (!ss) return -1;
+            return snprintf(buf, (size_t)buf_len, "%llu", (unsigned long long)__atomic_load_n(&ss->length_ms, __ATOMIC_RELAXED));
+        }
+        case PARAM_RESUME_COUNT:
+            return snprintf(buf, (size_t)buf_len, "%llu", (unsigned long long)(inst ? inst->resume_count : 0));
+        case PARAM_STATS_JSON: {
+            char json[STATS_JSON_MAX];
+            if (!inst || format_stats_json(inst, json, sizeof(json)) < 0) return -1;
+            if (strlen(json) >= (size_t)buf_len) return -1;
+            return snprintf(buf, (size_t)buf_len, "%s", json);
+        }
+        case PARAM_TTFA_TRACE: {
+            char json[512];
+            int n;
+            if (!inst) return -1;
+            n = format_ttfa_trace(inst, json, sizeof(json));
+            if (n < 0 || (size_t)n >= sizeof(json) || (size_t)n >= (size_t)buf_len) return -1;
+            return snprintf(buf, (size_t)buf_len, "%s", json);
+        }
+        case PARAM_STATS_LOG: {
+            int ret;
+            if (!inst) return -1;
+            pthread_mutex_lock(&inst->stats_log_mutex);
+            ret = snprintf(buf, (size_t)buf_len, "%s", inst->stats_log_path[0] ? inst->stats_log_path : "off");
+            pthread_mutex_unlock(&inst->stats_log_mutex);
+            return ret;
+        }
+        case PARAM_UNDERRUN_COUNT:
+            return snprintf(buf, (size_t)buf_len, "%llu", (unsigned long long)read_status(inst).underruns);
+        case PARAM_UNDERRUN_MS:
+            return snprintf(buf, (size_t)buf_len, "%llu", (unsigned long long)(inst ? underrun_ms_total(inst) : 0));
+        case PARAM_POSITION_MS:
+            return snprintf(buf, (size_t)buf_len, "%llu", (unsigned long long)read_status(inst).position_ms);
+        case PARAM_DURATION_MS: {
+            if (inst) apply_probe_result(inst);
+            return snprintf(buf, (size_t)buf_len, "%llu", (unsigned long long)(inst ? inst->stream_duration_ms : 0));
+        }
+        case PARAM_STREAM_BITRATE_KBPS: {
+            if (inst) apply_probe_result(inst);
+            return snprintf(buf, (size_t)buf_len, "%u", inst ? inst->stream_bitrate_kbps : 0U);
+        }
+        case PARAM_STREAM_CODEC: {
+            if (inst) apply_probe_result(inst);
+            return snprintf(buf, (size_t)buf_len, "%s", inst ? inst->stream_codec : "");
+        }
+        case PARAM_BUFFERED_AHEAD_MS:
+            return snprintf(buf, (size_t)buf_len, "%llu", (unsigned long long)read_status(inst).buffered_ms);
+        case PARAM_BUFFER_PRIME_MS: {
+            buffer_profile_t *p = inst ? (inst->buffer_profile ? inst->buffer_profile : select_buffer_profile(inst)) : NULL;
+            return snprintf(buf, (size_t)buf_len, "%u", p ? p->prime_ms : 0U);
+        }
+        case PARAM_BUFFER_REBUFFER_MS: {
+            buffer_profile_t *p = inst ? (inst->buffer_profile ? inst->buffer_profile : select_buffer_profile(inst)) : NULL;
+            return snprintf(buf, (size_t)buf_len, "%u", p ? p->rebuffer_ms : 0U);
+        }
+        case PARAM_ARRIVAL_RATE_PCT:
+            return snprintf(buf, (size_t)buf_len, "%u", inst ? inst->arrival_ratio_pct : 0U);
 
-    if (inst) {
-        int idx = get_result_index(key, "search_result_title_");
-        if (idx >= 0) {
-            int ret = -1;
+        case PARAM_SEARCH_GENERATION: {
+            if (!inst) return -1;
+            return snprintf(buf, (size_t)buf_len, "%u", __atomic_load_n(&inst->search_generation, __ATOMIC_ACQUIRE));
+        }
+        case PARAM_SEARCH_RESULTS_SNAPSHOT: {
+            int ret;
+            if (!inst) return -1;
             pthread_mutex_lock(&inst->search_mutex);
-            if (idx < inst->search_count) ret = snprintf(buf, (size_t)buf_len, "%s", inst->search_results[idx].title);
+            ret = format_search_snapshot_locked(inst, index > 0 ? index : 0, buf, (size_t)buf_len);
             pthread_mutex_unlock(&inst->search_mutex);
             return ret;
         }
-
-        idx = get_result_index(key, "search_result_channel_");
-        if (idx >= 0) {
-            int ret = -1;
+        case PARAM_SEARCH_STATUS: {
+            int ret;
+            if (!inst) return -1;
             pthread_mutex_lock(&inst->search_mutex);
-            if (idx < inst->search_count) ret = snprintf(buf, (size_t)buf_len, "%s", inst->search_results[idx].channel);
+            ret = snprintf(buf, (size_t)buf_len, "%s", inst->search_status);
             pthread_mutex_unlock(&inst->search_mutex);
             return ret;
         }
-
-        idx = get_result_index(key, "search_result_duration_");
-        if (idx >= 0) {
-            int ret = -1;
+        case PARAM_SEARCH_QUERY: {
+            int ret;
+            if (!inst) return -1;
             pthread_mutex_lock(&inst->search_mutex);
-            if (idx < inst->search_count) ret = snprintf(buf, (size_t)buf_len, "%s", inst->search_results[idx].duration);
+            ret = snprintf(buf, (size_t)buf_len, "%s", inst->search_query);
             pthread_mutex_unlock(&inst->search_mutex);
             return ret;
         }
-
-        idx = get_result_index(key, "search_result_url_");
-        if (idx >= 0) {
-            int ret = -1;
+        case PARAM_SEARCH_PROVIDER: {
+            int ret;
+            if (!inst) return -1;
             pthread_mutex_lock(&inst->search_mutex);
-            if (idx < inst->search_count) ret = snprintf(buf, (size_t)buf_len, "%s", inst->search_results[idx].url);
+            ret = snprintf(buf, (size_t)buf_len, "%s", inst->search_provider);
             pthread_mutex_unlock(&inst->search_mutex);
             return ret;
         }
-
-        idx = get_result_index(key, "search_result_provider_");
-        if (idx >= 0) {
-            int ret = -1;
+        case PARAM_SEARCH_ERROR: {
+            int ret;
+            if (!inst) return -1;
             pthread_mutex_lock(&inst->search_mutex);
-            if (idx < inst->search_count) ret = snprintf(buf, (size_t)buf_len, "%s", inst->search_results[idx].provider);
+            ret = snprintf(buf, (size_t)buf_len, "%s", inst->search_error);
+            pthread_mutex_unlock(&inst->search_mutex);
+            return ret;
+        }
+        case PARAM_SEARCH_COUNT: {
+            int ret;
+            if (!inst) return -1;
+            pthread_mutex_lock(&inst->search_mutex);
+            ret = snprintf(buf, (size_t)buf_len, "%d", inst->search_count);
+            pthread_mutex_unlock(&inst->search_mutex);
+            return ret;
+        }
+        case PARAM_SEARCH_ELAPSED_MS: {
+            int ret;
+            if (!inst) return -1;
+            pthread_mutex_lock(&inst->search_mutex);
+            ret = snprintf(buf, (size_t)buf_len, "%llu", (unsigned long long)inst->search_elapsed_ms);
             pthread_mutex_unlock(&inst->search_mutex);
             return ret;
         }
 
-        idx = get_result_index(key, "search_result_");
-        if (idx >= 0) {
+        case PARAM_SEARCH_RESULT_TITLE:
+        case PARAM_SEARCH_RESULT_CHANNEL:
+        case PARAM_SEARCH_RESULT_DURATION:
+        case PARAM_SEARCH_RESULT_URL:
+        case PARAM_SEARCH_RESULT_PROVIDER:
+        case PARAM_SEARCH_RESULT_ROW: {
             int ret = -1;
+            const search_result_t *r;
+            if (!inst || index < 0 || index >= SEARCH_MAX_RESULTS) return -1;
             pthread_mutex_lock(&inst->search_mutex);
-            if (idx < inst->search_count) {
-                ret = snprintf(buf,
-                               (size_t)buf_len,
-                               "%s\t%s\t%s\t%s",
-                               inst->search_results[idx].title,
-                               inst->search_results[idx].channel,
-                               inst->search_results[idx].duration,
-                               inst->search_results[idx].url);
+            r = &inst->search_results[index];
+            if (index < inst->search_count) {
+                switch (id) {
+                    case PARAM_SEARCH_RESULT_TITLE: ret = snprintf(buf, (size_t)buf_len, "%s", r->title); break;
+                    case PARAM_SEARCH_RESULT_CHANNEL: ret = snprintf(buf, (size_t)buf_len, "%s", r->channel); break;
+                    case PARAM_SEARCH_RESULT_DURATION: ret = snprintf(buf, (size_t)buf_len, "%s", r->duration); break;
+                    case PARAM_SEARCH_RESULT_URL: ret = snprintf(buf, (size_t)buf_len, "%s", r->url); break;
+                    case PARAM_SEARCH_RESULT_PROVIDER: ret = snprintf(buf, (size_t)buf_len, "%s", r->provider); break;
+                    default:
+                        ret = snprintf(buf, (size_t)buf_len, "%s\t%s\t%s\t%s", r->title, r->channel, r->duration, r->url);
+                        break;
+                }
             }
             pthread_mutex_unlock(&inst->search_mutex);
             return ret;
         }
+        default:
+            return -1;
     }
-
-    return -1;
 }
 
 static int v2_get_error(void *instance, char *buf, int buf_len) {
@@ -2114,8 +6351,71 @@ static int v2_get_error(void *instance, char *buf, int buf_len) {
     return snprintf(buf, (size_t)buf_len, "%s", inst->error_msg);
 }
 
-static void v2_render_block(void *instance, int16_t *out_interleaved_lr, int frames) {
-    yt_instance_t *inst = (yt_instance_t *)instance;
+static uint64_t loop_point_abs(const yt_instance_t *inst, uint64_t req, uint64_t current) {
+    if (req == LOOP_REQ_NONE) return current;
+    if (req == LOOP_REQ_CLEAR) return LOOP_UNSET;
+    if (req == LOOP_REQ_HERE) return inst->play_abs;
+    return req * 2U;
+}
+
+/*
+ * Render thread: applies loop_start/loop_end requests against the ring as it
+ * is now. A loop_start with no loop_end is only held while the decoder still
+ * has LOOP_MIN_AHEAD_MS of room, so it can never stall the stream.
+ */
+static void apply_loop_requests(yt_instance_t *inst) {
+    uint64_t a = __atomic_exchange_n(&inst->loop_start_req, LOOP_REQ_NONE, __ATOMIC_ACQ_REL);
+    uint64_t b = __atomic_exchange_n(&inst->loop_end_req, LOOP_REQ_NONE, __ATOMIC_ACQ_REL);
+    uint64_t ahead = ms_to_ring_samples(inst, LOOP_MIN_AHEAD_MS);
+    uint64_t start = loop_point_abs(inst, a, inst->loop_start_abs);
+    uint64_t end = loop_point_abs(inst, b, inst->loop_end_abs);
+    const char *rejected = NULL;
+    uint64_t xf = LOOP_XFADE_FRAMES;
+    char log_msg[160];
+
+    if (a == LOOP_REQ_NONE && b == LOOP_REQ_NONE) {
+        if (start != LOOP_UNSET && end == LOOP_UNSET && inst->play_abs > start &&
+            inst->play_abs - start + ahead >= RING_SAMPLES) {
+            clear_loop(inst);
+            render_log(inst, "loop_start released: no loop_end before it would block decoding");
+        }
+        return;
+    }
+
+    if (start != LOOP_UNSET && start < ring_oldest_abs(inst)) {
+        rejected = "loop_start is no longer buffered";
+    } else if (start != LOOP_UNSET && end != LOOP_UNSET && end <= start) {
+        rejected = "loop_end must come after loop_start";
+    } else if (start != LOOP_UNSET && end != LOOP_UNSET && end - start + ahead >= RING_SAMPLES) {
+        rejected = "loop is longer than the ring can hold";
+    }
+    if (rejected) {
+        snprintf(log_msg, sizeof(log_msg), "loop unchanged: %s", rejected);
+        render_log(inst, log_msg);
+        return;
+    }
+
+    if (start != LOOP_UNSET) {
+        if ((start - ring_oldest_abs(inst)) / 2U < xf) xf = (start - ring_oldest_abs(inst)) / 2U;
+        if (end != LOOP_UNSET && (end - start) / 4U < xf) xf = (end - start) / 4U;
+    }
+    inst->loop_xfade_frames = start != LOOP_UNSET ? (uint32_t)xf : 0;
+    inst->loop_tail_left = 0;
+    __atomic_store_n(&inst->loop_start_abs, start, __ATOMIC_RELAXED);
+    __atomic_store_n(&inst->loop_end_abs, end, __ATOMIC_RELAXED);
+    snprintf(log_msg, sizeof(log_msg), "loop frames %lld..%lld (crossfade %u)",
+             start == LOOP_UNSET ? -1LL : (long long)(start / 2U), end == LOOP_UNSET ? -1LL : (long long)(end / 2U),
+             inst->loop_xfade_frames);
+    render_log(inst, log_msg);
+}
+
+/* loop_decode=pause: once the whole loop is buffered the decoder waits, like a paused transport. */
+static bool loop_holds_decoder(const yt_instance_t *inst) {
+    return __atomic_load_n(&inst->loop_decode_pause, __ATOMIC_RELAXED) && inst->loop_start_abs != LOOP_UNSET &&
+           inst->loop_end_abs != LOOP_UNSET && inst->write_abs >= inst->loop_end_abs;
+}
+
+static void render_block(yt_instance_t *inst, int16_t *out_interleaved_lr, int frames) {
     size_t needed;
     size_t got;
     size_t i;
@@ -2127,24 +6427,26 @@ static void v2_render_block(void *instance, int16_t *out_interleaved_lr, int fra
     memset(out_interleaved_lr, 0, needed * sizeof(int16_t));
 
     if (!inst) return;
+    inst->block_frames = frames;
 
     if (inst->stream_url[0] == '\0') {
         return;
     }
 
-    if (inst->stream_eof) {
-        return;
-    }
-
+    apply_loop_requests(inst);
     if (inst->paused) {
         return;
     }
 
-    if (!inst->pipe) {
+    if (inst->stream_eof) {
+        if (ring_available(inst) == 0) return;
+    } else if (!inst->pipe) {
         bool resolve_ready = false;
         bool resolve_failed = false;
         bool resolve_running = false;
+        bool resolve_local = false;
         char resolved_media_url[STREAM_URL_MAX];
+        uint32_t rung_kbps = 0;
 
         resolved_media_url[0] = '\0';
         if (inst->restart_countdown > 0) {
@@ -2153,19 +6455,23 @@ static void v2_render_block(void *instance, int16_t *out_interleaved_lr, int fra
             pthread_mutex_lock(&inst->resolve_mutex);
             resolve_ready = inst->resolve_ready;
             resolve_failed = inst->resolve_failed;
-            resolve_running = inst->resolve_thread_running;
+            resolve_running = inst->resolve_pending;
+            resolve_local = inst->resolved_local;
             if (resolve_ready) {
-                snprintf(resolved_media_url, sizeof(resolved_media_url), "%s", inst->resolved_media_url);
+                rung_kbps = pick_start_format_locked(inst, resolved_media_url, sizeof(resolved_media_url));
             }
             pthread_mutex_unlock(&inst->resolve_mutex);
 
             if (resolve_ready) {
-                if (start_stream_resolved(inst, resolved_media_url) != 0) {
+                if ((resolve_local ? start_stream_local(inst, resolved_media_url)
+                                   : start_stream_resolved(inst, resolved_media_url)) != 0) {
                     pthread_mutex_lock(&inst->resolve_mutex);
                     inst->resolve_ready = false;
                     inst->resolve_failed = true;
                     pthread_mutex_unlock(&inst->resolve_mutex);
                     resolve_failed = true;
+                } else if (rung_kbps > 0) {
+                    begin_fast_start(inst, rung_kbps);
                 }
             } else if (resolve_failed) {
                 /* Resolve failed in background; fail over to legacy stream pipeline now. */
@@ -2180,6 +6486,10 @@ static void v2_render_block(void *instance, int16_t *out_interleaved_lr, int fra
             }
 
             if (!inst->pipe && resolve_failed) {
+                /* Resumes and seeks on a legacy stream also land here; only count real fallbacks. */
+                if (!inst->reconnecting && inst->resume_from_ms == 0 && !inst->resolved_fallback_attempted) {
+                    ws_stat_inc(&inst->stats.legacy_fallbacks);
+                }
                 if (start_stream_legacy(inst) != 0) {
                     inst->stream_eof = true;
                     inst->restart_countdown = 0;
@@ -2192,16 +6502,54 @@ static void v2_render_block(void *instance, int16_t *out_interleaved_lr, int fra
         }
     }
 
-    pump_pipe(inst);
+    if (inst->startup_pending && now_ms() - inst->startup_spawn_ms >= STARTUP_TIMEOUT_MS) {
+        finish_startup(inst, false, "no audio");
+    }
+    ladder_tick(inst);
+    __atomic_store_n(&inst->loop_decode_held, loop_holds_decoder(inst), __ATOMIC_RELAXED);
+    if (!inst->loop_decode_held) pump_pipe(inst);
 
     if (inst->prime_needed_samples > 0) {
         if (ring_available(inst) < inst->prime_needed_samples && !inst->stream_eof) {
             return;
         }
         inst->prime_needed_samples = 0;
+        trace_event(inst, "primed", 'i', TRACE_TID_PIPELINE, ring_available(inst));
+    }
+
+    if (inst->rebuffering) {
+        if (ring_available(inst) < inst->rebuffer_needed_samples && !inst->stream_eof) {
+            return;
+        }
+        finish_underrun(inst);
     }
 
     got = ring_pop(inst, out_interleaved_lr, needed);
+    if (inst->fade_in_pos < BUFFER_FADE_FRAMES) {
+        apply_fade_in(inst, out_interleaved_lr, got);
+    }
+    if (got < needed && (inst->pipe || inst->reconnecting) && !inst->stream_eof) {
+        begin_underrun(inst, out_interleaved_lr, got);
+    }
+
+    if (got > 0 && __atomic_load_n(&inst->trace_first_audio_pending, __ATOMIC_RELAXED) != 0) {
+        for (i = 0; i < got; i++) {
+            if (out_interleaved_lr[i] != 0) {
+                __atomic_store_n(&inst->trace_first_audio_pending, 0, __ATOMIC_RELAXED);
+                trace_event(inst, "first_audio", 'i', TRACE_TID_PIPELINE, i / 2);
+                break;
+            }
+        }
+    }
+
+    if (got > 0) {
+        uint64_t ttfa_start = ws_stat_load(&inst->stats.ttfa_start_ms);
+        if (inst->startup_pending) finish_startup(inst, true, NULL);
+        if (ttfa_start != 0) {
+            ws_stat_store(&inst->stats.ttfa_start_ms, 0);
+            ws_hist_record(&inst->stats.ttfa_ms, now_ms() - ttfa_start);
+        }
+    }
 
     if (inst->dropped_samples >= inst->dropped_log_next) {
         snprintf(log_msg,
@@ -2209,17 +6557,85 @@ static void v2_render_block(void *instance, int16_t *out_interleaved_lr, int fra
                  "ring overflow dropped_samples=%llu",
                  (unsigned long long)inst->dropped_samples);
         yt_log(log_msg);
-        inst->dropped_log_next += (uint64_t)MOVE_SAMPLE_RATE * 2ULL;
+        inst->dropped_log_next += (uint64_t)inst->sample_rate * 2ULL;
     }
+}
 
-    if (inst->gain != 1.0f) {
-        for (i = 0; i < got; i++) {
-            float s = out_interleaved_lr[i] * inst->gain;
-            if (s > 32767.0f) s = 32767.0f;
-            if (s < -32768.0f) s = -32768.0f;
-            out_interleaved_lr[i] = (int16_t)s;
+/* Render thread only: the fields below are the ones render_block itself drives. */
+static transport_state_t compute_transport_state(const yt_instance_t *inst) {
+    size_t avail;
+    if (inst->stream_url[0] == '\0') return TRANSPORT_STOPPED;
+    if (inst->paused) return TRANSPORT_PAUSED;
+    if (inst->seek_discard_samples > 0) return TRANSPORT_SEEKING;
+    if (inst->reconnecting) return ring_available(inst) > 0 ? TRANSPORT_RECONNECTING : TRANSPORT_BUFFERING;
+    if (!inst->pipe && inst->restart_countdown > 0) return TRANSPORT_LOADING;
+    if (!inst->pipe && !inst->stream_eof) return TRANSPORT_LOADING;
+    avail = ring_available(inst);
+    if (inst->stream_eof && avail == 0) return TRANSPORT_EOF;
+    if (inst->prime_needed_samples > 0 && avail < inst->prime_needed_samples) return TRANSPORT_BUFFERING;
+    if (inst->rebuffering) return TRANSPORT_BUFFERING;
+    return TRANSPORT_STREAMING;
+}
+
+static void publish_status(yt_instance_t *inst, const ws_meter_block_t *m, int frames) {
+    ws_status_t *s = &inst->status_last;
+    transport_state_t state = compute_transport_state(inst);
+    uint32_t hold_frames = (uint32_t)((uint64_t)inst->sample_rate * METER_HOLD_MS / 1000U);
+    int c;
+
+    if ((uint32_t)state != s->state || inst->underrun_count != s->underruns) s->version++;
+    if (__atomic_exchange_n(&inst->meter_reset_pending, 0, __ATOMIC_ACQUIRE)) {
+        s->clips = 0;
+        s->hold[0] = s->hold[1] = 0;
+    }
+    for (c = 0; c < 2; c++) {
+        s->peak[c] = m->peak[c];
+        s->rms[c] = (uint32_t)sqrt((double)m->sumsq[c] / (double)frames);
+        if (m->peak[c] >= s->hold[c] || inst->meter_hold_frames[c] <= (uint32_t)frames) {
+            s->hold[c] = m->peak[c];
+            inst->meter_hold_frames[c] = hold_frames;
+        } else {
+            inst->meter_hold_frames[c] -= (uint32_t)frames;
         }
     }
+    s->clips += m->clips;
+    s->state = (uint32_t)state;
+    s->level = m->peak[0] > m->peak[1] ? m->peak[0] : m->peak[1];
+    s->position_ms = ring_samples_to_ms(inst, inst->play_abs);
+    s->buffered_ms = ring_samples_to_ms(inst, ring_available(inst));
+    s->underruns = inst->underrun_count;
+    ws_status_publish(&inst->status, s);
+}
+
+static void v2_render_block(void *instance, int16_t *out_interleaved_lr, int frames) {
+    yt_instance_t *inst = (yt_instance_t *)instance;
+    uint64_t start_us;
+    uint64_t elapsed_us;
+
+    if (!inst) {
+        render_block(NULL, out_interleaved_lr, frames);
+        return;
+    }
+    start_us = mono_us();
+    if (inst->audio_cpu_countdown-- == 0) {
+        inst->audio_cpu_countdown = AUDIO_CPU_SAMPLE_BLOCKS;
+        ws_sched_note_audio_cpu();
+    }
+    render_block(inst, out_interleaved_lr, frames);
+    if (out_interleaved_lr && frames > 0) {
+        ws_meter_block_t meter;
+        render_voices(inst, out_interleaved_lr, frames);
+        render_sampler(inst, out_interleaved_lr, frames, start_us);
+        /* Master gain and metering in one pass over the finished mix. */
+        ws_gain_meter(out_interleaved_lr, (size_t)frames, inst->gain, &meter);
+        if (meter.clips > 0) ws_stat_add(&inst->stats.clipped_samples, meter.clips);
+        publish_status(inst, &meter, frames);
+    }
+    elapsed_us = mono_us() - start_us;
+    ws_hist_record(&inst->stats.render_us, elapsed_us);
+    if (frames > 0 && elapsed_us * (uint64_t)inst->sample_rate > (uint64_t)frames * 1000000ULL) {
+        ws_stat_inc(&inst->stats.deadline_misses);
+    }
 }
 
 static plugin_api_v2_t g_plugin_api_v2 = {
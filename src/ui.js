@@ -33,19 +33,23 @@ const PROVIDERS = [
   { id: 'youtube', label: 'YouTube' },
   { id: 'freesound', label: 'FreeSound' },
   { id: 'archive', label: 'Archive.org' },
-  { id: 'soundcloud', label: 'SoundCloud' }
+  { id: 'soundcloud', label: 'SoundCloud' },
+  { id: 'library', label: 'Library' }
 ];
 const PROVIDER_TAGS = {
   youtube: '[YT]',
   freesound: '[FS]',
   archive: '[AR]',
-  soundcloud: '[SC]'
+  soundcloud: '[SC]',
+  library: '[LB]'
 };
 
 let searchQuery = '';
 let searchProvider = 'youtube';
 let searchStatus = 'idle';
 let searchCount = 0;
+let searchGeneration = '';
+let stateVersion = '';
 let streamStatus = 'stopped';
 let selectedIndex = 0;
 let statusMessage = 'Click: select';
@@ -103,6 +107,7 @@ function currentActivityLabel() {
   if (searchStatus === 'queued') return 'Queued';
   if (streamStatus === 'loading') return 'Loading';
   if (streamStatus === 'buffering') return 'Buffering';
+  if (streamStatus === 'reconnecting') return 'Reconnecting';
   if (streamStatus === 'seeking') return 'Seeking';
   return '';
 }
@@ -348,6 +353,13 @@ function buildRootItems() {
     items.push(
       createAction(title, () => {
         if (!row || !row.url) return;
+        if (shiftHeld) {
+          /* Shift+select keeps a copy in the offline library instead of playing. */
+          host_module_set_param('offline_save', String(i));
+          statusMessage = `Saving ${providerTag(rowProvider)} offline...`;
+          needsRedraw = true;
+          return;
+        }
         host_module_set_param('stream_provider', rowProvider);
         host_module_set_param('stream_url', row.url);
         statusMessage = `Loading ${providerTag(rowProvider)} stream...`;
@@ -377,31 +389,52 @@ function rebuildMenu() {
   needsRedraw = true;
 }
 
-function loadResults() {
+/* One search_results_snapshot read (more only if the host buffer is small) replaces per-row params. */
+function loadSearchSnapshot() {
   const out = [];
-  for (let i = 0; i < searchCount && i < MAX_MENU_RESULTS; i++) {
-    const provider = normalizeProvider(host_module_get_param(`search_result_provider_${i}`) || searchProvider);
-    const title = host_module_get_param(`search_result_title_${i}`) || '';
-    const url = host_module_get_param(`search_result_url_${i}`) || '';
-    out.push({ provider, title, url });
+  let first = 0;
+  let header = null;
+
+  while (true) {
+    const raw = host_module_get_param(first === 0 ? 'search_results_snapshot' : `search_results_snapshot_${first}`);
+    if (!raw) return false;
+    const lines = raw.split('\n');
+    const head = lines[0].split('\t');
+    if (head.length < 6) return false;
+    if (header && head[0] !== header[0]) return false;
+    if (!header) header = head;
+
+    const rows = parseInt(head[5], 10) || 0;
+    for (let i = 1; i <= rows && i < lines.length; i++) {
+      const f = lines[i].split('\t');
+      out.push({ provider: normalizeProvider(f[0] || header[2]), title: f[1] || '', url: f[4] || '' });
+    }
+    first += rows;
+    if (rows === 0 || first >= (parseInt(header[3], 10) || 0) || out.length >= MAX_MENU_RESULTS) break;
   }
-  results = out;
+
+  searchGeneration = header[0];
+  searchStatus = header[1] || 'idle';
+  searchProvider = normalizeProvider(header[2] || searchProvider);
+  searchCount = parseInt(header[3], 10) || 0;
+  searchQuery = host_module_get_param('search_query') || '';
+  results = out.slice(0, MAX_MENU_RESULTS);
+  return true;
 }
 
 function refreshState() {
-  const prevSearchProvider = searchProvider;
-  const prevSearchStatus = searchStatus;
-  const prevSearchCount = searchCount;
   const prevStreamStatus = streamStatus;
 
-  streamStatus = host_module_get_param('stream_status') || 'stopped';
-  searchProvider = normalizeProvider(host_module_get_param('search_provider') || searchProvider);
-  searchQuery = host_module_get_param('search_query') || '';
-  searchStatus = host_module_get_param('search_status') || 'idle';
-  searchCount = parseInt(host_module_get_param('search_count') || '0', 10) || 0;
+  /* state_version moves whenever stream_status or the underrun count changes. */
+  const version = host_module_get_param('state_version') || '';
+  if (!version || version !== stateVersion) {
+    stateVersion = version;
+    streamStatus = host_module_get_param('stream_status') || 'stopped';
+  }
 
-  if (prevSearchProvider !== searchProvider || prevSearchStatus !== searchStatus || prevSearchCount !== searchCount) {
-    loadResults();
+  /* search_generation is a lock-free counter; results are only re-read when it moves. */
+  const generation = host_module_get_param('search_generation') || '';
+  if (generation !== searchGeneration && loadSearchSnapshot()) {
     rebuildMenu();
 
     if (searchStatus === 'searching') {
@@ -422,6 +455,7 @@ function refreshState() {
   if (prevStreamStatus !== streamStatus) {
     if (streamStatus === 'loading') statusMessage = 'Loading stream...';
     else if (streamStatus === 'buffering') statusMessage = 'Buffering...';
+    else if (streamStatus === 'reconnecting') statusMessage = 'Reconnecting...';
     else if (streamStatus === 'seeking') statusMessage = 'Seeking...';
     else if (streamStatus === 'paused') statusMessage = 'Paused';
     else if (streamStatus === 'streaming') statusMessage = 'Playing';
@@ -466,6 +500,8 @@ globalThis.init = function () {
   searchProvider = normalizeProvider(host_module_get_param('search_provider') || 'youtube');
   searchStatus = 'idle';
   searchCount = 0;
+  searchGeneration = '';
+  stateVersion = '';
   streamStatus = 'stopped';
   selectedIndex = 0;
   statusMessage = 'Click: select';
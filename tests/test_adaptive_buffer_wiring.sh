@@ -0,0 +1,50 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+
+fail=0
+
+if rg -q "prime_needed_samples = \\(size_t\\)MOVE_SAMPLE_RATE" "$DSP_C"; then
+  echo "FAIL: stream start should not hard-code a fixed 0.5s prime"
+  fail=1
+fi
+
+if ! rg -q "buffer_profile_t buffer_profiles\\[BUFFER_PROFILE_COUNT\\]" "$DSP_C"; then
+  echo "FAIL: DSP should keep per-provider jitter buffer profiles"
+  fail=1
+fi
+
+if ! rg -q "begin_stream_buffering\\(inst\\)" "$DSP_C"; then
+  echo "FAIL: stream start should derive prime threshold from the provider profile"
+  fail=1
+fi
+
+if ! rg -q "note_arrival\\(inst, pushed, throttled\\)" "$DSP_C"; then
+  echo "FAIL: pump_pipe should measure decoded arrival rate"
+  fail=1
+fi
+
+if ! rg -q "begin_underrun\\(inst, out_interleaved_lr, got\\)" "$DSP_C"; then
+  echo "FAIL: render path should detect underruns and fade out"
+  fail=1
+fi
+
+if ! rg -q "apply_fade_in\\(inst, out_interleaved_lr, got\\)" "$DSP_C"; then
+  echo "FAIL: render path should fade back in after rebuffering"
+  fail=1
+fi
+
+for key in underrun_count underrun_ms buffered_ahead_ms buffer_prime_ms buffer_rebuffer_ms; do
+  if ! rg -q "\"${key}\"" "$DSP_C"; then
+    echo "FAIL: get_param should expose ${key}"
+    fail=1
+  fi
+done
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+echo "PASS: adaptive jitter buffer wiring is present"
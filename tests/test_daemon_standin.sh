@@ -0,0 +1,110 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DAEMON_PY="$ROOT_DIR/src/bin/yt_dlp_daemon.py"
+STANDIN_PY="$ROOT_DIR/tools/standin/standin_server.py"
+FIXTURES="$ROOT_DIR/tools/standin/fixtures"
+BENCH_PY="$ROOT_DIR/tools/bench/daemon_bench.py"
+
+fail=0
+
+if ! rg -q "def provider_base_url\\(" "$DAEMON_PY"; then
+  echo "FAIL: daemon should resolve provider API bases through provider_base_url()"
+  fail=1
+fi
+
+if ! rg -q "WEBSTREAM_\\{provider.upper\\(\\)\\}_BASE_URL" "$DAEMON_PY"; then
+  echo "FAIL: daemon should honour WEBSTREAM_<PROVIDER>_BASE_URL overrides"
+  fail=1
+fi
+
+if rg -q "\"https://(freesound|archive)\\.org/(apiv2/(search|sounds)|advancedsearch|metadata|download)" "$DAEMON_PY"; then
+  echo "FAIL: provider API URLs should be built from provider_base_url(), not hardcoded"
+  fail=1
+fi
+
+if [[ ! -f "$BENCH_PY" ]]; then
+  echo "FAIL: missing tools/bench/daemon_bench.py"
+  fail=1
+fi
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+work="$(mktemp -d)"
+server_pid=""
+cleanup() {
+  if [[ -n "$server_pid" ]]; then kill "$server_pid" 2>/dev/null || true; fi
+  rm -rf "$work"
+}
+trap cleanup EXIT
+
+mkdir -p "$work/media"
+head -c 4096 /dev/zero > "$work/media/tone48k.wav"
+head -c 4096 /dev/zero > "$work/media/tone44k.wav"
+
+python3 "$STANDIN_PY" --root "$work/media" --fixtures "$FIXTURES" > "$work/port.txt" &
+server_pid=$!
+for _ in $(seq 1 50); do
+  [[ -s "$work/port.txt" ]] && break
+  sleep 0.1
+done
+port="$(awk '/^PORT/ {print $2}' "$work/port.txt")"
+if [[ -z "$port" ]]; then
+  echo "FAIL: stand-in server did not start"
+  exit 1
+fi
+base="http://127.0.0.1:${port}"
+
+printf 'SEARCH\tarchive\t5\ttone\nRESOLVE\tarchive\thttps://archive.org/details/tone48k\nSEARCH\tfreesound\t5\train\nRESOLVE\tfreesound\thttps://freesound.org/s/1001/\nQUIT\n' \
+  | WEBSTREAM_ARCHIVE_BASE_URL="$base" WEBSTREAM_FREESOUND_BASE_URL="$base/apiv2" FREESOUND_API_KEY=standin \
+    python3 "$DAEMON_PY" > "$work/out.txt"
+
+if ! grep -q $'^SEARCH_ITEM\ttone48k\t' "$work/out.txt"; then
+  echo "FAIL: archive search against the stand-in returned no tone48k item"
+  fail=1
+fi
+if ! grep -q $'^RESOLVE_OK\t'"$base"'/download/tone48k/tone48k.wav' "$work/out.txt"; then
+  echo "FAIL: archive resolve should pick the WAVE original under the overridden base"
+  fail=1
+fi
+if ! grep -q $'^SEARCH_ITEM\t1001\tRain on tin roof\tfieldrec\t1:03\t' "$work/out.txt"; then
+  echo "FAIL: freesound search against the stand-in returned unexpected fields"
+  fail=1
+fi
+if ! grep -q $'^RESOLVE_OK\t'"$base"'/media/tone44k.wav' "$work/out.txt"; then
+  echo "FAIL: freesound resolve should return the fixture preview URL"
+  fail=1
+fi
+if grep -q '^ERROR' "$work/out.txt"; then
+  echo "FAIL: daemon reported errors against the stand-in:"
+  grep '^ERROR' "$work/out.txt"
+  fail=1
+fi
+
+# The stand-in enforces the freesound token like the real API.
+printf 'SEARCH\tfreesound\t5\train\nQUIT\n' \
+  | env -u FREESOUND_API_KEY -u FREESOUND_TOKEN WEBSTREAM_FREESOUND_BASE_URL="$base/apiv2" \
+    python3 "$DAEMON_PY" > "$work/nokey.txt"
+if ! grep -q '^ERROR' "$work/nokey.txt"; then
+  echo "FAIL: freesound search without a key should fail"
+  fail=1
+fi
+
+if ! python3 "$BENCH_PY" --concurrency 1,2 --requests 3 --json > "$work/bench.txt"; then
+  echo "FAIL: daemon benchmark reported errors"
+  cat "$work/bench.txt"
+  fail=1
+fi
+if [[ "$(grep -c '"p99_ms"' "$work/bench.txt")" -ne 8 ]]; then
+  echo "FAIL: daemon benchmark should report 4 request kinds x 2 concurrency levels"
+  fail=1
+fi
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+echo "PASS: daemon searches and resolves offline against the stand-in"
@@ -0,0 +1,59 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+RESAMPLER_H="$ROOT_DIR/src/dsp/ws_resampler.h"
+
+fail=0
+
+if rg -q -- "-ar %d" "$DSP_C"; then
+  echo "FAIL: ffmpeg should decode at the source's native rate (no -ar)"
+  fail=1
+fi
+
+if ! rg -q -- "-f wav -acodec pcm_s16le -ac 2 pipe:1" "$DSP_C"; then
+  echo "FAIL: ffmpeg should emit WAV so the source rate is reported in-band"
+  fail=1
+fi
+
+if ! rg -q "g_host->sample_rate" "$DSP_C"; then
+  echo "FAIL: DSP should honor host_api_v1_t.sample_rate"
+  fail=1
+fi
+
+if ! rg -q "consume_wav_header\\(" "$DSP_C"; then
+  echo "FAIL: DSP should parse the decoder WAV header"
+  fail=1
+fi
+
+if ! rg -q "ws_resampler_process\\(" "$DSP_C"; then
+  echo "FAIL: decoded frames should pass through the in-process resampler"
+  fail=1
+fi
+
+if rg -q "ws_resampler_configure\\(" "$DSP_C" || ! rg -q "ws_resampler_attach\\(inst->resampler," "$DSP_C"; then
+  echo "FAIL: the render thread should attach to prebuilt kernel tables, not build them when a header arrives"
+  fail=1
+fi
+
+if ! awk '/^static void\* v2_create_instance\(/,/^}/' "$DSP_C" | rg -q "prepare_resampler_tables\\(inst\\)"; then
+  echo "FAIL: kernel tables for the common source rates should be built when the instance is created"
+  fail=1
+fi
+
+if ! rg -q "vfmaq_f32" "$RESAMPLER_H"; then
+  echo "FAIL: resampler should have a NEON inner loop"
+  fail=1
+fi
+
+if ! rg -q "resampler_bench" "$ROOT_DIR/scripts/bench.sh"; then
+  echo "FAIL: scripts/bench.sh should build the resampler benchmark"
+  fail=1
+fi
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+echo "PASS: host rate and resampler wiring is present"
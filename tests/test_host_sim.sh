@@ -0,0 +1,71 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+
+if ! command -v "${CC:-cc}" >/dev/null 2>&1; then
+  echo "SKIP: no native C compiler for the host simulator"
+  exit 0
+fi
+
+out="$("$ROOT_DIR/scripts/host_sim.sh" smoke.sim -- --json)"
+json="$(printf '%s\n' "$out" | tail -n 1)"
+
+python3 - "$json" <<'PY'
+import json
+import sys
+
+r = json.loads(sys.argv[1])
+if r["blocks"] < 900:
+    raise SystemExit(f"FAIL: expected ~1030 blocks for 3 s, got {r['blocks']}")
+if not r["ttfa_ms"] or r["ttfa_ms"][0] is None:
+    raise SystemExit("FAIL: no audio reached the host after select")
+if r["audio_blocks"] == 0:
+    raise SystemExit("FAIL: host received only silence")
+for key in ("p50", "p99", "max"):
+    if key not in r["render_us"]:
+        raise SystemExit(f"FAIL: missing render percentile {key}")
+stats = r["params"].get("stats_json")
+if not isinstance(stats, dict):
+    raise SystemExit("FAIL: stats_json should be a JSON object")
+if stats["render_us"]["n"] != r["blocks"]:
+    raise SystemExit(f"FAIL: stats_json saw {stats['render_us']['n']} render blocks, host ran {r['blocks']}")
+if stats["ttfa_ms"]["n"] != 1 or stats["spawns"]["stream"] < 1 or stats["pipe_bytes"] == 0:
+    raise SystemExit(f"FAIL: stats_json missing ttfa/spawn/pipe counts: {stats}")
+trace = r["params"].get("ttfa_trace")
+phases = ["resolve_start", "resolve_end", "spawn", "first_byte", "primed", "first_audio"]
+if not isinstance(trace, dict) or any(k not in trace for k in phases):
+    raise SystemExit(f"FAIL: ttfa_trace should report every phase: {trace}")
+if [trace[k] for k in phases] != sorted(trace[k] for k in phases):
+    raise SystemExit(f"FAIL: ttfa_trace phases out of order: {trace}")
+print(f"PASS: host simulator ran offline (ttfa {r['ttfa_ms'][0]} ms, render p99 {r['render_us']['p99']} us)")
+PY
+
+# Periodic stats snapshots land in the JSON-lines file while the host runs.
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+printf '%s\n' \
+  "0      set stats_log_interval_ms 1000" \
+  "0      set stats_log $work/stats.jsonl" \
+  "0      select archive https://archive.org/details/tone44k" \
+  "3000   set trace_dump $work/trace.json" \
+  "3200   end" > "$work/stats.sim"
+"$ROOT_DIR/scripts/host_sim.sh" "$work/stats.sim" > /dev/null
+
+python3 - "$work/stats.jsonl" "$work/trace.json" <<'PY'
+import json
+import sys
+
+trace = json.load(open(sys.argv[2]))
+names = {e["name"] for e in trace["traceEvents"] if e["ph"] != "M"}
+for name in ("stream_url", "resolve", "spawn", "first_byte", "primed", "first_audio"):
+    if name not in names:
+        raise SystemExit(f"FAIL: Chrome trace dump missing {name} events")
+
+lines = [json.loads(l) for l in open(sys.argv[1]) if l.strip()]
+if len(lines) < 2:
+    raise SystemExit(f"FAIL: expected >=2 periodic stats snapshots, got {len(lines)}")
+if lines[-1]["stats"]["render_us"]["n"] <= lines[0]["stats"]["render_us"]["n"]:
+    raise SystemExit("FAIL: stats snapshots should advance over time")
+print(f"PASS: stats_log wrote {len(lines)} JSON-lines snapshots; trace dump has {len(trace['traceEvents'])} events")
+PY
@@ -0,0 +1,167 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+
+fail=0
+
+if ! awk '/^static int run_search_command\(/,/^}/' "$DSP_C" | rg -q "LIBRARY_PROVIDER"; then
+  echo "FAIL: library searches should be served from the local index"
+  fail=1
+fi
+
+render_body="$(awk '/^static void render_block\(/,/^}/' "$DSP_C")"
+if ! rg -q "start_stream_local" <<< "$render_body"; then
+  echo "FAIL: render should start saved items from disk"
+  fail=1
+fi
+
+save_body="$(awk '/^static void save_library_item\(/,/^}/' "$DSP_C")"
+if ! rg -q "resolve_stream_url\\(" <<< "$save_body" || ! rg -q "ws_sched_prepare\\(" <<< "$save_body"; then
+  echo "FAIL: saves should resolve through the warm daemon and download as an isolated child"
+  fail=1
+fi
+
+forget_body="$(awk '/^static bool forget_local_copy\(/,/^}/' "$DSP_C")"
+if rg -q "ws_lib_forget\\(" <<< "$forget_body" || ! rg -q "ws_pool_submit\\(WS_JOB_LIBRARY, inst, forget_job\\)" <<< "$forget_body"; then
+  echo "FAIL: the render thread should hand a broken saved copy to a worker instead of taking the library lock"
+  fail=1
+fi
+
+for key in offline_save offline_status offline_budget_mb offline_rate_kbps; do
+  if ! rg -q "\\{ \"${key}\", PARAM_" "$DSP_C"; then
+    echo "FAIL: ${key} should be a param"
+    fail=1
+  fi
+done
+
+if ! rg -q "library_fetch.py" "$ROOT_DIR/scripts/build.sh"; then
+  echo "FAIL: build.sh should package the library download helper"
+  fail=1
+fi
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+if ! command -v "${CC:-cc}" >/dev/null 2>&1; then
+  echo "SKIP: no native C compiler for the library and host simulator checks"
+  exit 0
+fi
+
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+
+# Budget eviction is least recently used first, the index survives a reload and
+# a file removed behind the library's back drops out on the next load.
+cat > "$work/lib.c" <<'C'
+#include <stdio.h>
+#include "ws_library.h"
+
+static void add(const char *url, const char *title, uint64_t bytes, uint64_t saved) {
+    ws_lib_item_t it;
+    char path[WS_LIB_PATH_MAX];
+    FILE *fp;
+
+    memset(&it, 0, sizeof(it));
+    snprintf(it.provider, sizeof(it.provider), "archive");
+    snprintf(it.url, sizeof(it.url), "%s", url);
+    snprintf(it.title, sizeof(it.title), "%s", title);
+    snprintf(it.channel, sizeof(it.channel), "sim");
+    ws_lib_file_name(it.provider, it.url, it.file, sizeof(it.file));
+    ws_lib_path(it.file, path, sizeof(path));
+    fp = fopen(path, "wb");
+    fclose(fp);
+    it.bytes = bytes;
+    it.saved_s = saved;
+    ws_lib_add(&it);
+}
+
+int main(int argc, char **argv) {
+    ws_lib_item_t found[8];
+    ws_lib_item_t item;
+    char path[WS_LIB_PATH_MAX];
+    int n;
+
+    ws_lib_acquire(argv[1], 300);
+    add("u1", "First Song", 100, 1);
+    add("u2", "Second Song", 100, 2);
+    add("u3", "Third Tune", 100, 3);
+    if (!ws_lib_open("archive", "u1", 10, &item, path, sizeof(path))) return printf("FAIL: u1 should open\n"), 1;
+    add("u4", "Fourth Song", 100, 4);
+    if (ws_lib_contains("archive", "u2") || !ws_lib_contains("archive", "u1") || g_library.bytes != 300) {
+        return printf("FAIL: over budget should evict the least recently used item (u2)\n"), 1;
+    }
+    n = ws_lib_search("song", found, 8);
+    if (n != 2 || strcmp(found[0].url, "u1") != 0 || strcmp(found[1].url, "u4") != 0) {
+        return printf("FAIL: search should match case-insensitively, most recently used first (%d)\n", n), 1;
+    }
+    if (ws_lib_search("third sim", found, 8) != 1 || ws_lib_search("third song", found, 8) != 0) {
+        return printf("FAIL: every query word should have to match\n"), 1;
+    }
+    ws_lib_set_budget(150);
+    if (g_library.count != 1 || !ws_lib_contains("archive", "u1")) {
+        return printf("FAIL: shrinking the budget should evict down to the newest use\n"), 1;
+    }
+    ws_lib_release();
+
+    ws_lib_path(item.file, path, sizeof(path));
+    g_library.refs = 0;
+    g_library.count = 0;
+    g_library.bytes = 0;
+    ws_lib_acquire(argv[1], 1000);
+    if (g_library.count != 1 || g_library.items[0].played_s != 10) return printf("FAIL: the index should reload\n"), 1;
+    unlink(path);
+    g_library.refs = 0;
+    g_library.count = 0;
+    ws_lib_acquire(argv[1], 1000);
+    if (g_library.count != 0) return printf("FAIL: a missing file should drop out on load\n"), 1;
+    return 0;
+}
+C
+"${CC:-cc}" -O2 -I"$ROOT_DIR/src/dsp" "$work/lib.c" -o "$work/libcheck" -lpthread
+"$work/libcheck" "$work/unit"
+echo "PASS: LRU eviction to the budget, local search and index reload hold"
+
+# Save tone44k from an archive search, then play it back from a library search
+# in a fresh run: no daemon search or resolve, and audio straight from disk.
+printf '%s\n' \
+  "0      set search_provider archive" \
+  "0      set search_query tone" \
+  "0      set offline_rate_kbps 0" \
+  "1000   set offline_save 0" \
+  "4000   end" > "$work/save.sim"
+printf '%s\n' \
+  "0      set search_provider library" \
+  "0      set search_query tone" \
+  "500    select archive https://archive.org/details/tone44k" \
+  "2500   end" > "$work/play.sim"
+saved="$(SIM_LIBRARY_DIR="$work/lib" "$ROOT_DIR/scripts/host_sim.sh" "$work/save.sim" -- --json \
+  --report-param search_result_url_0 --report-param offline_status | tail -n 1)"
+: > "$work/daemon.log"
+played="$(SIM_LIBRARY_DIR="$work/lib" SIM_DAEMON_LOG="$work/daemon.log" "$ROOT_DIR/scripts/host_sim.sh" "$work/play.sim" -- --json \
+  --report-param search_count --report-param search_result_provider_0 | tail -n 1)"
+reqs="$(grep -c "REQ.*\\(SEARCH\\|RESOLVE\\)" "$work/daemon.log" || true)"
+python3 - "$saved" "$played" "$reqs" "$ROOT_DIR/build/host_sim/media/tone44k.wav" "$work/lib" <<'PY'
+import json
+import os
+import sys
+
+saved, played, reqs = json.loads(sys.argv[1]), json.loads(sys.argv[2]), int(sys.argv[3])
+status = saved["params"]["offline_status"]
+if saved["params"]["search_result_url_0"] != "https://archive.org/details/tone44k":
+    raise SystemExit(f"FAIL: unexpected first search result {saved['params']['search_result_url_0']}")
+size = os.path.getsize(sys.argv[4])
+if status["items"] != 1 or status["bytes"] != size or status["error"] or status["queued"] != 0:
+    raise SystemExit(f"FAIL: the save should land the whole file in the library: {status}")
+if any(name.endswith(".part") for name in os.listdir(sys.argv[5])):
+    raise SystemExit("FAIL: no partial download should be left behind")
+
+lib = played["params"]["stats_json"]["library"]
+if reqs != 0 or lib["local_plays"] != 1 or played["ttfa_ms"][0] is None:
+    raise SystemExit(f"FAIL: the saved item should play from disk without the daemon: {lib}, {reqs} daemon requests")
+if played["params"]["search_count"] != "1" or played["params"]["search_result_provider_0"] != "archive":
+    raise SystemExit(f"FAIL: the library search should list the saved item under its provider: {played['params']}")
+print(f"PASS: saved {size} bytes in the background; played from disk with no network (ttfa {played['ttfa_ms'][0]} ms)")
+PY
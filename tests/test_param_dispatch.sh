@@ -0,0 +1,56 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+
+fail=0
+
+if rg -q "strn?cmp\\(key," "$DSP_C"; then
+  echo "FAIL: get_param/set_param keys should go through the hashed key table, not strcmp chains"
+  fail=1
+fi
+
+for fn in v2_set_param v2_get_param; do
+  if ! awk "/^static (void|int) ${fn}\\(/,/^}/" "$DSP_C" | rg -q "param_lookup\\(key, &index\\)"; then
+    echo "FAIL: ${fn} should dispatch on param_lookup"
+    fail=1
+  fi
+done
+
+if rg -q "get_result_index" "$DSP_C"; then
+  echo "FAIL: indexed search_result_* keys should be parsed by the key table"
+  fail=1
+fi
+
+for key in search_result_ search_result_title_ search_result_url_ search_results_snapshot_; do
+  if ! rg -q "\\{ \"${key}\", PARAM_" "$DSP_C"; then
+    echo "FAIL: ${key}<n> should be an indexed key family"
+    fail=1
+  fi
+done
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+if ! command -v "${CC:-cc}" >/dev/null 2>&1; then
+  echo "PASS: param dispatch wiring (no native C compiler for the benchmark)"
+  exit 0
+fi
+
+# The benchmark exits non-zero if any key fails to map back to its id.
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+"${CC:-cc}" -O2 -Wno-format-truncation -I"$ROOT_DIR/src/dsp" "$ROOT_DIR/tools/bench/param_bench.c" \
+  -o "$work/param_bench" -lpthread -lm
+out="$("$work/param_bench")"
+probe="$(printf '%s\n' "$out" | sed -n 's/.*longest probe \([0-9]*\).*/\1/p')"
+if [[ -z "$probe" || "$probe" -gt 4 ]]; then
+  echo "FAIL: key table should resolve in a few probes, got '${probe}'"
+  printf '%s\n' "$out"
+  exit 1
+fi
+
+echo "PASS: param keys dispatch through the hashed table (longest probe ${probe})"
+printf '%s\n' "$out" | sed -n 's/^  hashed */  hashed: /p' | head -n 1
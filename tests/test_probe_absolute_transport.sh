@@ -0,0 +1,51 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+
+fail=0
+
+if ! rg -q "start_probe_async\\(inst, media_url\\)" "$DSP_C"; then
+  echo "FAIL: resolve thread should start a background ffprobe after publishing the URL"
+  fail=1
+fi
+
+if rg -q "start_probe_async" <(sed -n '/^static int start_stream_resolved/,/^}/p' "$DSP_C"); then
+  echo "FAIL: probing must not sit on the stream start path"
+  fail=1
+fi
+
+if ! rg -q "execl\\(ffprobe_path" "$DSP_C"; then
+  echo "FAIL: probe should run the bundled ffprobe"
+  fail=1
+fi
+
+if ! rg -q "cancel_probe_locked\\(inst\\)" "$DSP_C"; then
+  echo "FAIL: stale probes should be cancelled when the stream changes"
+  fail=1
+fi
+
+probe_body="$(sed -n '/^static void probe_job(/,/^}/p' "$DSP_C")"
+if [[ "$probe_body" != *"WEXITED | WNOWAIT"*"inst->probe_pid = -1;"*"waitpid(pid, &status, 0);"* ]]; then
+  echo "FAIL: probe_pid should be cleared before the probe is reaped, so a late kill cannot hit a reused group"
+  fail=1
+fi
+
+if ! rg -q "ring_floor_abs" "$DSP_C"; then
+  echo "FAIL: far seeks should restart the ring timeline at the target"
+  fail=1
+fi
+
+for key in position_ms duration_ms buffered_ahead_ms stream_bitrate_kbps stream_codec seek_position_ms; do
+  if ! rg -q "\"${key}\"" "$DSP_C"; then
+    echo "FAIL: DSP should handle ${key}"
+    fail=1
+  fi
+done
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+echo "PASS: background probe and absolute transport wiring is present"
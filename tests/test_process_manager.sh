@@ -0,0 +1,88 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+PROCMAN_H="$ROOT_DIR/src/dsp/ws_procman.h"
+
+fail=0
+
+reap_body="$(awk '/^static void schedule_stream_reap\(/,/^}/' "$DSP_C")"
+if [[ -z "$reap_body" ]]; then
+  echo "FAIL: schedule_stream_reap should remain the stream stop entry point"
+  fail=1
+fi
+if printf '%s\n' "$reap_body" | grep -q "pthread_create"; then
+  echo "FAIL: schedule_stream_reap must not create a thread per stop"
+  fail=1
+fi
+if ! printf '%s\n' "$reap_body" | grep -q "ws_proc_release("; then
+  echo "FAIL: schedule_stream_reap should hand children to the process manager"
+  fail=1
+fi
+
+if ! rg -q "SYS_pidfd_open" "$PROCMAN_H"; then
+  echo "FAIL: process manager should wait on pidfds where available"
+  fail=1
+fi
+
+try_reap_body="$(awk '/^static bool ws_proc_try_reap\(/,/^}/' "$PROCMAN_H")"
+if ! rg -q "rc != c->pid && !\\(rc < 0 && errno == ECHILD\\)" <<< "$try_reap_body"; then
+  echo "FAIL: only a reaped pid or ECHILD should drop a child; EINTR must keep it"
+  fail=1
+fi
+
+if rg -q "(sigaction|signal)\\(SIGCHLD" "$PROCMAN_H" "$DSP_C"; then
+  echo "FAIL: process manager must not install a SIGCHLD handler (the host owns it)"
+  fail=1
+fi
+
+if rg -q "usleep\\(200000\\)" "$DSP_C"; then
+  echo "FAIL: stop_daemon_locked should not block on the daemon exiting"
+  fail=1
+fi
+
+if ! rg -q "block_sigpipe\\(" "$DSP_C"; then
+  echo "FAIL: daemon writes should be protected from SIGPIPE"
+  fail=1
+fi
+
+if rg -q "[^2_a-z]pipe\\(" "$DSP_C" || ! rg -q "pipe2\\(pipefd, O_CLOEXEC\\)" "$DSP_C"; then
+  echo "FAIL: child pipes should be created close-on-exec so concurrently forked children do not inherit them"
+  fail=1
+fi
+
+for key in live spawned reaped escalations; do
+  if ! rg -q "\\\\\"${key}\\\\\"" "$DSP_C"; then
+    echo "FAIL: stats_json should report process ${key} count"
+    fail=1
+  fi
+done
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+if ! command -v "${CC:-cc}" >/dev/null 2>&1; then
+  echo "SKIP: no native C compiler for the host simulator run"
+  exit 0
+fi
+
+# 24 selections 120 ms apart: everything but the daemon and the last decoder must be reaped.
+json="$("$ROOT_DIR/scripts/host_sim.sh" switching.sim -- --json | tail -n 1)"
+python3 - "$json" <<'PY'
+import json
+import sys
+
+r = json.loads(sys.argv[1])
+procs = r["params"]["stats_json"]["procs"]
+if procs["spawned"] < 20:
+    raise SystemExit(f"FAIL: expected a decoder per selection, got {procs}")
+if procs["live"] > 3:
+    raise SystemExit(f"FAIL: superseded children were not reaped: {procs}")
+if procs["reaped"] + procs["live"] != procs["spawned"]:
+    raise SystemExit(f"FAIL: process accounting does not add up: {procs}")
+if r["ttfa_ms"][-1] is None:
+    raise SystemExit("FAIL: the final selection never produced audio")
+print(f"PASS: process manager reaped {procs['reaped']} of {procs['spawned']} children during rapid switching")
+PY
@@ -30,12 +30,12 @@ if ! rg -q "function openProviderMenu\\(" "$UI_JS"; then
   fail=1
 fi
 
-if ! rg -Fq '"SEARCH\t%s\t%d\t%s\n"' "$DSP_C"; then
+if ! rg -Fq '"%s\tSEARCH\t%s\t%d\t%s\n"' "$DSP_C"; then
   echo "FAIL: DSP search request should include provider"
   fail=1
 fi
 
-if ! rg -Fq '"RESOLVE\t%s\t%s\n"' "$DSP_C"; then
+if ! rg -Fq '"%s\tRESOLVE\t%s\t%s\n"' "$DSP_C"; then
   echo "FAIL: DSP resolve request should include provider"
   fail=1
 fi
@@ -0,0 +1,132 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+DAEMON_PY="$ROOT_DIR/src/bin/yt_dlp_daemon.py"
+
+fail=0
+
+if ! awk '/^def resolve_request_ytdlp\(/ {f = 1; next} /^def / {f = 0} f' "$DAEMON_PY" | rg -q "pick_fast_start_rungs\\("; then
+  echo "FAIL: the yt-dlp resolve should offer smaller formats as fast-start rungs"
+  fail=1
+fi
+
+if ! awk '/^static void render_block\(/,/^}/' "$DSP_C" | rg -q "pick_start_format_locked\\(inst"; then
+  echo "FAIL: a fresh start should pick its format from the resolve ladder"
+  fail=1
+fi
+
+if ! awk '/^static void render_block\(/,/^}/' "$DSP_C" | rg -q "ladder_tick\\(inst\\);"; then
+  echo "FAIL: render should advance the ladder before pumping the decoder"
+  fail=1
+fi
+
+if ! awk '/^static void splice_upgrade\(/,/^}/' "$DSP_C" | rg -q "inst->up_resampler = old_rs"; then
+  echo "FAIL: the splice should swap resampler pointers instead of copying a whole resampler on the render thread"
+  fail=1
+fi
+
+if ! awk '/^static int start_ladder_upgrade\(/,/^}/' "$DSP_C" | rg -q "ws_resampler_latency_frames"; then
+  echo "FAIL: the splice point should account for the rung's resampler delay"
+  fail=1
+fi
+
+for key in quality_ladder stream_quality; do
+  if ! rg -q "\\{ \"${key}\", PARAM_" "$DSP_C"; then
+    echo "FAIL: ${key} should be a param"
+    fail=1
+  fi
+done
+
+if ! rg -q "\\\\\"ladder\\\\\":\\{" "$DSP_C"; then
+  echo "FAIL: stats_json should report ladder counters"
+  fail=1
+fi
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+# Rungs are direct-download audio-only formats well below the target, lowest first.
+python3 - "$DAEMON_PY" <<'PY'
+import importlib.util
+import sys
+
+spec = importlib.util.spec_from_file_location("daemon", sys.argv[1])
+d = importlib.util.module_from_spec(spec)
+spec.loader.exec_module(d)
+
+formats = [
+    {"url": "https://a/48", "abr": 48, "acodec": "opus", "vcodec": "none", "protocol": "https"},
+    {"url": "https://a/70", "abr": 70.2, "acodec": "opus", "vcodec": "none", "protocol": "https"},
+    {"url": "https://a/hls", "abr": 64, "acodec": "aac", "vcodec": "none", "protocol": "m3u8_native"},
+    {"url": "https://a/video", "tbr": 90, "acodec": "aac", "vcodec": "avc1", "protocol": "https"},
+    {"url": "https://a/120", "abr": 120, "acodec": "opus", "vcodec": "none", "protocol": "https"},
+    {"url": "https://a/130", "abr": 130, "acodec": "aac", "vcodec": "none", "protocol": "https"},
+]
+rungs = d.pick_fast_start_rungs(formats, 130, "https://a/130")
+if rungs != [(48, "https://a/48"), (70, "https://a/70")]:
+    raise SystemExit(f"FAIL: unexpected fast-start rungs {rungs}")
+if d.pick_fast_start_rungs(formats, 0, "") or d.pick_fast_start_rungs(None, 130, ""):
+    raise SystemExit("FAIL: no target bitrate or format list should mean no ladder")
+print("PASS: daemon ladder keeps two direct audio rungs under 75% of the target")
+PY
+
+if ! command -v "${CC:-cc}" >/dev/null 2>&1; then
+  echo "SKIP: no native C compiler for the host simulator runs"
+  exit 0
+fi
+
+# tone44k's stand-in rung is every other frame at 22050 Hz, so once resampled it
+# should line up sample for sample with the full-quality file.
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+printf '%s\n' \
+  "0      select archive https://archive.org/details/tone44k" \
+  "12000  end" > "$work/ladder.sim"
+run() {
+  "$ROOT_DIR/scripts/host_sim.sh" "$work/ladder.sim" -- --json "$@" \
+    --report-param stream_quality --report-param stream_bitrate_kbps | tail -n 1
+}
+fast="$(run --record "$work/out.raw")"
+slow="$(SIM_RATE_KBPS=200 run)"
+python3 - "$fast" "$slow" "$work/out.raw" "$ROOT_DIR/build/host_sim/media/tone44k.wav" <<'PY'
+import array
+import json
+import sys
+import wave
+
+fast, slow = json.loads(sys.argv[1]), json.loads(sys.argv[2])
+fl, sl = fast["params"]["stats_json"]["ladder"], slow["params"]["stats_json"]["ladder"]
+if fl["fast_starts"] != 1 or fl["upgrades"] != 1 or fast["params"]["stream_quality"] != "upgraded":
+    raise SystemExit(f"FAIL: an unthrottled link should start on the rung and upgrade: {fl}, {fast['params']['stream_quality']}")
+if fast["params"]["stream_bitrate_kbps"] != "1411" or fast["params"]["underrun_count"] != "0":
+    raise SystemExit(f"FAIL: the upgrade should report the full bitrate without underruns: {fast['params']}")
+if sl["fast_starts"] != 1 or sl["stayed"] != 1 or sl["upgrades"] != 0 or slow["params"]["stream_quality"] != "stayed_low":
+    raise SystemExit(f"FAIL: 200 KiB/s cannot carry 1.5x the full WAV and should stay low: {sl}")
+
+out = open(sys.argv[3], "rb").read()
+with wave.open(sys.argv[4], "rb") as w:
+    hi = w.readframes(w.getnframes())
+
+# After the splice the output is the full-quality file verbatim; find where.
+probe = int(11.5 * 44100) * 4
+pos = hi.find(out[probe:probe + 4096 * 4])
+while pos >= 0 and pos % 4:
+    pos = hi.find(out[probe:probe + 4096 * 4], pos + 1)
+if pos < 0:
+    raise SystemExit("FAIL: output after the splice should be bit-exact full-quality audio")
+shift = probe // 4 - pos // 4
+
+# Before it the resampled rung should sit on the same timeline, not a frame off.
+o = array.array("h", out)[0::2]
+h = array.array("h", hi)[0::2]
+for t in (2.0, 6.0):
+    n = int(t * 44100)
+    err = {lag: sum((o[n + i] - h[n - shift + lag + i]) ** 2 for i in range(4000)) / 4000 for lag in (-1, 0, 1)}
+    if min(err, key=err.get) != 0 or err[0] > 64 * 64:
+        raise SystemExit(f"FAIL: rung audio at {t}s is misaligned with the full-quality timeline: {err}")
+print(f"PASS: fast start upgraded in place (bit-exact after the splice, rung aligned to 0 frames); "
+      f"200 KiB/s stayed low at {sl['net_kbps']} kbps; ttfa {fast['ttfa_ms'][0]} / {slow['ttfa_ms'][0]} ms")
+PY
@@ -0,0 +1,49 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+UI_JS="$ROOT_DIR/src/ui.js"
+
+fail=0
+
+if ! rg -q "recover_stream_interruption\\(inst, \"ended\", true\\)" "$DSP_C"; then
+  echo "FAIL: decoder EOF should go through resume/fallback recovery"
+  fail=1
+fi
+
+if ! rg -q "recover_stream_interruption\\(inst, \"stalled\", false\\)" "$DSP_C"; then
+  echo "FAIL: pump_pipe should detect stalled decoders"
+  fail=1
+fi
+
+if ! rg -q "inst->resume_from_ms = ring_samples_to_ms\\(inst, inst->write_abs\\)" "$DSP_C"; then
+  echo "FAIL: resume should restart at the decoded position"
+  fail=1
+fi
+
+if ! rg -q "\"%s-i" "$DSP_C"; then
+  echo "FAIL: resolved ffmpeg command should accept an input-side -ss"
+  fail=1
+fi
+
+if ! rg -q "stream_eof_premature\\(inst\\)" "$DSP_C"; then
+  echo "FAIL: EOF should be compared against the known duration"
+  fail=1
+fi
+
+if ! rg -q "\"resume_count\"" "$DSP_C"; then
+  echo "FAIL: get_param should expose resume_count"
+  fail=1
+fi
+
+if ! rg -q "'reconnecting'" "$UI_JS"; then
+  echo "FAIL: UI should label the reconnecting stream status"
+  fail=1
+fi
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+echo "PASS: resume-on-error wiring is present"
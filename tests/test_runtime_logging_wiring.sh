@@ -21,6 +21,20 @@ if ! rg -q "append_ws_log\\(msg\\)" "$DSP_C"; then
   fail=1
 fi
 
+if ! awk '/^static void\* stats_log_thread_main\(/,/^}/' "$DSP_C" | rg -q "drain_render_log\(inst\)"; then
+  echo "FAIL: the stats/log thread should drain lines queued by the render thread"
+  fail=1
+fi
+
+# Render-thread paths queue their lines; a file append can stall the audio callback.
+for fn in begin_underrun finish_startup begin_fast_start settle_on_rung start_ladder_upgrade splice_upgrade \
+          fail_slot apply_loop_requests; do
+  if awk "/^static [a-z_]+ ${fn}\\(/,/^}/" "$DSP_C" | rg -q "yt_log\\(|append_ws_log\\("; then
+    echo "FAIL: ${fn} runs on the render thread and should use render_log"
+    fail=1
+  fi
+done
+
 if [[ "$fail" -ne 0 ]]; then
   exit 1
 fi
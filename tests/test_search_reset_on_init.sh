@@ -12,7 +12,7 @@ if ! rg -q "host_module_set_param\\('search_query', ''\\)" "$UI_JS"; then
   fail=1
 fi
 
-if ! rg -q 'search_query"\) == 0' "$DSP_C"; then
+if ! rg -q '\{ "search_query", PARAM_' "$DSP_C"; then
   echo "FAIL: DSP should handle search_query param"
   fail=1
 fi
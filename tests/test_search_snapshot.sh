@@ -0,0 +1,92 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+UI_JS="$ROOT_DIR/src/ui.js"
+
+fail=0
+
+if ! rg -q "\\{ \"search_results_snapshot_\", PARAM_SEARCH_RESULTS_SNAPSHOT" "$DSP_C"; then
+  echo "FAIL: get_param should expose search_results_snapshot"
+  fail=1
+fi
+
+if ! rg -q "\\{ \"search_generation\", PARAM_" "$DSP_C"; then
+  echo "FAIL: get_param should expose search_generation"
+  fail=1
+fi
+
+if ! awk '/^static void set_search_status\(/,/^}/' "$DSP_C" | rg -q "search_generation"; then
+  echo "FAIL: every search status change should bump search_generation"
+  fail=1
+fi
+
+if ! rg -q "host_module_get_param\\('search_generation'\\)" "$UI_JS"; then
+  echo "FAIL: ui.js should poll search_generation"
+  fail=1
+fi
+
+if rg -q "search_result_(title|url|provider)_" "$UI_JS"; then
+  echo "FAIL: ui.js should read results from the snapshot, not per-row params"
+  fail=1
+fi
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+if ! command -v "${CC:-cc}" >/dev/null 2>&1; then
+  echo "SKIP: no native C compiler for the host simulator run"
+  exit 0
+fi
+
+# A 120-byte host buffer holds one row per snapshot page.
+json="$("$ROOT_DIR/scripts/host_sim.sh" search_snapshot.sim -- --json --param-buf 120 \
+  --report-param search_generation \
+  --report-param search_results_snapshot \
+  --report-param search_results_snapshot_1 \
+  --report-param search_result_title_0 \
+  --report-param search_result_url_1 | tail -n 1)"
+python3 - "$json" <<'PY'
+import json
+import sys
+
+p = json.loads(sys.argv[1])["params"]
+pages = [p["search_results_snapshot"], p["search_results_snapshot_1"]]
+rows = []
+for first, page in enumerate(pages):
+    lines = page.rstrip("\n").split("\n")
+    head = lines[0].split("\t")
+    if head[0] != p["search_generation"] or head[1] != "done" or head[3] != "2" or head[4] != str(first) or head[5] != "1":
+        raise SystemExit(f"FAIL: unexpected snapshot header {head} (generation {p['search_generation']})")
+    rows += [l.split("\t") for l in lines[1:]]
+if len(rows) != 2 or any(len(r) != 5 for r in rows):
+    raise SystemExit(f"FAIL: expected two 5-field rows across pages, got {rows}")
+if rows[0][1] != p["search_result_title_0"] or rows[1][4] != p["search_result_url_1"]:
+    raise SystemExit(f"FAIL: snapshot rows disagree with per-row params: {rows}")
+print("PASS: search_results_snapshot pages rows under a small host buffer")
+PY
+
+if ! command -v node >/dev/null 2>&1; then
+  echo "SKIP: node not available for the ui.js snapshot parser check"
+  exit 0
+fi
+
+# Run ui.js's loadSearchSnapshot against the same pages.
+fn="$(awk '/^function loadSearchSnapshot\(/,/^}/' "$UI_JS")"
+node - "$json" "$fn" <<'JS'
+const params = JSON.parse(process.argv[2]).params;
+let calls = 0;
+globalThis.host_module_get_param = (key) => { calls++; return params[key] || ''; };
+globalThis.normalizeProvider = (p) => p;
+var searchGeneration = '', searchStatus = '', searchProvider = '', searchCount = 0, searchQuery = '', results = [];
+const MAX_MENU_RESULTS = 20;
+eval(process.argv[3]);
+if (!loadSearchSnapshot()) throw new Error('FAIL: loadSearchSnapshot rejected the snapshot');
+if (results.length !== 2 || searchCount !== 2 || searchStatus !== 'done' || searchGeneration !== params.search_generation) {
+  throw new Error(`FAIL: ui.js parsed ${JSON.stringify({ results, searchCount, searchStatus, searchGeneration })}`);
+}
+if (results[1].url !== params.search_result_url_1) throw new Error('FAIL: ui.js row url mismatch');
+console.log(`PASS: ui.js loaded ${results.length} results in ${calls} get_param calls`);
+JS
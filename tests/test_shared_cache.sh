@@ -0,0 +1,165 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+
+fail=0
+
+for fn in run_search_command resolve_stream_url; do
+  if ! awk "/^static int ${fn}\\(/,/^}/" "$DSP_C" | rg -q "ws_shc_get\\(g_shcache.seg"; then
+    echo "FAIL: ${fn} should consult the shared cache before the daemon"
+    fail=1
+  fi
+done
+
+if ! awk '/^static bool recover_stream_interruption\(/,/^}/' "$DSP_C" | rg -q "forget_cached_resolve\\(inst\\)"; then
+  echo "FAIL: a resolved URL that fails before any audio should be dropped from the cache"
+  fail=1
+fi
+
+if ! rg -q "\\{ \"cache_clear\", PARAM_CACHE_CLEAR \\}" "$DSP_C" || ! rg -q "\\\\\"cache\\\\\":%s" "$DSP_C"; then
+  echo "FAIL: cache_clear and stats_json.cache should be exposed"
+  fail=1
+fi
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+if ! command -v "${CC:-cc}" >/dev/null 2>&1; then
+  echo "SKIP: no native C compiler for the cache checks"
+  exit 0
+fi
+
+# Two independent mappings of one file stand in for two processes.
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+cat > "$work/shc.c" <<'C'
+#include <stdio.h>
+#include <stdlib.h>
+#include "ws_shcache.h"
+
+static ws_shc_segment_t *a;
+static ws_shc_segment_t *b;
+static volatile int stop;
+
+static void *writer(void *arg) {
+    char val[4096];
+    unsigned n = 0;
+    (void)arg;
+    while (!stop) {
+        size_t len = 100 + (n * 37) % 3900;
+        memset(val, 'a' + (int)(n % 26), len);
+        ws_shc_put(a, 0, "race", val, len, 1000);
+        n++;
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    char got[WS_SHC_VAL_MAX];
+    char key[32];
+    char stale_path[1024];
+    ws_shc_segment_t *stale;
+    pthread_t t;
+    int i;
+    int reads = 0;
+
+    a = ws_shc_map_file(argv[1]);
+    b = ws_shc_map_file(argv[1]);
+    if (!a || !b || a == b) return printf("FAIL: could not map %s twice\n", argv[1]), 1;
+    (void)argc;
+
+    /* A segment stamped by a build with another layout is refused, not restamped. */
+    snprintf(stale_path, sizeof(stale_path), "%s.old", argv[1]);
+    stale = ws_shc_map_file(stale_path);
+    if (!stale) return printf("FAIL: could not create %s\n", stale_path), 1;
+    stale->entry_size = (uint32_t)sizeof(ws_shc_entry_t) / 2;
+    munmap(stale, sizeof(*stale));
+    if (ws_shc_map_file(stale_path) != NULL) return printf("FAIL: a segment with a foreign layout should not be mapped\n"), 1;
+    if (truncate(stale_path, 64) != 0 || ws_shc_map_file(stale_path) != NULL) {
+        return printf("FAIL: a segment shorter than this layout should not be grown and mapped\n"), 1;
+    }
+
+    ws_shc_put(a, 0, "archive\ttone", "x\ty", 3, 1000);
+    if (ws_shc_get(b, 0, "archive\ttone", 60000, 2000, got, sizeof(got)) != 3 || strcmp(got, "x\ty") != 0)
+        return printf("FAIL: a store through one mapping should be visible through the other\n"), 1;
+    if (ws_shc_get(b, 1, "archive\ttone", 60000, 2000, got, sizeof(got)) >= 0)
+        return printf("FAIL: search and resolve entries must not alias\n"), 1;
+    if (ws_shc_get(b, 0, "archive\ttone", 500, 2000, got, sizeof(got)) >= 0)
+        return printf("FAIL: entries older than max_age should miss\n"), 1;
+    ws_shc_drop(b, 0, "archive\ttone");
+    if (ws_shc_get(a, 0, "archive\ttone", 60000, 2000, got, sizeof(got)) >= 0)
+        return printf("FAIL: a dropped entry should miss\n"), 1;
+
+    for (i = 0; i < WS_SHC_ENTRIES * 3; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        ws_shc_put(a, 1, key, key, strlen(key), 1000 + (uint64_t)i);
+    }
+    snprintf(key, sizeof(key), "k%d", WS_SHC_ENTRIES * 3 - 1);
+    if (b->evictions == 0 || ws_shc_get(b, 1, key, 60000, 5000, got, sizeof(got)) < 0)
+        return printf("FAIL: a full table should evict the oldest and keep the newest\n"), 1;
+
+    /* Every value the writer stores is one repeated letter; a torn read would mix two. */
+    pthread_create(&t, NULL, writer, NULL);
+    while (ws_shc_get(b, 0, "race", 60000, 2000, got, sizeof(got)) < 0) {
+    }
+    for (i = 0; i < 200000; i++) {
+        int n = ws_shc_get(b, 0, "race", 60000, 2000, got, sizeof(got));
+        if (n > 0) {
+            reads++;
+            if ((int)strspn(got, (char[]){ got[0], 0 }) != n) {
+                stop = 1;
+                return printf("FAIL: torn read of %d bytes\n", n), 1;
+            }
+        }
+    }
+    stop = 1;
+    pthread_join(t, NULL);
+    printf("%d\n", reads);
+    return 0;
+}
+C
+"${CC:-cc}" -O2 -I"$ROOT_DIR/src/dsp" "$work/shc.c" -o "$work/shc" -lpthread
+if ! reads="$("$work/shc" "$work/seg.shm")"; then
+  echo "$reads"
+  exit 1
+fi
+echo "PASS: two mappings share entries, TTL/drop/eviction hold, $reads concurrent reads were never torn"
+
+# Search then play; the second run reuses the first run's segment, like a module reload.
+# The stand-in keeps its port so the cached media URL stays valid between runs.
+port="$(python3 -c 'import socket; s = socket.socket(); s.bind(("127.0.0.1", 0)); print(s.getsockname()[1])')"
+printf '%s\n' \
+  "0      set search_provider archive" \
+  "0      set search_query tone" \
+  "1000   select archive https://archive.org/details/tone44k" \
+  "2500   end" > "$work/cache.sim"
+run() {
+  : > "$work/daemon.log"
+  SIM_PORT="$port" SIM_CACHE_FILE="$work/cache.shm" SIM_DAEMON_LOG="$work/daemon.log" \
+    "$ROOT_DIR/scripts/host_sim.sh" "$work/cache.sim" -- --json --report-param search_count | tail -n 1
+  grep -c "REQ.*\\(SEARCH\\|RESOLVE\\)" "$work/daemon.log" || true
+}
+cold="$(run)"
+warm="$(run)"
+python3 - "$cold" "$warm" <<'PY'
+import json
+import sys
+
+def parse(text):
+    line, reqs = text.strip().split("\n")
+    r = json.loads(line)
+    return r, r["params"]["stats_json"]["cache"], int(reqs)
+
+cold, cc, cold_reqs = parse(sys.argv[1])
+warm, wc, warm_reqs = parse(sys.argv[2])
+if not cc.get("shared") or cold_reqs != 2 or cc["search"]["stores"] != 1 or cc["resolve"]["stores"] != 1:
+    raise SystemExit(f"FAIL: the cold run should go to the daemon and fill the shared cache: {cc}, {cold_reqs} requests")
+if warm_reqs != 0 or wc["search"]["hits"] != 1 or wc["resolve"]["hits"] != 1:
+    raise SystemExit(f"FAIL: the warm run should be served from the cache: {wc}, {warm_reqs} daemon requests")
+if warm["params"]["search_count"] != cold["params"]["search_count"] or warm["ttfa_ms"][0] is None:
+    raise SystemExit("FAIL: cached search results and resolved URL should behave like fresh ones")
+print(f"PASS: reload served search + resolve from the shared cache (ttfa {cold['ttfa_ms'][0]} -> {warm['ttfa_ms'][0]} ms)")
+PY
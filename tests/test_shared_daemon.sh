@@ -0,0 +1,84 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+DAEMON_PY="$ROOT_DIR/src/bin/yt_dlp_daemon.py"
+
+fail=0
+
+if rg -q "inst->daemon_(in|pid|out_fd|ready)\\b" "$DSP_C"; then
+  echo "FAIL: daemon pipes and pid should live in the process-wide g_daemon, not per instance"
+  fail=1
+fi
+
+if ! awk '/^static void\* v2_create_instance\(/,/^}/' "$DSP_C" | rg -q "daemon_acquire\\(inst\\)"; then
+  echo "FAIL: create_instance should take a reference on the shared daemon"
+  fail=1
+fi
+
+if ! awk '/^static void v2_destroy_instance\(/,/^}/' "$DSP_C" | rg -q "daemon_release\\(\\)"; then
+  echo "FAIL: destroy_instance should drop its daemon reference"
+  fail=1
+fi
+
+if awk '/^static void v2_destroy_instance\(/,/^}/' "$DSP_C" | rg -q "kill\\("; then
+  echo "FAIL: destroying one instance must not signal the daemon other instances share"
+  fail=1
+fi
+
+for kind in SEARCH RESOLVE; do
+  if ! rg -q "\"%s\\\\t${kind}\\\\t" "$DSP_C"; then
+    echo "FAIL: ${kind} requests should carry the per-instance tag"
+    fail=1
+  fi
+done
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+# The daemon echoes a request's tag on its reply and still answers untagged requests.
+replies="$(printf '@7.1\tPING\nPING\nQUIT\n' | python3 "$DAEMON_PY" /nonexistent | tr '\t' ' ')"
+expected="$(printf 'READY\n@7.1 PONG\nPONG\nBYE')"
+if [[ "$replies" != "$expected" ]]; then
+  echo "FAIL: unexpected daemon replies to tagged/untagged PING:"
+  echo "$replies"
+  exit 1
+fi
+
+if ! command -v "${CC:-cc}" >/dev/null 2>&1; then
+  echo "SKIP: no native C compiler for the host simulator run"
+  exit 0
+fi
+
+# Three instances resolve through one daemon; the newest is dropped mid-resolve.
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+json="$(SIM_RESOLVE_MS=600 SIM_DAEMON_LOG="$work/daemon.log" \
+  "$ROOT_DIR/scripts/host_sim.sh" shared_daemon.sim -- --json --instances 3 | tail -n 1)"
+python3 - "$json" "$work/daemon.log" <<'PY'
+import json
+import sys
+
+r = json.loads(sys.argv[1])
+d = r["params"]["stats_json"]["daemon"]
+events = [line.rstrip("\n").split("\t") for line in open(sys.argv[2])]
+pids = {e[0] for e in events}
+starts = [e for e in events if e[1] == "START"]
+tags = {e[2].split(".")[0] for e in events if e[1] == "REQ" and e[3] == "RESOLVE"}
+
+if len(pids) != 1 or len(starts) != 1 or d["starts"] != 1:
+    raise SystemExit(f"FAIL: three instances should share one daemon process, saw {len(pids)} ({d})")
+if len(tags) != 3:
+    raise SystemExit(f"FAIL: each instance should tag its own requests, saw {sorted(tags)}")
+if d["instances"] != 2:
+    raise SystemExit(f"FAIL: after one drop, two instances should hold the daemon: {d}")
+if d["stale_lines"] < 1:
+    raise SystemExit(f"FAIL: the dropped instance's late reply should be skipped by tag: {d}")
+if r["ttfa_ms"][0] is None:
+    raise SystemExit("FAIL: the first instance never produced audio through the shared daemon")
+if events[-1][1] != "EXIT" or not any(e[1] == "REQ" and e[3] == "QUIT" for e in events):
+    raise SystemExit(f"FAIL: the last destroy_instance should QUIT the shared daemon: {events[-2:]}")
+print(f"PASS: 3 instances shared daemon pid {d['pid']}; {d['stale_lines']} stale reply line skipped; QUIT after the last instance")
+PY
@@ -0,0 +1,93 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+
+fail=0
+
+body="$(awk '/^static int start_stream_resolved\(/,/^}/' "$DSP_C")"
+if ! rg -q "begin_startup\\(inst\\)" <<< "$body" || [[ "$(rg -o "startup->input_opts" <<< "$body" | wc -l)" -ne 2 ]]; then
+  echo "FAIL: both resolved decoder commands should take their input options from the startup profile"
+  fail=1
+fi
+
+if ! awk '/^static void render_block\(/,/^}/' "$DSP_C" | rg -q "finish_startup\\(inst, true"; then
+  echo "FAIL: the first audible block should time the start against its profile"
+  fail=1
+fi
+
+if ! awk '/^static bool recover_stream_interruption\(/,/^}/' "$DSP_C" | rg -q "finish_startup\\(inst, false"; then
+  echo "FAIL: a start that fails before any audio should count against its profile"
+  fail=1
+fi
+
+if ! awk '/^static void\* v2_create_instance\(/,/^}/' "$DSP_C" | rg -q "load_startup_profiles\\(inst\\)" ||
+   ! awk '/^static void v2_destroy_instance\(/,/^}/' "$DSP_C" | rg -q "save_startup_profiles\\(inst\\)"; then
+  echo "FAIL: startup profile stats should load on create and persist on destroy"
+  fail=1
+fi
+
+for key in startup_profile startup_profiles; do
+  if ! rg -q "\\{ \"${key}\", PARAM_" "$DSP_C"; then
+    echo "FAIL: ${key} should be a param"
+    fail=1
+  fi
+done
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+if ! command -v "${CC:-cc}" >/dev/null 2>&1; then
+  echo "SKIP: no native C compiler for the host simulator runs"
+  exit 0
+fi
+
+# The stub decoder probes like ffmpeg on a compressed stream, so ffmpeg's default
+# probing costs ~1 MB of a 600 KiB/s link. Six fresh starts try each profile twice.
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+printf '%s\n' \
+  "0      set range_prefetch off" \
+  "0      select archive https://archive.org/details/tone48k" \
+  "2500   restart" "5000   restart" "7500   restart" "10000  restart" "12500  restart" \
+  "15000  end" > "$work/tune.sim"
+printf '%s\n' \
+  "0      set range_prefetch off" \
+  "0      select archive https://archive.org/details/tone48k" \
+  "3000   end" > "$work/reload.sim"
+run() {
+  SIM_FFMPEG_PROBE=1 SIM_RATE_KBPS=600 SIM_STARTUP_FILE="$work/startup.tsv" \
+    "$ROOT_DIR/scripts/host_sim.sh" "$work/$1" -- --json \
+    --report-param startup_profile --report-param startup_profiles | tail -n 1
+}
+tune="$(run tune.sim)"
+cp "$work/startup.tsv" "$work/tuned.tsv"
+reload="$(run reload.sim)"
+python3 - "$tune" "$reload" "$work/tuned.tsv" <<'PY'
+import json
+import sys
+
+tune, reload = json.loads(sys.argv[1]), json.loads(sys.argv[2])
+arch = tune["params"]["startup_profiles"]["archive"]
+prof = arch["profiles"]
+if any(p["starts"] != 2 or p["failures"] != 0 for p in prof.values()):
+    raise SystemExit(f"FAIL: six fresh starts should try each profile twice: {prof}")
+fastest = min(prof, key=lambda k: prof[k]["ttfa_ms"])
+if fastest == "default" or prof["default"]["ttfa_ms"] < 2 * prof[fastest]["ttfa_ms"]:
+    raise SystemExit(f"FAIL: lighter probing should start much faster under a probing decoder: {prof}")
+
+saved = [line.rstrip("\n").split("\t") for line in open(sys.argv[3]) if line.startswith("archive\t")]
+if not saved or f"{fastest}:2/0/{prof[fastest]['ttfa_ms']}" not in saved[0]:
+    raise SystemExit(f"FAIL: the profile stats should be persisted: {saved}")
+
+if reload["params"]["startup_profile"] != fastest:
+    raise SystemExit(f"FAIL: a reload should open with the tuned profile, got {reload['params']['startup_profile']}")
+if reload["ttfa_ms"][0] * 2 > tune["ttfa_ms"][0]:
+    raise SystemExit(f"FAIL: the tuned reload should reach audio well before the untuned first start: "
+                     f"{reload['ttfa_ms'][0]} vs {tune['ttfa_ms'][0]} ms")
+times = ", ".join(f"{k} {v['ttfa_ms']} ms" for k, v in prof.items())
+print(f"PASS: archive converged on {fastest} ({times}); "
+      f"reload ttfa {reload['ttfa_ms'][0]} ms vs {tune['ttfa_ms'][0]} ms untuned")
+PY
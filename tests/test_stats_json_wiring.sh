@@ -0,0 +1,52 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+STATS_H="$ROOT_DIR/src/dsp/ws_stats.h"
+
+fail=0
+
+if ! rg -q "__atomic_fetch_add" "$STATS_H"; then
+  echo "FAIL: ws_stats.h counters should be lock-free atomics"
+  fail=1
+fi
+
+if rg -q "pthread_mutex" "$STATS_H"; then
+  echo "FAIL: ws_stats.h must not take locks"
+  fail=1
+fi
+
+if ! rg -q "\\{ \"stats_json\", PARAM_" "$DSP_C"; then
+  echo "FAIL: get_param should expose stats_json"
+  fail=1
+fi
+
+if ! rg -q "\\{ \"stats_log\", PARAM_" "$DSP_C"; then
+  echo "FAIL: set_param should accept stats_log for periodic snapshots"
+  fail=1
+fi
+
+for counter in render_us deadline_misses underruns dropped_samples pipe_bytes_per_sec resolve_ms daemon_restarts legacy_fallbacks spawns ttfa_ms; do
+  if ! rg -q "\\\\\"${counter}\\\\\"" "$DSP_C"; then
+    echo "FAIL: stats_json should report ${counter}"
+    fail=1
+  fi
+done
+
+if ! rg -q "ws_hist_record\\(&inst->stats.render_us" "$DSP_C"; then
+  echo "FAIL: render_block duration should feed the render histogram"
+  fail=1
+fi
+
+# Render-path updates go through the atomic helpers, never the stats log mutex.
+if awk '/^static void render_block\(/,/^}/' "$DSP_C" | rg -q "stats_log_mutex"; then
+  echo "FAIL: render_block must not lock for stats"
+  fail=1
+fi
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+echo "PASS: stats_json wiring is present and lock-free on the render path"
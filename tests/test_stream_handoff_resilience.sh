@@ -3,6 +3,7 @@ set -euo pipefail
 
 ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
 DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+PROCMAN_H="$ROOT_DIR/src/dsp/ws_procman.h"
 
 fail=0
 
@@ -16,7 +17,7 @@ if ! rg -q "schedule_stream_reap\\(" "$DSP_C"; then
   fail=1
 fi
 
-if ! rg -q "pthread_detach\\(" "$DSP_C"; then
+if ! rg -q "pthread_detach\\(" "$DSP_C" "$PROCMAN_H"; then
   echo "FAIL: stream reap should run detached to avoid UI blocking"
   fail=1
 fi
@@ -0,0 +1,143 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+UI_JS="$ROOT_DIR/src/ui.js"
+
+fail=0
+
+# The stream_status getter must not touch render-owned state.
+getter="$(awk '/^static int v2_get_param\(/,/^}/' "$DSP_C" | awk '/case PARAM_STREAM_STATUS:/,/case PARAM_OUTPUT_LEVEL:/')"
+if [[ -z "$getter" ]] || printf '%s\n' "$getter" | rg -q "inst->(pipe|paused|stream_eof|prime_needed_samples)|ring_available"; then
+  echo "FAIL: stream_status should read the published status snapshot, not live render state"
+  fail=1
+fi
+
+if ! awk '/^static void v2_render_block\(/,/^}/' "$DSP_C" | rg -q "publish_status\\(inst"; then
+  echo "FAIL: the render thread should publish the status snapshot once per block"
+  fail=1
+fi
+
+if ! rg -q "ws_status_publish\\(&inst->status" "$DSP_C"; then
+  echo "FAIL: status should be published through the ws_status.h seqlock"
+  fail=1
+fi
+
+if ! rg -q "host_module_get_param\\('state_version'\\)" "$UI_JS"; then
+  echo "FAIL: ui.js should poll state_version before re-reading stream_status"
+  fail=1
+fi
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+if ! command -v "${CC:-cc}" >/dev/null 2>&1; then
+  echo "SKIP: no native C compiler for the seqlock and host simulator checks"
+  exit 0
+fi
+
+# A reader racing a writer that keeps every field equal must never see a mix.
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+cat > "$work/seqlock.c" <<'C'
+#include <pthread.h>
+#include <stdio.h>
+#include "ws_status.h"
+
+static ws_status_cell_t cell;
+static volatile int done;
+
+static void *writer(void *arg) {
+    ws_status_t s;
+    uint64_t i;
+    (void)arg;
+    for (i = 1; i <= 2000000; i++) {
+        s.state = (uint32_t)i;
+        s.level = (uint32_t)i;
+        s.version = i;
+        s.position_ms = i;
+        s.buffered_ms = i;
+        s.underruns = i;
+        ws_status_publish(&cell, &s);
+    }
+    done = 1;
+    return NULL;
+}
+
+int main(void) {
+    pthread_t t;
+    unsigned long reads = 0, torn = 0, gaveup = 0;
+    pthread_create(&t, NULL, writer, NULL);
+    while (!done) {
+        ws_status_t s;
+        if (!ws_status_read(&cell, &s)) {
+            gaveup++;
+            continue;
+        }
+        reads++;
+        if (s.position_ms != s.version || s.underruns != s.version || s.buffered_ms != s.version ||
+            s.state != (uint32_t)s.version || s.level != (uint32_t)s.version) torn++;
+    }
+    pthread_join(t, NULL);
+    printf("%lu %lu %lu\n", reads, torn, gaveup);
+    return torn ? 1 : 0;
+}
+C
+"${CC:-cc}" -O2 -I"$ROOT_DIR/src/dsp" "$work/seqlock.c" -o "$work/seqlock" -lpthread
+read -r reads torn gaveup < <("$work/seqlock" || true)
+if [[ "$torn" != "0" ]]; then
+  echo "FAIL: $torn of $reads status reads were torn"
+  exit 1
+fi
+echo "PASS: $reads concurrent status reads, none torn ($gaveup gave up after bounded retries)"
+
+json="$("$ROOT_DIR/scripts/host_sim.sh" smoke.sim -- --json \
+  --report-param stream_status \
+  --report-param state_version \
+  --report-param output_level \
+  --report-param position_ms \
+  --report-param buffered_ahead_ms | tail -n 1)"
+python3 - "$json" <<'PY'
+import json
+import sys
+
+p = json.loads(sys.argv[1])["params"]
+if p["stream_status"] != "streaming":
+    raise SystemExit(f"FAIL: expected streaming at the end of smoke.sim, got {p['stream_status']}")
+# stopped -> loading -> buffering -> streaming, then again around the seek.
+if int(p["state_version"]) < 3:
+    raise SystemExit(f"FAIL: state_version should advance with each status change, got {p['state_version']}")
+if int(p["output_level"]) == 0:
+    raise SystemExit("FAIL: output_level should report the last block's peak")
+if int(p["position_ms"]) < 10000 or int(p["buffered_ahead_ms"]) == 0:
+    raise SystemExit(f"FAIL: position/buffer not published after the seek: {p}")
+print(f"PASS: status snapshot {p['stream_status']} v{p['state_version']} at {p['position_ms']} ms, peak {p['output_level']}")
+PY
+
+if ! command -v node >/dev/null 2>&1; then
+  echo "SKIP: node not available for the ui.js refresh check"
+  exit 0
+fi
+
+# refreshState re-reads stream_status only when state_version moves.
+fn="$(awk '/^function refreshState\(/,/^}/' "$UI_JS")"
+node - "$fn" <<'JS'
+const params = { state_version: '4', stream_status: 'streaming', search_generation: '1' };
+const reads = {};
+globalThis.host_module_get_param = (key) => { reads[key] = (reads[key] || 0) + 1; return params[key] || ''; };
+var streamStatus = 'stopped', stateVersion = '', searchGeneration = '1', statusMessage = '', needsRedraw = false;
+eval(process.argv[2]);
+refreshState();
+refreshState();
+refreshState();
+if (reads.stream_status !== 1 || streamStatus !== 'streaming') {
+  throw new Error(`FAIL: stream_status read ${reads.stream_status} times for one state_version`);
+}
+params.state_version = '5';
+params.stream_status = 'paused';
+refreshState();
+if (reads.stream_status !== 2 || statusMessage !== 'Paused') throw new Error('FAIL: a new state_version should refresh stream_status');
+console.log('PASS: ui.js skips stream_status while state_version is unchanged');
+JS
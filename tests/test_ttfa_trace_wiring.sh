@@ -0,0 +1,56 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+TRACE_H="$ROOT_DIR/src/dsp/ws_trace.h"
+
+fail=0
+
+if ! awk '/^static uint64_t now_ms\(void\)/,/^}/' "$DSP_C" | rg -q "mono_us\\(\\)"; then
+  echo "FAIL: now_ms should use the monotonic clock"
+  fail=1
+fi
+
+if ! awk '/^static uint64_t mono_us\(void\)/,/^}/' "$DSP_C" | rg -q "CLOCK_MONOTONIC"; then
+  echo "FAIL: mono_us should read CLOCK_MONOTONIC"
+  fail=1
+fi
+
+if ! rg -q "__atomic_fetch_add\\(&t->head" "$TRACE_H"; then
+  echo "FAIL: trace ring should claim slots with an atomic increment"
+  fail=1
+fi
+
+if rg -q "pthread_mutex" "$TRACE_H"; then
+  echo "FAIL: trace ring must not take locks"
+  fail=1
+fi
+
+for phase in stream_url resolve spawn first_byte primed first_audio; do
+  if ! rg -q "trace_event\\(inst, \"${phase}\"" "$DSP_C"; then
+    echo "FAIL: missing trace event for phase ${phase}"
+    fail=1
+  fi
+done
+
+if ! rg -q "\\{ \"trace_dump\", PARAM_" "$DSP_C"; then
+  echo "FAIL: set_param should support trace_dump for Chrome trace export"
+  fail=1
+fi
+
+if ! rg -q "traceEvents" "$DSP_C"; then
+  echo "FAIL: trace dump should use the Chrome trace_event format"
+  fail=1
+fi
+
+if ! rg -q "\\{ \"ttfa_trace\", PARAM_" "$DSP_C"; then
+  echo "FAIL: get_param should expose ttfa_trace"
+  fail=1
+fi
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+echo "PASS: TTFA phase tracing is wired with a monotonic clock and Chrome export"
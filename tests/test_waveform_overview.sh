@@ -0,0 +1,144 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+
+fail=0
+
+if ! awk '/^static void ring_push\(/,/^}/' "$DSP_C" | rg -q "ws_wave_push\\(&inst->wave"; then
+  echo "FAIL: ring_push should fold new samples into the waveform buckets"
+  fail=1
+fi
+
+for fn in clear_ring reset_ring_at; do
+  if ! awk "/^static void ${fn}\\(/,/^}/" "$DSP_C" | rg -q "ws_wave_reset\\(&inst->wave"; then
+    echo "FAIL: ${fn} should restart the waveform with the ring timeline"
+    fail=1
+  fi
+done
+
+if ! rg -q "\\{ \"waveform_\", PARAM_WAVEFORM \\}" "$DSP_C"; then
+  echo "FAIL: get_param should expose waveform and waveform_<first>"
+  fail=1
+fi
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+if ! command -v "${CC:-cc}" >/dev/null 2>&1; then
+  echo "SKIP: no native C compiler for the waveform checks"
+  exit 0
+fi
+
+# Incremental buckets must match a direct scan, however the pushes are chunked.
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+cat > "$work/wave.c" <<'C'
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "ws_waveform.h"
+
+#define BUCKET 1000
+#define TOTAL 20537
+
+static ws_wave_t w;
+
+int main(void) {
+    static int16_t audio[TOTAL];
+    ws_wave_bucket_t got[WS_WAVE_BUCKETS];
+    uint64_t first;
+    size_t pos = 0;
+    int n;
+    int b;
+
+    srand(7);
+    for (pos = 0; pos < TOTAL; pos++) audio[pos] = (int16_t)((rand() % 65536) - 32768);
+    ws_wave_reset(&w, 0, BUCKET);
+    for (pos = 0; pos < TOTAL;) {
+        size_t chunk = (size_t)(rand() % 700) + 1;
+        if (chunk > TOTAL - pos) chunk = TOTAL - pos;
+        ws_wave_push(&w, audio + pos, chunk);
+        pos += chunk;
+    }
+    n = ws_wave_read(&w, 0, got, WS_WAVE_BUCKETS, &first);
+    if (first != 0 || n != TOTAL / BUCKET + 1) {
+        printf("FAIL: expected %d buckets from 0, got %d from %llu\n", TOTAL / BUCKET + 1, n, (unsigned long long)first);
+        return 1;
+    }
+    for (b = 0; b < n; b++) {
+        int lo = 32767, hi = -32768;
+        double sq = 0.0;
+        size_t i, end = (size_t)(b + 1) * BUCKET < TOTAL ? (size_t)(b + 1) * BUCKET : TOTAL;
+        for (i = (size_t)b * BUCKET; i < end; i++) {
+            if (audio[i] < lo) lo = audio[i];
+            if (audio[i] > hi) hi = audio[i];
+            sq += (double)audio[i] * audio[i];
+        }
+        if (got[b].min != lo || got[b].max != hi ||
+            abs((int)got[b].rms - (int)sqrt(sq / (double)(end - (size_t)b * BUCKET))) > 1) {
+            printf("FAIL: bucket %d is %d/%d/%u, expected %d/%d\n", b, got[b].min, got[b].max, got[b].rms, lo, hi);
+            return 1;
+        }
+    }
+    /* A far seek restarts the overview mid-bucket. */
+    ws_wave_reset(&w, 5 * BUCKET * WS_WAVE_BUCKETS + 400, BUCKET);
+    ws_wave_push(&w, audio, 1500);
+    n = ws_wave_read(&w, 0, got, WS_WAVE_BUCKETS, &first);
+    if (first != 5 * WS_WAVE_BUCKETS || n != 2 || got[1].max == 0) {
+        printf("FAIL: reset should start at bucket %d, got %d from %llu\n", 5 * WS_WAVE_BUCKETS, n, (unsigned long long)first);
+        return 1;
+    }
+    printf("%d\n", TOTAL / BUCKET + 1);
+    return 0;
+}
+C
+"${CC:-cc}" -O2 -I"$ROOT_DIR/src/dsp" "$work/wave.c" -o "$work/wave" -lm
+if ! buckets="$("$work/wave")"; then
+  echo "$buckets"
+  exit 1
+fi
+echo "PASS: $buckets incremental buckets match a direct min/max/RMS scan"
+
+json="$("$ROOT_DIR/scripts/host_sim.sh" smoke.sim -- --json \
+  --report-param waveform \
+  --report-param waveform_100 \
+  --report-param position_ms \
+  --report-param buffered_ahead_ms | tail -n 1)"
+small="$("$ROOT_DIR/scripts/host_sim.sh" smoke.sim -- --json --param-buf 64 --report-param waveform | tail -n 1)"
+python3 - "$json" "$small" <<'PY'
+import json
+import sys
+
+def parse(text):
+    head, data = text.rstrip("\n").split("\n")
+    first, bucket_ms, count, pos = (int(x) for x in head.split("\t"))
+    if len(data) != count * 6:
+        raise SystemExit(f"FAIL: {count} buckets need {count * 6} hex digits, got {len(data)}")
+    rows = [tuple(int(data[i + k:i + k + 2], 16) for k in (0, 2, 4)) for i in range(0, len(data), 6)]
+    return first, bucket_ms, rows, pos
+
+p = json.loads(sys.argv[1])["params"]
+first, bucket_ms, rows, pos = parse(p["waveform"])
+written_ms = int(p["position_ms"]) + int(p["buffered_ahead_ms"])
+if first != 0 or abs(len(rows) - (written_ms // bucket_ms + 1)) > 1:
+    raise SystemExit(f"FAIL: expected ~{written_ms // bucket_ms + 1} buckets from 0, got {len(rows)} from {first}")
+if pos != int(p["position_ms"]):
+    raise SystemExit("FAIL: waveform header should carry the play position")
+full = rows[:-1]
+if any(mx <= 0x80 or mn >= 0x80 or rms == 0 for mn, mx, rms in full):
+    raise SystemExit(f"FAIL: completed tone buckets should straddle zero with non-zero RMS: {full[:4]}")
+
+first100, _, rows100, _ = parse(p["waveform_100"])
+if first100 != 100 or rows100 != rows[100:100 + len(rows100)]:
+    raise SystemExit(f"FAIL: waveform_100 should continue at bucket 100, got {first100}")
+
+s = json.loads(sys.argv[2])["params"]
+sfirst, _, srows, _ = parse(s["waveform"])
+# Separate runs, so the live edge may differ by a few buckets.
+if not srows or abs((sfirst + len(srows)) - (first + len(rows))) > 8:
+    raise SystemExit(f"FAIL: a small host buffer should keep the newest buckets up to the live edge ({sfirst}+{len(srows)})")
+print(f"PASS: waveform covers {len(rows)} x {bucket_ms} ms buckets; 64-byte buffer keeps the newest {len(srows)}")
+PY
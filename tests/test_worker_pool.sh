@@ -0,0 +1,124 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+DSP_C="$ROOT_DIR/src/dsp/yt_stream_plugin.c"
+POOL_H="$ROOT_DIR/src/dsp/ws_workpool.h"
+
+fail=0
+
+# Only the long-lived stats logger still owns a thread; everything else is a pool job.
+creates="$(grep -c "pthread_create(" "$DSP_C" || true)"
+if [[ "$creates" != "1" ]] || ! rg -q "pthread_create\\(&inst->stats_log_thread" "$DSP_C"; then
+  echo "FAIL: search/resolve/warmup/probe should run on the worker pool, not their own threads"
+  fail=1
+fi
+
+for job in RESOLVE SEARCH WARMUP PROBE; do
+  if ! rg -q "ws_pool_submit\\(WS_JOB_${job}," "$DSP_C"; then
+    echo "FAIL: ${job} work should be submitted as a typed pool job"
+    fail=1
+  fi
+done
+
+if rg -q "queued_search_" "$DSP_C"; then
+  echo "FAIL: queued_search_* fields should be replaced by latest-wins job coalescing"
+  fail=1
+fi
+
+if ! rg -q "WS_JOB_RESOLVE = 0" "$POOL_H"; then
+  echo "FAIL: resolve should be the highest-priority job type"
+  fail=1
+fi
+
+if ! rg -q "ws_pool_cancel\\(inst\\)" "$DSP_C"; then
+  echo "FAIL: destroy_instance should cancel and wait for its pool jobs"
+  fail=1
+fi
+
+if ! rg -q "\\\\\"jobs\\\\\"" "$DSP_C"; then
+  echo "FAIL: stats_json should report pool job counters"
+  fail=1
+fi
+
+if [[ "$fail" -ne 0 ]]; then
+  exit 1
+fi
+
+if ! command -v "${CC:-cc}" >/dev/null 2>&1; then
+  echo "SKIP: no native C compiler for the host simulator run"
+  exit 0
+fi
+
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+
+# Three instances' saves block their workers; only one may run, so a resolve
+# submitted after them still finds a free worker.
+cat > "$work/pool.c" <<'C'
+#include <stdio.h>
+#include "ws_workpool.h"
+
+static int owners[4];
+static int saves_running;
+static int saves_peak;
+static int resolved;
+static volatile int release_saves;
+
+static void save(void *owner) {
+    int n = __atomic_add_fetch(&saves_running, 1, __ATOMIC_SEQ_CST);
+    (void)owner;
+    if (n > saves_peak) saves_peak = n;
+    while (!__atomic_load_n(&release_saves, __ATOMIC_SEQ_CST)) usleep(1000);
+    __atomic_sub_fetch(&saves_running, 1, __ATOMIC_SEQ_CST);
+}
+
+static void resolve(void *owner) {
+    (void)owner;
+    __atomic_store_n(&resolved, 1, __ATOMIC_SEQ_CST);
+}
+
+int main(void) {
+    int i;
+
+    ws_pool_acquire();
+    for (i = 0; i < 3; i++) ws_pool_submit(WS_JOB_SAVE, &owners[i], save);
+    usleep(50000);
+    ws_pool_submit(WS_JOB_RESOLVE, &owners[3], resolve);
+    for (i = 0; i < 200 && !__atomic_load_n(&resolved, __ATOMIC_SEQ_CST); i++) usleep(1000);
+    if (!resolved) return printf("FAIL: a resolve should not queue behind running saves\n"), 1;
+    __atomic_store_n(&release_saves, 1, __ATOMIC_SEQ_CST);
+    for (i = 0; i < 2000 && __atomic_load_n(&g_pool.run[WS_JOB_SAVE], __ATOMIC_RELAXED) < 3; i++) usleep(1000);
+    for (i = 0; i < 3; i++) ws_pool_cancel(&owners[i]);
+    if (saves_peak != WS_POOL_SAVE_RUNNING || g_pool.run[WS_JOB_SAVE] != 3) {
+        return printf("FAIL: saves should run one at a time pool-wide (peak %d)\n", saves_peak), 1;
+    }
+    ws_pool_release();
+    return 0;
+}
+C
+"${CC:-cc}" -O2 -I"$ROOT_DIR/src/dsp" "$work/pool.c" -o "$work/pool" -lpthread
+"$work/pool"
+echo "PASS: saves run one at a time across instances and a resolve still gets a worker"
+
+# Six type-ahead searches against a 400 ms daemon, then a select mid-burst.
+json="$(SIM_SEARCH_MS=400 "$ROOT_DIR/scripts/host_sim.sh" search_burst.sim -- --json \
+  --report-param search_status --report-param search_count | tail -n 1)"
+python3 - "$json" <<'PY'
+import json
+import sys
+
+r = json.loads(sys.argv[1])
+p = r["params"]
+jobs = p["stats_json"]["jobs"]
+if jobs["search"]["run"] != 2 or jobs["coalesced"] < 4:
+    raise SystemExit(f"FAIL: expected the in-flight search plus one coalesced latest search, got {jobs}")
+if p["search_status"] != "done" or int(p["search_count"]) == 0:
+    raise SystemExit(f"FAIL: latest search should publish results, got {p['search_status']}/{p['search_count']}")
+trace = p["ttfa_trace"]
+if trace["resolve_end"] - trace["resolve_start"] >= 800:
+    raise SystemExit(f"FAIL: resolve should overtake the queued search at the daemon: {trace}")
+if r["ttfa_ms"][0] is None:
+    raise SystemExit("FAIL: selection during the search burst never produced audio")
+print(f"PASS: worker pool coalesced {jobs['coalesced']} searches; resolve took {trace['resolve_end'] - trace['resolve_start']:.0f} ms")
+PY
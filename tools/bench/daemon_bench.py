@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+"""SEARCH/RESOLVE latency benchmark for bin/yt_dlp_daemon.py.
+
+Starts tools/standin with recorded API fixtures, points real daemon
+processes at it through the WEBSTREAM_*_BASE_URL overrides and drives them
+with N concurrent clients (one warm daemon each, as with N plugin
+instances). Reports p50/p99 latency and throughput per provider, command
+and concurrency level. Only the freesound and archive.org paths are covered;
+the yt-dlp providers need the network.
+"""
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import wave
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+DAEMON = os.path.join(REPO_ROOT, "src", "bin", "yt_dlp_daemon.py")
+STANDIN = os.path.join(REPO_ROOT, "tools", "standin", "standin_server.py")
+FIXTURES = os.path.join(REPO_ROOT, "tools", "standin", "fixtures")
+
+REQUESTS = {
+    ("archive", "search"): "SEARCH\tarchive\t20\ttone",
+    ("archive", "resolve"): "RESOLVE\tarchive\thttps://archive.org/details/tone48k",
+    ("freesound", "search"): "SEARCH\tfreesound\t20\train",
+    ("freesound", "resolve"): "RESOLVE\tfreesound\thttps://freesound.org/s/1001/",
+}
+
+
+def percentile(sorted_values: list, pct: float) -> float:
+    if not sorted_values:
+        return 0.0
+    idx = min(len(sorted_values) - 1, int(round(pct / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[idx]
+
+
+def write_silence(path: str, rate: int) -> None:
+    with wave.open(path, "wb") as w:
+        w.setnchannels(2)
+        w.setsampwidth(2)
+        w.setframerate(rate)
+        w.writeframes(b"\0\0\0\0" * rate)
+
+
+class Daemon:
+    def __init__(self, env: dict):
+        self.proc = subprocess.Popen(
+            [sys.executable, DAEMON],
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.DEVNULL,
+            text=True,
+            bufsize=1,
+            env=env,
+        )
+        if self.proc.stdout.readline().strip() != "READY":
+            raise RuntimeError("daemon did not report READY")
+
+    def request(self, line: str) -> str:
+        """Sends one command and returns its terminal response line."""
+        self.proc.stdin.write(line + "\n")
+        self.proc.stdin.flush()
+        while True:
+            reply = self.proc.stdout.readline()
+            if not reply:
+                raise RuntimeError("daemon exited")
+            tag = reply.split("\t", 1)[0].strip()
+            if tag in ("SEARCH_END", "RESOLVE_OK", "ERROR"):
+                return tag
+
+    def close(self) -> None:
+        try:
+            self.proc.stdin.write("QUIT\n")
+            self.proc.stdin.flush()
+            self.proc.wait(timeout=5)
+        except Exception:
+            self.proc.kill()
+
+
+def run_level(env: dict, line: str, concurrency: int, per_client: int) -> dict:
+    daemons = [Daemon(env) for _ in range(concurrency)]
+    latencies = []
+    errors = [0]
+    lock = threading.Lock()
+    barrier = threading.Barrier(concurrency)
+
+    def client(d: Daemon) -> None:
+        local = []
+        barrier.wait()
+        for _ in range(per_client):
+            t0 = time.perf_counter()
+            tag = d.request(line)
+            local.append((time.perf_counter() - t0) * 1000.0)
+            if tag == "ERROR":
+                with lock:
+                    errors[0] += 1
+        with lock:
+            latencies.extend(local)
+
+    threads = [threading.Thread(target=client, args=(d,)) for d in daemons]
+    t_start = time.perf_counter()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    wall = time.perf_counter() - t_start
+    for d in daemons:
+        d.close()
+
+    latencies.sort()
+    return {
+        "requests": len(latencies),
+        "errors": errors[0],
+        "p50_ms": percentile(latencies, 50),
+        "p99_ms": percentile(latencies, 99),
+        "throughput_rps": len(latencies) / wall if wall > 0 else 0.0,
+    }
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description="Daemon SEARCH/RESOLVE benchmark against the offline stand-in")
+    ap.add_argument("--concurrency", default="1,2,4,8", help="comma-separated client counts")
+    ap.add_argument("--requests", type=int, default=40, help="requests per client per level")
+    ap.add_argument("--latency-ms", type=int, default=0, help="stand-in per-request latency")
+    ap.add_argument("--json", action="store_true", help="one JSON object per result line")
+    args = ap.parse_args()
+    levels = [int(x) for x in args.concurrency.split(",") if x.strip()]
+
+    media_dir = tempfile.mkdtemp(prefix="daemon_bench_")
+    write_silence(os.path.join(media_dir, "tone48k.wav"), 48000)
+    write_silence(os.path.join(media_dir, "tone44k.wav"), 44100)
+
+    standin = subprocess.Popen(
+        [sys.executable, STANDIN, "--root", media_dir, "--fixtures", FIXTURES,
+         "--latency-ms", str(args.latency_ms)],
+        stdout=subprocess.PIPE,
+        text=True,
+    )
+    try:
+        first = standin.stdout.readline().split()
+        if len(first) != 2 or first[0] != "PORT":
+            print("stand-in server failed to start", file=sys.stderr)
+            return 1
+        base = f"http://127.0.0.1:{first[1]}"
+        env = dict(os.environ)
+        env.update({
+            "WEBSTREAM_ARCHIVE_BASE_URL": base,
+            "WEBSTREAM_FREESOUND_BASE_URL": base + "/apiv2",
+            "FREESOUND_API_KEY": "standin",
+        })
+
+        if not args.json:
+            print(f"{'provider':<10} {'cmd':<8} {'conc':>4} {'reqs':>6} {'err':>4} "
+                  f"{'p50_ms':>8} {'p99_ms':>8} {'req/s':>8}")
+        failed = False
+        for (provider, cmd), line in REQUESTS.items():
+            for level in levels:
+                r = run_level(env, line, level, args.requests)
+                failed = failed or r["errors"] > 0
+                if args.json:
+                    print(json.dumps({"provider": provider, "cmd": cmd, "concurrency": level, **r}))
+                else:
+                    print(f"{provider:<10} {cmd:<8} {level:>4} {r['requests']:>6} {r['errors']:>4} "
+                          f"{r['p50_ms']:>8.2f} {r['p99_ms']:>8.2f} {r['throughput_rps']:>8.1f}")
+                sys.stdout.flush()
+        return 1 if failed else 0
+    finally:
+        standin.terminate()
+        standin.wait()
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,126 @@
+/*
+ * get_param/set_param key dispatch benchmark.
+ *
+ * Builds against the plugin source so it measures the real key table:
+ * lookups per second through the hashed map versus a linear strcmp scan of
+ * the same keys (what the old if-chain did), for plain and indexed keys
+ * (suffix and voice#_ infix families),
+ * plus full v2_get_param calls. Exits non-zero if any key fails to map back
+ * to its own id.
+ */
+#include "yt_stream_plugin.c"
+
+#define BENCH_ROUNDS 200000
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int linear_lookup(const char *key, int *index) {
+    size_t n = sizeof(g_param_keys) / sizeof(g_param_keys[0]);
+    size_t i;
+
+    *index = -1;
+    for (i = 0; i < n; i++) {
+        const char *k = g_param_keys[i].key;
+        size_t len = strlen(k);
+        const char *hash = strchr(k, '#');
+        if (hash) {
+            size_t pre = (size_t)(hash - k);
+            const char *rest = key + pre;
+            if (strncmp(key, k, pre) != 0 || *rest < '0' || *rest > '9') continue;
+            while (*rest >= '0' && *rest <= '9') rest++;
+            if (strcmp(rest, hash + 1) == 0) {
+                *index = atoi(key + pre);
+                return g_param_keys[i].id;
+            }
+        } else if (k[len - 1] == '_') {
+            if (strncmp(key, k, len) == 0 && key[len] >= '0' && key[len] <= '9') {
+                *index = atoi(key + len);
+                return g_param_keys[i].id;
+            }
+        } else if (strcmp(key, k) == 0) {
+            return g_param_keys[i].id;
+        }
+    }
+    return -1;
+}
+
+static void report(const char *name, int (*fn)(const char *, int *), const char **keys, int count) {
+    volatile int sink = 0;
+    double start = now_sec();
+    double secs;
+    int round;
+    int i;
+
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+        for (i = 0; i < count; i++) {
+            int index;
+            sink += fn(keys[i], &index) + index;
+        }
+    }
+    secs = now_sec() - start;
+    printf("  %-22s %8.1f ns/lookup  %7.2f M lookups/s\n", name,
+           secs * 1e9 / ((double)BENCH_ROUNDS * count), (double)BENCH_ROUNDS * count / secs / 1e6);
+    (void)sink;
+}
+
+int main(void) {
+    const int nkeys = (int)(sizeof(g_param_keys) / sizeof(g_param_keys[0]));
+    const char *plain[128];
+    const char *indexed[] = { "search_result_0", "search_result_title_7", "search_result_url_19",
+                              "search_result_provider_3", "search_results_snapshot_12", "voice2_gain",
+                              "voice3_stream_url", "slot12_capture" };
+    const char *getters[] = { "gain", "stream_status", "underrun_count", "arrival_rate_pct", "range_prefetch" };
+    const int nindexed = (int)(sizeof(indexed) / sizeof(indexed[0]));
+    int nplain = 0;
+    int failures = 0;
+    char buf[256];
+    volatile int sink = 0;
+    double start;
+    double secs;
+    int round;
+    int i;
+
+    for (i = 0; i < nkeys; i++) {
+        int index;
+        const char *k = g_param_keys[i].key;
+        if (param_lookup(k, &index) != g_param_keys[i].id) {
+            printf("FAIL: %s does not map to its id\n", k);
+            failures++;
+        }
+        if (k[strlen(k) - 1] != '_' && !strchr(k, '#') && nplain < 128) plain[nplain++] = k;
+    }
+    for (i = 0; i < nindexed; i++) {
+        int a, b;
+        if (param_lookup(indexed[i], &a) != linear_lookup(indexed[i], &b) || a != b) {
+            printf("FAIL: %s maps differently from the linear scan\n", indexed[i]);
+            failures++;
+        }
+    }
+    if (param_lookup("no_such_key", &i) != -1 || param_lookup("gain_2", &i) != -1 ||
+        param_lookup("voice_gain", &i) != -1 || param_lookup("voice2_gain2", &i) != -1) {
+        printf("FAIL: unknown keys should not resolve\n");
+        failures++;
+    }
+
+    printf("param dispatch: %d keys, %d slots, longest probe %d\n", nkeys, WS_KEYMAP_SLOTS, g_param_map.max_probe);
+    printf(" plain keys (%d):\n", nplain);
+    report("hashed", param_lookup, plain, nplain);
+    report("linear strcmp", linear_lookup, plain, nplain);
+    printf(" indexed keys (%d):\n", nindexed);
+    report("hashed", param_lookup, indexed, nindexed);
+    report("linear strcmp", linear_lookup, indexed, nindexed);
+
+    start = now_sec();
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+        for (i = 0; i < 5; i++) sink += v2_get_param(NULL, getters[i], buf, (int)sizeof(buf));
+    }
+    secs = now_sec() - start;
+    printf(" v2_get_param (no instance): %.1f ns/call  %.2f M calls/s\n",
+           secs * 1e9 / (BENCH_ROUNDS * 5.0), BENCH_ROUNDS * 5.0 / secs / 1e6);
+    (void)sink;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * Resampler quality/CPU benchmark.
+ *
+ * For each rate pair and tap count: throughput (ns per output frame and
+ * realtime factor), SNR of a 1 kHz sine against an ideal fit, and rejection
+ * of a tone above the output Nyquist when downsampling.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ws_resampler.h"
+
+#define BENCH_SECONDS 10
+#define CHUNK_FRAMES 1024
+
+static const double k_pi = 3.14159265358979323846;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int16_t *make_tone(int rate, double freq, double amp, size_t frames) {
+    int16_t *buf = malloc(frames * 2 * sizeof(int16_t));
+    size_t i;
+    if (!buf) return NULL;
+    for (i = 0; i < frames; i++) {
+        int16_t v = (int16_t)lrint(amp * 32767.0 * sin(2.0 * k_pi * freq * (double)i / (double)rate));
+        buf[i * 2] = v;
+        buf[i * 2 + 1] = v;
+    }
+    return buf;
+}
+
+static size_t run(ws_resampler_t *rs, const int16_t *in, size_t in_frames, int16_t *out, size_t out_cap) {
+    size_t made = 0;
+    size_t pos = 0;
+    while (pos < in_frames && made < out_cap) {
+        size_t used = 0;
+        size_t chunk = in_frames - pos < CHUNK_FRAMES ? in_frames - pos : CHUNK_FRAMES;
+        size_t cap = out_cap - made;
+        size_t n = ws_resampler_process(rs, in + pos * 2, chunk, out + made * 2, cap, &used);
+        made += n;
+        pos += used;
+        if (n == 0 && used == 0) break;
+    }
+    return made;
+}
+
+/* Least-squares fit of a*sin + b*cos at freq; returns SNR of the residual in dB. */
+static double sine_snr_db(const int16_t *out, size_t frames, size_t skip, int rate, double freq) {
+    double ss = 0.0, sc = 0.0, cc = 0.0, ys = 0.0, yc = 0.0;
+    double a, b, det, sig = 0.0, err = 0.0;
+    size_t i;
+    for (i = skip; i < frames; i++) {
+        double w = 2.0 * k_pi * freq * (double)i / (double)rate;
+        double s = sin(w), c = cos(w), y = out[i * 2];
+        ss += s * s; sc += s * c; cc += c * c; ys += y * s; yc += y * c;
+    }
+    det = ss * cc - sc * sc;
+    if (det == 0.0) return 0.0;
+    a = (ys * cc - yc * sc) / det;
+    b = (yc * ss - ys * sc) / det;
+    for (i = skip; i < frames; i++) {
+        double w = 2.0 * k_pi * freq * (double)i / (double)rate;
+        double fit = a * sin(w) + b * cos(w);
+        double y = out[i * 2];
+        sig += fit * fit;
+        err += (y - fit) * (y - fit);
+    }
+    if (err <= 0.0) return 200.0;
+    return 10.0 * log10(sig / err);
+}
+
+static double rms(const int16_t *buf, size_t frames, size_t skip) {
+    double acc = 0.0;
+    size_t i;
+    if (frames <= skip) return 0.0;
+    for (i = skip; i < frames; i++) acc += (double)buf[i * 2] * (double)buf[i * 2];
+    return sqrt(acc / (double)(frames - skip));
+}
+
+static void bench_pair(int in_rate, int out_rate, int taps) {
+    static ws_resampler_t rs;
+    size_t in_frames = (size_t)in_rate * BENCH_SECONDS;
+    size_t out_cap = (size_t)out_rate * BENCH_SECONDS + 4096;
+    int16_t *tone = make_tone(in_rate, 1000.0, 0.5, in_frames);
+    int16_t *out = malloc(out_cap * 2 * sizeof(int16_t));
+    double t0, t1, ns_per_frame, rt_factor, snr, reject = 0.0;
+    size_t made;
+
+    if (!tone || !out) {
+        fprintf(stderr, "allocation failed\n");
+        exit(1);
+    }
+
+    ws_resampler_configure(&rs, in_rate, out_rate, taps);
+    t0 = now_sec();
+    made = run(&rs, tone, in_frames, out, out_cap);
+    t1 = now_sec();
+    ns_per_frame = made > 0 ? (t1 - t0) * 1e9 / (double)made : 0.0;
+    rt_factor = (t1 - t0) > 0.0 ? (double)BENCH_SECONDS / (t1 - t0) : 0.0;
+    snr = sine_snr_db(out, made, (size_t)taps * 4, out_rate, 1000.0);
+
+    if (out_rate < in_rate) {
+        /* Tone between the two Nyquist frequencies must be filtered, not folded back. */
+        double freq = ((double)out_rate / 2.0 + (double)in_rate / 2.0) / 2.0;
+        int16_t *alias = make_tone(in_rate, freq, 0.5, in_frames);
+        double in_rms = rms(alias, in_frames, 0);
+        double out_rms;
+        ws_resampler_configure(&rs, in_rate, out_rate, taps);
+        made = run(&rs, alias, in_frames, out, out_cap);
+        out_rms = rms(out, made, (size_t)taps * 4);
+        reject = out_rms > 0.0 ? 20.0 * log10(in_rms / out_rms) : 200.0;
+        free(alias);
+    }
+
+    printf("%6d -> %6d  taps=%2d  %7.1f ns/frame  %7.0fx realtime  snr=%6.1f dB",
+           in_rate, out_rate, taps, ns_per_frame, rt_factor, snr);
+    if (out_rate < in_rate) printf("  alias_reject=%6.1f dB", reject);
+    printf("\n");
+
+    free(tone);
+    free(out);
+}
+
+int main(void) {
+    static const int pairs[][2] = {
+        {44100, 48000}, {48000, 44100}, {22050, 44100}, {32000, 44100}, {96000, 44100}, {44100, 44100}
+    };
+    size_t i;
+
+#if defined(WS_RESAMPLER_NEON)
+    printf("resampler bench (NEON)\n");
+#else
+    printf("resampler bench (scalar)\n");
+#endif
+    for (i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++) {
+        bench_pair(pairs[i][0], pairs[i][1], WS_RESAMPLER_TAPS_LOW);
+        bench_pair(pairs[i][0], pairs[i][1], WS_RESAMPLER_TAPS_HIGH);
+    }
+    return 0;
+}
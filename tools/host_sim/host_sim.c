@@ -0,0 +1,511 @@
+/*
+ * Standalone host simulator for the webstream DSP plugin.
+ *
+ * Loads dsp.so, drives render_block at the host cadence (128 frames at
+ * 44.1 kHz by default) and replays a timed script of set_param and on_midi
+ * calls.
+ * Reports render-time percentiles, deadline misses and time-to-first-audio.
+ * With --instances N it hosts N plugin instances (like N slots in a set):
+ * every set command goes to all of them, each is rendered every block, and
+ * get/--report-param read the first. --record FILE keeps the first
+ * instance's output as raw s16le stereo for offline comparison.
+ *
+ * Script lines: "<ms> [@<n>] <command> [args]", '#' starts a comment. "@<n>"
+ * sends the command to instance n only (0 is the first).
+ *   select <provider> <url>   set stream_provider + stream_url (starts a TTFA timer)
+ *   seek <ms>                 set seek_position_ms
+ *   restart | stop            trigger restart / stop
+ *   set <key> <value...>      raw set_param
+ *   midi <b0> <b1> <b2>       on_midi with hex bytes, e.g. "midi 90 24 7f"
+ *   get <key>                 print get_param
+ *   drop                      destroy the newest instance (with --instances, never the first)
+ *   end                       finish the run
+ */
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "plugin_api_v1.h"
+
+#define SIM_MAX_EVENTS 256
+#define SIM_LINE_MAX 1024
+#define SIM_MAX_SELECTS 32
+#define SIM_MAX_INSTANCES 8
+
+typedef struct {
+    uint64_t at_ms;
+    int target;                 /* instance index from "@<n>", -1 for all */
+    char cmd[16];
+    char arg1[256];
+    char arg2[SIM_LINE_MAX];
+} sim_event_t;
+
+typedef struct {
+    uint64_t select_ns;
+    uint64_t first_audio_ns;
+    char url[256];
+} sim_select_t;
+
+static bool g_verbose = false;
+
+static void sim_log(const char *msg) {
+    if (g_verbose && msg) fprintf(stderr, "[plugin] %s\n", msg);
+}
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t target) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(target / 1000000000ULL);
+    ts.tv_nsec = (long)(target % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static uint64_t percentile(const uint64_t *sorted, size_t n, double pct) {
+    size_t idx;
+    if (n == 0) return 0;
+    idx = (size_t)(pct / 100.0 * (double)(n - 1) + 0.5);
+    if (idx >= n) idx = n - 1;
+    return sorted[idx];
+}
+
+static int load_script(const char *path, sim_event_t *events, int max_events) {
+    FILE *fp;
+    char line[SIM_LINE_MAX];
+    int count = 0;
+    int lineno = 0;
+
+    fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "host_sim: cannot open script %s\n", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        sim_event_t *ev;
+        char *p = line;
+        char *end;
+        int consumed = 0;
+
+        lineno++;
+        line[strcspn(line, "\r\n")] = '\0';
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '\0' || *p == '#') continue;
+        if (count >= max_events) {
+            fprintf(stderr, "host_sim: too many script events (max %d)\n", max_events);
+            break;
+        }
+        ev = &events[count];
+        memset(ev, 0, sizeof(*ev));
+        ev->at_ms = strtoull(p, &end, 10);
+        if (end == p) {
+            fprintf(stderr, "host_sim: %s:%d: expected time in ms\n", path, lineno);
+            fclose(fp);
+            return -1;
+        }
+        p = end;
+        ev->target = -1;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '@') {
+            ev->target = (int)strtol(p + 1, &end, 10);
+            if (end == p + 1 || ev->target < 0) {
+                fprintf(stderr, "host_sim: %s:%d: expected @<instance>\n", path, lineno);
+                fclose(fp);
+                return -1;
+            }
+            p = end;
+        }
+        if (sscanf(p, " %15s %n", ev->cmd, &consumed) < 1) {
+            fprintf(stderr, "host_sim: %s:%d: missing command\n", path, lineno);
+            fclose(fp);
+            return -1;
+        }
+        p += consumed;
+        consumed = 0;
+        if (sscanf(p, "%255s %n", ev->arg1, &consumed) >= 1) {
+            p += consumed;
+            snprintf(ev->arg2, sizeof(ev->arg2), "%s", p);
+        }
+        count++;
+    }
+    fclose(fp);
+    return count;
+}
+
+static bool event_targets(const sim_event_t *ev, int k) {
+    return ev->target < 0 || ev->target == k;
+}
+
+/* get_param into buf (at most len bytes, like a host with a smaller buffer); failures read as "". */
+static void get_param_str(plugin_api_v2_t *api, void *inst, const char *key, char *buf, int len) {
+    buf[0] = '\0';
+    if (api->get_param(inst, key, buf, len) < 0) buf[0] = '\0';
+}
+
+static void print_json_string(const char *s) {
+    putchar('"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') printf("\\%c", c);
+        else if (c == '\n') fputs("\\n", stdout);
+        else if (c == '\t') fputs("\\t", stdout);
+        else if (c < 0x20) printf("\\u%04x", c);
+        else putchar(c);
+    }
+    putchar('"');
+}
+
+static bool block_has_audio(const int16_t *buf, int samples) {
+    int i;
+    for (i = 0; i < samples; i++) {
+        if (buf[i] != 0) return true;
+    }
+    return false;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: host_sim <dsp.so> --module-dir DIR --script FILE\n"
+            "                [--rate HZ] [--frames N] [--seconds S] [--fast]\n"
+            "                [--report-param KEY]... [--param-buf BYTES] [--instances N]\n"
+            "                [--record FILE] [--json] [--verbose]\n");
+}
+
+int main(int argc, char **argv) {
+    const char *dsp_path = NULL;
+    const char *module_dir = NULL;
+    const char *script_path = NULL;
+    const char *record_path = NULL;
+    FILE *record = NULL;
+    const char *report_keys[16];
+    int report_count = 0;
+    int rate = MOVE_SAMPLE_RATE;
+    int frames = MOVE_FRAMES_PER_BLOCK;
+    double max_seconds = 0.0;
+    bool fast = false;
+    bool json = false;
+    sim_event_t *events;
+    int event_count;
+    int next_event = 0;
+    sim_select_t selects[SIM_MAX_SELECTS];
+    int select_count = 0;
+    void *handle;
+    move_plugin_init_v2_fn init_fn;
+    plugin_api_v2_t *api;
+    host_api_v1_t host;
+    void *insts[SIM_MAX_INSTANCES];
+    int instance_count = 1;
+    void *inst;
+    int16_t *out;
+    uint64_t *render_ns;
+    uint64_t *sorted;
+    size_t blocks = 0;
+    size_t max_blocks;
+    uint64_t period_ns;
+    uint64_t start_ns;
+    uint64_t next_ns;
+    uint64_t deadline_misses = 0;
+    uint64_t late_wakeups = 0;
+    uint64_t max_late_ns = 0;
+    uint64_t param_max_ns = 0;
+    uint64_t audio_blocks = 0;
+    uint64_t end_ms = 0;
+    char buf[4096];
+    int param_buf = (int)sizeof(buf);
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--module-dir") == 0 && i + 1 < argc) {
+            module_dir = argv[++i];
+        } else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            script_path = argv[++i];
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            max_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--report-param") == 0 && i + 1 < argc) {
+            if (report_count < (int)(sizeof(report_keys) / sizeof(report_keys[0]))) {
+                report_keys[report_count++] = argv[++i];
+            } else {
+                i++;
+            }
+        } else if (strcmp(argv[i], "--param-buf") == 0 && i + 1 < argc) {
+            param_buf = atoi(argv[++i]);
+            if (param_buf < 16) param_buf = 16;
+            if (param_buf > (int)sizeof(buf)) param_buf = (int)sizeof(buf);
+        } else if (strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+            instance_count = atoi(argv[++i]);
+            if (instance_count < 1) instance_count = 1;
+            if (instance_count > SIM_MAX_INSTANCES) instance_count = SIM_MAX_INSTANCES;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--fast") == 0) {
+            fast = true;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            g_verbose = true;
+        } else if (argv[i][0] != '-' && !dsp_path) {
+            dsp_path = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!dsp_path || !module_dir || !script_path || rate <= 0 || frames <= 0) {
+        usage();
+        return 2;
+    }
+
+    events = calloc(SIM_MAX_EVENTS, sizeof(*events));
+    if (!events) return 1;
+    event_count = load_script(script_path, events, SIM_MAX_EVENTS);
+    if (event_count < 0) return 1;
+    for (i = 0; i < event_count; i++) {
+        if (events[i].at_ms > end_ms) end_ms = events[i].at_ms;
+    }
+    if (max_seconds > 0.0) end_ms = (uint64_t)(max_seconds * 1000.0);
+    if (end_ms == 0) end_ms = 10000;
+
+    handle = dlopen(dsp_path, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        fprintf(stderr, "host_sim: dlopen failed: %s\n", dlerror());
+        return 1;
+    }
+    init_fn = (move_plugin_init_v2_fn)dlsym(handle, MOVE_PLUGIN_INIT_V2_SYMBOL);
+    if (!init_fn) {
+        fprintf(stderr, "host_sim: %s not exported\n", MOVE_PLUGIN_INIT_V2_SYMBOL);
+        return 1;
+    }
+
+    memset(&host, 0, sizeof(host));
+    host.api_version = MOVE_PLUGIN_API_VERSION;
+    host.sample_rate = rate;
+    host.frames_per_block = frames;
+    host.log = sim_log;
+    api = init_fn(&host);
+    if (!api || api->api_version != MOVE_PLUGIN_API_VERSION_2) {
+        fprintf(stderr, "host_sim: plugin did not return a v2 API\n");
+        return 1;
+    }
+    for (i = 0; i < instance_count; i++) {
+        insts[i] = api->create_instance(module_dir, NULL);
+        if (!insts[i]) {
+            fprintf(stderr, "host_sim: create_instance failed\n");
+            return 1;
+        }
+    }
+    inst = insts[0];
+
+    period_ns = (uint64_t)frames * 1000000000ULL / (uint64_t)rate;
+    max_blocks = (size_t)(end_ms * 1000000ULL / period_ns) + 2;
+    out = calloc((size_t)frames * 2, sizeof(int16_t));
+    render_ns = calloc(max_blocks, sizeof(uint64_t));
+    sorted = calloc(max_blocks, sizeof(uint64_t));
+    if (!out || !render_ns || !sorted) return 1;
+    if (record_path) {
+        record = fopen(record_path, "wb");
+        if (!record) {
+            fprintf(stderr, "host_sim: cannot write %s\n", record_path);
+            return 1;
+        }
+    }
+
+    start_ns = mono_ns();
+    next_ns = start_ns;
+    while (blocks < max_blocks) {
+        /* Script time follows the sample clock so runs are reproducible in --fast mode. */
+        uint64_t sim_ms = (uint64_t)blocks * period_ns / 1000000ULL;
+        uint64_t wake_ns;
+        uint64_t t0;
+        uint64_t t1;
+        bool finished = false;
+
+        if (sim_ms >= end_ms) break;
+        if (!fast) {
+            sleep_until_ns(next_ns);
+            wake_ns = mono_ns();
+            if (wake_ns > next_ns + period_ns / 4) late_wakeups++;
+            if (wake_ns > next_ns && wake_ns - next_ns > max_late_ns) max_late_ns = wake_ns - next_ns;
+        }
+
+        while (next_event < event_count && events[next_event].at_ms <= sim_ms) {
+            sim_event_t *ev = &events[next_event++];
+            uint64_t p0 = mono_ns();
+            uint64_t p1;
+            int k;
+
+            if (strcmp(ev->cmd, "select") == 0) {
+                for (k = instance_count - 1; k >= 0; k--) {
+                    if (!event_targets(ev, k)) continue;
+                    api->set_param(insts[k], "stream_provider", ev->arg1);
+                    api->set_param(insts[k], "stream_url", ev->arg2);
+                }
+                /* TTFA is measured on the first instance, so only its selects start a timer. */
+                if (event_targets(ev, 0) && select_count < SIM_MAX_SELECTS) {
+                    selects[select_count].select_ns = mono_ns();
+                    selects[select_count].first_audio_ns = 0;
+                    snprintf(selects[select_count].url, sizeof(selects[select_count].url), "%s", ev->arg2);
+                    select_count++;
+                }
+            } else if (strcmp(ev->cmd, "seek") == 0) {
+                for (k = 0; k < instance_count; k++) {
+                    if (event_targets(ev, k)) api->set_param(insts[k], "seek_position_ms", ev->arg1);
+                }
+            } else if (strcmp(ev->cmd, "restart") == 0) {
+                for (k = 0; k < instance_count; k++) {
+                    if (event_targets(ev, k)) api->set_param(insts[k], "restart", "1");
+                }
+            } else if (strcmp(ev->cmd, "stop") == 0) {
+                for (k = 0; k < instance_count; k++) {
+                    if (event_targets(ev, k)) api->set_param(insts[k], "stop", "1");
+                }
+            } else if (strcmp(ev->cmd, "set") == 0) {
+                for (k = 0; k < instance_count; k++) {
+                    if (event_targets(ev, k)) api->set_param(insts[k], ev->arg1, ev->arg2);
+                }
+            } else if (strcmp(ev->cmd, "midi") == 0) {
+                unsigned b[3] = { 0, 0, 0 };
+                uint8_t msg[3];
+                int n = sscanf(ev->arg1, "%x", &b[0]) == 1 ? 1 : 0;
+                if (n == 1) {
+                    int more = sscanf(ev->arg2, "%x %x", &b[1], &b[2]);
+                    if (more > 0) n += more;
+                }
+                msg[0] = (uint8_t)b[0];
+                msg[1] = (uint8_t)b[1];
+                msg[2] = (uint8_t)b[2];
+                for (k = 0; k < instance_count; k++) {
+                    if (event_targets(ev, k)) api->on_midi(insts[k], msg, n, 0);
+                }
+            } else if (strcmp(ev->cmd, "get") == 0) {
+                get_param_str(api, inst, ev->arg1, buf, param_buf);
+                if (!json) printf("[%7llu ms] %s=%s\n", (unsigned long long)sim_ms, ev->arg1, buf);
+            } else if (strcmp(ev->cmd, "drop") == 0) {
+                if (instance_count > 1) api->destroy_instance(insts[--instance_count]);
+            } else if (strcmp(ev->cmd, "end") == 0) {
+                finished = true;
+            } else {
+                fprintf(stderr, "host_sim: unknown command '%s'\n", ev->cmd);
+            }
+            p1 = mono_ns();
+            if (p1 - p0 > param_max_ns) param_max_ns = p1 - p0;
+        }
+        if (finished) break;
+
+        t0 = mono_ns();
+        /* The first instance renders last, so out holds its audio for the TTFA check. */
+        for (i = instance_count - 1; i >= 0; i--) api->render_block(insts[i], out, frames);
+        t1 = mono_ns();
+        render_ns[blocks] = t1 - t0;
+        if (record) fwrite(out, sizeof(int16_t), (size_t)frames * 2, record);
+        /* Deadline: the block must be done before the next one is due. */
+        if (!fast && t1 > next_ns + period_ns) deadline_misses++;
+        if (fast && t1 - t0 > period_ns) deadline_misses++;
+
+        if (block_has_audio(out, frames * 2)) {
+            audio_blocks++;
+            if (select_count > 0 && selects[select_count - 1].first_audio_ns == 0) {
+                selects[select_count - 1].first_audio_ns = t1;
+            }
+        }
+
+        blocks++;
+        next_ns += period_ns;
+    }
+
+    memcpy(sorted, render_ns, blocks * sizeof(uint64_t));
+    qsort(sorted, blocks, sizeof(uint64_t), cmp_u64);
+
+    if (json) {
+        printf("{\"blocks\":%zu,\"period_us\":%.1f,\"render_us\":{\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,"
+               "\"p999\":%.1f,\"max\":%.1f},\"deadline_misses\":%llu,\"late_wakeups\":%llu,"
+               "\"max_wake_late_us\":%.1f,\"param_max_us\":%.1f,\"audio_blocks\":%llu,\"ttfa_ms\":[",
+               blocks,
+               (double)period_ns / 1000.0,
+               (double)percentile(sorted, blocks, 50.0) / 1000.0,
+               (double)percentile(sorted, blocks, 90.0) / 1000.0,
+               (double)percentile(sorted, blocks, 99.0) / 1000.0,
+               (double)percentile(sorted, blocks, 99.9) / 1000.0,
+               blocks ? (double)sorted[blocks - 1] / 1000.0 : 0.0,
+               (unsigned long long)deadline_misses,
+               (unsigned long long)late_wakeups,
+               (double)max_late_ns / 1000.0,
+               (double)param_max_ns / 1000.0,
+               (unsigned long long)audio_blocks);
+        for (i = 0; i < select_count; i++) {
+            if (selects[i].first_audio_ns) {
+                printf("%s%.1f", i ? "," : "", (double)(selects[i].first_audio_ns - selects[i].select_ns) / 1e6);
+            } else {
+                printf("%snull", i ? "," : "");
+            }
+        }
+        printf("],\"params\":{");
+        for (i = 0; i < report_count; i++) {
+            get_param_str(api, inst, report_keys[i], buf, param_buf);
+            if (buf[0] == '{') {
+                /* JSON-valued params (stats_json) are embedded as objects. */
+                printf("%s\"%s\":%s", i ? "," : "", report_keys[i], buf);
+            } else {
+                printf("%s\"%s\":", i ? "," : "", report_keys[i]);
+                print_json_string(buf);
+            }
+        }
+        printf("}}\n");
+    } else {
+        printf("blocks            %zu (%d frames @ %d Hz, period %.1f us%s)\n",
+               blocks, frames, rate, (double)period_ns / 1000.0, fast ? ", fast" : "");
+        printf("render p50/p90    %.1f / %.1f us\n",
+               (double)percentile(sorted, blocks, 50.0) / 1000.0,
+               (double)percentile(sorted, blocks, 90.0) / 1000.0);
+        printf("render p99/p99.9  %.1f / %.1f us\n",
+               (double)percentile(sorted, blocks, 99.0) / 1000.0,
+               (double)percentile(sorted, blocks, 99.9) / 1000.0);
+        printf("render max        %.1f us\n", blocks ? (double)sorted[blocks - 1] / 1000.0 : 0.0);
+        printf("deadline misses   %llu\n", (unsigned long long)deadline_misses);
+        if (!fast) {
+            printf("late wakeups      %llu (max %.1f us)\n",
+                   (unsigned long long)late_wakeups, (double)max_late_ns / 1000.0);
+        }
+        printf("param call max    %.1f us\n", (double)param_max_ns / 1000.0);
+        printf("audio blocks      %llu\n", (unsigned long long)audio_blocks);
+        for (i = 0; i < select_count; i++) {
+            if (selects[i].first_audio_ns) {
+                printf("ttfa              %.1f ms  %s\n",
+                       (double)(selects[i].first_audio_ns - selects[i].select_ns) / 1e6, selects[i].url);
+            } else {
+                printf("ttfa              none     %s\n", selects[i].url);
+            }
+        }
+        for (i = 0; i < report_count; i++) {
+            get_param_str(api, inst, report_keys[i], buf, param_buf);
+            printf("%-17s %s\n", report_keys[i], buf);
+        }
+    }
+
+    for (i = instance_count - 1; i >= 0; i--) api->destroy_instance(insts[i]);
+    if (record) fclose(record);
+    free(out);
+    free(render_ns);
+    free(sorted);
+    free(events);
+    return 0;
+}
@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+"""Writes a 16-bit stereo test WAV: a slow sine sweep with a click every second.
+
+With --decimate SRC it instead keeps every Nth frame of SRC (N = SRC rate /
+--rate), so the result lines up sample for sample with SRC.
+"""
+import argparse
+import math
+import struct
+import wave
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument("path")
+    ap.add_argument("--rate", type=int, default=48000)
+    ap.add_argument("--seconds", type=float, default=60.0)
+    ap.add_argument("--decimate", metavar="SRC")
+    args = ap.parse_args()
+
+    if args.decimate:
+        with wave.open(args.decimate, "rb") as src:
+            step = src.getframerate() // args.rate
+            data = src.readframes(src.getnframes())
+        with wave.open(args.path, "wb") as w:
+            w.setnchannels(2)
+            w.setsampwidth(2)
+            w.setframerate(args.rate)
+            w.writeframes(b"".join(data[i:i + 4] for i in range(0, len(data), 4 * step)))
+        return 0
+
+    frames = int(args.rate * args.seconds)
+    with wave.open(args.path, "wb") as w:
+        w.setnchannels(2)
+        w.setsampwidth(2)
+        w.setframerate(args.rate)
+        phase = 0.0
+        block = bytearray()
+        for i in range(frames):
+            t = i / args.rate
+            freq = 220.0 + 660.0 * (t % 10.0) / 10.0
+            phase += 2.0 * math.pi * freq / args.rate
+            v = 0.4 * math.sin(phase)
+            if i % args.rate < args.rate // 200:
+                v += 0.3
+            s = int(max(-1.0, min(1.0, v)) * 32767)
+            block += struct.pack("<hh", s, s)
+            if len(block) >= 1 << 20:
+                w.writeframes(bytes(block))
+                block.clear()
+        w.writeframes(bytes(block))
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
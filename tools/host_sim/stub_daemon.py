@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Offline stand-in for bin/yt_dlp_daemon.py used by the host simulator.
+
+Speaks the same line protocol. Search returns one result per media file in
+WEBSTREAM_SIM_MEDIA_DIR; resolve maps ".../<name>" to
+"$WEBSTREAM_SIM_MEDIA_BASE/<name>.wav" (served by tools/standin). When a
+"<name>_lo.wav" sits next to it, that file is offered as a fast-start rung
+at half the bitrate, like a low-bitrate format in a real format list.
+WEBSTREAM_SIM_RESOLVE_MS and WEBSTREAM_SIM_SEARCH_MS add artificial delays.
+If WEBSTREAM_SIM_DAEMON_LOG is set, each daemon appends START, the tag and
+command of every request, and EXIT to that file.
+"""
+import os
+import sys
+import time
+import wave
+
+
+reply_tag = ""
+
+
+def write_fields(*fields) -> None:
+    if reply_tag:
+        fields = (reply_tag,) + fields
+    sys.stdout.write("\t".join(str(f).replace("\t", " ") for f in fields) + "\n")
+    sys.stdout.flush()
+
+
+def log_event(*fields) -> None:
+    path = os.environ.get("WEBSTREAM_SIM_DAEMON_LOG", "")
+    if path:
+        with open(path, "a") as f:
+            f.write("\t".join(str(x) for x in (os.getpid(),) + fields) + "\n")
+
+
+def media_duration(path: str) -> str:
+    try:
+        with wave.open(path, "rb") as w:
+            total = int(w.getnframes() / float(w.getframerate()))
+    except Exception:
+        return ""
+    return f"{total // 60}:{total % 60:02d}"
+
+
+def main() -> int:
+    global reply_tag
+    media_dir = os.environ.get("WEBSTREAM_SIM_MEDIA_DIR", "")
+    media_base = os.environ.get("WEBSTREAM_SIM_MEDIA_BASE", "").rstrip("/")
+    resolve_delay = int(os.environ.get("WEBSTREAM_SIM_RESOLVE_MS", "0") or "0") / 1000.0
+    search_delay = int(os.environ.get("WEBSTREAM_SIM_SEARCH_MS", "0") or "0") / 1000.0
+
+    log_event("START")
+    write_fields("READY")
+    for raw in sys.stdin:
+        parts = raw.rstrip("\n").split("\t")
+        reply_tag = parts.pop(0) if parts[0].startswith("@") else ""
+        cmd = parts[0] if parts else ""
+        log_event("REQ", reply_tag or "-", cmd)
+        if cmd == "SEARCH":
+            provider = parts[1] if len(parts) > 1 else "archive"
+            if search_delay > 0:
+                time.sleep(search_delay)
+            write_fields("SEARCH_BEGIN")
+            names = sorted(n for n in os.listdir(media_dir) if n.endswith(".wav") and not n.endswith("_lo.wav")) if media_dir else []
+            for name in names:
+                stem = name[:-4]
+                write_fields("SEARCH_ITEM", stem, stem, "host-sim", media_duration(os.path.join(media_dir, name)),
+                             f"https://archive.org/details/{stem}" if provider == "archive" else f"https://example.invalid/{stem}")
+            write_fields("SEARCH_END")
+        elif cmd == "RESOLVE":
+            source = parts[2] if len(parts) > 2 else ""
+            if resolve_delay > 0:
+                time.sleep(resolve_delay)
+            stem = source.rstrip("/").rsplit("/", 1)[-1]
+            if not media_base or not stem:
+                write_fields("ERROR", "host_sim media base not configured")
+            elif media_dir and os.path.exists(os.path.join(media_dir, f"{stem}_lo.wav")):
+                write_fields("RESOLVE_OK", f"{media_base}/{stem}.wav", "", "", 1411, 705, f"{media_base}/{stem}_lo.wav")
+            else:
+                write_fields("RESOLVE_OK", f"{media_base}/{stem}.wav", "", "")
+        elif cmd == "QUIT":
+            try:
+                write_fields("BYE")
+            except BrokenPipeError:
+                # The plugin may close its end right after QUIT.
+                os.dup2(os.open(os.devnull, os.O_WRONLY), sys.stdout.fileno())
+            break
+        else:
+            write_fields("ERROR", "unknown command")
+    log_event("EXIT")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
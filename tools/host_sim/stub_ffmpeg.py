@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""Minimal ffmpeg stand-in for the host simulator.
+
+Handles exactly what the plugin asks of ffmpeg for 16-bit stereo WAV media:
+"-i <http url or local path>" plus an optional "-ss <seconds>", writing a
+streaming WAV to stdout. Seeks use an HTTP Range request, like ffmpeg's http
+protocol does; local files (offline library copies) are simply seeked.
+
+WEBSTREAM_SIM_DECODER_BURN=N forks N busy-looping helpers for the life of
+the decode, standing in for a CPU-heavy codec. WEBSTREAM_SIM_DECODER_LOG
+gets one "pid policy nice cpus" line per start, as the kernel sees it.
+WEBSTREAM_SIM_FFMPEG_PROBE=1 holds output back until "-probesize" bytes or
+"-analyzeduration" worth of input (ffmpeg's defaults: 5 MB, 5 s) have been
+read, the way ffmpeg probes a compressed stream before its first packet.
+"""
+import os
+import struct
+import sys
+import urllib.request
+
+CHUNK = 16384
+
+
+def arg_value(argv, flag):
+    if flag in argv:
+        i = argv.index(flag)
+        if i + 1 < len(argv):
+            return argv[i + 1]
+    return None
+
+
+def open_url(url, start=None):
+    if not url.startswith(("http://", "https://")):
+        fp = open(url, "rb")
+        if start is not None:
+            fp.seek(start)
+        return fp
+    req = urllib.request.Request(url, headers={"User-Agent": "host-sim-ffmpeg"})
+    if start is not None:
+        req.add_header("Range", f"bytes={start}-")
+    return urllib.request.urlopen(req, timeout=15)
+
+
+def read_exact(fp, n):
+    data = b""
+    while len(data) < n:
+        part = fp.read(n - len(data))
+        if not part:
+            raise EOFError("short read")
+        data += part
+    return data
+
+
+def parse_header(fp):
+    """Returns (fmt_body, data_offset) after consuming up to the data payload."""
+    riff = read_exact(fp, 12)
+    if riff[0:4] != b"RIFF" or riff[8:12] != b"WAVE":
+        raise ValueError("not a WAV file")
+    offset = 12
+    fmt = None
+    while True:
+        hdr = read_exact(fp, 8)
+        cid, size = hdr[0:4], struct.unpack("<I", hdr[4:8])[0]
+        offset += 8
+        if cid == b"data":
+            return fmt, offset
+        body = read_exact(fp, size + (size & 1))
+        offset += size + (size & 1)
+        if cid == b"fmt ":
+            fmt = body[:16]
+
+
+def probe_bytes(argv, byte_rate):
+    if os.environ.get("WEBSTREAM_SIM_FFMPEG_PROBE") != "1":
+        return 0
+    size = int(arg_value(argv, "-probesize") or 5000000)
+    duration_us = int(arg_value(argv, "-analyzeduration") or 5000000)
+    return min(size, byte_rate * duration_us // 1000000)
+
+
+def log_sched():
+    path = os.environ.get("WEBSTREAM_SIM_DECODER_LOG")
+    if not path:
+        return
+    names = {os.SCHED_OTHER: "other", os.SCHED_BATCH: "batch", os.SCHED_IDLE: "idle",
+             os.SCHED_FIFO: "fifo", os.SCHED_RR: "rr"}
+    policy = names.get(os.sched_getscheduler(0), "?")
+    cpus = ",".join(str(c) for c in sorted(os.sched_getaffinity(0)))
+    with open(path, "a") as fp:
+        fp.write(f"{os.getpid()}\t{policy}\t{os.getpriority(os.PRIO_PROCESS, 0)}\t{cpus}\n")
+
+
+def start_burners():
+    """Spinners share our process group and scheduling, so they stop with us."""
+    parent = os.getpid()
+    for _ in range(int(os.environ.get("WEBSTREAM_SIM_DECODER_BURN") or "0")):
+        if os.fork() == 0:
+            while os.getppid() == parent:
+                for _ in range(100000):
+                    pass
+            os._exit(0)
+
+
+def main() -> int:
+    argv = sys.argv[1:]
+    url = arg_value(argv, "-i")
+    # Whole milliseconds: float seconds truncate a frame at some splice points.
+    ss_ms = round(float(arg_value(argv, "-ss") or "0") * 1000)
+    if not url:
+        sys.stderr.write("stub_ffmpeg: missing -i\n")
+        return 1
+
+    log_sched()
+    start_burners()
+    src = open_url(url)
+    fmt, data_offset = parse_header(src)
+    if fmt is None:
+        sys.stderr.write("stub_ffmpeg: missing fmt chunk\n")
+        return 1
+    _, channels, rate, byte_rate, block_align, bits = struct.unpack("<HHIIHH", fmt)
+    if channels != 2 or bits != 16:
+        sys.stderr.write("stub_ffmpeg: only 16-bit stereo WAV media is supported\n")
+        return 1
+
+    if ss_ms > 0:
+        skip = ss_ms * rate // 1000 * block_align
+        src.close()
+        src = open_url(url, data_offset + skip)
+
+    held = b""
+    want = probe_bytes(argv, byte_rate)
+    while len(held) < want:
+        part = src.read(min(CHUNK, want - len(held)))
+        if not part:
+            break
+        held += part
+
+    out = sys.stdout.buffer
+    out.write(b"RIFF" + struct.pack("<I", 0xFFFFFFFF) + b"WAVE")
+    out.write(b"fmt " + struct.pack("<I", 16) + fmt)
+    out.write(b"data" + struct.pack("<I", 0xFFFFFFFF))
+    try:
+        out.write(held)
+        while True:
+            data = src.read(CHUNK)
+            if not data:
+                break
+            out.write(data)
+            out.flush()
+    except BrokenPipeError:
+        return 0
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
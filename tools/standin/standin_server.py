@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""Local HTTP stand-in for provider APIs and media hosts.
+
+Serves files from a directory with HTTP Range support and optional latency
+and bandwidth limits so streaming code can be exercised offline. With
+--fixtures it also answers the freesound and archive.org API routes the
+daemon uses from recorded JSON responses; point the daemon at it with
+WEBSTREAM_FREESOUND_BASE_URL=http://127.0.0.1:<port>/apiv2 and
+WEBSTREAM_ARCHIVE_BASE_URL=http://127.0.0.1:<port>.
+Prints "PORT <n>" on stdout once listening.
+"""
+import argparse
+import os
+import re
+import sys
+import threading
+import time
+import urllib.parse
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+RANGE_RE = re.compile(r"bytes=(\d*)-(\d*)$")
+
+# path pattern -> fixture file; "{0}" is the first capture, "default" the fallback.
+FIXTURE_ROUTES = [
+    (re.compile(r"^/apiv2/search/text/?$"), "freesound/search.json", True),
+    (re.compile(r"^/apiv2/sounds/([^/]+)/?$"), "freesound/sound_{0}.json", True),
+    (re.compile(r"^/advancedsearch\.php$"), "archive/advancedsearch.json", False),
+    (re.compile(r"^/metadata/([^/]+)/?$"), "archive/metadata_{0}.json", False),
+]
+DOWNLOAD_RE = re.compile(r"^/(?:download/[^/]+|media)/(.+)$")
+
+
+class StandinState:
+    def __init__(self, root: str, latency_ms: int, rate_kbps: int, fixtures: str):
+        self.root = os.path.abspath(root)
+        self.fixtures = os.path.abspath(fixtures) if fixtures else ""
+        self.latency_ms = latency_ms
+        self.rate_kbps = rate_kbps
+        self.lock = threading.Lock()
+        self.requests = 0
+        self.range_requests = 0
+        self.active = 0
+        self.max_active = 0
+
+
+class StandinHandler(BaseHTTPRequestHandler):
+    server_version = "webstream-standin/1.0"
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, fmt, *args):
+        return
+
+    @property
+    def state(self) -> StandinState:
+        return self.server.state
+
+    def resolve_path(self):
+        path = urllib.parse.unquote(self.path.split("?", 1)[0])
+        if path == "/__stats":
+            return "__stats"
+        m = DOWNLOAD_RE.match(path)
+        rel = m.group(1) if m else path.lstrip("/")
+        full = os.path.abspath(os.path.join(self.state.root, rel))
+        if not full.startswith(self.state.root + os.sep) or not os.path.isfile(full):
+            return None
+        return full
+
+    def send_stats(self):
+        st = self.state
+        with st.lock:
+            body = (
+                f"requests={st.requests}\nrange_requests={st.range_requests}\n"
+                f"max_active={st.max_active}\n"
+            ).encode()
+        self.send_response(200)
+        self.send_header("Content-Type", "text/plain")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def send_json(self, code: int, body: bytes):
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def handle_fixture(self) -> bool:
+        """Answers recorded API routes; returns False when the path is not an API route."""
+        st = self.state
+        parsed = urllib.parse.urlparse(self.path)
+        for pattern, template, needs_token in FIXTURE_ROUTES:
+            m = pattern.match(parsed.path)
+            if not m:
+                continue
+            with st.lock:
+                st.requests += 1
+            if st.latency_ms > 0:
+                time.sleep(st.latency_ms / 1000.0)
+            query = urllib.parse.parse_qs(parsed.query)
+            if needs_token and not query.get("token"):
+                self.send_json(401, b'{"detail": "Authentication credentials were not provided."}')
+                return True
+            key = m.group(1) if m.groups() else ""
+            path = os.path.join(st.fixtures, template.format(key))
+            if not os.path.isfile(path):
+                path = os.path.join(st.fixtures, template.format("default"))
+            try:
+                with open(path, "r", encoding="utf-8") as fp:
+                    body = fp.read()
+            except OSError:
+                self.send_json(404, b'{"detail": "Not found."}')
+                return True
+            base = f"http://{self.headers.get('Host') or '127.0.0.1'}"
+            body = body.replace("{{base}}", base).replace("{{id}}", key)
+            self.send_json(200, body.encode("utf-8"))
+            return True
+        return False
+
+    def write_throttled(self, fp, length: int):
+        rate = self.state.rate_kbps * 1024
+        chunk = 16384
+        started = time.monotonic()
+        sent = 0
+        while sent < length:
+            data = fp.read(min(chunk, length - sent))
+            if not data:
+                break
+            self.wfile.write(data)
+            sent += len(data)
+            if rate > 0:
+                ahead = sent / rate - (time.monotonic() - started)
+                if ahead > 0:
+                    time.sleep(ahead)
+
+    def handle_media(self, head_only: bool):
+        if self.state.fixtures and self.handle_fixture():
+            return
+        path = self.resolve_path()
+        if path == "__stats":
+            self.send_stats()
+            return
+        if path is None:
+            self.send_error(404)
+            return
+
+        st = self.state
+        size = os.path.getsize(path)
+        start, end = 0, size - 1
+        partial = False
+        rng = self.headers.get("Range")
+        if rng:
+            m = RANGE_RE.match(rng.strip())
+            if not m or (m.group(1) == "" and m.group(2) == ""):
+                self.send_error(416)
+                return
+            if m.group(1) == "":
+                start = max(0, size - int(m.group(2)))
+            else:
+                start = int(m.group(1))
+                if m.group(2) != "":
+                    end = min(size - 1, int(m.group(2)))
+            if start >= size or start > end:
+                self.send_response(416)
+                self.send_header("Content-Range", f"bytes */{size}")
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+            partial = True
+
+        with st.lock:
+            st.requests += 1
+            if partial:
+                st.range_requests += 1
+            st.active += 1
+            st.max_active = max(st.max_active, st.active)
+        try:
+            if st.latency_ms > 0:
+                time.sleep(st.latency_ms / 1000.0)
+            length = end - start + 1
+            self.send_response(206 if partial else 200)
+            self.send_header("Content-Type", "application/octet-stream")
+            self.send_header("Accept-Ranges", "bytes")
+            self.send_header("Content-Length", str(length))
+            if partial:
+                self.send_header("Content-Range", f"bytes {start}-{end}/{size}")
+            self.end_headers()
+            if head_only:
+                return
+            with open(path, "rb") as fp:
+                fp.seek(start)
+                self.write_throttled(fp, length)
+        except (BrokenPipeError, ConnectionResetError):
+            pass
+        finally:
+            with st.lock:
+                st.active -= 1
+
+    def do_GET(self):
+        self.handle_media(False)
+
+    def do_HEAD(self):
+        self.handle_media(True)
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument("--root", required=True, help="directory of media files to serve")
+    ap.add_argument("--port", type=int, default=0)
+    ap.add_argument("--latency-ms", type=int, default=0, help="delay before each response")
+    ap.add_argument("--rate-kbps", type=int, default=0, help="per-connection bandwidth cap (KiB/s)")
+    ap.add_argument("--fixtures", default="", help="recorded API responses (see tools/standin/fixtures)")
+    args = ap.parse_args()
+
+    server = ThreadingHTTPServer(("127.0.0.1", args.port), StandinHandler)
+    server.daemon_threads = True
+    server.state = StandinState(args.root, args.latency_ms, args.rate_kbps, args.fixtures)
+    sys.stdout.write(f"PORT {server.server_address[1]}\n")
+    sys.stdout.flush()
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())